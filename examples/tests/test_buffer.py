@@ -95,6 +95,16 @@ def test_buffer_locking():
     api.post("        buf.unlocksamples()\n")
     api.post("\n")
 
+    api.post("Method 3: buffer protocol\n")
+    api.post("---\n")
+    api.post("# samples are locked during each access, as 'f' items\n")
+    api.post("view = memoryview(buf)\n")
+    api.post("view[0] = view[0] * 0.5\n")
+    api.post("buf.setdirty()\n")
+    api.post("samples = array('f')\n")
+    api.post("samples.frombytes(buf)  # copies all channels at once\n")
+    api.post("\n")
+
     api.post("IMPORTANT: Always unlock after locking!\n")
     api.post("Use try/finally to ensure unlock happens.\n")
 
@@ -393,8 +403,8 @@ def test_safety_notes():
 
     api.post("6. Performance\n")
     api.post("   - peek()/poke() lock each call\n")
-    api.post("   - For bulk access, use locksamples()\n")
-    api.post("   - Then access raw pointer (advanced)\n")
+    api.post("   - For bulk access, use memoryview(buf)\n")
+    api.post("   - Or array.frombytes(buf) to copy all samples\n")
 
     api.post("\n")
 
@@ -5,6 +5,7 @@
 #define API_BUFFER_H
 
 #include "api_common.h"
+#include <limits.h>
 
 
 // ----------------------------------------------------------------------------
@@ -299,6 +300,45 @@ static bool Buffer_unlocksamples(int argc, py_Ref argv) {
     return true;
 }
 
+// Buffer protocol: memoryview(buf), array.frombytes(buf), ...
+// The samples are locked, as 'f' items, until the view is released
+static void Buffer__releasebuffer(py_Buffer* view) {
+    buffer_unlocksamples((t_buffer_obj*)view->internal);
+}
+
+static bool Buffer__getbuffer(py_Ref self, py_Buffer* out, bool writable) {
+    BufferObject* wrapper = py_touserdata(self);
+
+    if (!wrapper->buffer_ref) {
+        return RuntimeError("Buffer reference is null");
+    }
+
+    t_buffer_obj* obj = buffer_ref_getobject(wrapper->buffer_ref);
+    if (!obj) {
+        return RuntimeError("Buffer object does not exist");
+    }
+
+    t_atom_long frames = buffer_getframecount(obj);
+    t_atom_long channels = buffer_getchannelcount(obj);
+    if (frames * channels > INT_MAX / (t_atom_long)sizeof(float)) {
+        return ValueError("Buffer is too large for a memory view");
+    }
+
+    float* samples = buffer_locksamples(obj);
+    if (!samples) {
+        return RuntimeError("Failed to lock buffer samples");
+    }
+
+    out->data = samples;
+    out->size = (int)(frames * channels * sizeof(float));
+    out->itemsize = sizeof(float);
+    out->format = 'f';
+    out->readonly = false;
+    out->internal = obj;
+    out->release = Buffer__releasebuffer;
+    return true;
+}
+
 // Method: getchannelcount()
 static bool Buffer_getchannelcount(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
@@ -961,6 +961,7 @@ bool api_module_initialize(void) {
     py_bindmethod(g_buffer_type, "poke", Buffer_poke);
     py_bindmethod(g_buffer_type, "is_null", Buffer_is_null);
     py_bindmethod(g_buffer_type, "pointer", Buffer_pointer);
+    py_tpsetbuffer(g_buffer_type, Buffer__getbuffer);
 
     // AtomArray type
     g_atomarray_type = py_newtype("AtomArray", tp_object, mod, (py_Dtor)AtomArray__del__);
@@ -4,22 +4,76 @@
 
 #if PK_ENABLE_THREADS
 
+#include "pocketpy/common/vector.h"
+
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <time.h>
 
 #if __EMSCRIPTEN__ || __APPLE__ || __linux__
 #include <pthread.h>
 #define PK_USE_PTHREADS 1
 typedef pthread_t c11_thrd_t;
 typedef void* c11_thrd_retval_t;
+typedef pthread_mutex_t c11_mutex_t;
+typedef pthread_cond_t c11_cond_t;
 #else
 #include <threads.h>
 #define PK_USE_PTHREADS 0
 typedef thrd_t c11_thrd_t;
 typedef int c11_thrd_retval_t;
+typedef mtx_t c11_mutex_t;
+typedef cnd_t c11_cond_t;
 #endif
 
 bool c11_thrd_create(c11_thrd_t* thrd, c11_thrd_retval_t (*func)(void*), void* arg);
+void c11_thrd_join(c11_thrd_t thrd);
 void c11_thrd_yield();
 
+void c11_mutex__ctor(c11_mutex_t* self);
+void c11_mutex__dtor(c11_mutex_t* self);
+void c11_mutex__lock(c11_mutex_t* self);
+void c11_mutex__unlock(c11_mutex_t* self);
+
+/// Set `out` to `timeout` seconds from now, on the `TIME_UTC` clock.
+void c11_deadline(struct timespec* out, double timeout);
+
+void c11_cond__ctor(c11_cond_t* self);
+void c11_cond__dtor(c11_cond_t* self);
+void c11_cond__wait(c11_cond_t* self, c11_mutex_t* mutex);
+/// Wait until `deadline` (`TIME_UTC`), return false if it has passed.
+bool c11_cond__timedwait(c11_cond_t* self, c11_mutex_t* mutex, const struct timespec* deadline);
+void c11_cond__signal(c11_cond_t* self);
+void c11_cond__broadcast(c11_cond_t* self);
+
+typedef struct c11_thrdpool_job {
+    void (*func)(void* arg);
+    void* arg;
+} c11_thrdpool_job;
+
+/// Long-lived worker threads fed by a bounded MPMC queue.
+/// A worker is started when a job is submitted and no worker is idle.
+typedef struct c11_thrdpool {
+    c11_mutex_t mutex;
+    c11_cond_t not_empty;
+    c11_cond_t not_full;
+    c11_cond_t job_done;  // broadcast after each job
+    c11_thrdpool_job* queue;
+    int capacity;
+    int head;
+    int length;
+    int n_idle;
+    bool is_closed;
+    c11_vector /*T=c11_thrd_t*/ workers;
+} c11_thrdpool;
+
+void c11_thrdpool__ctor(c11_thrdpool* self, int capacity);
+/// Run the queued jobs and join all workers.
+void c11_thrdpool__dtor(c11_thrdpool* self);
+/// Queue a job, blocking while the queue is full. Return false if no worker can run it.
+bool c11_thrdpool__submit(c11_thrdpool* self, void (*func)(void*), void* arg);
+/// Wait until a job sets `flag`, at most `timeout` seconds if it is not negative.
+/// Return the value of `flag`.
+bool c11_thrdpool__wait(c11_thrdpool* self, atomic_bool* flag, double timeout);
+
 #endif
\ No newline at end of file
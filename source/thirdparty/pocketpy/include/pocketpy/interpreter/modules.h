@@ -22,6 +22,13 @@ void pk__add_module_unicodedata();
 void pk__add_module_vmath();
 void pk__add_module_array2d();
 void pk__add_module_colorcvt();
+void pk__add_module_collections();
+void pk__add_module_heapq();
+void pk__add_module_bisect();
+void pk__add_module_functools();
+void pk__add_module_itertools();
+void pk__add_module_array();
+void pk__add_module_struct();
 
 void pk__add_module_conio();
 void pk__add_module_lz4();
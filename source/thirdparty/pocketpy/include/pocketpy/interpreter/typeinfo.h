@@ -4,6 +4,30 @@
 #include "pocketpy/common/vector.h"
 #include "pocketpy/objects/object.h"
 
+typedef enum py_MagicSlot {
+    PK_SLOT_NONE = -1,
+#define MAGIC_SLOT(x) PK_SLOT##x,
+#include "pocketpy/xmacros/magicslots.h"
+#undef MAGIC_SLOT
+    PK_SLOT_COUNT,
+} py_MagicSlot;
+
+typedef struct FrozenNameDict_KV {
+    py_Name key;
+    py_TValue* value;  // points into the `__dict__` of the type that defines `key`
+} FrozenNameDict_KV;
+
+/// A read-only snapshot of all names visible on a type, including inherited ones.
+/// Rebuilt lazily after a name is added to or removed from any type in the MRO.
+typedef struct FrozenNameDict {
+    int length;
+    int capacity;      // power of two
+    int shift;         // 64 - log2(capacity)
+    bool is_perfect;   // no two keys share a home slot, a lookup is a single probe
+    uint64_t seed;     // multiplier of the key hash
+    FrozenNameDict_KV items[];
+} FrozenNameDict;
+
 typedef struct py_TypeInfo {
     py_Name name;
     py_Type index;
@@ -15,11 +39,18 @@ typedef struct py_TypeInfo {
 
     bool is_python;  // is it a python class? (not derived from c object)
     bool is_final;  // can it be subclassed?
+    bool is_base;   // has it been subclassed?
+
+    FrozenNameDict* frozen_dict;  // NULL until the next lookup after a mutation
+    // inherited hot magic methods, valid while `frozen_dict` is not NULL
+    // `__hash__` is the effective hash: NULL if the type is unhashable
+    py_TValue* magic_slots[PK_SLOT_COUNT];
 
     bool (*getattribute)(py_Ref self, py_Name name) PY_RAISE PY_RETURN;
     bool (*setattribute)(py_Ref self, py_Name name, py_Ref val) PY_RAISE PY_RETURN;
     bool (*delattribute)(py_Ref self, py_Name name) PY_RAISE;
     bool (*getunboundmethod)(py_Ref self, py_Name name) PY_RETURN;
+    py_GetBufferFunc getbuffer;  // NULL if the type has no buffer
 
     py_TValue annotations;
     py_Dtor dtor;  // destructor for this type, NULL if no dtor
@@ -30,6 +61,16 @@ py_TypeInfo* pk_typeinfo(py_Type type);
 py_ItemRef pk_tpfindname(py_TypeInfo* ti, py_Name name);
 #define pk_tpfindmagic pk_tpfindname
 
+/// Find a hot magic method of `type` without hashing its name.
+py_ItemRef pk_tpfindslot(py_Type type, py_MagicSlot slot);
+py_Name pk_magicslot_name(py_MagicSlot slot);
+/// Map a magic name to its slot, `PK_SLOT_NONE` if it has none.
+py_MagicSlot pk_magicslot(py_Name name);
+
+/// Drop the frozen dicts of `ti` and its subclasses.
+/// Call before adding or removing a name in `ti`'s `__dict__`.
+void py_TypeInfo__invalidate(py_TypeInfo* ti);
+
 py_Type pk_newtype(const char* name,
                    py_Type base,
                    const py_GlobalRef module,
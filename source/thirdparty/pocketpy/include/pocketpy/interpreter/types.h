@@ -11,14 +11,31 @@ typedef struct {
 
 typedef struct {
     int length;
-    uint32_t capacity;
-    uint32_t null_index_value;
+    uint32_t capacity;     // number of slots, a power of two
+    uint32_t growth_left;  // EMPTY slots that can be filled before a rehash
     bool index_is_short;
-    void* indices;
+    bool str_keys_only;  // no key other than `str` has been inserted
+    uint8_t* ctrl;  // control bytes, one per slot
+    void* indices;  // entry index per slot, uint16_t or uint32_t
     c11_vector /*T=DictEntry*/ entries;
 } Dict;
 
+#define PK_DICT_MIN_CAPACITY 16
+
+/* Dict core, shared by `dict`, `set` and `frozenset` */
+void Dict__ctor(Dict* self, uint32_t capacity, int entries_capacity);
+void Dict__dtor(Dict* self);
+void Dict__copy(Dict* self, Dict* src);
+void Dict__clear(Dict* self);
+bool Dict__try_get(Dict* self, py_TValue* key, DictEntry** out);
+bool Dict__set(Dict* self, py_TValue* key, py_TValue* val);
+int Dict__pop(Dict* self, py_Ref key);
+/// Iterate over a `Dict` stored in the userdata of `owner`. mode 0: keys, 1: values, 2: items
+void pk_newdictiterator(py_OutRef out, py_Ref owner, int mode);
+
 typedef c11_vector List;
 
 void c11_chunked_array2d__mark(void* ud, c11_vector* p_stack);
+void c11_deque__mark(void* ud, c11_vector* p_stack);
+void c11_lru_cache__mark(void* ud, c11_vector* p_stack);
 void function__gc_mark(void* ud, c11_vector* p_stack);
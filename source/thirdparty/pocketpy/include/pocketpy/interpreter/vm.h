@@ -10,6 +10,7 @@
 #include "pocketpy/interpreter/frame.h"
 #include "pocketpy/interpreter/typeinfo.h"
 #include "pocketpy/interpreter/line_profiler.h"
+#include "pocketpy/common/threads.h"
 #include <time.h>
 
 // TODO:
@@ -39,6 +40,7 @@ typedef struct py_ModuleInfo {
     c11_string* package;
     c11_string* path;
     py_GlobalRef self;  // weakref to the original module object
+    bool is_source;     // executed from Python source, rather than built in C
 } py_ModuleInfo;
 
 typedef struct VM {
@@ -76,8 +78,17 @@ typedef struct VM {
     ValueStack stack;  // put `stack` at the end for better cache locality
 } VM;
 
+#if PK_ENABLE_THREADS
+/// Guards the process-wide tables: the VMs in `GlobalSetup.c` and the channels of `pkpy`.
+extern c11_mutex_t pk_all_vm_mutex;
+/// Worker threads running the jobs of `pkpy.ComputeThread`, shared by all VMs.
+extern c11_thrdpool pk_compute_thread_pool;
+#endif
+
 void VM__ctor(VM* self);
 void VM__dtor(VM* self);
+/// Copy the modules and types of `src` into `self`, a blank VM that is current.
+bool VM__clone(VM* self, VM* src);
 
 void VM__push_frame(VM* self, py_Frame* frame);
 void VM__pop_frame(VM* self);
@@ -91,6 +102,13 @@ bool pk__normalize_index(int* index, int length);
 
 bool pk__object_new(int argc, py_Ref argv);
 
+/// Item size of a `py_Buffer` format, 0 if unsupported.
+int pk__format_itemsize(char format);
+/// Read the item of `format` at `p`.
+void pk__unpack_item(char format, const void* p, py_OutRef out);
+/// Write `val` as an item of `format` at `p`. Raise if it does not fit.
+bool pk__pack_item(char format, void* p, py_Ref val) PY_RAISE;
+
 bool pk_wrapper__self(int argc, py_Ref argv);
 
 const char* pk_op2str(py_Name op);
@@ -114,6 +132,7 @@ bool pk_arraycontains(py_Ref self, py_Ref val);
 
 bool pk_loadmethod(py_StackRef self, py_Name name);
 bool pk_callmagic(py_Name name, int argc, py_Ref argv);
+bool pk_callmagicslot(py_MagicSlot slot, int argc, py_Ref argv);
 
 bool pk_exec(CodeObject* co, py_Ref module);
 bool pk_execdyn(CodeObject* co, py_Ref module, py_Ref globals, py_Ref locals);
@@ -121,12 +140,27 @@ bool pk_execdyn(CodeObject* co, py_Ref module, py_Ref globals, py_Ref locals);
 /// Assumes [a, b] are on the stack, performs a binary op.
 /// The result is stored in `self->last_retval`.
 /// The stack remains unchanged.
-bool pk_stack_binaryop(VM* self, py_Name op, py_Name rop);
+bool pk_stack_binaryop(VM* self, py_MagicSlot op, py_MagicSlot rop);
+/// Same as `py_binaryop` but takes magic slots.
+bool pk_binaryop(py_Ref lhs, py_Ref rhs, py_MagicSlot op, py_MagicSlot rop);
+
+/// Splice the stored arguments of the `partial` at `p0` into the call on the stack.
+/// Afterwards `[func, nil, args..., kwargs...]` is ready for `VM__vectorcall`.
+bool pk_partial__unpack(py_StackRef p0, uint16_t* argc, uint16_t* kwargc);
+/// Call the `_lru_cache_wrapper` at `p0` with the arguments on the stack above it.
+/// The stack is left dirty, the caller resets it.
+bool pk_lru_cache__call(py_StackRef p0, int argc, int kwargc);
 
 void pk_print_stack(VM* self, py_Frame* frame, Bytecode byte);
 
 bool pk_format_object(VM* self, py_Ref val, c11_sv spec);
 
+/// `pickle.dumps()` with out-of-band buffers. Either `buffer_callback` decides for each `bytes`, or
+/// large `bytes` are appended to the list `buffers`. Both may be NULL.
+bool pk_pickle_dumps(py_Ref val, py_Ref buffer_callback, py_Ref buffers);
+/// `pickle.loads()` taking out-of-band buffers from the list or tuple `buffers`, which may be NULL.
+bool pk_pickle_loads(const unsigned char* data, int size, py_Ref buffers);
+
 // type registration
 void pk_object__register();
 void pk_number__register();
@@ -135,6 +169,8 @@ py_Type pk_str_iterator__register();
 py_Type pk_bytes__register();
 py_Type pk_dict__register();
 py_Type pk_dict_items__register();
+py_Type pk_set__register();
+py_Type pk_frozenset__register();
 py_Type pk_list__register();
 py_Type pk_tuple__register();
 py_Type pk_list_iterator__register();
@@ -156,6 +192,8 @@ py_Type pk_classmethod__register();
 py_Type pk_generator__register();
 py_Type pk_namedict__register();
 py_Type pk_code__register();
+py_Type pk_memoryview__register();
+py_Type pk_bytearray__register();
 
 py_GlobalRef pk_builtins__register();
 
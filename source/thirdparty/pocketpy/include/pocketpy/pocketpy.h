@@ -96,6 +96,24 @@ typedef struct py_Callbacks {
 /// @return `true` if the function is successful or `false` if an exception is raised.
 typedef bool (*py_CFunction)(int argc, py_StackRef argv) PY_RAISE PY_RETURN;
 
+/// A view of the contiguous memory of an object, filled by `py_getbuffer()`.
+/// `data` stays valid until python code that may resize the object runs.
+typedef struct py_Buffer {
+    void* data;
+    int size;       // in bytes
+    int itemsize;   // size of `data` is a multiple of it
+    char format;    // `struct` format of the items: 'B', 'b', 'h', 'i', 'q', 'f' or 'd'
+    bool readonly;
+    py_Ref obj;      // the exporting object, as passed to `py_getbuffer()`
+    void* internal;  // private to the exporter
+    /// Called by `py_releasebuffer()`. It may only use `obj` and `internal`.
+    void (*release)(struct py_Buffer* self);
+} py_Buffer;
+
+/// Buffer provider of a type. Fill `out` with the memory of `self`.
+/// Raise `TypeError` if `writable` is requested from readonly memory.
+typedef bool (*py_GetBufferFunc)(py_Ref self, py_Buffer* out, bool writable) PY_RAISE;
+
 /// Python compiler modes.
 /// + `EXEC_MODE`: for statements.
 /// + `EVAL_MODE`: for expressions.
@@ -112,11 +130,25 @@ PK_API void py_initialize();
 PK_API void py_finalize();
 /// Get the current VM index.
 PK_API int py_currentvm();
-/// Switch to a VM.
-/// @param index index of the VM ranging from 0 to 16 (exclusive). `0` is the default VM.
+/// Switch to a VM, creating it if it does not exist.
+/// @param index non-negative index of the VM. `0` is the default VM.
 PK_API void py_switchvm(int index);
+/// Create a VM at the lowest unused index and return that index.
+/// The current VM is not changed.
+PK_API int py_newvm();
+/// Delete a VM and free its memory. Does nothing if the VM does not exist.
+/// The default VM and the current VM cannot be deleted.
+PK_API void py_delvm(int index);
 /// Reset the current VM.
 PK_API void py_resetvm();
+/// Create or reset VM `dst_index` as a copy of the initialized VM `src_index`, then switch to it.
+/// Native modules and types are recreated with the same type indices,
+/// source modules are imported again and other values are copied.
+/// `src_index` must not be running while it is cloned.
+PK_API bool py_clonevm(int src_index, int dst_index) PY_RAISE;
+/// Run the callbacks of the `pkpy.Future` objects of the current VM whose jobs have finished.
+/// Call it periodically from the thread that owns the VM, e.g. from an idle loop.
+PK_API bool py_poll_completions() PY_RAISE;
 /// Reset All VMs.
 PK_API void py_resetallvm();
 /// Get the current VM context. This is used for user-defined data.
@@ -367,6 +399,8 @@ PK_API py_GlobalRef py_tpobject(py_Type type);
 PK_API const char* py_tpname(py_Type type);
 /// Disable the type for subclassing.
 PK_API void py_tpsetfinal(py_Type type);
+/// Set the buffer provider of the given type. It is inherited by subclasses.
+PK_API void py_tpsetbuffer(py_Type type, py_GetBufferFunc getbuffer);
 /// Set attribute hooks for the given type.
 PK_API void py_tphookattributes(py_Type type,
                                 bool (*getattribute)(py_Ref self, py_Name name) PY_RAISE PY_RETURN,
@@ -727,6 +761,19 @@ PK_API bool
 /// noexcept
 PK_API int py_dict_len(py_Ref self);
 
+/************* PySet *************/
+
+/// Create an empty `set`.
+PK_API void py_newset(py_OutRef);
+/// true: success, false: error
+PK_API bool py_set_add(py_Ref self, py_Ref val) PY_RAISE;
+/// -1: error, 0: not found, 1: found. Works for `set` and `frozenset`.
+PK_API int py_set_contains(py_Ref self, py_Ref val) PY_RAISE;
+/// -1: error, 0: not found, 1: found (and deleted)
+PK_API int py_set_discard(py_Ref self, py_Ref val) PY_RAISE;
+/// noexcept. Works for `set` and `frozenset`.
+PK_API int py_set_len(py_Ref self);
+
 /************* PySlice *************/
 
 /// Create an UNINITIALIZED `slice` object.
@@ -735,6 +782,17 @@ PK_API py_ObjectRef py_newslice(py_OutRef);
 /// Create a `slice` object from 3 integers.
 PK_API void py_newsliceint(py_OutRef out, py_i64 start, py_i64 stop, py_i64 step);
 
+/************* Buffer Protocol *************/
+
+/// Check if the object supports the buffer protocol.
+PK_API bool py_checkbuffer(py_Ref self);
+/// Get a view of the memory of the object without copying.
+/// Raise `TypeError` if the object has no buffer or if `writable` memory is not available.
+/// Each successful call must be paired with `py_releasebuffer()`.
+PK_API bool py_getbuffer(py_Ref self, py_Buffer* out, bool writable) PY_RAISE;
+/// Release a view obtained by `py_getbuffer()`.
+PK_API void py_releasebuffer(py_Buffer* self);
+
 /************* random module *************/
 PK_API void py_newRandom(py_OutRef out);
 PK_API void py_Random_seed(py_Ref self, py_i64 seed);
@@ -768,12 +826,25 @@ PK_API c11_color32 py_tocolor32(py_Ref self);
 PK_API bool py_json_dumps(py_Ref val, int indent) PY_RAISE PY_RETURN;
 /// Python equivalent to `json.loads(val)`.
 PK_API bool py_json_loads(const char* source) PY_RAISE PY_RETURN;
+/// Create an incremental JSON parser.
+PK_API void py_json_parser_new(py_OutRef out);
+/// Feed the next chunk of a JSON document to the parser.
+PK_API bool py_json_parser_feed(py_Ref parser, const char* data, int size) PY_RAISE;
+/// Finish the document and return the decoded object. The parser can not be fed any more.
+PK_API bool py_json_parser_close(py_Ref parser) PY_RAISE PY_RETURN;
 
 /************* pickle module *************/
 /// Python equivalent to `pickle.dumps(val)`.
 PK_API bool py_pickle_dumps(py_Ref val) PY_RAISE PY_RETURN;
 /// Python equivalent to `pickle.loads(val)`.
 PK_API bool py_pickle_loads(const unsigned char* data, int size) PY_RAISE PY_RETURN;
+/// Save the state of `__main__` and of the modules imported from source to a file.
+/// The snapshot holds their global variables, but not functions, classes or modules,
+/// which are referred to by name and must be defined again before loading.
+PK_API bool py_snapshot_save(const char* path) PY_RAISE;
+/// Restore a snapshot written by `py_snapshot_save()` into the current VM.
+/// Modules that are not imported yet are imported first.
+PK_API bool py_snapshot_load(const char* path) PY_RAISE;
 
 /************* pkpy module *************/
 /// Begin the watchdog with `timeout` in milliseconds.
@@ -784,6 +855,30 @@ PK_API void py_watchdog_begin(py_i64 timeout);
 /// Reset the watchdog.
 PK_API void py_watchdog_end();
 
+#if PK_ENABLE_THREADS
+/// A bounded queue of messages shared by all VMs and threads, see `pkpy.Channel`.
+typedef struct py_Channel py_Channel;
+/// Get the channel named `name`, creating it with room for `capacity` messages,
+/// rounded up to a power of two and at least 2. If the channel already exists,
+/// it is returned as is and `capacity` is ignored.
+/// Can be called from any thread. Release it with `py_channel_close()`.
+PK_API py_Channel* py_channel_open(const char* name, int capacity);
+/// Release a channel returned by `py_channel_open()`.
+PK_API void py_channel_close(py_Channel* self);
+/// Send a copy of `data`, received as `bytes` by `pkpy.Channel.recv()`.
+/// Block at most `timeout` seconds, forever if it is negative. Return false on timeout.
+PK_API bool py_channel_send(py_Channel* self, const void* data, int size, double timeout);
+/// Receive a message into `*data`, which must be freed by `py_free()`.
+/// `*is_pickled` is set for messages sent by `pkpy.Channel.send()`, see `py_pickle_loads()`,
+/// and cleared for raw bytes.
+/// Block at most `timeout` seconds, forever if it is negative. Return false on timeout.
+PK_API bool py_channel_recv(py_Channel* self,
+                            void** data,
+                            int* size,
+                            bool* is_pickled,
+                            double timeout);
+#endif
+
 PK_API void py_profiler_begin();
 PK_API void py_profiler_end();
 PK_API void py_profiler_reset();
@@ -835,6 +930,8 @@ enum py_PredefinedType {
     tp_code,
     tp_dict,
     tp_dict_iterator,  // 1 slot
+    tp_set,
+    tp_frozenset,
     tp_property,       // 2 slots (getter + setter)
     tp_star_wrapper,   // 1 slot + int level
     tp_staticmethod,   // 1 slot
@@ -876,6 +973,12 @@ enum py_PredefinedType {
     tp_array2d,
     tp_array2d_view,
     tp_chunked_array2d,
+    /* collections */
+    tp_deque,
+    tp_deque_iterator,
+    /* functools */
+    tp_partial,
+    tp_lru_cache_wrapper,
 };
 
 #ifdef __cplusplus
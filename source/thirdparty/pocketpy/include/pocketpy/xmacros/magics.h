@@ -31,6 +31,7 @@ MAGIC_METHOD(__rshift__)
 MAGIC_METHOD(__and__)
 MAGIC_METHOD(__or__)
 MAGIC_METHOD(__xor__)
+MAGIC_METHOD(__iadd__)
 /////////////////////////////
 MAGIC_METHOD(__repr__)
 MAGIC_METHOD(__str__)
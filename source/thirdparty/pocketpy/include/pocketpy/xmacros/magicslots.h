@@ -0,0 +1,51 @@
+#ifdef MAGIC_SLOT
+
+// hot magic methods cached in `py_TypeInfo::magic_slots`
+// comparison
+MAGIC_SLOT(__lt__)
+MAGIC_SLOT(__le__)
+MAGIC_SLOT(__gt__)
+MAGIC_SLOT(__ge__)
+MAGIC_SLOT(__eq__)
+MAGIC_SLOT(__ne__)
+// binary operators
+MAGIC_SLOT(__add__)
+MAGIC_SLOT(__radd__)
+MAGIC_SLOT(__sub__)
+MAGIC_SLOT(__rsub__)
+MAGIC_SLOT(__mul__)
+MAGIC_SLOT(__rmul__)
+MAGIC_SLOT(__truediv__)
+MAGIC_SLOT(__rtruediv__)
+MAGIC_SLOT(__floordiv__)
+MAGIC_SLOT(__rfloordiv__)
+MAGIC_SLOT(__mod__)
+MAGIC_SLOT(__rmod__)
+MAGIC_SLOT(__pow__)
+MAGIC_SLOT(__rpow__)
+MAGIC_SLOT(__matmul__)
+MAGIC_SLOT(__lshift__)
+MAGIC_SLOT(__rshift__)
+MAGIC_SLOT(__and__)
+MAGIC_SLOT(__or__)
+MAGIC_SLOT(__xor__)
+// in-place operators
+MAGIC_SLOT(__iadd__)
+// protocols
+MAGIC_SLOT(__repr__)
+MAGIC_SLOT(__str__)
+MAGIC_SLOT(__hash__)
+MAGIC_SLOT(__len__)
+MAGIC_SLOT(__bool__)
+MAGIC_SLOT(__iter__)
+MAGIC_SLOT(__next__)
+MAGIC_SLOT(__contains__)
+MAGIC_SLOT(__getitem__)
+MAGIC_SLOT(__setitem__)
+MAGIC_SLOT(__delitem__)
+// specials
+MAGIC_SLOT(__new__)
+MAGIC_SLOT(__init__)
+MAGIC_SLOT(__call__)
+
+#endif
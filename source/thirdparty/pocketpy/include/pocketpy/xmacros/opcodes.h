@@ -64,6 +64,7 @@ OPCODE(BINARY_AND)
 OPCODE(BINARY_OR)
 OPCODE(BINARY_XOR)
 OPCODE(BINARY_MATMUL)
+OPCODE(INPLACE_ADD)
 OPCODE(COMPARE_LT)
 OPCODE(COMPARE_LE)
 OPCODE(COMPARE_EQ)
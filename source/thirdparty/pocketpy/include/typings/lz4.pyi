@@ -9,3 +9,36 @@ def decompress(data: bytes) -> bytes:
     
     This function is equivalent to `lz4.block.decompress` of https://pypi.org/project/lz4/.
     """
+
+class LZ4File:
+    """A file object reading or writing the LZ4 frame format. Use `lz4.open()` to create one.
+
+    The data is compatible with the `lz4` command line tool
+    and `lz4.frame` of https://pypi.org/project/lz4/.
+    """
+
+    def read(self, size: int = -1) -> bytes:
+        """Read and decompress up to `size` bytes, or everything if `size` is negative."""
+
+    def write(self, data: bytes | str) -> int:
+        """Compress and write `data`. A `str` is written as UTF-8."""
+
+    def close(self) -> None:
+        """Finish the frame. Data written without closing the file is lost."""
+
+    def __enter__(self) -> 'LZ4File': ...
+    def __exit__(self, *args) -> None: ...
+
+def open(file: str | object, mode: str = 'rb',
+         block_size: int = 65536, threads: int = 1) -> LZ4File:
+    """Open an LZ4 compressed file, given either a path or a binary file object.
+
+    `mode` is `'rb'` or `'wb'`. When writing, `block_size` can be 64KB, 256KB, 1MB or 4MB.
+    Memory use is bounded by `block_size * threads`, and with `threads > 1` that many blocks
+    are compressed in parallel.
+
+    ```python
+    with lz4.open('data.pkl.lz4', 'wb', block_size=1024*1024, threads=4) as f:
+        pickle.dump(obj, f)
+    ```
+    """
@@ -1,4 +1,4 @@
-from typing import Self, Literal
+from typing import Self, Callable
 from vmath import vec2, vec2i
 
 class TValue[T]:
@@ -26,6 +26,24 @@ def enable_full_buffering_mode() -> None:
 def currentvm() -> int:
     """Return the current VM index."""
 
+def snapshot_save(path: str) -> None:
+    """Save the global variables of `__main__` and of the modules imported from source.
+
+    Functions, classes and modules are not saved. They are referred to by name,
+    so the program must define them again before calling `snapshot_load()`.
+    """
+
+def snapshot_load(path: str) -> None:
+    """Restore the global variables saved by `snapshot_save()`."""
+
+def clonevm(vm_index: int) -> None:
+    """Replace VM `vm_index` with a copy of the current VM.
+
+    Modules imported from source are imported again in the new VM,
+    the global variables of `__main__` and of native modules are copied.
+    Functions and classes of `__main__` are not copied.
+    """
+
 
 def watchdog_begin(timeout: int):
     """Begin the watchdog with `timeout` in milliseconds.
@@ -42,26 +60,55 @@ def profiler_end() -> None: ...
 def profiler_reset() -> None: ...
 def profiler_report() -> dict[str, list[list]]: ...
 
+class Future:
+    """The result of a job submitted to a `ComputeThread`."""
+
+    def done(self) -> bool:
+        """Check if the job is finished."""
+
+    def result(self, timeout: float | None = None):
+        """Wait for the job and return its result.
+
+        Raise `TimeoutError` if it is not finished after `timeout` seconds,
+        and `RuntimeError` if it failed.
+        """
+
+    def add_done_callback(self, fn: Callable[[Future], None]) -> None:
+        """Call `fn(self)` from `poll_completions()` once the job is finished.
+
+        If the job is already finished, `fn` is called immediately.
+        """
+
+def poll_completions() -> None:
+    """Run the callbacks of the futures whose jobs have finished."""
+
 class ComputeThread:
-    def __init__(self, vm_index: Literal[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15]): ...
+    def __init__(self, vm_index: int | None = None):
+        """Run jobs in VM `vm_index`.
+
+        If `vm_index` is `None`, a new VM is created and deleted with this object.
+        """
 
     @property
     def is_done(self) -> bool:
         """Check if the current job is done."""
 
-    def wait_for_done(self) -> None:
-        """Wait for the current job to finish."""
+    def wait_for_done(self, timeout: float | None = None) -> bool:
+        """Block until the current job is finished or `timeout` seconds have passed.
+
+        Return whether the job is finished.
+        """
 
     def last_error(self) -> str | None: ...
     def last_retval(self): ...
 
-    def submit_exec(self, source: str) -> None:
+    def submit_exec(self, source: str) -> Future:
         """Submit a job to execute some source code."""
 
-    def submit_eval(self, source: str) -> None:
+    def submit_eval(self, source: str) -> Future:
         """Submit a job to evaluate some source code."""
 
-    def submit_call(self, eval_src: str, *args, **kwargs) -> None:
+    def submit_call(self, eval_src: str, *args, **kwargs) -> Future:
         """Submit a job to call a function with arguments."""
 
     def exec(self, source: str) -> None:
@@ -69,3 +116,35 @@ class ComputeThread:
 
     def eval(self, source: str):
         """Directly evaluate some source code."""
+
+class Channel:
+    def __init__(self, name: str, capacity: int | None = None):
+        """Open the channel named `name`, shared by all VMs and threads.
+
+        It is created with room for `capacity` messages (64 by default), rounded up to
+        a power of two and at least 2, if no other `Channel` object with the same name exists.
+        Raise `ValueError` if it exists with a different capacity.
+        """
+
+    @property
+    def name(self) -> str: ...
+    @property
+    def capacity(self) -> int: ...
+
+    def __len__(self) -> int:
+        """The number of messages waiting to be received."""
+
+    def send(self, obj, timeout: float | None = None) -> None:
+        """Send a pickled copy of `obj`.
+
+        Block while the channel is full, and raise `TimeoutError` after `timeout` seconds.
+        """
+
+    def send_bytes(self, data, timeout: float | None = None) -> None:
+        """Send a copy of a buffer like `bytes` or `array2d`, received as `bytes`."""
+
+    def recv(self, timeout: float | None = None):
+        """Receive the oldest message.
+
+        Block while the channel is empty, and raise `TimeoutError` after `timeout` seconds.
+        """
@@ -1,33 +1,26 @@
-class cache:
-    def __init__(self, f):
-        self.f = f
-        self.cache = {}
+from _functools import partial, _lru_cache_wrapper
 
-    def __call__(self, *args):
-        if args not in self.cache:
-            self.cache[args] = self.f(*args)
-        return self.cache[args]
-    
-class lru_cache:
-    def __init__(self, maxsize=128):
+class _CacheInfo:
+    def __init__(self, hits, misses, maxsize, currsize):
+        self.hits = hits
+        self.misses = misses
         self.maxsize = maxsize
-        self.cache = {}
+        self.currsize = currsize
+
+    def __repr__(self):
+        return f"CacheInfo(hits={self.hits}, misses={self.misses}, maxsize={self.maxsize}, currsize={self.currsize})"
+
+def lru_cache(maxsize=128, typed=False):
+    if callable(maxsize):
+        # used as `@lru_cache` without arguments
+        return _lru_cache_wrapper(maxsize, 128, typed)
+    def decorator(f):
+        return _lru_cache_wrapper(f, maxsize, typed)
+    return decorator
+
+def cache(f):
+    return _lru_cache_wrapper(f, None, False)
 
-    def __call__(self, f):
-        def wrapped(*args):
-            if args in self.cache:
-                res = self.cache.pop(args)
-                self.cache[args] = res
-                return res
-            
-            res = f(*args)
-            if len(self.cache) >= self.maxsize:
-                first_key = next(iter(self.cache))
-                self.cache.pop(first_key)
-            self.cache[args] = res
-            return res
-        return wrapped
-    
 def reduce(function, sequence, initial=...):
     it = iter(sequence)
     if initial is ...:
@@ -40,16 +33,3 @@ def reduce(function, sequence, initial=...):
     for element in it:
         value = function(value, element)
     return value
-
-class partial:
-    def __init__(self, f, *args, **kwargs):
-        self.f = f
-        if not callable(f):
-            raise TypeError("the first argument must be callable")
-        self.args = args
-        self.kwargs = kwargs
-
-    def __call__(self, *args, **kwargs):
-        kwargs.update(self.kwargs)
-        return self.f(*self.args, *args, **kwargs)
-
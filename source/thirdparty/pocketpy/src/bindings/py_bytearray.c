@@ -0,0 +1,500 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/sstream.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* `bytearray` keeps its bytes in a `c11_vector` whose capacity at least doubles on growth, so
+ * appending in a loop is amortised O(1). `+=` extends in place through `__iadd__`.
+ */
+
+static void c11_bytearray__dtor(void* ud) { c11_vector__dtor(ud); }
+
+static c11_vector* c11_bytearray__new(py_OutRef out, py_Type type) {
+    c11_vector* self = py_newobject(out, type, 0, sizeof(c11_vector));
+    c11_vector__ctor(self, 1);
+    return self;
+}
+
+static void c11_bytearray__reserve(c11_vector* self, int capacity) {
+    if(capacity > self->capacity) c11_vector__reserve(self, c11__max(capacity, self->capacity * 2));
+}
+
+/// Replace `self[start:stop]` with `size` bytes of `data`, which may point into `self`.
+static void
+    c11_bytearray__splice(c11_vector* self, int start, int stop, const void* data, int size) {
+    const char* begin = self->data;
+    void* tmp = NULL;
+    if(size > 0 && (const char*)data >= begin && (const char*)data < begin + self->capacity) {
+        tmp = PK_MALLOC(size);
+        memcpy(tmp, data, size);
+        data = tmp;
+    }
+    int length = self->length - (stop - start) + size;
+    c11_bytearray__reserve(self, length);
+    char* p = self->data;
+    if(self->length > stop) memmove(p + start + size, p + stop, self->length - stop);
+    if(size > 0) memcpy(p + start, data, size);
+    self->length = length;
+    PK_FREE(tmp);
+}
+
+static bool Bytearray__checkbyte(py_Ref val, unsigned char* out) {
+    if(!py_checkint(val)) return false;
+    py_i64 v = py_toint(val);
+    if(v < 0 || v > 255) return ValueError("byte must be in range(0, 256)");
+    *out = (unsigned char)v;
+    return true;
+}
+
+/// Append the bytes of a buffer or of an iterable of ints.
+static bool Bytearray__extend(py_Ref self, py_Ref iterable) {
+    c11_vector* ud = py_touserdata(self);
+    if(py_checkbuffer(iterable)) {
+        py_Buffer view;
+        if(!py_getbuffer(iterable, &view, false)) return false;
+        c11_bytearray__splice(ud, ud->length, ud->length, view.data, view.size);
+        py_releasebuffer(&view);
+        return true;
+    }
+    if(py_isstr(iterable)) return TypeError("cannot extend bytearray with str");
+    unsigned char byte = 0;
+    py_TValue* p;
+    int length = pk_arrayview(iterable, &p);
+    if(length != -1) {
+        c11_bytearray__reserve(ud, ud->length + length);
+        for(int i = 0; i < length; i++) {
+            if(!Bytearray__checkbyte(p + i, &byte)) return false;
+            c11_vector__push(unsigned char, ud, byte);
+        }
+        return true;
+    }
+    if(!py_iter(iterable)) return false;
+    py_Ref iter = py_pushtmp();
+    *iter = *py_retval();
+    while(true) {
+        int res = py_next(iter);
+        if(res == -1) {
+            py_pop();
+            return false;
+        }
+        if(res == 0) break;
+        if(!Bytearray__checkbyte(py_retval(), &byte)) {
+            py_pop();
+            return false;
+        }
+        c11_bytearray__reserve(ud, ud->length + 1);
+        c11_vector__push(unsigned char, ud, byte);
+    }
+    py_pop();
+    return true;
+}
+
+static bool bytearray__new__(int argc, py_Ref argv) {
+    // __new__(cls, source=None)
+    py_Type cls = py_totype(argv);
+    py_Ref source = py_arg(1);
+    py_Ref out = py_pushtmp();
+    c11_vector* self = c11_bytearray__new(out, cls);
+    if(py_isint(source)) {
+        py_i64 n = py_toint(source);
+        if(n < 0) return ValueError("negative count");
+        c11_vector__reserve(self, (int)n);
+        memset(self->data, 0, n);
+        self->length = (int)n;
+    } else if(py_isstr(source)) {
+        return TypeError("string argument without an encoding");
+    } else if(!py_isnone(source)) {
+        if(!Bytearray__extend(out, source)) return false;
+    }
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool bytearray__getbuffer(py_Ref self, py_Buffer* out, bool writable) {
+    c11_vector* ud = py_touserdata(self);
+    out->data = ud->data;
+    out->size = ud->length;
+    out->itemsize = 1;
+    out->format = 'B';
+    out->readonly = false;
+    return true;
+}
+
+static bool bytearray__len__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_vector* self = py_touserdata(argv);
+    py_newint(py_retval(), self->length);
+    return true;
+}
+
+static bool bytearray__getitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_vector* self = py_touserdata(argv);
+    py_Ref key = py_arg(1);
+    const unsigned char* data = self->data;
+    if(py_isint(key)) {
+        int index = py_toint(key);
+        if(!pk__normalize_index(&index, self->length)) return false;
+        py_newint(py_retval(), data[index]);
+        return true;
+    }
+    if(!py_istype(key, tp_slice)) return TypeError("bytearray indices must be integers or slices");
+    int start, stop, step;
+    if(!pk__parse_int_slice(key, self->length, &start, &stop, &step)) return false;
+    c11_vector* res = c11_bytearray__new(py_retval(), py_typeof(argv));
+    if(step == 1) {
+        c11_bytearray__splice(res, 0, 0, data + start, c11__max(stop - start, 0));
+        return true;
+    }
+    for(int i = start; step > 0 ? i < stop : i > stop; i += step) {
+        c11_bytearray__reserve(res, res->length + 1);
+        c11_vector__push(unsigned char, res, data[i]);
+    }
+    return true;
+}
+
+static bool bytearray__setitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    c11_vector* self = py_touserdata(argv);
+    py_Ref key = py_arg(1);
+    if(py_isint(key)) {
+        int index = py_toint(key);
+        if(!pk__normalize_index(&index, self->length)) return false;
+        unsigned char byte = 0;
+        if(!Bytearray__checkbyte(py_arg(2), &byte)) return false;
+        c11__setitem(unsigned char, self, index, byte);
+        py_newnone(py_retval());
+        return true;
+    }
+    if(!py_istype(key, tp_slice)) return TypeError("bytearray indices must be integers or slices");
+    int start, stop, step;
+    if(!pk__parse_int_slice(key, self->length, &start, &stop, &step)) return false;
+    // convert the value first, it may be any iterable of ints
+    py_Ref value = py_arg(2);
+    if(!py_checkbuffer(value) || py_isidentical(value, argv)) {
+        if(py_isint(value) || py_isstr(value)) {
+            return TypeError("can assign only bytes, buffers, or iterables of ints");
+        }
+        py_Ref tmp = py_pushtmp();
+        c11_bytearray__new(tmp, py_typeof(argv));
+        if(!Bytearray__extend(tmp, value)) return false;
+        py_assign(value, tmp);
+        py_pop();
+    }
+    py_Buffer view;
+    if(!py_getbuffer(value, &view, false)) return false;
+    if(step == 1) {
+        c11_bytearray__splice(self, start, c11__max(stop, start), view.data, view.size);
+    } else {
+        int length = 0;
+        for(int i = start; step > 0 ? i < stop : i > stop; i += step)
+            length++;
+        if(length != view.size) {
+            py_releasebuffer(&view);
+            return ValueError("attempt to assign bytes of size %d to extended slice of size %d",
+                              view.size,
+                              length);
+        }
+        const unsigned char* src = view.data;
+        for(int i = 0; i < length; i++) {
+            c11__setitem(unsigned char, self, start + i * step, src[i]);
+        }
+    }
+    py_releasebuffer(&view);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool bytearray__delitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_vector* self = py_touserdata(argv);
+    py_Ref key = py_arg(1);
+    if(py_isint(key)) {
+        int index = py_toint(key);
+        if(!pk__normalize_index(&index, self->length)) return false;
+        c11_bytearray__splice(self, index, index + 1, NULL, 0);
+        py_newnone(py_retval());
+        return true;
+    }
+    if(!py_istype(key, tp_slice)) return TypeError("bytearray indices must be integers or slices");
+    int start, stop, step;
+    if(!pk__parse_int_slice(key, self->length, &start, &stop, &step)) return false;
+    if(step < 0) {
+        // delete the same items walking forwards
+        int count = 0;
+        for(int i = start; i > stop; i += step)
+            count++;
+        if(count == 0) {
+            py_newnone(py_retval());
+            return true;
+        }
+        stop = start + 1;
+        start = start + (count - 1) * step;
+        step = -step;
+    }
+    if(step == 1) {
+        c11_bytearray__splice(self, start, c11__max(stop, start), NULL, 0);
+    } else {
+        unsigned char* data = self->data;
+        int j = start;
+        for(int i = start; i < self->length; i++) {
+            if(i < stop && (i - start) % step == 0) continue;
+            data[j++] = data[i];
+        }
+        self->length = j;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool bytearray__add__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!py_checkbuffer(py_arg(1))) {
+        py_newnotimplemented(py_retval());
+        return true;
+    }
+    py_Ref out = py_pushtmp();
+    c11_vector* self = py_touserdata(argv);
+    c11_vector* res = c11_bytearray__new(out, py_typeof(argv));
+    c11_bytearray__splice(res, 0, 0, self->data, self->length);
+    if(!Bytearray__extend(out, py_arg(1))) return false;
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool bytearray__iadd__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!py_checkbuffer(py_arg(1))) {
+        return TypeError("can't concat %t to bytearray", py_arg(1)->type);
+    }
+    if(!Bytearray__extend(argv, py_arg(1))) return false;
+    py_assign(py_retval(), argv);
+    return true;
+}
+
+/// -2: not comparable, 0: equal, 1: not equal
+static int Bytearray__compare(py_Ref lhs, py_Ref rhs) {
+    if(!py_istype(rhs, tp_bytes) && !py_istype(rhs, py_typeof(lhs))) return -2;
+    py_Buffer a, b;
+    py_getbuffer(lhs, &a, false);
+    py_getbuffer(rhs, &b, false);
+    int res = a.size != b.size || (a.size > 0 && memcmp(a.data, b.data, a.size) != 0);
+    py_releasebuffer(&a);
+    py_releasebuffer(&b);
+    return res;
+}
+
+static bool bytearray__eq__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Bytearray__compare(argv, py_arg(1));
+    if(res == -2) {
+        py_newnotimplemented(py_retval());
+    } else {
+        py_newbool(py_retval(), res == 0);
+    }
+    return true;
+}
+
+static bool bytearray__ne__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Bytearray__compare(argv, py_arg(1));
+    if(res == -2) {
+        py_newnotimplemented(py_retval());
+    } else {
+        py_newbool(py_retval(), res != 0);
+    }
+    return true;
+}
+
+/// Find `sub` (an int or a buffer) in `self[start:end]`. Return -2 on error.
+static int Bytearray__find(py_Ref self, py_Ref sub, py_Ref start, py_Ref end) {
+    c11_vector* ud = py_touserdata(self);
+    int lo = 0, hi = ud->length;
+    if(!py_isnone(start)) {
+        if(!py_checkint(start)) return -2;
+        lo = py_toint(start);
+        if(lo < 0) lo = c11__max(lo + ud->length, 0);
+    }
+    if(!py_isnone(end)) {
+        if(!py_checkint(end)) return -2;
+        hi = py_toint(end);
+        if(hi < 0) hi += ud->length;
+        hi = c11__min(hi, ud->length);
+    }
+    unsigned char byte = 0;
+    const void* needle = &byte;
+    int size = 1;
+    py_Buffer view = {.release = NULL};
+    if(py_isint(sub)) {
+        if(!Bytearray__checkbyte(sub, &byte)) return -2;
+    } else {
+        if(!py_getbuffer(sub, &view, false)) return -2;
+        needle = view.data;
+        size = view.size;
+    }
+    const char* data = ud->data;
+    int res = -1;
+    for(int i = lo; i + size <= hi; i++) {
+        if(size == 0 || memcmp(data + i, needle, size) == 0) {
+            res = i;
+            break;
+        }
+    }
+    py_releasebuffer(&view);
+    return res;
+}
+
+static bool bytearray__contains__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Bytearray__find(argv, py_arg(1), py_None(), py_None());
+    if(res == -2) return false;
+    py_newbool(py_retval(), res >= 0);
+    return true;
+}
+
+static bool bytearray_find(int argc, py_Ref argv) {
+    // find(self, sub, start=None, end=None)
+    int res = Bytearray__find(argv, py_arg(1), py_arg(2), py_arg(3));
+    if(res == -2) return false;
+    py_newint(py_retval(), res);
+    return true;
+}
+
+static bool bytearray__iter__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_vector* self = py_touserdata(argv);
+    py_Ref list = py_pushtmp();
+    py_newlistn(list, self->length);
+    const unsigned char* data = self->data;
+    for(int i = 0; i < self->length; i++) {
+        py_newint(py_list_getitem(list, i), data[i]);
+    }
+    bool ok = py_iter(list);
+    py_pop();
+    return ok;
+}
+
+static bool bytearray__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_vector* self = py_touserdata(argv);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstr(&buf, "bytearray(b");
+    c11_sbuf__write_quoted(&buf, (c11_sv){self->data, self->length}, '\'');
+    c11_sbuf__write_char(&buf, ')');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+static bool bytearray__reduce__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_vector* self = py_touserdata(argv);
+    py_Ref p = py_newtuple(py_pushtmp(), 2);
+    py_assign(&p[0], py_tpobject(py_typeof(argv)));
+    py_Ref args = py_newtuple(&p[1], 1);
+    unsigned char* bytes = py_newbytes(&args[0], self->length);
+    if(self->length > 0) memcpy(bytes, self->data, self->length);
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+static bool bytearray_append(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_vector* self = py_touserdata(argv);
+    unsigned char byte = 0;
+    if(!Bytearray__checkbyte(py_arg(1), &byte)) return false;
+    c11_bytearray__reserve(self, self->length + 1);
+    c11_vector__push(unsigned char, self, byte);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool bytearray_extend(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Bytearray__extend(argv, py_arg(1))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool bytearray_insert(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    c11_vector* self = py_touserdata(argv);
+    int index = py_toint(py_arg(1));
+    if(index < 0) index += self->length;
+    index = c11__min(c11__max(index, 0), self->length);
+    unsigned char byte = 0;
+    if(!Bytearray__checkbyte(py_arg(2), &byte)) return false;
+    c11_bytearray__splice(self, index, index, &byte, 1);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool bytearray_pop(int argc, py_Ref argv) {
+    // pop(self, index=-1)
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    c11_vector* self = py_touserdata(argv);
+    if(self->length == 0) return IndexError("pop from empty bytearray");
+    int index = py_toint(py_arg(1));
+    if(!pk__normalize_index(&index, self->length)) return false;
+    py_newint(py_retval(), c11__getitem(unsigned char, self, index));
+    c11_bytearray__splice(self, index, index + 1, NULL, 0);
+    return true;
+}
+
+static bool bytearray_clear(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_vector* self = py_touserdata(argv);
+    c11_vector__clear(self);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool bytearray_copy(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_vector* self = py_touserdata(argv);
+    c11_vector* res = c11_bytearray__new(py_retval(), py_typeof(argv));
+    c11_bytearray__splice(res, 0, 0, self->data, self->length);
+    return true;
+}
+
+static bool bytearray_decode(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_vector* self = py_touserdata(argv);
+    py_newstrv(py_retval(), (c11_sv){self->data, self->length});
+    return true;
+}
+
+py_Type pk_bytearray__register() {
+    py_Type type = pk_newtype("bytearray", tp_object, NULL, c11_bytearray__dtor, false, true);
+    py_tpsetbuffer(type, bytearray__getbuffer);
+    py_setdict(py_tpobject(type), __hash__, py_None());
+
+    py_bind(py_tpobject(type), "__new__(cls, source=None)", bytearray__new__);
+    py_bindmagic(type, __len__, bytearray__len__);
+    py_bindmagic(type, __getitem__, bytearray__getitem__);
+    py_bindmagic(type, __setitem__, bytearray__setitem__);
+    py_bindmagic(type, __delitem__, bytearray__delitem__);
+    py_bindmagic(type, __add__, bytearray__add__);
+    py_bindmagic(type, __iadd__, bytearray__iadd__);
+    py_bindmagic(type, __eq__, bytearray__eq__);
+    py_bindmagic(type, __ne__, bytearray__ne__);
+    py_bindmagic(type, __contains__, bytearray__contains__);
+    py_bindmagic(type, __iter__, bytearray__iter__);
+    py_bindmagic(type, __repr__, bytearray__repr__);
+    py_bindmagic(type, __reduce__, bytearray__reduce__);
+
+    py_bindmethod(type, "append", bytearray_append);
+    py_bindmethod(type, "extend", bytearray_extend);
+    py_bindmethod(type, "insert", bytearray_insert);
+    py_bind(py_tpobject(type), "pop(self, index=-1)", bytearray_pop);
+    py_bindmethod(type, "clear", bytearray_clear);
+    py_bindmethod(type, "copy", bytearray_copy);
+    py_bind(py_tpobject(type), "find(self, sub, start=None, end=None)", bytearray_find);
+    py_bindmethod(type, "decode", bytearray_decode);
+    return type;
+}
@@ -567,9 +567,16 @@ static bool bytes__new__(int argc, py_Ref argv) {
         return true;
     }
     if(argc > 2) return TypeError("bytes() takes at most 1 argument");
+    if(py_checkbuffer(&argv[1])) {
+        py_Buffer view;
+        if(!py_getbuffer(&argv[1], &view, false)) return false;
+        memcpy(py_newbytes(py_retval(), view.size), view.data, view.size);
+        py_releasebuffer(&view);
+        return true;
+    }
     py_TValue* p;
     int length = pk_arrayview(&argv[1], &p);
-    if(length == -1) return TypeError("bytes() argument must be a list or tuple");
+    if(length == -1) return TypeError("bytes() argument must be a list, tuple or buffer");
     unsigned char* data = py_newbytes(py_retval(), length);
     for(int i = 0; i < length; i++) {
         if(!py_checktype(&p[i], tp_int)) return false;
@@ -657,13 +664,15 @@ static bool bytes__hash__(int argc, py_Ref argv) {
 static bool bytes__add__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(2);
     c11_bytes* self = py_touserdata(&argv[0]);
-    if(py_arg(1)->type != tp_bytes) {
+    if(!py_checkbuffer(py_arg(1))) {
         py_newnotimplemented(py_retval());
     } else {
-        c11_bytes* other = py_touserdata(&argv[1]);
-        unsigned char* p = py_newbytes(py_retval(), self->size + other->size);
+        py_Buffer other;
+        if(!py_getbuffer(py_arg(1), &other, false)) return false;
+        unsigned char* p = py_newbytes(py_retval(), self->size + other.size);
         memcpy(p, self->data, self->size);
-        memcpy(p + self->size, other->data, other->size);
+        memcpy(p + self->size, other.data, other.size);
+        py_releasebuffer(&other);
     }
     return true;
 }
@@ -676,6 +685,17 @@ static bool bytes_decode(int argc, py_Ref argv) {
     return true;
 }
 
+static bool bytes__getbuffer(py_Ref self, py_Buffer* out, bool writable) {
+    if(writable) return TypeError("cannot modify read-only memory");
+    c11_bytes* ud = py_touserdata(self);
+    out->data = ud->data;
+    out->size = ud->size;
+    out->itemsize = 1;
+    out->format = 'B';
+    out->readonly = true;
+    return true;
+}
+
 static bool bytes__len__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     c11_bytes* self = py_touserdata(&argv[0]);
@@ -686,6 +706,7 @@ static bool bytes__len__(int argc, py_Ref argv) {
 py_Type pk_bytes__register() {
     py_Type type = pk_newtype("bytes", tp_object, NULL, NULL, false, true);
     // no need to dtor because the memory is controlled by the object
+    py_tpsetbuffer(type, bytes__getbuffer);
 
     py_bindmagic(tp_bytes, __new__, bytes__new__);
     py_bindmagic(tp_bytes, __repr__, bytes__repr__);
@@ -9,8 +9,32 @@ bool c11_thrd_create(c11_thrd_t* thrd, c11_thrd_retval_t (*func)(void*), void* a
     return res == 0;
 }
 
+void c11_thrd_join(c11_thrd_t thrd) { pthread_join(thrd, NULL); }
+
 void c11_thrd_yield() { sched_yield(); }
 
+void c11_mutex__ctor(c11_mutex_t* self) { pthread_mutex_init(self, NULL); }
+
+void c11_mutex__dtor(c11_mutex_t* self) { pthread_mutex_destroy(self); }
+
+void c11_mutex__lock(c11_mutex_t* self) { pthread_mutex_lock(self); }
+
+void c11_mutex__unlock(c11_mutex_t* self) { pthread_mutex_unlock(self); }
+
+void c11_cond__ctor(c11_cond_t* self) { pthread_cond_init(self, NULL); }
+
+void c11_cond__dtor(c11_cond_t* self) { pthread_cond_destroy(self); }
+
+void c11_cond__wait(c11_cond_t* self, c11_mutex_t* mutex) { pthread_cond_wait(self, mutex); }
+
+bool c11_cond__timedwait(c11_cond_t* self, c11_mutex_t* mutex, const struct timespec* deadline) {
+    return pthread_cond_timedwait(self, mutex, deadline) == 0;
+}
+
+void c11_cond__signal(c11_cond_t* self) { pthread_cond_signal(self); }
+
+void c11_cond__broadcast(c11_cond_t* self) { pthread_cond_broadcast(self); }
+
 #else
 
 bool c11_thrd_create(c11_thrd_t* thrd, c11_thrd_retval_t (*func)(void*), void* arg) {
@@ -18,8 +42,131 @@ bool c11_thrd_create(c11_thrd_t* thrd, c11_thrd_retval_t (*func)(void*), void* a
     return res == thrd_success;
 }
 
+void c11_thrd_join(c11_thrd_t thrd) { thrd_join(thrd, NULL); }
+
 void c11_thrd_yield() { thrd_yield(); }
 
+void c11_mutex__ctor(c11_mutex_t* self) { mtx_init(self, mtx_plain); }
+
+void c11_mutex__dtor(c11_mutex_t* self) { mtx_destroy(self); }
+
+void c11_mutex__lock(c11_mutex_t* self) { mtx_lock(self); }
+
+void c11_mutex__unlock(c11_mutex_t* self) { mtx_unlock(self); }
+
+void c11_cond__ctor(c11_cond_t* self) { cnd_init(self); }
+
+void c11_cond__dtor(c11_cond_t* self) { cnd_destroy(self); }
+
+void c11_cond__wait(c11_cond_t* self, c11_mutex_t* mutex) { cnd_wait(self, mutex); }
+
+bool c11_cond__timedwait(c11_cond_t* self, c11_mutex_t* mutex, const struct timespec* deadline) {
+    return cnd_timedwait(self, mutex, deadline) == thrd_success;
+}
+
+void c11_cond__signal(c11_cond_t* self) { cnd_signal(self); }
+
+void c11_cond__broadcast(c11_cond_t* self) { cnd_broadcast(self); }
+
 #endif
 
+void c11_deadline(struct timespec* out, double timeout) {
+    timespec_get(out, TIME_UTC);
+    long long nsec = out->tv_nsec + (long long)(timeout * 1e9);
+    out->tv_sec += nsec / 1000000000;
+    out->tv_nsec = nsec % 1000000000;
+}
+
+static c11_thrd_retval_t c11_thrdpool__worker(void* arg) {
+    c11_thrdpool* self = arg;
+    c11_mutex__lock(&self->mutex);
+    while(true) {
+        while(self->length == 0 && !self->is_closed) {
+            self->n_idle++;
+            c11_cond__wait(&self->not_empty, &self->mutex);
+            self->n_idle--;
+        }
+        if(self->length == 0) break;  // closed and drained
+        c11_thrdpool_job job = self->queue[self->head];
+        self->head = (self->head + 1) % self->capacity;
+        self->length--;
+        c11_cond__signal(&self->not_full);
+        c11_mutex__unlock(&self->mutex);
+        job.func(job.arg);
+        c11_mutex__lock(&self->mutex);
+        c11_cond__broadcast(&self->job_done);
+    }
+    c11_mutex__unlock(&self->mutex);
+    return (c11_thrd_retval_t)0;
+}
+
+void c11_thrdpool__ctor(c11_thrdpool* self, int capacity) {
+    c11_mutex__ctor(&self->mutex);
+    c11_cond__ctor(&self->not_empty);
+    c11_cond__ctor(&self->not_full);
+    c11_cond__ctor(&self->job_done);
+    self->queue = PK_MALLOC(sizeof(c11_thrdpool_job) * capacity);
+    self->capacity = capacity;
+    self->head = 0;
+    self->length = 0;
+    self->n_idle = 0;
+    self->is_closed = false;
+    c11_vector__ctor(&self->workers, sizeof(c11_thrd_t));
+}
+
+void c11_thrdpool__dtor(c11_thrdpool* self) {
+    c11_mutex__lock(&self->mutex);
+    self->is_closed = true;
+    c11_cond__broadcast(&self->not_empty);
+    c11_mutex__unlock(&self->mutex);
+    // no job can be submitted now, so `workers` does not change
+    c11__foreach(c11_thrd_t, &self->workers, it) c11_thrd_join(*it);
+    c11_vector__dtor(&self->workers);
+    PK_FREE(self->queue);
+    c11_cond__dtor(&self->job_done);
+    c11_cond__dtor(&self->not_full);
+    c11_cond__dtor(&self->not_empty);
+    c11_mutex__dtor(&self->mutex);
+}
+
+bool c11_thrdpool__submit(c11_thrdpool* self, void (*func)(void*), void* arg) {
+    c11_mutex__lock(&self->mutex);
+    while(self->length == self->capacity) {
+        c11_cond__wait(&self->not_full, &self->mutex);
+    }
+    int tail = (self->head + self->length) % self->capacity;
+    self->queue[tail] = (c11_thrdpool_job){func, arg};
+    self->length++;
+    // idle workers that are already signaled are still counted in `n_idle`
+    if(self->n_idle < self->length) {
+        c11_thrd_t thrd;
+        if(c11_thrd_create(&thrd, c11_thrdpool__worker, self)) {
+            c11_vector__push(c11_thrd_t, &self->workers, thrd);
+        } else if(self->workers.length == 0) {
+            self->length--;
+            c11_mutex__unlock(&self->mutex);
+            return false;
+        }
+    }
+    c11_cond__signal(&self->not_empty);
+    c11_mutex__unlock(&self->mutex);
+    return true;
+}
+
+bool c11_thrdpool__wait(c11_thrdpool* self, atomic_bool* flag, double timeout) {
+    if(atomic_load(flag)) return true;
+    struct timespec deadline;
+    if(timeout >= 0) c11_deadline(&deadline, timeout);
+    c11_mutex__lock(&self->mutex);
+    while(!atomic_load(flag)) {
+        if(timeout < 0) {
+            c11_cond__wait(&self->job_done, &self->mutex);
+        } else if(!c11_cond__timedwait(&self->job_done, &self->mutex, &deadline)) {
+            break;
+        }
+    }
+    c11_mutex__unlock(&self->mutex);
+    return atomic_load(flag);
+}
+
 #endif  // PK_ENABLE_THREADS
\ No newline at end of file
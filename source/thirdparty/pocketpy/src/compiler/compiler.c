@@ -784,7 +784,7 @@ static void BinaryExpr__emit_(Expr* self_, Ctx* ctx) {
     uint16_t arg = BC_NOARG;
 
     switch(self->op) {
-        case TK_ADD: opcode = OP_BINARY_ADD; break;
+        case TK_ADD: opcode = self->inplace ? OP_INPLACE_ADD : OP_BINARY_ADD; break;
         case TK_SUB: opcode = OP_BINARY_SUB; break;
         case TK_MUL: opcode = OP_BINARY_MUL; break;
         case TK_DIV: opcode = OP_BINARY_TRUEDIV; break;
@@ -354,7 +354,7 @@ __NEXT_STEP:
         }
         case OP_LOAD_SUBSCR: {
             // [a, b] -> a[b]
-            py_Ref magic = py_tpfindmagic(SECOND()->type, __getitem__);
+            py_Ref magic = pk_tpfindslot(SECOND()->type, PK_SLOT__getitem__);
             if(magic) {
                 if(magic->type == tp_nativefunc) {
                     if(!py_callcfunc(magic->_cfunc, 2, SECOND())) goto __ERROR;
@@ -418,7 +418,7 @@ __NEXT_STEP:
         }
         case OP_STORE_SUBSCR: {
             // [val, a, b] -> a[b] = val
-            py_Ref magic = py_tpfindmagic(SECOND()->type, __setitem__);
+            py_Ref magic = pk_tpfindslot(SECOND()->type, PK_SLOT__setitem__);
             if(magic) {
                 PUSH(THIRD());  // [val, a, b, val]
                 if(magic->type == tp_nativefunc) {
@@ -491,7 +491,7 @@ __NEXT_STEP:
 
         case OP_DELETE_SUBSCR: {
             // [a, b] -> del a[b]
-            py_Ref magic = py_tpfindmagic(SECOND()->type, __delitem__);
+            py_Ref magic = pk_tpfindslot(SECOND()->type, PK_SLOT__delitem__);
             if(magic) {
                 if(magic->type == tp_nativefunc) {
                     if(!py_callcfunc(magic->_cfunc, 2, SECOND())) goto __ERROR;
@@ -562,24 +562,14 @@ __NEXT_STEP:
         }
         case OP_BUILD_SET: {
             py_TValue* begin = SP() - byte.arg;
-            py_Ref typeobject_set = py_getdict(self->builtins, py_name("set"));
-            assert(typeobject_set != NULL);
-            py_push(typeobject_set);
-            py_pushnil();
-            if(!py_vectorcall(0, 0)) goto __ERROR;
-            py_push(py_retval());  // empty set
-            py_Name id_add = py_name("add");
+            py_Ref tmp = py_pushtmp();
+            py_newset(tmp);
             for(int i = 0; i < byte.arg; i++) {
-                py_push(TOP());
-                if(!py_pushmethod(id_add)) {
-                    c11__abort("OP_BUILD_SET: failed to load method 'add'");
-                }
-                py_push(begin + i);
-                if(!py_vectorcall(1, 0)) goto __ERROR;
+                bool ok = py_set_add(tmp, begin + i);
+                if(!ok) goto __ERROR;
             }
-            py_TValue tmp = *TOP();
             SP() = begin;
-            PUSH(&tmp);
+            PUSH(tmp);
             DISPATCH();
         }
         case OP_BUILD_SLICE: {
@@ -613,26 +603,39 @@ __NEXT_STEP:
         *TOP() = self->last_retval;                                                                \
         DISPATCH();                                                                                \
     }
-            CASE_BINARY_OP(OP_BINARY_ADD, __add__, __radd__)
-            CASE_BINARY_OP(OP_BINARY_SUB, __sub__, __rsub__)
-            CASE_BINARY_OP(OP_BINARY_MUL, __mul__, __rmul__)
-            CASE_BINARY_OP(OP_BINARY_TRUEDIV, __truediv__, __rtruediv__)
-            CASE_BINARY_OP(OP_BINARY_FLOORDIV, __floordiv__, __rfloordiv__)
-            CASE_BINARY_OP(OP_BINARY_MOD, __mod__, __rmod__)
-            CASE_BINARY_OP(OP_BINARY_POW, __pow__, __rpow__)
-            CASE_BINARY_OP(OP_BINARY_LSHIFT, __lshift__, 0)
-            CASE_BINARY_OP(OP_BINARY_RSHIFT, __rshift__, 0)
-            CASE_BINARY_OP(OP_BINARY_AND, __and__, 0)
-            CASE_BINARY_OP(OP_BINARY_OR, __or__, 0)
-            CASE_BINARY_OP(OP_BINARY_XOR, __xor__, 0)
-            CASE_BINARY_OP(OP_BINARY_MATMUL, __matmul__, 0)
-            CASE_BINARY_OP(OP_COMPARE_LT, __lt__, __gt__)
-            CASE_BINARY_OP(OP_COMPARE_LE, __le__, __ge__)
-            CASE_BINARY_OP(OP_COMPARE_EQ, __eq__, __eq__)
-            CASE_BINARY_OP(OP_COMPARE_NE, __ne__, __ne__)
-            CASE_BINARY_OP(OP_COMPARE_GT, __gt__, __lt__)
-            CASE_BINARY_OP(OP_COMPARE_GE, __ge__, __le__)
+            CASE_BINARY_OP(OP_BINARY_ADD, PK_SLOT__add__, PK_SLOT__radd__)
+            CASE_BINARY_OP(OP_BINARY_SUB, PK_SLOT__sub__, PK_SLOT__rsub__)
+            CASE_BINARY_OP(OP_BINARY_MUL, PK_SLOT__mul__, PK_SLOT__rmul__)
+            CASE_BINARY_OP(OP_BINARY_TRUEDIV, PK_SLOT__truediv__, PK_SLOT__rtruediv__)
+            CASE_BINARY_OP(OP_BINARY_FLOORDIV, PK_SLOT__floordiv__, PK_SLOT__rfloordiv__)
+            CASE_BINARY_OP(OP_BINARY_MOD, PK_SLOT__mod__, PK_SLOT__rmod__)
+            CASE_BINARY_OP(OP_BINARY_POW, PK_SLOT__pow__, PK_SLOT__rpow__)
+            CASE_BINARY_OP(OP_BINARY_LSHIFT, PK_SLOT__lshift__, PK_SLOT_NONE)
+            CASE_BINARY_OP(OP_BINARY_RSHIFT, PK_SLOT__rshift__, PK_SLOT_NONE)
+            CASE_BINARY_OP(OP_BINARY_AND, PK_SLOT__and__, PK_SLOT_NONE)
+            CASE_BINARY_OP(OP_BINARY_OR, PK_SLOT__or__, PK_SLOT_NONE)
+            CASE_BINARY_OP(OP_BINARY_XOR, PK_SLOT__xor__, PK_SLOT_NONE)
+            CASE_BINARY_OP(OP_BINARY_MATMUL, PK_SLOT__matmul__, PK_SLOT_NONE)
+            CASE_BINARY_OP(OP_COMPARE_LT, PK_SLOT__lt__, PK_SLOT__gt__)
+            CASE_BINARY_OP(OP_COMPARE_LE, PK_SLOT__le__, PK_SLOT__ge__)
+            CASE_BINARY_OP(OP_COMPARE_EQ, PK_SLOT__eq__, PK_SLOT__eq__)
+            CASE_BINARY_OP(OP_COMPARE_NE, PK_SLOT__ne__, PK_SLOT__ne__)
+            CASE_BINARY_OP(OP_COMPARE_GT, PK_SLOT__gt__, PK_SLOT__lt__)
+            CASE_BINARY_OP(OP_COMPARE_GE, PK_SLOT__ge__, PK_SLOT__le__)
 #undef CASE_BINARY_OP
+        case OP_INPLACE_ADD: {
+            // [a, b] -> a.__iadd__(b) if defined, otherwise a + b
+            py_Ref magic = pk_tpfindslot(SECOND()->type, PK_SLOT__iadd__);
+            bool done = false;
+            if(magic) {
+                if(!py_call(magic, 2, SECOND())) goto __ERROR;
+                done = self->last_retval.type != tp_NotImplementedType;
+            }
+            if(!done && !pk_stack_binaryop(self, PK_SLOT__add__, PK_SLOT__radd__)) goto __ERROR;
+            POP();
+            *TOP() = self->last_retval;
+            DISPATCH();
+        }
         case OP_IS_OP: {
             bool res = py_isidentical(SECOND(), TOP());
             POP();
@@ -642,7 +645,7 @@ __NEXT_STEP:
         }
         case OP_CONTAINS_OP: {
             // [b, a] -> b __contains__ a (a in b) -> [retval]
-            py_Ref magic = py_tpfindmagic(SECOND()->type, __contains__);
+            py_Ref magic = pk_tpfindslot(SECOND()->type, PK_SLOT__contains__);
             if(magic) {
                 if(magic->type == tp_nativefunc) {
                     if(!py_callcfunc(magic->_cfunc, 2, SECOND())) goto __ERROR;
@@ -837,12 +840,8 @@ __NEXT_STEP:
         }
         case OP_SET_ADD: {
             // [set, iter, value]
-            py_push(THIRD());  // [| set]
-            if(!py_pushmethod(py_name("add"))) {
-                c11__abort("OP_SET_ADD: failed to load method 'add'");
-            }  // [|add() set]
-            py_push(THIRD());
-            if(!py_vectorcall(1, 0)) goto __ERROR;
+            bool ok = py_set_add(THIRD(), TOP());
+            if(!ok) goto __ERROR;
             POP();
             DISPATCH();
         }
@@ -1252,21 +1251,21 @@ const char* pk_op2str(py_Name op) {
     return py_name2str(op);
 }
 
-bool pk_stack_binaryop(VM* self, py_Name op, py_Name rop) {
+bool pk_stack_binaryop(VM* self, py_MagicSlot op, py_MagicSlot rop) {
     // [a, b]
-    py_Ref magic = py_tpfindmagic(SECOND()->type, op);
+    py_Ref magic = pk_tpfindslot(SECOND()->type, op);
     if(magic) {
         bool ok = py_call(magic, 2, SECOND());
         if(!ok) return false;
         if(self->last_retval.type != tp_NotImplementedType) return true;
     }
     // try reverse operation
-    if(rop) {
+    if(rop != PK_SLOT_NONE) {
         // [a, b] -> [b, a]
         py_TValue tmp = *TOP();
         *TOP() = *SECOND();
         *SECOND() = tmp;
-        magic = py_tpfindmagic(SECOND()->type, rop);
+        magic = pk_tpfindslot(SECOND()->type, rop);
         if(magic) {
             bool ok = py_call(magic, 2, SECOND());
             if(!ok) return false;
@@ -1275,19 +1274,19 @@ bool pk_stack_binaryop(VM* self, py_Name op, py_Name rop) {
     }
     // eq/ne op never fails
     bool res = py_isidentical(SECOND(), TOP());
-    if(op == __eq__) {
+    if(op == PK_SLOT__eq__) {
         py_newbool(py_retval(), res);
         return true;
     }
-    if(op == __ne__) {
+    if(op == PK_SLOT__ne__) {
         py_newbool(py_retval(), !res);
         return true;
     }
 
-    py_Type lhs_t = rop ? TOP()->type : SECOND()->type;
-    py_Type rhs_t = rop ? SECOND()->type : TOP()->type;
+    py_Type lhs_t = rop != PK_SLOT_NONE ? TOP()->type : SECOND()->type;
+    py_Type rhs_t = rop != PK_SLOT_NONE ? SECOND()->type : TOP()->type;
     return TypeError("unsupported operand type(s) for '%s': '%t' and '%t'",
-                     pk_op2str(op),
+                     pk_op2str(pk_magicslot_name(op)),
                      lhs_t,
                      rhs_t);
 }
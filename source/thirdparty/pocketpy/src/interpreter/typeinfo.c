@@ -1,16 +1,180 @@
 #include "pocketpy/interpreter/vm.h"
 #include <assert.h>
 
-py_ItemRef pk_tpfindname(py_TypeInfo* ti, py_Name name) {
-    assert(ti != NULL);
+#define FrozenNameDict__MIN_CAPACITY 8
+#define FrozenNameDict__MAX_SEEDS 64
+#define FrozenNameDict__hash(self, key)                                                            \
+    (int)(((uint64_t)(uintptr_t)(key) * (self)->seed) >> (self)->shift)
+
+static uint64_t FrozenNameDict__next_seed(uint64_t seed) {
+    // pcg multiplier, kept odd for multiplicative hashing
+    return (seed * 6364136223846793005ULL + 1442695040888963407ULL) | 1;
+}
+
+static void FrozenNameDict__place(FrozenNameDict* self, py_Name key, py_TValue* value) {
+    int mask = self->capacity - 1;
+    int i = FrozenNameDict__hash(self, key);
+    while(self->items[i].key != NULL) {
+        if(self->items[i].key == key) return;  // shadowed by a subclass
+        i = (i + 1) & mask;
+    }
+    self->items[i].key = key;
+    self->items[i].value = value;
+    self->length++;
+}
+
+/// Try to find a seed under which every key has its own home slot.
+static void FrozenNameDict__make_perfect(FrozenNameDict* self) {
+    FrozenNameDict_KV* kvs = PK_MALLOC(sizeof(FrozenNameDict_KV) * self->length);
+    bool* used = PK_MALLOC(sizeof(bool) * self->capacity);
+    int n = 0;
+    for(int i = 0; i < self->capacity; i++) {
+        if(self->items[i].key != NULL) kvs[n++] = self->items[i];
+    }
+    uint64_t seed = self->seed;
+    for(int attempt = 0; attempt < FrozenNameDict__MAX_SEEDS; attempt++) {
+        FrozenNameDict trial = *self;
+        trial.seed = seed;
+        memset(used, 0, sizeof(bool) * self->capacity);
+        bool ok = true;
+        for(int i = 0; i < n; i++) {
+            int h = FrozenNameDict__hash(&trial, kvs[i].key);
+            if(used[h]) {
+                ok = false;
+                break;
+            }
+            used[h] = true;
+        }
+        if(ok) {
+            self->seed = seed;
+            self->is_perfect = true;
+            memset(self->items, 0, sizeof(FrozenNameDict_KV) * self->capacity);
+            for(int i = 0; i < n; i++) {
+                self->items[FrozenNameDict__hash(self, kvs[i].key)] = kvs[i];
+            }
+            break;
+        }
+        seed = FrozenNameDict__next_seed(seed);
+    }
+    PK_FREE(used);
+    PK_FREE(kvs);
+}
+
+static FrozenNameDict* FrozenNameDict__new(py_TypeInfo* ti) {
+    int upper_bound = 0;
+    for(py_TypeInfo* p = ti; p; p = p->base_ti) {
+        upper_bound += PyObject__dict(p->self._obj)->length;
+    }
+    int capacity = FrozenNameDict__MIN_CAPACITY;
+    int shift = 64 - 3;
+    while(capacity < upper_bound * 2) {
+        capacity *= 2;
+        shift--;
+    }
+    FrozenNameDict* self =
+        PK_MALLOC(sizeof(FrozenNameDict) + sizeof(FrozenNameDict_KV) * capacity);
+    self->length = 0;
+    self->capacity = capacity;
+    self->shift = shift;
+    self->is_perfect = false;
+    self->seed = FrozenNameDict__next_seed(0x9E3779B97F4A7C15ULL);
+    memset(self->items, 0, sizeof(FrozenNameDict_KV) * capacity);
+    // subclass first, so that overridden names are skipped in bases
+    for(py_TypeInfo* p = ti; p; p = p->base_ti) {
+        NameDict* dict = PyObject__dict(p->self._obj);
+        for(int i = 0; i < dict->capacity; i++) {
+            NameDict_KV* kv = &dict->items[i];
+            if(kv->key == NULL) continue;
+            FrozenNameDict__place(self, kv->key, &kv->value);
+        }
+    }
+    FrozenNameDict__make_perfect(self);
+    return self;
+}
+
+static py_TValue* FrozenNameDict__try_get(FrozenNameDict* self, py_Name name) {
+    int mask = self->capacity - 1;
+    int i = FrozenNameDict__hash(self, name);
+    while(true) {
+        FrozenNameDict_KV* kv = &self->items[i];
+        if(kv->key == name) return kv->value;
+        if(kv->key == NULL || self->is_perfect) return NULL;
+        i = (i + 1) & mask;
+    }
+}
+
+/// The nearest type defining `__eq__` decides hashing, see `py_hash`.
+static py_TValue* py_TypeInfo__resolve_hash(py_TypeInfo* ti) {
     do {
-        py_Ref res = py_getdict(&ti->self, name);
-        if(res) return res;
+        py_Ref slot_hash = py_getdict(&ti->self, __hash__);
+        if(slot_hash && py_isnone(slot_hash)) return NULL;
+        if(py_getdict(&ti->self, __eq__)) return slot_hash;
         ti = ti->base_ti;
     } while(ti);
     return NULL;
 }
 
+static FrozenNameDict* py_TypeInfo__freeze(py_TypeInfo* ti) {
+    FrozenNameDict* self = FrozenNameDict__new(ti);
+    ti->frozen_dict = self;
+    for(int i = 0; i < PK_SLOT_COUNT; i++) {
+        ti->magic_slots[i] = FrozenNameDict__try_get(self, pk_magicslot_name(i));
+    }
+    ti->magic_slots[PK_SLOT__hash__] = py_TypeInfo__resolve_hash(ti);
+    return self;
+}
+
+py_ItemRef pk_tpfindname(py_TypeInfo* ti, py_Name name) {
+    assert(ti != NULL);
+    FrozenNameDict* self = ti->frozen_dict;
+    if(self == NULL) self = py_TypeInfo__freeze(ti);
+    return FrozenNameDict__try_get(self, name);
+}
+
+PK_INLINE py_ItemRef pk_tpfindslot(py_Type type, py_MagicSlot slot) {
+    py_TypeInfo* ti = pk_typeinfo(type);
+    if(ti->frozen_dict == NULL) py_TypeInfo__freeze(ti);
+    return ti->magic_slots[slot];
+}
+
+py_Name pk_magicslot_name(py_MagicSlot slot) {
+    switch(slot) {
+#define MAGIC_SLOT(x)                                                                              \
+    case PK_SLOT##x: return x;
+#include "pocketpy/xmacros/magicslots.h"
+#undef MAGIC_SLOT
+        default: c11__unreachable();
+    }
+}
+
+py_MagicSlot pk_magicslot(py_Name name) {
+#define MAGIC_SLOT(x)                                                                              \
+    if(name == x) return PK_SLOT##x;
+#include "pocketpy/xmacros/magicslots.h"
+#undef MAGIC_SLOT
+    return PK_SLOT_NONE;
+}
+
+void py_TypeInfo__invalidate(py_TypeInfo* ti) {
+    if(ti->frozen_dict) {
+        PK_FREE(ti->frozen_dict);
+        ti->frozen_dict = NULL;
+    }
+    if(!ti->is_base) return;
+    // subclasses have flattened our names into their own frozen dicts
+    c11_vector* types = &pk_current_vm->types;
+    for(py_Type i = 1; i < types->length; i++) {
+        py_TypeInfo* sub = c11__getitem(TypePointer, types, i).ti;
+        if(sub->frozen_dict == NULL) continue;
+        for(py_TypeInfo* p = sub->base_ti; p; p = p->base_ti) {
+            if(p != ti) continue;
+            PK_FREE(sub->frozen_dict);
+            sub->frozen_dict = NULL;
+            break;
+        }
+    }
+}
+
 PK_INLINE py_TypeInfo* pk_typeinfo(py_Type type) {
 #ifndef NDEBUG
     int length = pk_current_vm->types.length;
@@ -46,11 +210,14 @@ static void py_TypeInfo__common_init(py_Name name,
     if(!dtor && base) dtor = base_ti->dtor;
     self->is_python = is_python;
     self->is_final = is_final;
+    self->frozen_dict = NULL;
+    if(base_ti) base_ti->is_base = true;
 
     self->getattribute = NULL;
     self->setattribute = NULL;
     self->delattribute = NULL;
     self->getunboundmethod = NULL;
+    self->getbuffer = base_ti ? base_ti->getbuffer : NULL;
 
     self->annotations = *py_NIL();
     self->dtor = dtor;
@@ -65,6 +232,8 @@ py_Type pk_newtype(const char* name,
                    bool is_final) {
     py_Type index = pk_current_vm->types.length;
     py_TypeInfo* self = py_newobject(py_retval(), tp_type, -1, sizeof(py_TypeInfo));
+    // not reset by `py_TypeInfo__common_init`, subclasses survive RELOAD_MODE
+    self->is_base = false;
     py_TypeInfo__common_init(py_name(name),
                              base,
                              index,
@@ -116,3 +285,6 @@ py_Type pk_newtypewithmode(py_Name name,
     return pk_newtype(py_name2str(name), base, module, dtor, is_python, is_final);
 }
 
+#undef FrozenNameDict__MIN_CAPACITY
+#undef FrozenNameDict__MAX_SEEDS
+#undef FrozenNameDict__hash
@@ -159,6 +159,8 @@ void VM__ctor(VM* self) {
 
     validate(tp_dict, pk_dict__register());
     validate(tp_dict_iterator, pk_dict_items__register());
+    validate(tp_set, pk_set__register());
+    validate(tp_frozenset, pk_frozenset__register());
 
     validate(tp_property, pk_property__register());
     validate(tp_star_wrapper, pk_newtype("star_wrapper", tp_object, NULL, NULL, false, true));
@@ -222,6 +224,8 @@ void VM__ctor(VM* self) {
         tp_range,
         tp_bytes,
         tp_dict,
+        tp_set,
+        tp_frozenset,
         tp_property,
         tp_staticmethod,
         tp_classmethod,
@@ -240,6 +244,15 @@ void VM__ctor(VM* self) {
     pk__add_module_vmath();
     pk__add_module_array2d();
     pk__add_module_colorcvt();
+    pk__add_module_collections();
+    pk__add_module_heapq();
+    pk__add_module_bisect();
+    pk__add_module_functools();
+    pk__add_module_itertools();
+    pk__add_module_array();
+
+    py_setdict(self->builtins, py_name("memoryview"), py_tpobject(pk_memoryview__register()));
+    py_setdict(self->builtins, py_name("bytearray"), py_tpobject(pk_bytearray__register()));
 
     // add modules
     pk__add_module_os();
@@ -257,6 +270,7 @@ void VM__ctor(VM* self) {
     pk__add_module_inspect();
     pk__add_module_pickle();
     pk__add_module_base64();
+    pk__add_module_struct();
     pk__add_module_importlib();
     pk__add_module_unicodedata();
 
@@ -284,6 +298,11 @@ void VM__dtor(VM* self) {
     // reset traceinfo
     py_sys_settrace(NULL, true);
     LineProfiler__dtor(&self->line_profiler);
+    // free frozen type dicts, type objects have no dtor
+    for(py_Type i = 1; i < self->types.length; i++) {
+        py_TypeInfo* ti = c11__getitem(TypePointer, &self->types, i).ti;
+        PK_FREE(ti->frozen_dict);
+    }
     // destroy all objects
     ManagedHeap__dtor(&self->heap);
     // clear frames
@@ -482,6 +501,18 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
         // [unbound, self, args..., kwargs...]
     }
 
+    // functools callables work on the raw stack layout
+    if(p0->type == tp_partial) {
+        // [func, NULL, args..., kwargs...]
+        if(!pk_partial__unpack(p0, &argc, &kwargc)) return RES_ERROR;
+        return VM__vectorcall(self, argc, kwargc, opcall);
+    }
+    if(p0->type == tp_lru_cache_wrapper) {
+        bool ok = pk_lru_cache__call(p0, argc, kwargc);
+        self->stack.sp = p0;
+        return ok ? RES_RETURN : RES_ERROR;
+    }
+
     py_Ref argv = p0 + 1 + (int)py_isnil(p0 + 1);
 
     if(p0->type == tp_function) {
@@ -567,7 +598,7 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
 
     if(p0->type == tp_type) {
         // [cls, NULL, args..., kwargs...]
-        py_Ref new_f = py_tpfindmagic(py_totype(p0), __new__);
+        py_Ref new_f = pk_tpfindslot(py_totype(p0), PK_SLOT__new__);
         assert(new_f && py_isnil(p0 + 1));
 
         // prepare a copy of args and kwargs
@@ -584,7 +615,7 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
         // NOTE: previously we use `get_unbound_method` but here we just use `tpfindmagic`
         // >> [cls, NULL, args..., kwargs...]
         // >> py_retval() is the new instance
-        py_Ref init_f = py_tpfindmagic(py_totype(p0), __init__);
+        py_Ref init_f = pk_tpfindslot(py_totype(p0), PK_SLOT__init__);
         if(init_f) {
             // do an inplace patch
             *p0 = *init_f;              // __init__
@@ -697,7 +728,11 @@ void ManagedHeap__mark(ManagedHeap* self) {
         }
 
         void* ud = PyObject__userdata(obj);
-        switch(obj->type) {
+        // instances of user subclasses carry the userdata of their builtin base
+        py_Type type = obj->type;
+        while(type > tp_lru_cache_wrapper)
+            type = pk_typeinfo(type)->base;
+        switch(type) {
             case tp_list: {
                 List* self = ud;
                 for(int i = 0; i < self->length; i++) {
@@ -706,7 +741,9 @@ void ManagedHeap__mark(ManagedHeap* self) {
                 }
                 break;
             }
-            case tp_dict: {
+            case tp_dict:
+            case tp_set:
+            case tp_frozenset: {
                 Dict* self = ud;
                 for(int i = 0; i < self->entries.length; i++) {
                     DictEntry* entry = c11__at(DictEntry, &self->entries, i);
@@ -744,6 +781,14 @@ void ManagedHeap__mark(ManagedHeap* self) {
                 c11_chunked_array2d__mark(ud, p_stack);
                 break;
             }
+            case tp_deque: {
+                c11_deque__mark(ud, p_stack);
+                break;
+            }
+            case tp_lru_cache_wrapper: {
+                c11_lru_cache__mark(ud, p_stack);
+                break;
+            }
         }
     }
 }
@@ -0,0 +1,350 @@
+#include "pocketpy/interpreter/vm.h"
+#include "pocketpy/interpreter/typeinfo.h"
+#include "pocketpy/objects/codeobject.h"
+#include "pocketpy/common/smallmap.h"
+#include "pocketpy/pocketpy.h"
+
+#include <string.h>
+
+// Objects of one VM are allocated on its own heap and code objects keep their constants there,
+// so nothing can be shared by pointer. A clone instead repeats the work of C initialization
+// (native modules and types, which keep their indices) and imports the same source modules.
+// Data is copied value by value, anything without a direct copy goes through pickle.
+
+typedef struct VMCloner {
+    VM* src;
+    py_Type n_ctor_types;    // types created by `VM__ctor`, identical in both VMs
+    c11_smallmap_p2i memo;   // object of `src` -> index in `objects`
+    py_Ref objects;          // list keeping the copies alive
+} VMCloner;
+
+static bool VMCloner__clone(VMCloner* self, py_Ref val, py_OutRef out);
+
+static py_TypeInfo* VMCloner__ti(VMCloner* self, py_Type type) {
+    return c11__getitem(TypePointer, &self->src->types, type).ti;
+}
+
+static void VMCloner__memo(VMCloner* self, PyObject* key, py_Ref val) {
+    c11_smallmap_p2i__set(&self->memo, key, py_list_len(self->objects));
+    py_list_append(self->objects, val);
+}
+
+static py_GlobalRef VMCloner__module(py_GlobalRef src_module) {
+    py_ModuleInfo* mi = py_touserdata(src_module);
+    const char* path = mi->path->data;
+    py_GlobalRef mod = py_getmodule(path);
+    if(mod) return mod;
+    int res = py_import(path);
+    if(res == -1) return NULL;
+    if(res == 0) {
+        ImportError("cannot clone module '%s'", path);
+        return NULL;
+    }
+    return py_getmodule(path);
+}
+
+static bool VMCloner__type(VMCloner* self, py_Type type, py_Type* out) {
+    py_TypeInfo* ti = VMCloner__ti(self, type);
+    if(!ti->is_python) {
+        // native types keep their indices
+        *out = type;
+        return true;
+    }
+    const char* name = py_name2str(ti->name);
+    if(ti->module == NULL) return TypeError("cannot clone type '%s'", name);
+    py_GlobalRef mod = VMCloner__module(ti->module);
+    if(!mod) return false;
+    py_ItemRef cls = py_getdict(mod, ti->name);
+    if(cls == NULL || !py_istype(cls, tp_type)) {
+        // nested classes and classes of `__main__` cannot be found by name
+        return TypeError("cannot clone type '%s'", name);
+    }
+    *out = py_totype(cls);
+    return true;
+}
+
+static bool VMCloner__function(VMCloner* self, py_Ref val, py_OutRef out) {
+    Function* ud = py_touserdata(val);
+    PyObject* obj = val->_obj;
+    const char* name = ud->decl->code.name->data;
+    if(ud->cfunc) {
+        // compiled by `py_newfunction()`, the source is "def <sig>: pass"
+        c11_sv src = c11_string__sv(ud->decl->code.src->source);
+        c11_sv sig = c11_sv__slice2(src, 4, src.size - 6);
+        c11_string* sig_str = c11_string__new2(sig.data, sig.size);
+        py_newfunction(out, sig_str->data, ud->cfunc, ud->decl->docstring, obj->slots);
+        c11_string__delete(sig_str);
+        VMCloner__memo(self, obj, out);
+        for(int i = 0; i < obj->slots; i++) {
+            if(!VMCloner__clone(self, py_getslot(val, i), py_getslot(out, i))) return false;
+        }
+        return true;
+    }
+    // python functions are defined again by their module
+    py_ItemRef res = NULL;
+    if(ud->clazz) {
+        py_Type type;
+        if(!VMCloner__type(self, ((py_TypeInfo*)PyObject__userdata(ud->clazz))->index, &type)) {
+            return false;
+        }
+        res = py_getdict(py_tpobject(type), py_name(name));
+    } else if(ud->module) {
+        py_GlobalRef mod = VMCloner__module(ud->module);
+        if(!mod) return false;
+        res = py_getdict(mod, py_name(name));
+    }
+    if(res == NULL || !py_istype(res, tp_function)) {
+        return TypeError("cannot clone function '%s'", name);
+    }
+    *out = *res;
+    return true;
+}
+
+typedef struct VMClonerInto {
+    VMCloner* cloner;
+    py_Ref dst;
+    py_GlobalRef src_main;  // skip code defined in `__main__`, or NULL
+} VMClonerInto;
+
+static bool VMCloner__dict_item(py_Ref key, py_Ref val, void* ctx) {
+    VMClonerInto* into = ctx;
+    py_StackRef p = py_pushtmp();
+    py_pushnil();
+    bool ok = VMCloner__clone(into->cloner, key, p) && VMCloner__clone(into->cloner, val, p + 1);
+    if(ok) ok = py_dict_setitem(into->dst, p, p + 1);
+    py_shrink(2);
+    return ok;
+}
+
+static bool VMCloner__attr(py_Name name, py_Ref val, void* ctx) {
+    VMClonerInto* into = ctx;
+    // names already defined in the new VM are kept
+    if(py_getdict(into->dst, name)) return true;
+    if(into->src_main) {
+        if(py_istype(val, tp_function)) {
+            Function* ud = py_touserdata(val);
+            if(ud->module == into->src_main) return true;
+        } else if(py_istype(val, tp_type)) {
+            py_TypeInfo* ti = py_touserdata(val);
+            if(ti->module == into->src_main) return true;
+        }
+    }
+    py_StackRef p = py_pushtmp();
+    bool ok = VMCloner__clone(into->cloner, val, p);
+    if(ok) py_setdict(into->dst, name, p);
+    py_pop();
+    return ok;
+}
+
+static bool VMCloner__pickle(VMCloner* self, py_Ref val, py_OutRef out) {
+    VM* dst = pk_current_vm;
+    pk_current_vm = self->src;
+    bool ok = py_pickle_dumps(val);
+    unsigned char* data = NULL;
+    int size = 0;
+    if(ok) {
+        unsigned char* p = py_tobytes(py_retval(), &size);
+        data = PK_MALLOC(size);
+        memcpy(data, p, size);
+    } else {
+        py_clearexc(NULL);
+    }
+    pk_current_vm = dst;
+    if(!ok) {
+        const char* name = py_name2str(VMCloner__ti(self, val->type)->name);
+        return TypeError("cannot clone '%s' object", name);
+    }
+    ok = py_pickle_loads(data, size);
+    PK_FREE(data);
+    if(!ok) return false;
+    *out = *py_retval();
+    VMCloner__memo(self, val->_obj, out);
+    return true;
+}
+
+static bool VMCloner__clone(VMCloner* self, py_Ref val, py_OutRef out) {
+    if(!val->is_ptr) {
+        *out = *val;
+        if(val->type < self->n_ctor_types) return true;
+        return VMCloner__type(self, val->type, &out->type);
+    }
+    PyObject* obj = val->_obj;
+    int index = c11_smallmap_p2i__get(&self->memo, obj, -1);
+    if(index != -1) {
+        *out = *py_list_getitem(self->objects, index);
+        return true;
+    }
+    switch(val->type) {
+        case tp_str: {
+            py_newstrv(out, py_tosv(val));
+            return true;
+        }
+        case tp_bytes: {
+            int size;
+            unsigned char* data = py_tobytes(val, &size);
+            memcpy(py_newbytes(out, size), data, size);
+            return true;
+        }
+        case tp_type: {
+            py_Type type;
+            if(!VMCloner__type(self, py_totype(val), &type)) return false;
+            *out = *py_tpobject(type);
+            return true;
+        }
+        case tp_module: {
+            py_GlobalRef mod = VMCloner__module(val);
+            if(!mod) return false;
+            *out = *mod;
+            return true;
+        }
+        case tp_function: return VMCloner__function(self, val, out);
+        case tp_tuple: {
+            int length = py_tuple_len(val);
+            py_newtuple(out, length);
+            VMCloner__memo(self, obj, out);
+            for(int i = 0; i < length; i++) {
+                if(!VMCloner__clone(self, py_tuple_getitem(val, i), py_tuple_getitem(out, i))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case tp_list: {
+            py_newlist(out);
+            VMCloner__memo(self, obj, out);
+            py_StackRef item = py_pushtmp();
+            for(int i = 0; i < py_list_len(val); i++) {
+                if(!VMCloner__clone(self, py_list_getitem(val, i), item)) return false;
+                py_list_append(out, item);
+            }
+            py_pop();
+            return true;
+        }
+        case tp_dict: {
+            py_newdict(out);
+            VMCloner__memo(self, obj, out);
+            VMClonerInto into = {self, out, NULL};
+            return py_dict_apply(val, VMCloner__dict_item, &into);
+        }
+        case tp_boundmethod:
+        case tp_property:
+        case tp_staticmethod:
+        case tp_classmethod:
+        case tp_slice: {
+            py_newobject(out, val->type, obj->slots, 0);
+            VMCloner__memo(self, obj, out);
+            for(int i = 0; i < obj->slots; i++) {
+                if(!VMCloner__clone(self, py_getslot(val, i), py_getslot(out, i))) return false;
+            }
+            return true;
+        }
+        default: break;
+    }
+    // instances of pure python classes are a `__dict__`
+    py_TypeInfo* ti = VMCloner__ti(self, val->type);
+    bool is_pure = ti->is_python && obj->slots == -1;
+    for(py_TypeInfo* p = ti; is_pure && p->index != tp_object; p = p->base_ti) {
+        is_pure = p->is_python;
+    }
+    if(!is_pure) return VMCloner__pickle(self, val, out);
+    py_Type type;
+    if(!VMCloner__type(self, val->type, &type)) return false;
+    py_newobject(out, type, -1, 0);
+    VMCloner__memo(self, obj, out);
+    VMClonerInto into = {self, out, NULL};
+    return py_applydict(val, VMCloner__attr, &into);
+}
+
+static void VMCloner__collect_modules(BinTree* node, c11_vector* out) {
+    if(node == NULL) return;
+    VMCloner__collect_modules(node->left, out);
+    // the root node is a placeholder
+    if(!py_isnil(&node->value)) c11_vector__push(py_Ref, out, &node->value);
+    VMCloner__collect_modules(node->right, out);
+}
+
+static bool VMCloner__run(VMCloner* self, c11_vector* modules) {
+    VM* src = self->src;
+    // native modules, created empty so that native types can refer to them
+    c11__foreach(py_Ref, modules, mod) {
+        py_ModuleInfo* mi = py_touserdata(*mod);
+        if(mi->is_source || *mod == src->main) continue;
+        if(!py_getmodule(mi->path->data)) py_newmodule(mi->path->data);
+    }
+    // native types, in the same order to keep their indices
+    int n_native_types = self->n_ctor_types;
+    while(n_native_types < src->types.length) {
+        py_TypeInfo* ti = VMCloner__ti(self, n_native_types);
+        if(ti->is_python) break;
+        py_GlobalRef mod = NULL;
+        if(ti->module) mod = py_getmodule(((py_ModuleInfo*)py_touserdata(ti->module))->path->data);
+        py_Type type = pk_newtype(py_name2str(ti->name), ti->base, mod, ti->dtor, false, ti->is_final);
+        c11__rtassert(type == n_native_types);
+        py_TypeInfo* dst_ti = pk_typeinfo(type);
+        dst_ti->is_base = ti->is_base;
+        dst_ti->getattribute = ti->getattribute;
+        dst_ti->setattribute = ti->setattribute;
+        dst_ti->delattribute = ti->delattribute;
+        dst_ti->getunboundmethod = ti->getunboundmethod;
+        dst_ti->getbuffer = ti->getbuffer;
+        dst_ti->on_end_subclass = ti->on_end_subclass;
+        n_native_types++;
+    }
+    for(int i = n_native_types; i < src->types.length; i++) {
+        py_TypeInfo* ti = VMCloner__ti(self, i);
+        if(!ti->is_python) {
+            return RuntimeError("cannot clone native type '%s' created after a python class",
+                                py_name2str(ti->name));
+        }
+    }
+    // attributes of native types and modules
+    for(int i = 1; i < n_native_types; i++) {
+        py_TypeInfo* ti = VMCloner__ti(self, i);
+        VMClonerInto into = {self, py_tpobject(i), NULL};
+        if(!py_applydict(&ti->self, VMCloner__attr, &into)) return false;
+        if(i >= self->n_ctor_types && !py_isnil(&ti->annotations)) {
+            if(!VMCloner__clone(self, &ti->annotations, &pk_typeinfo(i)->annotations)) {
+                return false;
+            }
+        }
+    }
+    c11__foreach(py_Ref, modules, mod) {
+        py_ModuleInfo* mi = py_touserdata(*mod);
+        if(mi->is_source || *mod == src->main) continue;
+        VMClonerInto into = {self, py_getmodule(mi->path->data), NULL};
+        if(!py_applydict(*mod, VMCloner__attr, &into)) return false;
+    }
+    // source modules run again, then the data of `__main__` is copied
+    c11__foreach(py_Ref, modules, mod) {
+        py_ModuleInfo* mi = py_touserdata(*mod);
+        if(!mi->is_source || py_getmodule(mi->path->data)) continue;
+        if(!VMCloner__module(*mod)) return false;
+    }
+    VMClonerInto into = {self, pk_current_vm->main, src->main};
+    return py_applydict(src->main, VMCloner__attr, &into);
+}
+
+bool VM__clone(VM* self, VM* src) {
+    assert(self == pk_current_vm);
+    self->callbacks = src->callbacks;
+    self->ctx = src->ctx;
+    self->max_recursion_depth = src->max_recursion_depth;
+
+    VMCloner cloner;
+    cloner.src = src;
+    cloner.n_ctor_types = self->types.length;
+    c11__rtassert(src->types.length >= cloner.n_ctor_types);
+    c11_smallmap_p2i__ctor(&cloner.memo);
+    cloner.objects = py_pushtmp();
+    py_newlist(cloner.objects);
+
+    c11_vector modules;
+    c11_vector__ctor(&modules, sizeof(py_Ref));
+    VMCloner__collect_modules(&src->modules, &modules);
+    bool ok = VMCloner__run(&cloner, &modules);
+    c11_vector__dtor(&modules);
+
+    c11_smallmap_p2i__dtor(&cloner.memo);
+    py_pop();
+    return ok;
+}
@@ -0,0 +1,893 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/sstream.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* `array` stores its items unboxed in a `c11_vector` whose `elem_size` is the item size of the
+ * typecode. Arithmetic operators are element-wise, not concatenation/repetition as in CPython:
+ * integer arrays wrap around like C integers and division always yields floats.
+ */
+
+typedef struct {
+    char typecode;
+    c11_vector data;
+} c11_array;
+
+typedef struct {
+    int index;
+} c11_array_iterator;
+
+#define Array__SWITCH(typecode, CASE)                                                              \
+    switch(typecode) {                                                                             \
+        case 'b': CASE(int8_t); break;                                                             \
+        case 'h': CASE(int16_t); break;                                                            \
+        case 'i': CASE(int32_t); break;                                                            \
+        case 'q': CASE(int64_t); break;                                                            \
+        case 'f': CASE(float); break;                                                              \
+        case 'd': CASE(double); break;                                                             \
+        default: c11__unreachable();                                                               \
+    }
+
+enum { Array__ADD, Array__SUB, Array__MUL, Array__DIV };
+
+PK_INLINE static bool Array__isfloat(char typecode) { return typecode == 'f' || typecode == 'd'; }
+
+PK_INLINE static void* Array__at(c11_array* self, int i) {
+    return (char*)self->data.data + (size_t)i * self->data.elem_size;
+}
+
+static void c11_array__dtor(void* ud) {
+    c11_array* self = ud;
+    c11_vector__dtor(&self->data);
+}
+
+static c11_array* c11_array__new(py_OutRef out, py_Type type, char typecode, int length) {
+    c11_array* self = py_newobject(out, type, 0, sizeof(c11_array));
+    self->typecode = typecode;
+    c11_vector__ctor(&self->data, pk__format_itemsize(typecode));
+    if(length > 0) c11_vector__reserve(&self->data, length);
+    self->data.length = length;
+    return self;
+}
+
+/// Resize to `length` items, growing the capacity geometrically.
+static void c11_array__resize(c11_array* self, int length) {
+    if(length > self->data.capacity) {
+        c11_vector__reserve(&self->data, c11__max(c11_vector__nextcap(&self->data), length));
+    }
+    self->data.length = length;
+}
+
+static void c11_array__getitem(c11_array* self, int i, py_OutRef out) {
+    pk__unpack_item(self->typecode, Array__at(self, i), out);
+}
+
+static bool c11_array__setitem(c11_array* self, int i, py_Ref val) {
+    return pk__pack_item(self->typecode, Array__at(self, i), val);
+}
+
+static bool c11_array__append(c11_array* self, py_Ref val) {
+    int length = self->data.length;
+    c11_array__resize(self, length + 1);
+    if(!c11_array__setitem(self, length, val)) {
+        self->data.length = length;
+        return false;
+    }
+    return true;
+}
+
+static bool c11_array__frombytes(c11_array* self, const unsigned char* data, int size) {
+    int itemsize = self->data.elem_size;
+    if(size % itemsize != 0) return ValueError("bytes length not a multiple of item size");
+    int length = self->data.length;
+    c11_array__resize(self, length + size / itemsize);
+    if(size > 0) memcpy(Array__at(self, length), data, size);
+    return true;
+}
+
+/// Append all items of `iterable`. On error, the items appended so far are kept.
+static bool c11_array__extend(c11_array* self, py_Ref iterable) {
+    py_TValue* p;
+    int length = pk_arrayview(iterable, &p);
+    if(length != -1) {
+        int start = self->data.length;
+        c11_array__resize(self, start + length);
+        for(int i = 0; i < length; i++) {
+            if(!c11_array__setitem(self, start + i, p + i)) {
+                self->data.length = start + i;
+                return false;
+            }
+        }
+        return true;
+    }
+    if(!py_iter(iterable)) return false;
+    py_Ref it = py_pushtmp();
+    py_assign(it, py_retval());
+    while(true) {
+        int res = py_next(it);
+        if(res == -1) return false;
+        if(res == 0) break;
+        if(!c11_array__append(self, py_retval())) return false;
+    }
+    py_pop();
+    return true;
+}
+
+/// -1: error, 0: false, 1: true
+static int c11_array__contains_at(c11_array* self, int i, py_Ref val) {
+    py_TValue item;
+    c11_array__getitem(self, i, &item);
+    return py_equal(&item, val);
+}
+
+/* arithmetic */
+
+/// Convert the items of `src` into a float buffer `dst` of `typecode` ('f' or 'd').
+static void Array__tofloat(c11_array* src, char typecode, void* dst) {
+    int n = src->data.length;
+#define CASE(T)                                                                                    \
+    if(typecode == 'f') {                                                                          \
+        for(int i = 0; i < n; i++)                                                                 \
+            ((float*)dst)[i] = (float)((T*)src->data.data)[i];                                     \
+    } else {                                                                                       \
+        for(int i = 0; i < n; i++)                                                                 \
+            ((double*)dst)[i] = (double)((T*)src->data.data)[i];                                   \
+    }
+    Array__SWITCH(src->typecode, CASE)
+#undef CASE
+}
+
+/// Apply `dst[i] = dst[i] op rhs[i]` (or `rhs[i] op dst[i]` if `reflected`) in place.
+/// `rhs` is NULL for a scalar operand, which is `iscalar` or `fscalar` by the typecode.
+static void Array__kernel(char typecode, void* dst_, const void* rhs_, int n, int op,
+                          bool reflected, py_i64 iscalar, py_f64 fscalar) {
+    // integers are computed in uint64_t so that they wrap around instead of overflowing
+#define LOOP(T, EXPR)                                                                              \
+    do {                                                                                           \
+        T* dst = dst_;                                                                             \
+        if(rhs_) {                                                                                 \
+            const T* rhs = rhs_;                                                                   \
+            for(int i = 0; i < n; i++) {                                                           \
+                T x = dst[i], y = rhs[i];                                                          \
+                dst[i] = (EXPR);                                                                   \
+            }                                                                                      \
+        } else {                                                                                   \
+            T y = Array__isfloat(typecode) ? (T)fscalar : (T)iscalar;                              \
+            for(int i = 0; i < n; i++) {                                                           \
+                T x = dst[i];                                                                      \
+                dst[i] = (EXPR);                                                                   \
+            }                                                                                      \
+        }                                                                                          \
+    } while(0)
+#define INT_CASE(T)                                                                                \
+    switch(op) {                                                                                   \
+        case Array__ADD: LOOP(T, (T)((uint64_t)x + (uint64_t)y)); break;                           \
+        case Array__SUB:                                                                           \
+            if(reflected) {                                                                        \
+                LOOP(T, (T)((uint64_t)y - (uint64_t)x));                                           \
+            } else {                                                                               \
+                LOOP(T, (T)((uint64_t)x - (uint64_t)y));                                           \
+            }                                                                                      \
+            break;                                                                                 \
+        case Array__MUL: LOOP(T, (T)((uint64_t)x * (uint64_t)y)); break;                           \
+        default: c11__unreachable();                                                               \
+    }
+#define FLOAT_CASE(T)                                                                              \
+    switch(op) {                                                                                   \
+        case Array__ADD: LOOP(T, x + y); break;                                                    \
+        case Array__SUB:                                                                           \
+            if(reflected) {                                                                        \
+                LOOP(T, y - x);                                                                    \
+            } else {                                                                               \
+                LOOP(T, x - y);                                                                    \
+            }                                                                                      \
+            break;                                                                                 \
+        case Array__MUL: LOOP(T, x * y); break;                                                    \
+        case Array__DIV:                                                                           \
+            if(reflected) {                                                                        \
+                LOOP(T, y / x);                                                                    \
+            } else {                                                                               \
+                LOOP(T, x / y);                                                                    \
+            }                                                                                      \
+            break;                                                                                 \
+        default: c11__unreachable();                                                               \
+    }
+    switch(typecode) {
+        case 'b': INT_CASE(int8_t); break;
+        case 'h': INT_CASE(int16_t); break;
+        case 'i': INT_CASE(int32_t); break;
+        case 'q': INT_CASE(int64_t); break;
+        case 'f': FLOAT_CASE(float); break;
+        case 'd': FLOAT_CASE(double); break;
+        default: c11__unreachable();
+    }
+#undef LOOP
+#undef INT_CASE
+#undef FLOAT_CASE
+}
+
+static bool Array__binop(py_Ref argv, int op, bool reflected) {
+    c11_array* self = py_touserdata(&argv[0]);
+    py_Ref other = &argv[1];
+    c11_array* rhs = NULL;
+    bool float_result = op == Array__DIV || Array__isfloat(self->typecode);
+    if(py_typeof(other) == py_typeof(&argv[0])) {
+        rhs = py_touserdata(other);
+        if(rhs->typecode != self->typecode) {
+            return TypeError("array typecodes differ: '%c' and '%c'",
+                             self->typecode,
+                             rhs->typecode);
+        }
+        if(rhs->data.length != self->data.length) {
+            return ValueError("array lengths differ: %d and %d",
+                              self->data.length,
+                              rhs->data.length);
+        }
+    } else if(py_isfloat(other)) {
+        float_result = true;
+    } else if(!py_isint(other)) {
+        py_newnotimplemented(py_retval());
+        return true;
+    }
+
+    int n = self->data.length;
+    char typecode = float_result && !Array__isfloat(self->typecode) ? 'd' : self->typecode;
+    c11_array* res = c11_array__new(py_retval(), py_typeof(&argv[0]), typecode, n);
+    const void* rhs_data = NULL;
+    void* tmp = NULL;
+    if(typecode == self->typecode) {
+        if(n > 0) memcpy(res->data.data, self->data.data, (size_t)n * res->data.elem_size);
+        if(rhs) rhs_data = rhs->data.data;
+    } else {
+        Array__tofloat(self, typecode, res->data.data);
+        if(rhs) {
+            tmp = PK_MALLOC((size_t)n * res->data.elem_size);
+            Array__tofloat(rhs, typecode, tmp);
+            rhs_data = tmp;
+        }
+    }
+    py_i64 iscalar = py_isint(other) ? py_toint(other) : 0;
+    py_f64 fscalar = 0;
+    if(!rhs) fscalar = py_isint(other) ? (py_f64)py_toint(other) : py_tofloat(other);
+    Array__kernel(typecode, res->data.data, rhs_data, n, op, reflected, iscalar, fscalar);
+    PK_FREE(tmp);
+    return true;
+}
+
+#define DEF_BINOP(name, op, reflected)                                                             \
+    static bool array##name(int argc, py_Ref argv) {                                               \
+        PY_CHECK_ARGC(2);                                                                          \
+        return Array__binop(argv, op, reflected);                                                  \
+    }
+
+DEF_BINOP(__add__, Array__ADD, false)
+DEF_BINOP(__sub__, Array__SUB, false)
+DEF_BINOP(__mul__, Array__MUL, false)
+DEF_BINOP(__truediv__, Array__DIV, false)
+DEF_BINOP(__radd__, Array__ADD, true)
+DEF_BINOP(__rsub__, Array__SUB, true)
+DEF_BINOP(__rmul__, Array__MUL, true)
+DEF_BINOP(__rtruediv__, Array__DIV, true)
+
+#undef DEF_BINOP
+
+static bool array__neg__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    // multiplying by -1 wraps integers and keeps the sign of zero for floats
+    py_Ref args = py_pushtmp();
+    py_pushtmp();
+    py_assign(&args[0], argv);
+    py_newint(&args[1], -1);
+    bool ok = Array__binop(args, Array__MUL, false);
+    py_shrink(2);
+    return ok;
+}
+
+/* python bindings */
+
+static bool array__getbuffer(py_Ref self, py_Buffer* out, bool writable) {
+    c11_array* ud = py_touserdata(self);
+    out->data = ud->data.data;
+    out->size = ud->data.length * ud->data.elem_size;
+    out->itemsize = ud->data.elem_size;
+    out->format = ud->typecode;
+    out->readonly = false;
+    return true;
+}
+
+static bool array__new__(int argc, py_Ref argv) {
+    // __new__(cls, typecode, initializer=None)
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    c11_sv typecode = py_tosv(py_arg(1));
+    char tc = typecode.size == 1 ? typecode.data[0] : '\0';
+    // 'B' is a valid buffer format, but arrays do not support it
+    if(tc == 'B' || pk__format_itemsize(tc) == 0) {
+        return ValueError("bad typecode (must be b, h, i, q, f or d)");
+    }
+    py_Ref out = py_pushtmp();
+    c11_array* self = c11_array__new(out, py_totype(argv), tc, 0);
+    py_Ref init = py_arg(2);
+    if(py_istype(init, tp_bytes)) {
+        int size;
+        unsigned char* data = py_tobytes(init, &size);
+        if(!c11_array__frombytes(self, data, size)) return false;
+    } else if(py_isstr(init)) {
+        return TypeError("cannot use a str to initialize an array with typecode '%c'",
+                         self->typecode);
+    } else if(py_typeof(init) == py_totype(argv) &&
+              ((c11_array*)py_touserdata(init))->typecode == self->typecode) {
+        c11_array* other = py_touserdata(init);
+        c11_array__resize(self, other->data.length);
+        if(other->data.length > 0) {
+            memcpy(self->data.data,
+                   other->data.data,
+                   (size_t)other->data.length * other->data.elem_size);
+        }
+    } else if(!py_isnone(init)) {
+        if(!c11_array__extend(self, init)) return false;
+    }
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool array__len__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array* self = py_touserdata(argv);
+    py_newint(py_retval(), self->data.length);
+    return true;
+}
+
+/// Number of items in a normalized slice.
+static int Array__slicelength(int start, int stop, int step) {
+    if(step > 0) return stop > start ? (stop - start + step - 1) / step : 0;
+    return start > stop ? (start - stop - step - 1) / -step : 0;
+}
+
+static bool array__getitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_array* self = py_touserdata(argv);
+    py_Ref key = py_arg(1);
+    if(py_isint(key)) {
+        int index = py_toint(key);
+        if(!pk__normalize_index(&index, self->data.length)) return false;
+        c11_array__getitem(self, index, py_retval());
+        return true;
+    }
+    if(!py_istype(key, tp_slice)) return TypeError("array indices must be integers");
+    int start, stop, step;
+    if(!pk__parse_int_slice(key, self->data.length, &start, &stop, &step)) return false;
+    int n = Array__slicelength(start, stop, step);
+    c11_array* res = c11_array__new(py_retval(), py_typeof(argv), self->typecode, n);
+    int itemsize = self->data.elem_size;
+    if(step == 1) {
+        if(n > 0) memcpy(res->data.data, Array__at(self, start), (size_t)n * itemsize);
+    } else {
+        for(int i = 0; i < n; i++) {
+            memcpy(Array__at(res, i), Array__at(self, start + i * step), itemsize);
+        }
+    }
+    return true;
+}
+
+static bool array__setitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    c11_array* self = py_touserdata(argv);
+    py_Ref key = py_arg(1);
+    if(py_isint(key)) {
+        int index = py_toint(key);
+        if(!pk__normalize_index(&index, self->data.length)) return false;
+        if(!c11_array__setitem(self, index, py_arg(2))) return false;
+        py_newnone(py_retval());
+        return true;
+    }
+    if(!py_istype(key, tp_slice)) return TypeError("array indices must be integers");
+    if(py_typeof(py_arg(2)) != py_typeof(argv)) {
+        return TypeError("can only assign array (not \"%t\") to array slice", py_arg(2)->type);
+    }
+    c11_array* value = py_touserdata(py_arg(2));
+    if(value->typecode != self->typecode) {
+        return TypeError("bad argument type for built-in operation");
+    }
+    int start, stop, step;
+    if(!pk__parse_int_slice(key, self->data.length, &start, &stop, &step)) return false;
+    int n = Array__slicelength(start, stop, step);
+    int itemsize = self->data.elem_size;
+    int m = value->data.length;
+    // `value` may be `self`, so its items are copied out first
+    void* src = PK_MALLOC((size_t)m * itemsize + 1);
+    if(m > 0) memcpy(src, value->data.data, (size_t)m * itemsize);
+    if(step == 1) {
+        int length = self->data.length;
+        int tail = length - (start + n);
+        if(m > n) c11_array__resize(self, length + m - n);
+        if(tail > 0) {
+            memmove(Array__at(self, start + m), Array__at(self, start + n), (size_t)tail * itemsize);
+        }
+        if(m > 0) memcpy(Array__at(self, start), src, (size_t)m * itemsize);
+        self->data.length = length + m - n;
+    } else {
+        if(m != n) {
+            PK_FREE(src);
+            return ValueError("attempt to assign array of size %d to extended slice of size %d",
+                              m,
+                              n);
+        }
+        for(int i = 0; i < n; i++) {
+            memcpy(Array__at(self, start + i * step), (char*)src + (size_t)i * itemsize, itemsize);
+        }
+    }
+    PK_FREE(src);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool array__delitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_array* self = py_touserdata(argv);
+    py_Ref key = py_arg(1);
+    int length = self->data.length;
+    int itemsize = self->data.elem_size;
+    int start, stop, step;
+    if(py_isint(key)) {
+        start = py_toint(key);
+        if(!pk__normalize_index(&start, length)) return false;
+        stop = start + 1;
+        step = 1;
+    } else if(py_istype(key, tp_slice)) {
+        if(!pk__parse_int_slice(key, length, &start, &stop, &step)) return false;
+    } else {
+        return TypeError("array indices must be integers");
+    }
+    int n = Array__slicelength(start, stop, step);
+    if(step < 0) {
+        // delete the same items walking forward
+        start = start + (n - 1) * step;
+        step = -step;
+    }
+    // compact the kept items towards the front
+    int dst = start;
+    for(int src = start; src < length; src++) {
+        bool deleted = src < start + n * step && (src - start) % step == 0;
+        if(deleted) continue;
+        memmove(Array__at(self, dst), Array__at(self, src), itemsize);
+        dst++;
+    }
+    if(n > 0) self->data.length = dst;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool array__contains__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_array* self = py_touserdata(argv);
+    for(int i = 0; i < self->data.length; i++) {
+        int res = c11_array__contains_at(self, i, py_arg(1));
+        if(res == -1) return false;
+        if(res == 1) {
+            py_newbool(py_retval(), true);
+            return true;
+        }
+    }
+    py_newbool(py_retval(), false);
+    return true;
+}
+
+/// -1: not comparable, 0: false, 1: true
+static int Array__equal(py_Ref lhs, py_Ref rhs) {
+    if(py_typeof(lhs) != py_typeof(rhs)) return -1;
+    c11_array* a = py_touserdata(lhs);
+    c11_array* b = py_touserdata(rhs);
+    if(a->data.length != b->data.length) return 0;
+    if(a->data.length == 0) return 1;
+    if(a->typecode == b->typecode && !Array__isfloat(a->typecode)) {
+        return memcmp(a->data.data, b->data.data, (size_t)a->data.length * a->data.elem_size) == 0;
+    }
+    for(int i = 0; i < a->data.length; i++) {
+        py_TValue x, y;
+        c11_array__getitem(a, i, &x);
+        c11_array__getitem(b, i, &y);
+        bool eq;
+        if(py_isint(&x) && py_isint(&y)) {
+            eq = py_toint(&x) == py_toint(&y);
+        } else {
+            py_f64 fx = py_isint(&x) ? (py_f64)py_toint(&x) : py_tofloat(&x);
+            py_f64 fy = py_isint(&y) ? (py_f64)py_toint(&y) : py_tofloat(&y);
+            eq = fx == fy;
+        }
+        if(!eq) return 0;
+    }
+    return 1;
+}
+
+static bool array__eq__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Array__equal(py_arg(0), py_arg(1));
+    if(res == -1) {
+        py_newnotimplemented(py_retval());
+    } else {
+        py_newbool(py_retval(), res);
+    }
+    return true;
+}
+
+static bool array__ne__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Array__equal(py_arg(0), py_arg(1));
+    if(res == -1) {
+        py_newnotimplemented(py_retval());
+    } else {
+        py_newbool(py_retval(), !res);
+    }
+    return true;
+}
+
+enum { Array__LT, Array__LE, Array__GT, Array__GE };
+
+/// Order like a tuple: by the first items that differ, or else by the lengths.
+static bool Array__order(int argc, py_Ref argv, int op) {
+    PY_CHECK_ARGC(2);
+    if(py_typeof(py_arg(0)) != py_typeof(py_arg(1))) {
+        py_newnotimplemented(py_retval());
+        return true;
+    }
+    c11_array* a = py_touserdata(py_arg(0));
+    c11_array* b = py_touserdata(py_arg(1));
+    int length = a->data.length < b->data.length ? a->data.length : b->data.length;
+    for(int i = 0; i < length; i++) {
+        py_TValue x, y;
+        c11_array__getitem(a, i, &x);
+        c11_array__getitem(b, i, &y);
+        bool lt, gt;
+        if(py_isint(&x) && py_isint(&y)) {
+            if(py_toint(&x) == py_toint(&y)) continue;
+            lt = py_toint(&x) < py_toint(&y);
+            gt = !lt;
+        } else {
+            py_f64 fx = py_isint(&x) ? (py_f64)py_toint(&x) : py_tofloat(&x);
+            py_f64 fy = py_isint(&y) ? (py_f64)py_toint(&y) : py_tofloat(&y);
+            if(fx == fy) continue;
+            lt = fx < fy;
+            gt = fx > fy;  // both are false for nan
+        }
+        // the items differ, so `<=` and `>=` are strict here
+        py_newbool(py_retval(), (op == Array__LT || op == Array__LE) ? lt : gt);
+        return true;
+    }
+    int la = a->data.length, lb = b->data.length;
+    bool res;
+    switch(op) {
+        case Array__LT: res = la < lb; break;
+        case Array__LE: res = la <= lb; break;
+        case Array__GT: res = la > lb; break;
+        default: res = la >= lb; break;
+    }
+    py_newbool(py_retval(), res);
+    return true;
+}
+
+static bool array__lt__(int argc, py_Ref argv) { return Array__order(argc, argv, Array__LT); }
+
+static bool array__le__(int argc, py_Ref argv) { return Array__order(argc, argv, Array__LE); }
+
+static bool array__gt__(int argc, py_Ref argv) { return Array__order(argc, argv, Array__GT); }
+
+static bool array__ge__(int argc, py_Ref argv) { return Array__order(argc, argv, Array__GE); }
+
+static bool array__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array* self = py_touserdata(argv);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstr(&buf, "array('");
+    c11_sbuf__write_char(&buf, self->typecode);
+    c11_sbuf__write_char(&buf, '\'');
+    if(self->data.length > 0) c11_sbuf__write_cstr(&buf, ", [");
+    for(int i = 0; i < self->data.length; i++) {
+        if(i > 0) c11_sbuf__write_cstr(&buf, ", ");
+        py_TValue item;
+        c11_array__getitem(self, i, &item);
+        if(!py_repr(&item)) {
+            c11_sbuf__dtor(&buf);
+            return false;
+        }
+        c11_sbuf__write_sv(&buf, py_tosv(py_retval()));
+    }
+    if(self->data.length > 0) c11_sbuf__write_char(&buf, ']');
+    c11_sbuf__write_char(&buf, ')');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+static bool array__iter__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Ref type = py_getdict(py_getmodule("array"), py_name("arrayiterator"));
+    c11_array_iterator* ud =
+        py_newobject(py_retval(), py_totype(type), 1, sizeof(c11_array_iterator));
+    ud->index = 0;
+    py_setslot(py_retval(), 0, argv);
+    return true;
+}
+
+static bool arrayiterator__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array_iterator* ud = py_touserdata(argv);
+    c11_array* self = py_touserdata(py_getslot(argv, 0));
+    if(ud->index >= self->data.length) return StopIteration();
+    c11_array__getitem(self, ud->index++, py_retval());
+    return true;
+}
+
+static bool array__reduce__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array* self = py_touserdata(argv);
+    py_Ref args = py_pushtmp();
+    py_TValue* p = py_newtuple(args, 2);
+    char typecode[2] = {self->typecode, '\0'};
+    py_newstr(&p[0], typecode);
+    int size = self->data.length * self->data.elem_size;
+    unsigned char* bytes = py_newbytes(&p[1], size);
+    if(size > 0) memcpy(bytes, self->data.data, size);
+    p = py_newtuple(py_retval(), 2);
+    p[0] = *py_tpobject(py_typeof(argv));
+    p[1] = *args;
+    py_pop();
+    return true;
+}
+
+static bool array_typecode(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array* self = py_touserdata(argv);
+    char typecode[2] = {self->typecode, '\0'};
+    py_newstr(py_retval(), typecode);
+    return true;
+}
+
+static bool array_itemsize(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array* self = py_touserdata(argv);
+    py_newint(py_retval(), self->data.elem_size);
+    return true;
+}
+
+static bool array_append(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!c11_array__append(py_touserdata(argv), py_arg(1))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool array_extend(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_array* self = py_touserdata(argv);
+    py_Ref iterable = py_arg(1);
+    if(py_typeof(iterable) == py_typeof(argv)) {
+        c11_array* other = py_touserdata(iterable);
+        if(other->typecode != self->typecode) {
+            return TypeError("can only extend with array of same kind");
+        }
+        int length = self->data.length;
+        int m = other->data.length;
+        c11_array__resize(self, length + m);
+        // `other` may be `self`, whose first `length` items are unchanged by the resize
+        if(m > 0) {
+            memcpy(Array__at(self, length), other->data.data, (size_t)m * self->data.elem_size);
+        }
+    } else if(!c11_array__extend(self, iterable)) {
+        return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool array_insert(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    c11_array* self = py_touserdata(argv);
+    int length = self->data.length;
+    py_i64 index = py_toint(py_arg(1));
+    if(index < 0) index += length;
+    index = c11__max(0, c11__min(index, length));
+    if(!c11_array__append(self, py_arg(2))) return false;
+    int itemsize = self->data.elem_size;
+    char item[8];
+    memcpy(item, Array__at(self, length), itemsize);
+    memmove(Array__at(self, (int)index + 1),
+            Array__at(self, (int)index),
+            (size_t)(length - index) * itemsize);
+    memcpy(Array__at(self, (int)index), item, itemsize);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool array_pop(int argc, py_Ref argv) {
+    // pop(self, i=-1)
+    c11_array* self = py_touserdata(argv);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    int length = self->data.length;
+    if(length == 0) return IndexError("pop from empty array");
+    int index = py_toint(py_arg(1));
+    if(!pk__normalize_index(&index, length)) return false;
+    c11_array__getitem(self, index, py_retval());
+    int itemsize = self->data.elem_size;
+    memmove(Array__at(self, index),
+            Array__at(self, index + 1),
+            (size_t)(length - index - 1) * itemsize);
+    self->data.length--;
+    return true;
+}
+
+/// Index of the first item equal to `val`, -1 if not found, -2 on error.
+static int Array__index(c11_array* self, py_Ref val) {
+    for(int i = 0; i < self->data.length; i++) {
+        int res = c11_array__contains_at(self, i, val);
+        if(res == -1) return -2;
+        if(res == 1) return i;
+    }
+    return -1;
+}
+
+static bool array_index(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int index = Array__index(py_touserdata(argv), py_arg(1));
+    if(index == -2) return false;
+    if(index == -1) return ValueError("array.index(x): x not in array");
+    py_newint(py_retval(), index);
+    return true;
+}
+
+static bool array_remove(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_array* self = py_touserdata(argv);
+    int index = Array__index(self, py_arg(1));
+    if(index == -2) return false;
+    if(index == -1) return ValueError("array.remove(x): x not in array");
+    int itemsize = self->data.elem_size;
+    memmove(Array__at(self, index),
+            Array__at(self, index + 1),
+            (size_t)(self->data.length - index - 1) * itemsize);
+    self->data.length--;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool array_count(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_array* self = py_touserdata(argv);
+    int count = 0;
+    for(int i = 0; i < self->data.length; i++) {
+        int res = c11_array__contains_at(self, i, py_arg(1));
+        if(res == -1) return false;
+        count += res;
+    }
+    py_newint(py_retval(), count);
+    return true;
+}
+
+static bool array_reverse(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array* self = py_touserdata(argv);
+    c11_vector* data = &self->data;
+#define CASE(T) c11__reverse(T, data);
+    Array__SWITCH(self->typecode, CASE)
+#undef CASE
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool array_tolist(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array* self = py_touserdata(argv);
+    int n = self->data.length;
+    py_newlistn(py_retval(), n);
+    py_TValue* p = py_list_data(py_retval());
+    for(int i = 0; i < n; i++) {
+        c11_array__getitem(self, i, &p[i]);
+    }
+    return true;
+}
+
+static bool array_fromlist(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(1, tp_list);
+    c11_array* self = py_touserdata(argv);
+    int length = self->data.length;
+    // all or nothing, like CPython
+    if(!c11_array__extend(self, py_arg(1))) {
+        self->data.length = length;
+        return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool array_tobytes(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_array* self = py_touserdata(argv);
+    int size = self->data.length * self->data.elem_size;
+    unsigned char* bytes = py_newbytes(py_retval(), size);
+    if(size > 0) memcpy(bytes, self->data.data, size);
+    return true;
+}
+
+static bool array_frombytes(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_array* self = py_touserdata(argv);
+    py_Buffer view;
+    if(!py_getbuffer(py_arg(1), &view, false)) return false;
+    const unsigned char* data = view.data;
+    void* tmp = NULL;
+    const char* begin = self->data.data;
+    const char* end = begin + (size_t)self->data.capacity * self->data.elem_size;
+    if((const char*)data >= begin && (const char*)data < end) {
+        // a view of `self` would dangle once the storage grows
+        tmp = PK_MALLOC(view.size);
+        memcpy(tmp, data, view.size);
+        data = tmp;
+    }
+    bool ok = c11_array__frombytes(self, data, view.size);
+    py_releasebuffer(&view);
+    PK_FREE(tmp);
+    if(!ok) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+void pk__add_module_array() {
+    py_GlobalRef mod = py_newmodule("array");
+    py_newstr(py_emplacedict(mod, py_name("typecodes")), "bhiqfd");
+
+    py_Type type = pk_newtype("array", tp_object, mod, c11_array__dtor, false, true);
+    py_setdict(mod, py_name("array"), py_tpobject(type));
+    py_setdict(py_tpobject(type), __hash__, py_None());
+    py_tpsetbuffer(type, array__getbuffer);
+
+    py_bind(py_tpobject(type), "__new__(cls, typecode, initializer=None)", array__new__);
+    py_bindmagic(type, __len__, array__len__);
+    py_bindmagic(type, __getitem__, array__getitem__);
+    py_bindmagic(type, __setitem__, array__setitem__);
+    py_bindmagic(type, __delitem__, array__delitem__);
+    py_bindmagic(type, __contains__, array__contains__);
+    py_bindmagic(type, __iter__, array__iter__);
+    py_bindmagic(type, __eq__, array__eq__);
+    py_bindmagic(type, __ne__, array__ne__);
+    py_bindmagic(type, __lt__, array__lt__);
+    py_bindmagic(type, __le__, array__le__);
+    py_bindmagic(type, __gt__, array__gt__);
+    py_bindmagic(type, __ge__, array__ge__);
+    py_bindmagic(type, __repr__, array__repr__);
+    py_bindmagic(type, __reduce__, array__reduce__);
+    py_bindmagic(type, __add__, array__add__);
+    py_bindmagic(type, __sub__, array__sub__);
+    py_bindmagic(type, __mul__, array__mul__);
+    py_bindmagic(type, __truediv__, array__truediv__);
+    py_bindmagic(type, __radd__, array__radd__);
+    py_bindmagic(type, __rsub__, array__rsub__);
+    py_bindmagic(type, __rmul__, array__rmul__);
+    py_bindmagic(type, __rtruediv__, array__rtruediv__);
+    py_bindmagic(type, __neg__, array__neg__);
+
+    py_bindproperty(type, "typecode", array_typecode, NULL);
+    py_bindproperty(type, "itemsize", array_itemsize, NULL);
+
+    py_bindmethod(type, "append", array_append);
+    py_bindmethod(type, "extend", array_extend);
+    py_bindmethod(type, "insert", array_insert);
+    py_bind(py_tpobject(type), "pop(self, i=-1)", array_pop);
+    py_bindmethod(type, "index", array_index);
+    py_bindmethod(type, "remove", array_remove);
+    py_bindmethod(type, "count", array_count);
+    py_bindmethod(type, "reverse", array_reverse);
+    py_bindmethod(type, "tolist", array_tolist);
+    py_bindmethod(type, "fromlist", array_fromlist);
+    py_bindmethod(type, "tobytes", array_tobytes);
+    py_bindmethod(type, "frombytes", array_frombytes);
+
+    type = pk_newtype("arrayiterator", tp_object, mod, NULL, false, true);
+    py_setdict(mod, py_name("arrayiterator"), py_tpobject(type));
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, arrayiterator__next__);
+}
+
+#undef Array__SWITCH
@@ -167,30 +167,31 @@ base64_decode(const char *in, unsigned int inlen, unsigned char *out)
 
 static bool base64_b64encode(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    PY_CHECK_ARG_TYPE(0, tp_bytes);
-    int src_size;
-    unsigned char* src_data = py_tobytes(argv, &src_size);
-    unsigned char* dst_data = py_newbytes(py_retval(), src_size * 4 / 3 + 4);
-    int size = base64_encode(src_data, src_size, (char*)dst_data);
+    py_Buffer view;
+    if(!py_getbuffer(argv, &view, false)) return false;
+    unsigned char* dst_data = py_newbytes(py_retval(), view.size * 4 / 3 + 4);
+    int size = base64_encode(view.data, view.size, (char*)dst_data);
+    py_releasebuffer(&view);
     py_bytes_resize(py_retval(), size);
     return true;
 }
 
 static bool base64_b64decode(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    int src_size;
-    void* src_data;
+    py_Buffer view;
     if(py_istype(argv, tp_str)) {
         c11_sv sv = py_tosv(argv);
-        src_data = (void*)sv.data;
-        src_size = sv.size;
-    } else if(py_istype(argv, tp_bytes)) {
-        src_data = py_tobytes(argv, &src_size);
+        view.data = (void*)sv.data;
+        view.size = sv.size;
+        view.release = NULL;
+    } else if(py_checkbuffer(argv)) {
+        if(!py_getbuffer(argv, &view, false)) return false;
     } else {
         return TypeError("expect bytes or str, got %t", argv->type);
     }
-    unsigned char* dst_data = py_newbytes(py_retval(), src_size);
-    int size = base64_decode((const char*)src_data, src_size, dst_data);
+    unsigned char* dst_data = py_newbytes(py_retval(), view.size);
+    int size = base64_decode((const char*)view.data, view.size, dst_data);
+    py_releasebuffer(&view);
     py_bytes_resize(py_retval(), size);
     return true;
 }
@@ -0,0 +1,128 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/interpreter/vm.h"
+
+/// Fetch `a[i]` into `out`. Lists and tuples are read directly, re-validating the index since
+/// `__lt__` or `key` may have resized the list.
+static bool bisect__getitem(py_Ref a, int i, py_Ref out) {
+    py_TValue* p;
+    int length = pk_arrayview(a, &p);
+    if(length != -1) {
+        if(i >= length) return IndexError("list index out of range");
+        py_assign(out, p + i);
+        return true;
+    }
+    py_TValue index;
+    py_newint(&index, i);
+    if(!py_getitem(a, &index)) return false;
+    py_assign(out, py_retval());
+    return true;
+}
+
+/// Binary search for `x` in `a[lo:hi]`, which is sorted by `key`.
+/// `x` is compared as is, `key` is only applied to the items of `a`.
+static bool bisect__search(py_Ref a, py_Ref x, py_Ref lo_, py_Ref hi_, py_Ref key, bool right,
+                           int* out) {
+    if(!py_checkint(lo_)) return false;
+    py_i64 lo = py_toint(lo_);
+    if(lo < 0) return ValueError("lo must be non-negative");
+    py_i64 hi;
+    if(py_isnone(hi_)) {
+        if(!py_len(a)) return false;
+        hi = py_toint(py_retval());
+    } else {
+        if(!py_checkint(hi_)) return false;
+        hi = py_toint(hi_);
+    }
+    py_Ref item = py_pushtmp();
+    while(lo < hi) {
+        py_i64 mid = (lo + hi) / 2;
+        if(!bisect__getitem(a, (int)mid, item)) return false;
+        if(!py_isnone(key)) {
+            if(!py_call(key, 1, item)) return false;
+            py_assign(item, py_retval());
+        }
+        if(right) {
+            int res = py_less(x, item);
+            if(res == -1) return false;
+            if(res) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        } else {
+            int res = py_less(item, x);
+            if(res == -1) return false;
+            if(res) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+    }
+    py_pop();
+    *out = (int)lo;
+    return true;
+}
+
+static bool bisect__bisect(py_Ref argv, bool right) {
+    // (a, x, lo=0, hi=None, key=None)
+    int index;
+    if(!bisect__search(py_arg(0), py_arg(1), py_arg(2), py_arg(3), py_arg(4), right, &index)) {
+        return false;
+    }
+    py_newint(py_retval(), index);
+    return true;
+}
+
+static bool bisect__insort(py_Ref argv, bool right) {
+    // (a, x, lo=0, hi=None, key=None)
+    py_Ref a = py_arg(0);
+    py_Ref key = py_arg(4);
+    py_Ref x = py_pushtmp();
+    if(py_isnone(key)) {
+        py_assign(x, py_arg(1));
+    } else {
+        if(!py_call(key, 1, py_arg(1))) return false;
+        py_assign(x, py_retval());
+    }
+    int index;
+    if(!bisect__search(a, x, py_arg(2), py_arg(3), key, right, &index)) return false;
+    py_pop();
+    if(py_islist(a)) {
+        py_list_insert(a, index, py_arg(1));
+        py_newnone(py_retval());
+        return true;
+    }
+    if(!py_getattr(a, py_name("insert"))) return false;
+    py_Ref args = py_pushtmp();
+    py_pushtmp();
+    py_newint(&args[0], index);
+    py_assign(&args[1], py_arg(1));
+    if(!py_call(py_retval(), 2, args)) return false;
+    py_shrink(2);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool bisect_bisect_left(int argc, py_Ref argv) { return bisect__bisect(argv, false); }
+
+static bool bisect_bisect_right(int argc, py_Ref argv) { return bisect__bisect(argv, true); }
+
+static bool bisect_insort_left(int argc, py_Ref argv) { return bisect__insort(argv, false); }
+
+static bool bisect_insort_right(int argc, py_Ref argv) { return bisect__insort(argv, true); }
+
+void pk__add_module_bisect() {
+    py_GlobalRef mod = py_newmodule("bisect");
+
+    py_bind(mod, "bisect_left(a, x, lo=0, hi=None, key=None)", bisect_bisect_left);
+    py_bind(mod, "bisect_right(a, x, lo=0, hi=None, key=None)", bisect_bisect_right);
+    py_bind(mod, "insort_left(a, x, lo=0, hi=None, key=None)", bisect_insort_left);
+    py_bind(mod, "insort_right(a, x, lo=0, hi=None, key=None)", bisect_insort_right);
+    // copy first, `py_setdict` may move the items of the dict
+    py_TValue alias = *py_getdict(mod, py_name("bisect_right"));
+    py_setdict(mod, py_name("bisect"), &alias);
+    alias = *py_getdict(mod, py_name("insort_right"));
+    py_setdict(mod, py_name("insort"), &alias);
+}
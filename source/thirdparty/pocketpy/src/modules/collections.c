@@ -0,0 +1,563 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/sstream.h"
+#include "pocketpy/interpreter/types.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* `deque` is a ring buffer of `py_TValue`. `capacity` is zero or a power of two, so wrapping an
+ * index is a single mask. Items live at `data[(head + i) & (capacity - 1)]` for `0 <= i < length`;
+ * slots outside that range are garbage and never marked.
+ */
+
+typedef struct {
+    py_TValue* data;
+    int head;
+    int length;
+    int capacity;
+    int maxlen;        // -1 if unbounded
+    uint32_t version;  // bumped by every change of length or order
+} c11_deque;
+
+typedef struct {
+    c11_deque* deque;
+    int index;
+    uint32_t version;
+} c11_deque_iterator;
+
+#define Deque__MIN_CAPACITY 8
+
+static void c11_deque__dtor(c11_deque* self) { PK_FREE(self->data); }
+
+void c11_deque__mark(void* ud, c11_vector* p_stack) {
+    c11_deque* self = ud;
+    for(int i = 0; i < self->length; i++) {
+        pk__mark_value(&self->data[(self->head + i) & (self->capacity - 1)]);
+    }
+}
+
+PK_INLINE static py_TValue* c11_deque__at(c11_deque* self, int i) {
+    return &self->data[(self->head + i) & (self->capacity - 1)];
+}
+
+static c11_deque* c11_deque__new(py_OutRef out, py_Type type, int maxlen) {
+    int slots = type == tp_deque ? 0 : -1;
+    c11_deque* self = py_newobject(out, type, slots, sizeof(c11_deque));
+    self->data = NULL;
+    self->head = 0;
+    self->length = 0;
+    self->capacity = 0;
+    self->maxlen = maxlen;
+    self->version = 0;
+    return self;
+}
+
+/// Grow the buffer so it can hold at least `n` items. The ring is unrolled to start at slot 0.
+static void c11_deque__reserve(c11_deque* self, int n) {
+    if(n <= self->capacity) return;
+    int capacity = c11__max(self->capacity, Deque__MIN_CAPACITY);
+    while(capacity < n)
+        capacity *= 2;
+    py_TValue* data = PK_MALLOC(sizeof(py_TValue) * capacity);
+    for(int i = 0; i < self->length; i++) {
+        data[i] = *c11_deque__at(self, i);
+    }
+    PK_FREE(self->data);
+    self->data = data;
+    self->head = 0;
+    self->capacity = capacity;
+}
+
+static void c11_deque__clear(c11_deque* self) {
+    self->head = 0;
+    self->length = 0;
+    self->version++;
+}
+
+static void c11_deque__append(c11_deque* self, py_Ref val) {
+    if(self->length == self->maxlen) {
+        if(self->maxlen == 0) return;
+        // a bounded deque drops items from the opposite end
+        self->head = (self->head + 1) & (self->capacity - 1);
+        self->length--;
+    }
+    if(self->length == self->capacity) c11_deque__reserve(self, self->length + 1);
+    *c11_deque__at(self, self->length) = *val;
+    self->length++;
+    self->version++;
+}
+
+static void c11_deque__appendleft(c11_deque* self, py_Ref val) {
+    if(self->length == self->maxlen) {
+        if(self->maxlen == 0) return;
+        self->length--;
+    }
+    if(self->length == self->capacity) c11_deque__reserve(self, self->length + 1);
+    self->head = (self->head - 1) & (self->capacity - 1);
+    self->data[self->head] = *val;
+    self->length++;
+    self->version++;
+}
+
+/// Rotate `k` steps to the right, `0 < k < length`, moving whichever side is shorter.
+static void c11_deque__rotate(c11_deque* self, int k) {
+    int mask = self->capacity - 1;
+    if(k <= self->length / 2) {
+        for(int i = 0; i < k; i++) {
+            py_TValue tmp = *c11_deque__at(self, self->length - 1);
+            self->head = (self->head - 1) & mask;
+            self->data[self->head] = tmp;
+        }
+    } else {
+        for(int i = k; i < self->length; i++) {
+            py_TValue tmp = self->data[self->head];
+            self->head = (self->head + 1) & mask;
+            *c11_deque__at(self, self->length - 1) = tmp;
+        }
+    }
+    self->version++;
+}
+
+/// Remove the item at `index`, shifting whichever side is shorter.
+static void c11_deque__delitem(c11_deque* self, int index) {
+    if(index < self->length / 2) {
+        for(int i = index; i > 0; i--) {
+            *c11_deque__at(self, i) = *c11_deque__at(self, i - 1);
+        }
+        self->head = (self->head + 1) & (self->capacity - 1);
+    } else {
+        for(int i = index; i < self->length - 1; i++) {
+            *c11_deque__at(self, i) = *c11_deque__at(self, i + 1);
+        }
+    }
+    self->length--;
+    self->version++;
+}
+
+static bool c11_deque__extend(c11_deque* self, py_Ref iterable, bool left) {
+    void (*f_push)(c11_deque*, py_Ref) = left ? c11_deque__appendleft : c11_deque__append;
+    py_TValue* p;
+    int length = pk_arrayview(iterable, &p);
+    if(length != -1) {
+        for(int i = 0; i < length; i++) {
+            f_push(self, p + i);
+        }
+        return true;
+    }
+    if(py_isinstance(iterable, tp_deque)) {
+        c11_deque* other = py_touserdata(iterable);
+        if(other != self) {
+            for(int i = 0; i < other->length; i++) {
+                f_push(self, c11_deque__at(other, i));
+            }
+            return true;
+        }
+        // extending a deque with itself, take a snapshot first
+        length = self->length;
+        py_newlistn(py_pushtmp(), length);
+        py_TValue* snapshot = py_list_data(py_peek(-1));
+        for(int i = 0; i < length; i++) {
+            snapshot[i] = *c11_deque__at(self, i);
+        }
+        for(int i = 0; i < length; i++) {
+            f_push(self, &snapshot[i]);
+        }
+        py_pop();
+        return true;
+    }
+    if(!py_iter(iterable)) return false;
+    py_push(py_retval());
+    while(true) {
+        int res = py_next(py_peek(-1));
+        if(res == -1) return false;
+        if(res == 0) break;
+        f_push(self, py_retval());
+    }
+    py_pop();
+    return true;
+}
+
+/// Find the first item equal to `val`. -2: error, -1: not found.
+static int c11_deque__index(c11_deque* self, py_Ref val) {
+    uint32_t version = self->version;
+    py_Ref item = py_pushtmp();
+    for(int i = 0; i < self->length; i++) {
+        // `__eq__` may run arbitrary code, so compare a rooted copy
+        py_assign(item, c11_deque__at(self, i));
+        int res = py_equal(item, val);
+        if(res == -1) return -2;
+        if(self->version != version) {
+            RuntimeError("deque mutated during iteration");
+            return -2;
+        }
+        if(res) {
+            py_pop();
+            return i;
+        }
+    }
+    py_pop();
+    return -1;
+}
+
+static bool c11_deque__normalize_index(c11_deque* self, py_Ref arg, int* out) {
+    if(!py_checkint(arg)) return false;
+    py_i64 index = py_toint(arg);
+    if(index < 0) index += self->length;
+    if(index < 0 || index >= self->length) return IndexError("deque index out of range");
+    *out = (int)index;
+    return true;
+}
+
+static bool deque__new__(int argc, py_Ref argv) {
+    // __new__(cls, iterable=None, maxlen=None), `__init__` fills the deque
+    c11_deque__new(py_retval(), py_totype(argv), -1);
+    return true;
+}
+
+static bool deque__init__(int argc, py_Ref argv) {
+    // __init__(self, iterable=None, maxlen=None)
+    c11_deque* self = py_touserdata(argv);
+    py_Ref iterable = py_arg(1);
+    py_Ref maxlen = py_arg(2);
+    if(py_isnone(maxlen)) {
+        self->maxlen = -1;
+    } else {
+        if(!py_checkint(maxlen)) return false;
+        py_i64 n = py_toint(maxlen);
+        if(n < 0 || n > INT32_MAX) return ValueError("maxlen must be non-negative");
+        self->maxlen = (int)n;
+    }
+    c11_deque__clear(self);
+    if(!py_isnone(iterable) && !c11_deque__extend(self, iterable, false)) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque__len__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque* self = py_touserdata(argv);
+    py_newint(py_retval(), self->length);
+    return true;
+}
+
+static bool deque__contains__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = c11_deque__index(py_touserdata(argv), py_arg(1));
+    if(res == -2) return false;
+    py_newbool(py_retval(), res >= 0);
+    return true;
+}
+
+static bool deque__getitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_deque* self = py_touserdata(argv);
+    int index = 0;
+    if(!c11_deque__normalize_index(self, py_arg(1), &index)) return false;
+    py_assign(py_retval(), c11_deque__at(self, index));
+    return true;
+}
+
+static bool deque__setitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    c11_deque* self = py_touserdata(argv);
+    int index = 0;
+    if(!c11_deque__normalize_index(self, py_arg(1), &index)) return false;
+    *c11_deque__at(self, index) = *py_arg(2);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque__iter__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque_iterator* ud =
+        py_newobject(py_retval(), tp_deque_iterator, 1, sizeof(c11_deque_iterator));
+    py_setslot(py_retval(), 0, argv);  // keep the deque alive
+    ud->deque = py_touserdata(argv);
+    ud->index = 0;
+    ud->version = ud->deque->version;
+    return true;
+}
+
+static bool deque__eq__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!py_isinstance(py_arg(1), tp_deque)) {
+        py_newnotimplemented(py_retval());
+        return true;
+    }
+    c11_deque* self = py_touserdata(argv);
+    c11_deque* other = py_touserdata(py_arg(1));
+    if(self->length != other->length) {
+        py_newbool(py_retval(), false);
+        return true;
+    }
+    uint32_t self_version = self->version;
+    uint32_t other_version = other->version;
+    py_Ref a = py_pushtmp();
+    py_Ref b = py_pushtmp();
+    for(int i = 0; i < self->length; i++) {
+        py_assign(a, c11_deque__at(self, i));
+        py_assign(b, c11_deque__at(other, i));
+        int res = py_equal(a, b);
+        if(res == -1) return false;
+        if(self->version != self_version || other->version != other_version) {
+            return RuntimeError("deque mutated during iteration");
+        }
+        if(!res) {
+            py_shrink(2);
+            py_newbool(py_retval(), false);
+            return true;
+        }
+    }
+    py_shrink(2);
+    py_newbool(py_retval(), true);
+    return true;
+}
+
+static bool deque__ne__(int argc, py_Ref argv) {
+    if(!deque__eq__(argc, argv)) return false;
+    if(py_istype(py_retval(), tp_bool)) py_newbool(py_retval(), !py_tobool(py_retval()));
+    return true;
+}
+
+static bool deque__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque* self = py_touserdata(argv);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstr(&buf, py_tpname(py_typeof(argv)));
+    c11_sbuf__write_cstr(&buf, "([");
+    py_Ref item = py_pushtmp();
+    for(int i = 0; i < self->length; i++) {
+        py_assign(item, c11_deque__at(self, i));
+        if(!py_repr(item)) {
+            c11_sbuf__dtor(&buf);
+            return false;
+        }
+        c11_sbuf__write_sv(&buf, py_tosv(py_retval()));
+        if(i != self->length - 1) c11_sbuf__write_cstr(&buf, ", ");
+    }
+    py_pop();
+    c11_sbuf__write_char(&buf, ']');
+    if(self->maxlen != -1) {
+        c11_sbuf__write_cstr(&buf, ", maxlen=");
+        c11_sbuf__write_int(&buf, self->maxlen);
+    }
+    c11_sbuf__write_char(&buf, ')');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+static bool deque__reduce__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque* self = py_touserdata(argv);
+    py_Ref p = py_newtuple(py_pushtmp(), 2);
+    py_assign(&p[0], py_tpobject(argv->type));
+    py_Ref args = py_newtuple(&p[1], 2);
+    py_newlistn(&args[0], self->length);
+    for(int i = 0; i < self->length; i++) {
+        py_list_setitem(&args[0], i, c11_deque__at(self, i));
+    }
+    if(self->maxlen == -1) {
+        py_newnone(&args[1]);
+    } else {
+        py_newint(&args[1], self->maxlen);
+    }
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+static bool deque_maxlen(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque* self = py_touserdata(argv);
+    if(self->maxlen == -1) {
+        py_newnone(py_retval());
+    } else {
+        py_newint(py_retval(), self->maxlen);
+    }
+    return true;
+}
+
+static bool deque_append(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_deque__append(py_touserdata(argv), py_arg(1));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_appendleft(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_deque__appendleft(py_touserdata(argv), py_arg(1));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_pop(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque* self = py_touserdata(argv);
+    if(self->length == 0) return IndexError("pop from an empty deque");
+    self->length--;
+    self->version++;
+    py_assign(py_retval(), c11_deque__at(self, self->length));
+    return true;
+}
+
+static bool deque_popleft(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque* self = py_touserdata(argv);
+    if(self->length == 0) return IndexError("pop from an empty deque");
+    py_assign(py_retval(), &self->data[self->head]);
+    self->head = (self->head + 1) & (self->capacity - 1);
+    self->length--;
+    self->version++;
+    return true;
+}
+
+static bool deque_extend(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!c11_deque__extend(py_touserdata(argv), py_arg(1), false)) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_extendleft(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!c11_deque__extend(py_touserdata(argv), py_arg(1), true)) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_clear(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque__clear(py_touserdata(argv));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_copy(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque* self = py_touserdata(argv);
+    c11_deque* res = c11_deque__new(py_retval(), py_typeof(argv), self->maxlen);
+    c11_deque__reserve(res, self->length);
+    for(int i = 0; i < self->length; i++) {
+        res->data[i] = *c11_deque__at(self, i);
+    }
+    res->length = self->length;
+    return true;
+}
+
+static bool deque_count(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_deque* self = py_touserdata(argv);
+    uint32_t version = self->version;
+    py_Ref item = py_pushtmp();
+    int count = 0;
+    for(int i = 0; i < self->length; i++) {
+        py_assign(item, c11_deque__at(self, i));
+        int res = py_equal(item, py_arg(1));
+        if(res == -1) return false;
+        if(self->version != version) return RuntimeError("deque mutated during iteration");
+        count += res;
+    }
+    py_pop();
+    py_newint(py_retval(), count);
+    return true;
+}
+
+static bool deque_remove(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_deque* self = py_touserdata(argv);
+    int index = c11_deque__index(self, py_arg(1));
+    if(index == -2) return false;
+    if(index == -1) return ValueError("deque.remove(x): x not in deque");
+    c11_deque__delitem(self, index);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_reverse(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque* self = py_touserdata(argv);
+    for(int i = 0, j = self->length - 1; i < j; i++, j--) {
+        py_TValue tmp = *c11_deque__at(self, i);
+        *c11_deque__at(self, i) = *c11_deque__at(self, j);
+        *c11_deque__at(self, j) = tmp;
+    }
+    self->version++;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_rotate(int argc, py_Ref argv) {
+    // rotate(self, n=1)
+    c11_deque* self = py_touserdata(argv);
+    if(!py_checkint(py_arg(1))) return false;
+    py_i64 n = py_toint(py_arg(1));
+    if(self->length > 1) {
+        int k = (int)(n % self->length);
+        if(k < 0) k += self->length;
+        if(k != 0) c11_deque__rotate(self, k);
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_iterator__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_deque_iterator* self = py_touserdata(argv);
+    if(self->version != self->deque->version) {
+        return RuntimeError("deque mutated during iteration");
+    }
+    if(self->index >= self->deque->length) return StopIteration();
+    py_assign(py_retval(), c11_deque__at(self->deque, self->index));
+    self->index++;
+    return true;
+}
+
+static void register_deque(py_Ref mod) {
+    py_Type type = py_newtype("deque", tp_object, mod, (void (*)(void*))c11_deque__dtor);
+    assert(type == tp_deque);
+    py_bind(py_tpobject(type), "__new__(cls, iterable=None, maxlen=None)", deque__new__);
+    py_bind(py_tpobject(type), "__init__(self, iterable=None, maxlen=None)", deque__init__);
+    py_bindmagic(type, __len__, deque__len__);
+    py_bindmagic(type, __contains__, deque__contains__);
+    py_bindmagic(type, __getitem__, deque__getitem__);
+    py_bindmagic(type, __setitem__, deque__setitem__);
+    py_bindmagic(type, __iter__, deque__iter__);
+    py_bindmagic(type, __eq__, deque__eq__);
+    py_bindmagic(type, __ne__, deque__ne__);
+    py_bindmagic(type, __repr__, deque__repr__);
+    py_bindmagic(type, __reduce__, deque__reduce__);
+    py_setdict(py_tpobject(type), __hash__, py_None());
+
+    py_bindproperty(type, "maxlen", deque_maxlen, NULL);
+    py_bindmethod(type, "append", deque_append);
+    py_bindmethod(type, "appendleft", deque_appendleft);
+    py_bindmethod(type, "pop", deque_pop);
+    py_bindmethod(type, "popleft", deque_popleft);
+    py_bindmethod(type, "extend", deque_extend);
+    py_bindmethod(type, "extendleft", deque_extendleft);
+    py_bindmethod(type, "clear", deque_clear);
+    py_bindmethod(type, "copy", deque_copy);
+    py_bindmethod(type, "count", deque_count);
+    py_bindmethod(type, "remove", deque_remove);
+    py_bindmethod(type, "reverse", deque_reverse);
+    py_bind(py_tpobject(type), "rotate(self, n=1)", deque_rotate);
+}
+
+static void register_deque_iterator(py_Ref mod) {
+    py_Type type = py_newtype("deque_iterator", tp_object, mod, NULL);
+    assert(type == tp_deque_iterator);
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, deque_iterator__next__);
+}
+
+void pk__add_module_collections() {
+    // re-exported by `python/collections.py`
+    py_GlobalRef mod = py_newmodule("_collections");
+
+    register_deque(mod);
+    register_deque_iterator(mod);
+}
+
+#undef Deque__MIN_CAPACITY
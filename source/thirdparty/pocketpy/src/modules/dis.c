@@ -117,6 +117,7 @@ static bool disassemble(CodeObject* co) {
                     CASE_BINARY_OP(OP_BINARY_OR, __or__, 0)
                     CASE_BINARY_OP(OP_BINARY_XOR, __xor__, 0)
                     CASE_BINARY_OP(OP_BINARY_MATMUL, __matmul__, 0)
+                    CASE_BINARY_OP(OP_INPLACE_ADD, __add__, __radd__)
                     CASE_BINARY_OP(OP_COMPARE_LT, __lt__, __gt__)
                     CASE_BINARY_OP(OP_COMPARE_LE, __le__, __ge__)
                     CASE_BINARY_OP(OP_COMPARE_EQ, __eq__, __eq__)
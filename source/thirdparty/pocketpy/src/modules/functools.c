@@ -0,0 +1,500 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/interpreter/types.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* `partial` keeps `func`, the positional arguments and the keyword arguments in 3 slots. The
+ * keyword arguments are a flat tuple of `(name, value)` pairs, with names stored as ints, which
+ * is the layout `VM__vectorcall` expects on the stack. Calls are spliced in place by
+ * `pk_partial__unpack`, so no intermediate tuple or dict is built.
+ */
+
+#define Partial__FUNC 0
+#define Partial__ARGS 1
+#define Partial__KWARGS 2
+
+static bool partial__new__(int argc, py_Ref argv) {
+    // __new__(cls, func, *args, **kwargs)
+    py_Ref func = py_arg(1);
+    py_Ref args = py_arg(2);
+    Dict* kwargs = py_touserdata(py_arg(3));
+    if(!py_callable(func)) return TypeError("the first argument must be callable");
+
+    py_Ref inner_args = NULL;
+    py_Ref inner_kwargs = NULL;
+    if(py_istype(func, tp_partial)) {
+        // flatten `partial(partial(f, ...), ...)`
+        inner_args = py_getslot(func, Partial__ARGS);
+        inner_kwargs = py_getslot(func, Partial__KWARGS);
+        func = py_getslot(func, Partial__FUNC);
+    }
+
+    py_Ref out = py_pushtmp();
+    py_newobject(out, tp_partial, 3, 0);
+    py_setslot(out, Partial__FUNC, func);
+
+    int n_inner = inner_args ? py_tuple_len(inner_args) : 0;
+    int n_args = py_tuple_len(args);
+    py_Ref p = py_newtuple(py_getslot(out, Partial__ARGS), n_inner + n_args);
+    for(int i = 0; i < n_inner; i++) {
+        p[i] = *py_tuple_getitem(inner_args, i);
+    }
+    for(int i = 0; i < n_args; i++) {
+        p[n_inner + i] = *py_tuple_getitem(args, i);
+    }
+
+    // keyword arguments of the outer call override the inner ones
+    int n_inner_kw = inner_kwargs ? py_tuple_len(inner_kwargs) / 2 : 0;
+    py_Ref name = py_pushtmp();
+    int n_kw = kwargs->length;
+    for(int pass = 0; pass < 2; pass++) {
+        py_TValue* kw = NULL;
+        if(pass == 1) kw = py_newtuple(py_getslot(out, Partial__KWARGS), 2 * n_kw);
+        int j = 0;
+        for(int i = 0; i < n_inner_kw; i++) {
+            py_Ref key = py_tuple_getitem(inner_kwargs, 2 * i);
+            py_newstr(name, py_name2str((py_Name)py_toint(key)));
+            DictEntry* entry;
+            if(!Dict__try_get(kwargs, name, &entry)) return false;
+            if(entry) continue;
+            if(pass == 0) {
+                n_kw++;
+            } else {
+                kw[j++] = *key;
+                kw[j++] = *py_tuple_getitem(inner_kwargs, 2 * i + 1);
+            }
+        }
+        if(pass == 0) continue;
+        for(int i = 0; i < kwargs->entries.length; i++) {
+            DictEntry* entry = c11__at(DictEntry, &kwargs->entries, i);
+            if(py_isnil(&entry->key)) continue;
+            py_newint(&kw[j++], (uintptr_t)py_namev(py_tosv(&entry->key)));
+            kw[j++] = entry->val;
+        }
+    }
+    py_pop();
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool partial__call__(int argc, py_Ref argv) {
+    // only reached through an explicit `__call__`, `VM__vectorcall` handles the other calls
+    py_push(argv);
+    py_pushnil();
+    for(int i = 1; i < argc; i++) {
+        py_push(&argv[i]);
+    }
+    return py_vectorcall(argc - 1, 0);
+}
+
+static bool partial__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstr(&buf, "functools.partial(");
+    py_Ref args = py_getslot(argv, Partial__ARGS);
+    py_Ref kwargs = py_getslot(argv, Partial__KWARGS);
+    int n_args = py_tuple_len(args);
+    int n_kw = py_tuple_len(kwargs) / 2;
+    for(int i = -1; i < n_args; i++) {
+        py_Ref item = i == -1 ? py_getslot(argv, Partial__FUNC) : py_tuple_getitem(args, i);
+        if(!py_repr(item)) {
+            c11_sbuf__dtor(&buf);
+            return false;
+        }
+        if(i != -1) c11_sbuf__write_cstr(&buf, ", ");
+        c11_sbuf__write_sv(&buf, py_tosv(py_retval()));
+    }
+    for(int i = 0; i < n_kw; i++) {
+        if(!py_repr(py_tuple_getitem(kwargs, 2 * i + 1))) {
+            c11_sbuf__dtor(&buf);
+            return false;
+        }
+        c11_sbuf__write_cstr(&buf, ", ");
+        c11_sbuf__write_cstr(&buf, py_name2str((py_Name)py_toint(py_tuple_getitem(kwargs, 2 * i))));
+        c11_sbuf__write_char(&buf, '=');
+        c11_sbuf__write_sv(&buf, py_tosv(py_retval()));
+    }
+    c11_sbuf__write_char(&buf, ')');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+static bool partial_func(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_assign(py_retval(), py_getslot(argv, Partial__FUNC));
+    return true;
+}
+
+static bool partial_args(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_assign(py_retval(), py_getslot(argv, Partial__ARGS));
+    return true;
+}
+
+static bool partial_keywords(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Ref kwargs = py_getslot(argv, Partial__KWARGS);
+    py_Ref out = py_pushtmp();
+    py_newdict(out);
+    for(int i = 0; i < py_tuple_len(kwargs) / 2; i++) {
+        const char* name = py_name2str((py_Name)py_toint(py_tuple_getitem(kwargs, 2 * i)));
+        if(!py_dict_setitem_by_str(out, name, py_tuple_getitem(kwargs, 2 * i + 1))) return false;
+    }
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool Partial__has_kwarg(py_Ref kwargs, int kwargc, py_Ref name) {
+    for(int j = 0; j < kwargc; j++) {
+        if(kwargs[2 * j]._i64 == name->_i64) return true;
+    }
+    return false;
+}
+
+bool pk_partial__unpack(py_StackRef p0, uint16_t* argc, uint16_t* kwargc) {
+    // [partial, self/nil, args..., kwargs...]
+    // -> [func, nil, p_args..., <self>, args..., p_kwargs..., kwargs...]
+    VM* vm = pk_current_vm;
+    py_Ref p_args = py_getslot(p0, Partial__ARGS);
+    py_Ref p_kwargs = py_getslot(p0, Partial__KWARGS);
+    int n_args = py_tuple_len(p_args);
+    int n_kw = py_tuple_len(p_kwargs) / 2;
+
+    py_Ref argv = p0 + 1 + (int)py_isnil(p0 + 1);
+    py_Ref p1 = p0 + 2 + *argc;
+    int n_pos = p1 - argv;
+    if(vm->stack.sp + n_args + 2 * n_kw >= vm->stack.end) {
+        return py_exception(tp_RecursionError, "maximum recursion depth exceeded");
+    }
+
+    // keyword arguments of the call override the stored ones
+    py_TValue* kw = py_tuple_data(p_kwargs);
+    int n_kw_used = 0;
+    for(int i = 0; i < n_kw; i++) {
+        n_kw_used += !Partial__has_kwarg(p1, *kwargc, &kw[2 * i]);
+    }
+
+    py_Ref new_argv = p0 + 2;
+    py_Ref new_p1 = new_argv + n_args + n_pos;
+    py_Ref new_kwargs = new_p1 + 2 * n_kw_used;
+    memmove(new_kwargs, p1, 2 * *kwargc * sizeof(py_TValue));
+    memmove(new_argv + n_args, argv, n_pos * sizeof(py_TValue));
+    memcpy(new_argv, py_tuple_data(p_args), n_args * sizeof(py_TValue));
+    py_Ref p = new_p1;
+    for(int i = 0; i < n_kw; i++) {
+        if(Partial__has_kwarg(new_kwargs, *kwargc, &kw[2 * i])) continue;
+        *p++ = kw[2 * i];
+        *p++ = kw[2 * i + 1];
+    }
+    vm->stack.sp = new_p1 + 2 * (n_kw_used + *kwargc);
+    // `p_args` and `p_kwargs` are copied, the partial itself can be overwritten now
+    p0[0] = *py_getslot(p0, Partial__FUNC);
+    py_newnil(p0 + 1);
+    *argc = n_args + n_pos;
+    *kwargc = n_kw_used + *kwargc;
+    return true;
+}
+
+/* `_lru_cache_wrapper` maps argument keys to results in a `Dict`. A bounded cache keeps its
+ * entries in a doubly linked list threaded through `nodes`, most recently used first, and the
+ * dict maps each key to its node index. An unbounded cache maps keys to results directly.
+ */
+
+typedef struct {
+    py_TValue key;
+    py_TValue result;
+    int prev;  // towards the most recently used node, -1 at the head
+    int next;  // towards the least recently used node, -1 at the tail
+} LruNode;
+
+typedef struct {
+    py_TValue func;
+    int maxsize;  // -1 if unbounded
+    bool typed;
+    int hits;
+    int misses;
+    Dict table;
+    LruNode* nodes;
+    int length;
+    int capacity;
+    int head;
+    int tail;
+} c11_lru_cache;
+
+static void c11_lru_cache__dtor(c11_lru_cache* self) {
+    Dict__dtor(&self->table);
+    PK_FREE(self->nodes);
+}
+
+void c11_lru_cache__mark(void* ud, c11_vector* p_stack) {
+    c11_lru_cache* self = ud;
+    pk__mark_value(&self->func);
+    for(int i = 0; i < self->table.entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->table.entries, i);
+        if(py_isnil(&entry->key)) continue;
+        pk__mark_value(&entry->key);
+        pk__mark_value(&entry->val);
+    }
+    for(int i = 0; i < self->length; i++) {
+        pk__mark_value(&self->nodes[i].result);
+    }
+}
+
+static void c11_lru_cache__clear(c11_lru_cache* self) {
+    Dict__clear(&self->table);
+    self->length = 0;
+    self->head = self->tail = -1;
+    self->hits = self->misses = 0;
+}
+
+static void c11_lru_cache__unlink(c11_lru_cache* self, int i) {
+    LruNode* node = &self->nodes[i];
+    if(node->prev != -1) {
+        self->nodes[node->prev].next = node->next;
+    } else {
+        self->head = node->next;
+    }
+    if(node->next != -1) {
+        self->nodes[node->next].prev = node->prev;
+    } else {
+        self->tail = node->prev;
+    }
+}
+
+static void c11_lru_cache__push_front(c11_lru_cache* self, int i) {
+    LruNode* node = &self->nodes[i];
+    node->prev = -1;
+    node->next = self->head;
+    if(self->head != -1) self->nodes[self->head].prev = i;
+    self->head = i;
+    if(self->tail == -1) self->tail = i;
+}
+
+/// Build the cache key of `argv[0:argc]` and the keyword arguments at `kwargs` into `out`.
+static void c11_lru_cache__key(c11_lru_cache* self,
+                               py_OutRef out,
+                               py_Ref argv,
+                               int argc,
+                               py_Ref kwargs,
+                               int kwargc) {
+    if(argc == 1 && kwargc == 0 && (argv->type == tp_int || argv->type == tp_str)) {
+        // a single int or str is its own key, whose type is implied
+        py_assign(out, argv);
+        return;
+    }
+    int length = argc + (kwargc ? 1 + 2 * kwargc : 0) + (self->typed ? argc + kwargc : 0);
+    py_TValue* p = py_newtuple(out, length);
+    for(int i = 0; i < argc; i++) {
+        *p++ = argv[i];
+    }
+    if(kwargc) {
+        // the wrapper type separates positional and keyword arguments
+        *p++ = *py_tpobject(tp_lru_cache_wrapper);
+        for(int i = 0; i < kwargc; i++) {
+            py_newstr(p++, py_name2str((py_Name)py_toint(&kwargs[2 * i])));
+            *p++ = kwargs[2 * i + 1];
+        }
+    }
+    if(self->typed) {
+        for(int i = 0; i < argc; i++) {
+            *p++ = *py_tpobject(argv[i].type);
+        }
+        for(int i = 0; i < kwargc; i++) {
+            *p++ = *py_tpobject(kwargs[2 * i + 1].type);
+        }
+    }
+}
+
+/// Store `result` under `key`, evicting the least recently used entry if the cache is full.
+static bool c11_lru_cache__insert(c11_lru_cache* self, py_Ref key, py_Ref result) {
+    if(self->maxsize == -1) return Dict__set(&self->table, key, result);
+    int index;
+    if(self->length < self->maxsize) {
+        if(self->length == self->capacity) {
+            self->capacity = c11__min(c11__max(self->capacity * 2, 8), self->maxsize);
+            self->nodes = PK_REALLOC(self->nodes, sizeof(LruNode) * self->capacity);
+        }
+        index = self->length++;
+    } else {
+        index = self->tail;
+        c11_lru_cache__unlink(self, index);
+        py_Ref evicted = py_pushtmp();
+        py_assign(evicted, &self->nodes[index].key);
+        int res = Dict__pop(&self->table, evicted);
+        py_pop();
+        if(res == -1) return false;
+    }
+    LruNode* node = &self->nodes[index];
+    node->key = *key;
+    node->result = *result;
+    c11_lru_cache__push_front(self, index);
+    py_TValue value;
+    py_newint(&value, index);
+    return Dict__set(&self->table, key, &value);
+}
+
+bool pk_lru_cache__call(py_StackRef p0, int argc, int kwargc) {
+    // [wrapper, self/nil, args..., kwargs...]
+    c11_lru_cache* self = py_touserdata(p0);
+    py_Ref argv = p0 + 1 + (int)py_isnil(p0 + 1);
+    py_Ref kwargs = p0 + 2 + argc;
+    int n_pos = kwargs - argv;
+
+    py_Ref key = py_pushtmp();
+    if(self->maxsize != 0) {
+        c11_lru_cache__key(self, key, argv, n_pos, kwargs, kwargc);
+        DictEntry* entry;
+        if(!Dict__try_get(&self->table, key, &entry)) return false;
+        if(entry) {
+            self->hits++;
+            if(self->maxsize == -1) {
+                py_assign(py_retval(), &entry->val);
+            } else {
+                int index = py_toint(&entry->val);
+                if(index != self->head) {
+                    c11_lru_cache__unlink(self, index);
+                    c11_lru_cache__push_front(self, index);
+                }
+                py_assign(py_retval(), &self->nodes[index].result);
+            }
+            return true;
+        }
+    }
+    self->misses++;
+
+    // call `func` with a copy of the arguments, the originals keep `key` company on the stack
+    py_push(&self->func);
+    py_pushnil();
+    for(int i = 0; i < n_pos + 2 * kwargc; i++) {
+        py_push(&argv[i]);
+    }
+    if(!py_vectorcall(n_pos, kwargc)) return false;
+    if(self->maxsize == 0) return true;
+
+    py_Ref result = py_pushtmp();
+    py_assign(result, py_retval());
+    // a recursive call may have cached the same key already
+    DictEntry* entry;
+    if(!Dict__try_get(&self->table, key, &entry)) return false;
+    if(!entry && !c11_lru_cache__insert(self, key, result)) return false;
+    py_assign(py_retval(), result);
+    return true;
+}
+
+static bool lru_cache_wrapper__new__(int argc, py_Ref argv) {
+    // __new__(cls, func, maxsize, typed)
+    PY_CHECK_ARGC(4);
+    if(!py_callable(py_arg(1))) return TypeError("the first argument must be callable");
+    int maxsize;
+    if(py_isnone(py_arg(2))) {
+        maxsize = -1;
+    } else {
+        if(!py_checkint(py_arg(2))) return false;
+        py_i64 n = py_toint(py_arg(2));
+        maxsize = n < 0 ? 0 : (int)c11__min(n, INT32_MAX);
+    }
+    c11_lru_cache* self =
+        py_newobject(py_retval(), tp_lru_cache_wrapper, 0, sizeof(c11_lru_cache));
+    self->func = *py_arg(1);
+    self->maxsize = maxsize;
+    self->typed = py_tobool(py_arg(3));
+    Dict__ctor(&self->table, PK_DICT_MIN_CAPACITY, 4);
+    self->nodes = NULL;
+    self->capacity = 0;
+    c11_lru_cache__clear(self);
+    return true;
+}
+
+static bool lru_cache_wrapper__call__(int argc, py_Ref argv) {
+    // only reached through an explicit `__call__`, `VM__vectorcall` handles the other calls
+    py_push(argv);
+    py_pushnil();
+    for(int i = 1; i < argc; i++) {
+        py_push(&argv[i]);
+    }
+    return py_vectorcall(argc - 1, 0);
+}
+
+static bool lru_cache_wrapper_cache_info(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_lru_cache* self = py_touserdata(argv);
+    int res = py_import("functools");
+    if(res == -1) return false;
+    if(res == 0) return ImportError("module 'functools' not found");
+    py_Ref cls = py_pushtmp();
+    if(!py_getattr(py_retval(), py_name("_CacheInfo"))) return false;
+    py_assign(cls, py_retval());
+    py_Ref args = py_pushtmp();
+    for(int i = 1; i < 4; i++) {
+        py_pushtmp();
+    }
+    py_newint(&args[0], self->hits);
+    py_newint(&args[1], self->misses);
+    if(self->maxsize == -1) {
+        py_newnone(&args[2]);
+    } else {
+        py_newint(&args[2], self->maxsize);
+    }
+    py_newint(&args[3], self->maxsize == -1 ? self->table.length : self->length);
+    if(!py_call(cls, 4, args)) return false;
+    py_shrink(5);
+    return true;
+}
+
+static bool lru_cache_wrapper_cache_clear(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_lru_cache__clear(py_touserdata(argv));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool lru_cache_wrapper__wrapped__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_lru_cache* self = py_touserdata(argv);
+    py_assign(py_retval(), &self->func);
+    return true;
+}
+
+static void register_partial(py_Ref mod) {
+    py_Type type = pk_newtype("partial", tp_object, mod, NULL, false, true);
+    assert(type == tp_partial);
+    py_setdict(mod, py_name("partial"), py_tpobject(type));
+    py_bind(py_tpobject(type), "__new__(cls, func, *args, **kwargs)", partial__new__);
+    py_bindmagic(type, __call__, partial__call__);
+    py_bindmagic(type, __repr__, partial__repr__);
+    py_bindproperty(type, "func", partial_func, NULL);
+    py_bindproperty(type, "args", partial_args, NULL);
+    py_bindproperty(type, "keywords", partial_keywords, NULL);
+}
+
+static void register_lru_cache_wrapper(py_Ref mod) {
+    py_Type type = pk_newtype("_lru_cache_wrapper",
+                              tp_object,
+                              mod,
+                              (void (*)(void*))c11_lru_cache__dtor,
+                              false,
+                              true);
+    assert(type == tp_lru_cache_wrapper);
+    py_setdict(mod, py_name("_lru_cache_wrapper"), py_tpobject(type));
+    py_bindmagic(type, __new__, lru_cache_wrapper__new__);
+    py_bindmagic(type, __call__, lru_cache_wrapper__call__);
+    py_bindmethod(type, "cache_info", lru_cache_wrapper_cache_info);
+    py_bindmethod(type, "cache_clear", lru_cache_wrapper_cache_clear);
+    py_bindproperty(type, "__wrapped__", lru_cache_wrapper__wrapped__, NULL);
+}
+
+void pk__add_module_functools() {
+    // re-exported by `python/functools.py`
+    py_GlobalRef mod = py_newmodule("_functools");
+
+    register_partial(mod);
+    register_lru_cache_wrapper(mod);
+}
+
+#undef Partial__FUNC
+#undef Partial__ARGS
+#undef Partial__KWARGS
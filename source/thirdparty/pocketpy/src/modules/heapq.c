@@ -0,0 +1,164 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/interpreter/types.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* The heap is a plain `list` kept in min-heap order. Items are moved by swapping, so every item
+ * stays inside the list (and thus reachable) while `__lt__` runs arbitrary code. Any change of
+ * length during a comparison is reported as an error, as the indices are no longer valid.
+ */
+
+/// -1: error, 0: false, 1: true
+static int heapq__less(List* heap, int i, int j, py_Ref tmp) {
+    int length = heap->length;
+    py_assign(&tmp[0], c11__at(py_TValue, heap, i));
+    py_assign(&tmp[1], c11__at(py_TValue, heap, j));
+    int res = py_less(&tmp[0], &tmp[1]);
+    if(res == -1) return -1;
+    if(heap->length != length) {
+        RuntimeError("list changed size during iteration");
+        return -1;
+    }
+    return res;
+}
+
+PK_INLINE static void heapq__swap(List* heap, int i, int j) {
+    py_TValue* data = heap->data;
+    py_TValue tmp = data[i];
+    data[i] = data[j];
+    data[j] = tmp;
+}
+
+/// The heap is valid at all indices >= `startpos`, except possibly for `pos`.
+/// Move the item at `pos` towards the root until it fits.
+static bool heapq__siftdown(List* heap, int startpos, int pos, py_Ref tmp) {
+    while(pos > startpos) {
+        int parentpos = (pos - 1) >> 1;
+        int res = heapq__less(heap, pos, parentpos, tmp);
+        if(res == -1) return false;
+        if(!res) break;
+        heapq__swap(heap, pos, parentpos);
+        pos = parentpos;
+    }
+    return true;
+}
+
+/// Bubble the smaller child up until hitting a leaf, then sift the item at `pos` back down.
+static bool heapq__siftup(List* heap, int pos, py_Ref tmp) {
+    int endpos = heap->length;
+    int startpos = pos;
+    int limit = endpos >> 1;
+    while(pos < limit) {
+        int childpos = 2 * pos + 1;
+        if(childpos + 1 < endpos) {
+            int res = heapq__less(heap, childpos, childpos + 1, tmp);
+            if(res == -1) return false;
+            childpos += res ^ 1;
+        }
+        heapq__swap(heap, pos, childpos);
+        pos = childpos;
+    }
+    return heapq__siftdown(heap, startpos, pos, tmp);
+}
+
+static bool heapq_heappush(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    List* heap = py_touserdata(py_arg(0));
+    py_list_append(py_arg(0), py_arg(1));
+    py_Ref tmp = py_pushtmp();
+    py_pushtmp();
+    if(!heapq__siftdown(heap, 0, heap->length - 1, tmp)) return false;
+    py_shrink(2);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool heapq_heappop(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    List* heap = py_touserdata(py_arg(0));
+    if(heap->length == 0) return IndexError("index out of range");
+    py_TValue lastelt = c11_vector__back(py_TValue, heap);
+    heap->length--;
+    if(heap->length == 0) {
+        py_assign(py_retval(), &lastelt);
+        return true;
+    }
+    py_Ref returnitem = py_pushtmp();
+    py_assign(returnitem, c11__at(py_TValue, heap, 0));
+    c11__setitem(py_TValue, heap, 0, lastelt);
+    py_Ref tmp = py_pushtmp();
+    py_pushtmp();
+    if(!heapq__siftup(heap, 0, tmp)) return false;
+    py_assign(py_retval(), returnitem);
+    py_shrink(3);
+    return true;
+}
+
+static bool heapq_heapreplace(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    List* heap = py_touserdata(py_arg(0));
+    if(heap->length == 0) return IndexError("index out of range");
+    py_Ref returnitem = py_pushtmp();
+    py_assign(returnitem, c11__at(py_TValue, heap, 0));
+    c11__setitem(py_TValue, heap, 0, *py_arg(1));
+    py_Ref tmp = py_pushtmp();
+    py_pushtmp();
+    if(!heapq__siftup(heap, 0, tmp)) return false;
+    py_assign(py_retval(), returnitem);
+    py_shrink(3);
+    return true;
+}
+
+static bool heapq_heappushpop(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    List* heap = py_touserdata(py_arg(0));
+    if(heap->length == 0) {
+        py_assign(py_retval(), py_arg(1));
+        return true;
+    }
+    py_Ref returnitem = py_pushtmp();
+    py_assign(returnitem, c11__at(py_TValue, heap, 0));
+    int res = py_less(returnitem, py_arg(1));
+    if(res == -1) return false;
+    if(!res) {
+        py_pop();
+        py_assign(py_retval(), py_arg(1));
+        return true;
+    }
+    if(heap->length == 0) return IndexError("index out of range");
+    c11__setitem(py_TValue, heap, 0, *py_arg(1));
+    py_Ref tmp = py_pushtmp();
+    py_pushtmp();
+    if(!heapq__siftup(heap, 0, tmp)) return false;
+    py_assign(py_retval(), returnitem);
+    py_shrink(3);
+    return true;
+}
+
+static bool heapq_heapify(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    List* heap = py_touserdata(py_arg(0));
+    py_Ref tmp = py_pushtmp();
+    py_pushtmp();
+    for(int i = heap->length / 2 - 1; i >= 0; i--) {
+        if(!heapq__siftup(heap, i, tmp)) return false;
+    }
+    py_shrink(2);
+    py_newnone(py_retval());
+    return true;
+}
+
+void pk__add_module_heapq() {
+    py_GlobalRef mod = py_newmodule("heapq");
+
+    py_bindfunc(mod, "heappush", heapq_heappush);
+    py_bindfunc(mod, "heappop", heapq_heappop);
+    py_bindfunc(mod, "heapreplace", heapq_heapreplace);
+    py_bindfunc(mod, "heappushpop", heapq_heappushpop);
+    py_bindfunc(mod, "heapify", heapq_heapify);
+}
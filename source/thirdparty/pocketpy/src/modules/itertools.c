@@ -0,0 +1,782 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* Every iterator here keeps its python objects in slots, which the GC marks, and its plain C
+ * state (indices, counters) in the userdata. Results are always fresh tuples, since a tuple
+ * handed out may still be referenced by the caller. `StopIteration` is caught by `py_next()`
+ * without unwinding, so the stack must be restored before raising it.
+ */
+
+/// Convert `iterable` into a tuple in `out`.
+static bool Itertools__totuple(py_Ref iterable, py_OutRef out) {
+    if(py_istuple(iterable)) {
+        py_assign(out, iterable);
+        return true;
+    }
+    if(!py_tpcall(tp_tuple, 1, iterable)) return false;
+    py_assign(out, py_retval());
+    return true;
+}
+
+static bool Itertools__check_r(py_Ref arg, py_i64* out) {
+    if(!py_checkint(arg)) return false;
+    *out = py_toint(arg);
+    if(*out < 0) return ValueError("r must be non-negative");
+    return true;
+}
+
+/* chain(*iterables) */
+
+#define Chain__SOURCE 0
+#define Chain__ACTIVE 1
+
+static bool chain__new__(int argc, py_Ref argv) {
+    // __new__(cls, *iterables)
+    py_Ref out = py_pushtmp();
+    py_newobject(out, py_totype(argv), 2, 0);
+    if(!py_iter(py_arg(1))) return false;
+    py_setslot(out, Chain__SOURCE, py_retval());
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool chain_from_iterable(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Ref chain = py_getdict(py_getmodule("itertools"), py_name("chain"));
+    py_Ref out = py_pushtmp();
+    py_newobject(out, py_totype(chain), 2, 0);
+    if(!py_iter(py_arg(0))) return false;
+    py_setslot(out, Chain__SOURCE, py_retval());
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool chain__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    while(true) {
+        py_Ref active = py_getslot(argv, Chain__ACTIVE);
+        if(py_isnil(active)) {
+            int res = py_next(py_getslot(argv, Chain__SOURCE));
+            if(res == -1) return false;
+            if(res == 0) return StopIteration();
+            py_Ref iterable = py_pushtmp();
+            py_assign(iterable, py_retval());
+            if(!py_iter(iterable)) return false;
+            py_setslot(argv, Chain__ACTIVE, py_retval());
+            py_pop();
+            continue;
+        }
+        int res = py_next(active);
+        if(res == -1) return false;
+        if(res == 1) return true;
+        py_setslot(argv, Chain__ACTIVE, py_NIL());
+    }
+}
+
+/* islice(iterable, stop) / islice(iterable, start, stop[, step]) */
+
+typedef struct {
+    py_i64 next;  // index of the next item to yield
+    py_i64 stop;  // -1 if unbounded
+    py_i64 step;
+    py_i64 consumed;
+} Islice;
+
+static bool Islice__index(py_Ref arg, py_i64 dflt, py_i64* out) {
+    if(py_isnone(arg)) {
+        *out = dflt;
+        return true;
+    }
+    if(!py_isint(arg) || py_toint(arg) < 0) {
+        return ValueError("indices for islice() must be None or an integer: 0 <= x <= sys.maxsize");
+    }
+    *out = py_toint(arg);
+    return true;
+}
+
+static bool islice__new__(int argc, py_Ref argv) {
+    if(argc < 3 || argc > 5) return TypeError("islice expected 2 to 4 arguments, got %d", argc - 1);
+    py_i64 start = 0, stop = -1, step = 1;
+    if(argc == 3) {
+        if(!Islice__index(py_arg(2), -1, &stop)) return false;
+    } else {
+        if(!Islice__index(py_arg(2), 0, &start)) return false;
+        if(!Islice__index(py_arg(3), -1, &stop)) return false;
+        if(argc == 5) {
+            if(!py_isnone(py_arg(4)) && (!py_isint(py_arg(4)) || py_toint(py_arg(4)) <= 0)) {
+                return ValueError("step for islice() must be a positive integer or None");
+            }
+            if(!py_isnone(py_arg(4))) step = py_toint(py_arg(4));
+        }
+    }
+    py_Ref out = py_pushtmp();
+    Islice* ud = py_newobject(out, py_totype(argv), 1, sizeof(Islice));
+    ud->next = start;
+    ud->stop = stop;
+    ud->step = step;
+    ud->consumed = 0;
+    if(!py_iter(py_arg(1))) return false;
+    py_setslot(out, 0, py_retval());
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool islice__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Islice* ud = py_touserdata(argv);
+    if(ud->stop != -1 && ud->next >= ud->stop) {
+        // skip the rest of `[consumed, stop)` like CPython does
+        while(ud->consumed < ud->stop) {
+            int res = py_next(py_getslot(argv, 0));
+            if(res == -1) return false;
+            if(res == 0) break;
+            ud->consumed++;
+        }
+        return StopIteration();
+    }
+    while(ud->consumed <= ud->next) {
+        int res = py_next(py_getslot(argv, 0));
+        if(res == -1) return false;
+        if(res == 0) {
+            // exhausted, make every later call stop immediately
+            ud->stop = ud->next = 0;
+            return StopIteration();
+        }
+        ud->consumed++;
+    }
+    ud->next += ud->step;
+    return true;
+}
+
+/* count(start=0, step=1) */
+
+static bool count__new__(int argc, py_Ref argv) {
+    // __new__(cls, start=0, step=1)
+    py_newobject(py_retval(), py_totype(argv), 2, 0);
+    py_setslot(py_retval(), 0, py_arg(1));
+    py_setslot(py_retval(), 1, py_arg(2));
+    return true;
+}
+
+static bool count__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Ref curr = py_pushtmp();
+    py_assign(curr, py_getslot(argv, 0));
+    py_Ref step = py_getslot(argv, 1);
+    if(py_isint(curr) && py_isint(step)) {
+        py_TValue next;
+        py_newint(&next, py_toint(curr) + py_toint(step));
+        py_setslot(argv, 0, &next);
+    } else {
+        if(!py_binaryadd(curr, step)) return false;
+        py_setslot(argv, 0, py_retval());
+    }
+    py_assign(py_retval(), curr);
+    py_pop();
+    return true;
+}
+
+static bool count__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstr(&buf, "count(");
+    for(int i = 0; i < 2; i++) {
+        py_Ref val = py_getslot(argv, i);
+        // the step is only shown if it is not 1
+        if(i == 1 && py_isint(val) && py_toint(val) == 1) break;
+        if(!py_repr(val)) {
+            c11_sbuf__dtor(&buf);
+            return false;
+        }
+        if(i == 1) c11_sbuf__write_cstr(&buf, ", ");
+        c11_sbuf__write_sv(&buf, py_tosv(py_retval()));
+    }
+    c11_sbuf__write_char(&buf, ')');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+/* cycle(iterable) */
+
+typedef struct {
+    int index;
+    bool exhausted;
+} Cycle;
+
+static bool cycle__new__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    py_Ref out = py_pushtmp();
+    Cycle* ud = py_newobject(out, py_totype(argv), 2, sizeof(Cycle));
+    ud->index = 0;
+    ud->exhausted = false;
+    if(!py_iter(py_arg(1))) return false;
+    py_setslot(out, 0, py_retval());
+    py_newlist(py_getslot(out, 1));
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool cycle__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Cycle* ud = py_touserdata(argv);
+    py_Ref saved = py_getslot(argv, 1);
+    if(!ud->exhausted) {
+        int res = py_next(py_getslot(argv, 0));
+        if(res == -1) return false;
+        if(res == 1) {
+            py_list_append(saved, py_retval());
+            return true;
+        }
+        ud->exhausted = true;
+        py_setslot(argv, 0, py_NIL());
+    }
+    int length = py_list_len(saved);
+    if(length == 0) return StopIteration();
+    py_assign(py_retval(), py_list_getitem(saved, ud->index));
+    ud->index = (ud->index + 1) % length;
+    return true;
+}
+
+/* repeat(object, times=None) */
+
+static bool repeat__new__(int argc, py_Ref argv) {
+    // __new__(cls, object, times=None)
+    py_i64 times = -1;
+    if(!py_isnone(py_arg(2))) {
+        if(!py_checkint(py_arg(2))) return false;
+        times = c11__max(py_toint(py_arg(2)), 0);
+    }
+    py_i64* ud = py_newobject(py_retval(), py_totype(argv), 1, sizeof(py_i64));
+    *ud = times;
+    py_setslot(py_retval(), 0, py_arg(1));
+    return true;
+}
+
+static bool repeat__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_i64* remaining = py_touserdata(argv);
+    if(*remaining == 0) return StopIteration();
+    if(*remaining > 0) (*remaining)--;
+    py_assign(py_retval(), py_getslot(argv, 0));
+    return true;
+}
+
+/* zip_longest(*iterables, fillvalue=None) */
+
+static bool zip_longest__new__(int argc, py_Ref argv) {
+    // __new__(cls, *iterables, fillvalue=None)
+    int n = py_tuple_len(py_arg(1));
+    py_Ref out = py_pushtmp();
+    int* active = py_newobject(out, py_totype(argv), 2, sizeof(int));
+    *active = n;
+    py_Ref iters = py_getslot(out, 0);
+    py_newtuple(iters, n);
+    for(int i = 0; i < n; i++) {
+        if(!py_iter(py_tuple_getitem(py_arg(1), i))) return false;
+        py_tuple_setitem(iters, i, py_retval());
+    }
+    py_setslot(out, 1, py_arg(2));
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool zip_longest__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    int* active = py_touserdata(argv);
+    if(*active == 0) return StopIteration();
+    py_Ref iters = py_getslot(argv, 0);
+    int n = py_tuple_len(iters);
+    py_Ref result = py_pushtmp();
+    py_newtuple(result, n);
+    for(int i = 0; i < n; i++) {
+        py_Ref it = py_tuple_getitem(iters, i);
+        if(!py_isnil(it)) {
+            int res = py_next(it);
+            if(res == -1) return false;
+            if(res == 1) {
+                py_tuple_setitem(result, i, py_retval());
+                continue;
+            }
+            py_tuple_setitem(iters, i, py_NIL());
+            if(--(*active) == 0) {
+                py_pop();
+                return StopIteration();
+            }
+        }
+        py_tuple_setitem(result, i, py_getslot(argv, 1));
+    }
+    py_assign(py_retval(), result);
+    py_pop();
+    return true;
+}
+
+/* product(*iterables, repeat=1) */
+
+typedef struct {
+    bool started;
+    bool stopped;
+    int indices[];
+} Product;
+
+static bool product__new__(int argc, py_Ref argv) {
+    // __new__(cls, *iterables, repeat=1)
+    if(!py_checkint(py_arg(2))) return false;
+    py_i64 repeat = py_toint(py_arg(2));
+    if(repeat < 0) return ValueError("repeat argument cannot be negative");
+    int n_iterables = py_tuple_len(py_arg(1));
+    int n = n_iterables * (int)repeat;
+    py_Ref out = py_pushtmp();
+    Product* ud = py_newobject(out, py_totype(argv), 1, sizeof(Product) + n * sizeof(int));
+    ud->started = false;
+    ud->stopped = false;
+    py_Ref pools = py_getslot(out, 0);
+    py_newtuple(pools, n);
+    for(int i = 0; i < n_iterables && n > 0; i++) {
+        if(!Itertools__totuple(py_tuple_getitem(py_arg(1), i), py_tuple_getitem(pools, i))) {
+            return false;
+        }
+        if(py_tuple_len(py_tuple_getitem(pools, i)) == 0) ud->stopped = true;
+    }
+    for(int i = n_iterables; i < n; i++) {
+        py_tuple_setitem(pools, i, py_tuple_getitem(pools, i % n_iterables));
+    }
+    for(int i = 0; i < n; i++) {
+        ud->indices[i] = 0;
+    }
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool product__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Product* ud = py_touserdata(argv);
+    if(ud->stopped) return StopIteration();
+    py_Ref pools = py_getslot(argv, 0);
+    int n = py_tuple_len(pools);
+    if(ud->started) {
+        // advance the rightmost index, carrying to the left
+        int i = n - 1;
+        for(; i >= 0; i--) {
+            int length = py_tuple_len(py_tuple_getitem(pools, i));
+            if(++ud->indices[i] < length) break;
+            ud->indices[i] = 0;
+        }
+        if(i < 0) {
+            ud->stopped = true;
+            return StopIteration();
+        }
+    }
+    ud->started = true;
+    py_TValue* p = py_newtuple(py_retval(), n);
+    for(int i = 0; i < n; i++) {
+        p[i] = *py_tuple_getitem(py_tuple_getitem(pools, i), ud->indices[i]);
+    }
+    return true;
+}
+
+/* permutations(iterable, r=None) */
+
+typedef struct {
+    int n;
+    int r;
+    bool started;
+    bool stopped;
+    int data[];  // indices[n], then cycles[r]
+} Permutations;
+
+static bool permutations__new__(int argc, py_Ref argv) {
+    // __new__(cls, iterable, r=None)
+    py_Ref out = py_pushtmp();
+    py_Ref pool = py_pushtmp();
+    if(!Itertools__totuple(py_arg(1), pool)) return false;
+    int n = py_tuple_len(pool);
+    py_i64 r = n;
+    if(!py_isnone(py_arg(2)) && !Itertools__check_r(py_arg(2), &r)) return false;
+    int udsize = sizeof(Permutations) + (n + (int)c11__min(r, n)) * sizeof(int);
+    Permutations* ud = py_newobject(out, py_totype(argv), 1, udsize);
+    py_setslot(out, 0, pool);
+    ud->n = n;
+    ud->r = (int)c11__min(r, n);
+    ud->started = false;
+    ud->stopped = r > n;
+    int* indices = ud->data;
+    int* cycles = ud->data + n;
+    for(int i = 0; i < n; i++) {
+        indices[i] = i;
+    }
+    for(int i = 0; i < ud->r; i++) {
+        cycles[i] = n - i;
+    }
+    py_assign(py_retval(), out);
+    py_shrink(2);
+    return true;
+}
+
+static bool permutations__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Permutations* ud = py_touserdata(argv);
+    if(ud->stopped) return StopIteration();
+    int n = ud->n, r = ud->r;
+    int* indices = ud->data;
+    int* cycles = ud->data + n;
+    if(ud->started) {
+        if(n == 0) {
+            ud->stopped = true;
+            return StopIteration();
+        }
+        int i = r - 1;
+        for(; i >= 0; i--) {
+            cycles[i]--;
+            if(cycles[i] == 0) {
+                // rotate indices[i:] one step to the left
+                int first = indices[i];
+                memmove(indices + i, indices + i + 1, (n - i - 1) * sizeof(int));
+                indices[n - 1] = first;
+                cycles[i] = n - i;
+            } else {
+                int j = cycles[i];
+                int tmp = indices[i];
+                indices[i] = indices[n - j];
+                indices[n - j] = tmp;
+                break;
+            }
+        }
+        if(i < 0) {
+            ud->stopped = true;
+            return StopIteration();
+        }
+    }
+    ud->started = true;
+    py_Ref pool = py_getslot(argv, 0);
+    py_TValue* p = py_newtuple(py_retval(), r);
+    for(int i = 0; i < r; i++) {
+        p[i] = *py_tuple_getitem(pool, indices[i]);
+    }
+    return true;
+}
+
+/* combinations(iterable, r) */
+
+typedef struct {
+    int n;
+    int r;
+    bool started;
+    bool stopped;
+    int indices[];
+} Combinations;
+
+static bool combinations__new__(int argc, py_Ref argv) {
+    // __new__(cls, iterable, r)
+    py_i64 r;
+    if(!Itertools__check_r(py_arg(2), &r)) return false;
+    py_Ref out = py_pushtmp();
+    py_Ref pool = py_pushtmp();
+    if(!Itertools__totuple(py_arg(1), pool)) return false;
+    int n = py_tuple_len(pool);
+    int r_ = (int)c11__min(r, n);
+    Combinations* ud =
+        py_newobject(out, py_totype(argv), 1, sizeof(Combinations) + r_ * sizeof(int));
+    py_setslot(out, 0, pool);
+    ud->n = n;
+    ud->r = r_;
+    ud->started = false;
+    ud->stopped = r > n;
+    for(int i = 0; i < r_; i++) {
+        ud->indices[i] = i;
+    }
+    py_assign(py_retval(), out);
+    py_shrink(2);
+    return true;
+}
+
+static bool combinations__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Combinations* ud = py_touserdata(argv);
+    if(ud->stopped) return StopIteration();
+    int n = ud->n, r = ud->r;
+    if(ud->started) {
+        // find the rightmost index that is not at its maximum `i + n - r`
+        int i = r - 1;
+        while(i >= 0 && ud->indices[i] == i + n - r)
+            i--;
+        if(i < 0) {
+            ud->stopped = true;
+            return StopIteration();
+        }
+        ud->indices[i]++;
+        for(int j = i + 1; j < r; j++) {
+            ud->indices[j] = ud->indices[j - 1] + 1;
+        }
+    }
+    ud->started = true;
+    py_Ref pool = py_getslot(argv, 0);
+    py_TValue* p = py_newtuple(py_retval(), r);
+    for(int i = 0; i < r; i++) {
+        p[i] = *py_tuple_getitem(pool, ud->indices[i]);
+    }
+    return true;
+}
+
+/* accumulate(iterable, func=None, initial=None) */
+
+#define Accumulate__ITER 0
+#define Accumulate__TOTAL 1
+#define Accumulate__FUNC 2
+
+static bool accumulate__new__(int argc, py_Ref argv) {
+    // __new__(cls, iterable, func=None, initial=None)
+    py_Ref out = py_pushtmp();
+    // a given `initial` is yielded first and then becomes the running total
+    bool* initial_pending = py_newobject(out, py_totype(argv), 3, sizeof(bool));
+    *initial_pending = !py_isnone(py_arg(3));
+    if(!py_iter(py_arg(1))) return false;
+    py_setslot(out, Accumulate__ITER, py_retval());
+    py_setslot(out, Accumulate__FUNC, py_arg(2));
+    if(*initial_pending) py_setslot(out, Accumulate__TOTAL, py_arg(3));
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool accumulate__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    bool* initial_pending = py_touserdata(argv);
+    py_Ref total = py_getslot(argv, Accumulate__TOTAL);
+    if(*initial_pending) {
+        *initial_pending = false;
+        py_assign(py_retval(), total);
+        return true;
+    }
+    int res = py_next(py_getslot(argv, Accumulate__ITER));
+    if(res == -1) return false;
+    if(res == 0) return StopIteration();
+    if(py_isnil(total)) {
+        py_setslot(argv, Accumulate__TOTAL, py_retval());
+        return true;
+    }
+    py_Ref args = py_pushtmp();
+    py_pushtmp();
+    py_assign(&args[0], total);
+    py_assign(&args[1], py_retval());
+    py_Ref func = py_getslot(argv, Accumulate__FUNC);
+    if(py_isnone(func)) {
+        if(py_isint(&args[0]) && py_isint(&args[1])) {
+            py_newint(py_retval(), py_toint(&args[0]) + py_toint(&args[1]));
+        } else if(!py_binaryadd(&args[0], &args[1])) {
+            return false;
+        }
+    } else {
+        if(!py_call(func, 2, args)) return false;
+    }
+    py_setslot(argv, Accumulate__TOTAL, py_retval());
+    py_shrink(2);
+    return true;
+}
+
+/* groupby(iterable, key=None) */
+
+#define Groupby__ITER 0
+#define Groupby__KEYFUNC 1
+#define Groupby__TGTKEY 2
+#define Groupby__CURRKEY 3
+#define Groupby__CURRVALUE 4
+#define Groupby__CURRGROUPER 5
+
+static bool groupby__new__(int argc, py_Ref argv) {
+    // __new__(cls, iterable, key=None)
+    py_Ref out = py_pushtmp();
+    py_newobject(out, py_totype(argv), 6, 0);
+    if(!py_iter(py_arg(1))) return false;
+    py_setslot(out, Groupby__ITER, py_retval());
+    py_setslot(out, Groupby__KEYFUNC, py_arg(2));
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+/// Advance to the next value. -1: error, 0: exhausted, 1: success
+static int Groupby__step(py_Ref self) {
+    int res = py_next(py_getslot(self, Groupby__ITER));
+    if(res != 1) return res;
+    py_Ref value = py_pushtmp();
+    py_assign(value, py_retval());
+    py_Ref keyfunc = py_getslot(self, Groupby__KEYFUNC);
+    if(!py_isnone(keyfunc)) {
+        if(!py_call(keyfunc, 1, value)) return -1;
+        py_setslot(self, Groupby__CURRKEY, py_retval());
+    } else {
+        py_setslot(self, Groupby__CURRKEY, value);
+    }
+    py_setslot(self, Groupby__CURRVALUE, value);
+    py_pop();
+    return 1;
+}
+
+static bool groupby__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_setslot(argv, Groupby__CURRGROUPER, py_NIL());
+    // skip to the next group
+    while(true) {
+        py_Ref currkey = py_getslot(argv, Groupby__CURRKEY);
+        py_Ref tgtkey = py_getslot(argv, Groupby__TGTKEY);
+        if(!py_isnil(currkey)) {
+            if(py_isnil(tgtkey)) break;
+            int res = py_equal(tgtkey, currkey);
+            if(res == -1) return false;
+            if(res == 0) break;
+        }
+        int res = Groupby__step(argv);
+        if(res == -1) return false;
+        if(res == 0) return StopIteration();
+    }
+    py_setslot(argv, Groupby__TGTKEY, py_getslot(argv, Groupby__CURRKEY));
+
+    py_Ref result = py_pushtmp();
+    py_TValue* p = py_newtuple(result, 2);
+    p[0] = *py_getslot(argv, Groupby__CURRKEY);
+    py_Ref grouper = py_getdict(py_getmodule("itertools"), py_name("_grouper"));
+    py_newobject(&p[1], py_totype(grouper), 2, 0);
+    py_setslot(&p[1], 0, argv);
+    py_setslot(&p[1], 1, py_getslot(argv, Groupby__TGTKEY));
+    py_setslot(argv, Groupby__CURRGROUPER, &p[1]);
+    py_assign(py_retval(), result);
+    py_pop();
+    return true;
+}
+
+static bool grouper__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Ref parent = py_getslot(argv, 0);
+    // a group is invalidated as soon as its parent moves on
+    py_Ref currgrouper = py_getslot(parent, Groupby__CURRGROUPER);
+    if(py_isnil(currgrouper) || currgrouper->_obj != argv->_obj) return StopIteration();
+    if(py_isnil(py_getslot(parent, Groupby__CURRVALUE))) {
+        int res = Groupby__step(parent);
+        if(res == -1) return false;
+        if(res == 0) return StopIteration();
+    }
+    int res = py_equal(py_getslot(argv, 1), py_getslot(parent, Groupby__CURRKEY));
+    if(res == -1) return false;
+    if(res == 0) return StopIteration();
+    py_assign(py_retval(), py_getslot(parent, Groupby__CURRVALUE));
+    py_setslot(parent, Groupby__CURRVALUE, py_NIL());
+    return true;
+}
+
+/* batched(iterable, n) */
+
+static bool batched__new__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    PY_CHECK_ARG_TYPE(2, tp_int);
+    py_i64 n = py_toint(py_arg(2));
+    if(n < 1) return ValueError("n must be at least one");
+    py_Ref out = py_pushtmp();
+    int* ud = py_newobject(out, py_totype(argv), 1, sizeof(int));
+    *ud = (int)c11__min(n, INT32_MAX);
+    if(!py_iter(py_arg(1))) return false;
+    py_setslot(out, 0, py_retval());
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool batched__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    int n = *(int*)py_touserdata(argv);
+    py_Ref it = py_getslot(argv, 0);
+    if(py_isnil(it)) return StopIteration();
+    py_Ref batch = py_pushtmp();
+    py_newlist(batch);
+    for(int i = 0; i < n; i++) {
+        int res = py_next(it);
+        if(res == -1) return false;
+        if(res == 0) {
+            py_setslot(argv, 0, py_NIL());
+            break;
+        }
+        py_list_append(batch, py_retval());
+    }
+    int length = py_list_len(batch);
+    if(length == 0) {
+        py_pop();
+        return StopIteration();
+    }
+    py_TValue* p = py_newtuple(py_retval(), length);
+    memcpy(p, py_list_data(batch), length * sizeof(py_TValue));
+    py_pop();
+    return true;
+}
+
+static py_Type Itertools__register(py_Ref mod, const char* name, py_CFunction next) {
+    py_Type type = py_newtype(name, tp_object, mod, NULL);
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, next);
+    return type;
+}
+
+void pk__add_module_itertools() {
+    py_GlobalRef mod = py_newmodule("itertools");
+    py_Type type;
+
+    type = Itertools__register(mod, "chain", chain__next__);
+    py_bind(py_tpobject(type), "__new__(cls, *iterables)", chain__new__);
+    py_bindstaticmethod(type, "from_iterable", chain_from_iterable);
+
+    type = Itertools__register(mod, "islice", islice__next__);
+    py_bindmagic(type, __new__, islice__new__);
+
+    type = Itertools__register(mod, "count", count__next__);
+    py_bind(py_tpobject(type), "__new__(cls, start=0, step=1)", count__new__);
+    py_bindmagic(type, __repr__, count__repr__);
+
+    type = Itertools__register(mod, "cycle", cycle__next__);
+    py_bindmagic(type, __new__, cycle__new__);
+
+    type = Itertools__register(mod, "repeat", repeat__next__);
+    py_bind(py_tpobject(type), "__new__(cls, object, times=None)", repeat__new__);
+
+    type = Itertools__register(mod, "zip_longest", zip_longest__next__);
+    py_bind(py_tpobject(type), "__new__(cls, *iterables, fillvalue=None)", zip_longest__new__);
+
+    type = Itertools__register(mod, "product", product__next__);
+    py_bind(py_tpobject(type), "__new__(cls, *iterables, repeat=1)", product__new__);
+
+    type = Itertools__register(mod, "permutations", permutations__next__);
+    py_bind(py_tpobject(type), "__new__(cls, iterable, r=None)", permutations__new__);
+
+    type = Itertools__register(mod, "combinations", combinations__next__);
+    py_bind(py_tpobject(type), "__new__(cls, iterable, r)", combinations__new__);
+
+    type = Itertools__register(mod, "accumulate", accumulate__next__);
+    py_bind(py_tpobject(type),
+            "__new__(cls, iterable, func=None, initial=None)",
+            accumulate__new__);
+
+    type = Itertools__register(mod, "groupby", groupby__next__);
+    py_bind(py_tpobject(type), "__new__(cls, iterable, key=None)", groupby__new__);
+    Itertools__register(mod, "_grouper", grouper__next__);
+
+    type = Itertools__register(mod, "batched", batched__next__);
+    py_bindmagic(type, __new__, batched__new__);
+}
+
+#undef Chain__SOURCE
+#undef Chain__ACTIVE
+#undef Accumulate__ITER
+#undef Accumulate__TOTAL
+#undef Accumulate__FUNC
+#undef Groupby__ITER
+#undef Groupby__KEYFUNC
+#undef Groupby__TGTKEY
+#undef Groupby__CURRKEY
+#undef Groupby__CURRVALUE
+#undef Groupby__CURRGROUPER
@@ -5,45 +5,44 @@
 #include "pocketpy/common/sstream.h"
 #include "pocketpy/interpreter/vm.h"
 #include <math.h>
+#include <errno.h>
+#include <stdlib.h>
 
-static bool json_loads(int argc, py_Ref argv) {
-    PY_CHECK_ARGC(1);
-    PY_CHECK_ARG_TYPE(0, tp_str);
-    const char* source = py_tostr(argv);
-    return py_json_loads(source);
-}
-
-static bool json_dumps(int argc, py_Ref argv) {
-    PY_CHECK_ARGC(2);
-    PY_CHECK_ARG_TYPE(1, tp_int);
-    int indent = py_toint(&argv[1]);
-    return py_json_dumps(argv, indent);
-}
-
-void pk__add_module_json() {
-    py_Ref mod = py_newmodule("json");
-
-    py_setdict(mod, py_name("null"), py_None());
-    py_setdict(mod, py_name("true"), py_True());
-    py_setdict(mod, py_name("false"), py_False());
-    py_TValue tmp;
-    py_newfloat(&tmp, NAN);
-    py_setdict(mod, py_name("NaN"), &tmp);
-    py_newfloat(&tmp, INFINITY);
-    py_setdict(mod, py_name("Infinity"), &tmp);
+// chunk size for streaming to and from files
+#define Json__CHUNK_SIZE 65536
 
-    py_bindfunc(mod, "loads", json_loads);
-    py_bind(mod, "dumps(obj, indent=0)", json_dumps);
-}
+typedef struct {
+    c11_sbuf buf;
+    py_Ref write;  // `write` method of the target file, or NULL to keep everything in `buf`
+} json_Writer;
 
 typedef struct {
-    c11_sbuf* buf;
+    json_Writer* w;
     bool first;
     int indent;
     int depth;
 } json__write_dict_kv_ctx;
 
-static bool json__write_object(c11_sbuf* buf, py_TValue* obj, int indent, int depth);
+static bool json__write_object(json_Writer* w, py_TValue* obj, int indent, int depth);
+
+static bool json__flush(json_Writer* w) {
+    // the stream keeps room for a string header in front of the text
+    int header = sizeof(c11_string);
+    int size = w->buf.data.length - header;
+    if(size == 0) return true;
+    py_StackRef chunk = py_pushtmp();
+    py_newstrv(chunk, (c11_sv){(char*)w->buf.data.data + header, size});
+    w->buf.data.length = header;
+    bool ok = py_call(w->write, 1, chunk);
+    py_pop();
+    return ok;
+}
+
+/// Pass the buffered text on to the file once there is enough of it.
+PK_INLINE static bool json__maybe_flush(json_Writer* w) {
+    if(w->write == NULL || w->buf.data.length < Json__CHUNK_SIZE) return true;
+    return json__flush(w);
+}
 
 static void json__write_indent(c11_sbuf* buf, int n_spaces) {
     for(int i = 0; i < n_spaces; i++) {
@@ -51,7 +50,9 @@ static void json__write_indent(c11_sbuf* buf, int n_spaces) {
     }
 }
 
-static bool json__write_array(c11_sbuf* buf, py_TValue* arr, int length, int indent, int depth) {
+static bool
+    json__write_array(json_Writer* w, py_TValue* arr, int length, int indent, int depth) {
+    c11_sbuf* buf = &w->buf;
     c11_sbuf__write_char(buf, '[');
     if(length == 0) {
         c11_sbuf__write_char(buf, ']');
@@ -63,8 +64,8 @@ static bool json__write_array(c11_sbuf* buf, py_TValue* arr, int length, int ind
     for(int i = 0; i < length; i++) {
         if(i != 0) c11_sbuf__write_cstr(buf, sep);
         json__write_indent(buf, n_spaces);
-        bool ok = json__write_object(buf, arr + i, indent, depth);
-        if(!ok) return false;
+        bool ok = json__write_object(w, arr + i, indent, depth);
+        if(!ok || !json__maybe_flush(w)) return false;
     }
     if(indent > 0) {
         c11_sbuf__write_char(buf, '\n');
@@ -78,28 +79,31 @@ static bool json__write_dict_kv(py_Ref k, py_Ref v, void* ctx_) {
     json__write_dict_kv_ctx* ctx = ctx_;
     int n_spaces = ctx->indent * ctx->depth;
     const char* sep = ctx->indent > 0 ? ",\n" : ", ";
-    if(!ctx->first) c11_sbuf__write_cstr(ctx->buf, sep);
+    if(!ctx->first) c11_sbuf__write_cstr(&ctx->w->buf, sep);
     ctx->first = false;
     if(!py_isstr(k)) return TypeError("keys must be strings");
-    json__write_indent(ctx->buf, n_spaces);
-    c11_sbuf__write_quoted(ctx->buf, py_tosv(k), '"');
-    c11_sbuf__write_cstr(ctx->buf, ": ");
-    return json__write_object(ctx->buf, v, ctx->indent, ctx->depth);
+    json__write_indent(&ctx->w->buf, n_spaces);
+    c11_sbuf__write_quoted(&ctx->w->buf, py_tosv(k), '"');
+    c11_sbuf__write_cstr(&ctx->w->buf, ": ");
+    if(!json__write_object(ctx->w, v, ctx->indent, ctx->depth)) return false;
+    return json__maybe_flush(ctx->w);
 }
 
 static bool json__write_namedict_kv(py_Name k, py_Ref v, void* ctx_) {
     json__write_dict_kv_ctx* ctx = ctx_;
     int n_spaces = ctx->indent * ctx->depth;
     const char* sep = ctx->indent > 0 ? ",\n" : ", ";
-    if(!ctx->first) c11_sbuf__write_cstr(ctx->buf, sep);
+    if(!ctx->first) c11_sbuf__write_cstr(&ctx->w->buf, sep);
     ctx->first = false;
-    json__write_indent(ctx->buf, n_spaces);
-    c11_sbuf__write_quoted(ctx->buf, py_name2sv(k), '"');
-    c11_sbuf__write_cstr(ctx->buf, ": ");
-    return json__write_object(ctx->buf, v, ctx->indent, ctx->depth);
+    json__write_indent(&ctx->w->buf, n_spaces);
+    c11_sbuf__write_quoted(&ctx->w->buf, py_name2sv(k), '"');
+    c11_sbuf__write_cstr(&ctx->w->buf, ": ");
+    if(!json__write_object(ctx->w, v, ctx->indent, ctx->depth)) return false;
+    return json__maybe_flush(ctx->w);
 }
 
-static bool json__write_object(c11_sbuf* buf, py_TValue* obj, int indent, int depth) {
+static bool json__write_object(json_Writer* w, py_TValue* obj, int indent, int depth) {
+    c11_sbuf* buf = &w->buf;
     switch(obj->type) {
         case tp_NoneType: c11_sbuf__write_cstr(buf, "null"); return true;
         case tp_int: c11_sbuf__write_int(buf, obj->_i64); return true;
@@ -122,10 +126,10 @@ static bool json__write_object(c11_sbuf* buf, py_TValue* obj, int indent, int de
             return true;
         }
         case tp_list: {
-            return json__write_array(buf, py_list_data(obj), py_list_len(obj), indent, depth + 1);
+            return json__write_array(w, py_list_data(obj), py_list_len(obj), indent, depth + 1);
         }
         case tp_tuple: {
-            return json__write_array(buf, py_tuple_data(obj), py_tuple_len(obj), indent, depth + 1);
+            return json__write_array(w, py_tuple_data(obj), py_tuple_len(obj), indent, depth + 1);
         }
         case tp_dict: {
             c11_sbuf__write_char(buf, '{');
@@ -134,7 +138,7 @@ static bool json__write_object(c11_sbuf* buf, py_TValue* obj, int indent, int de
                 return true;
             }
             if(indent > 0) c11_sbuf__write_char(buf, '\n');
-            json__write_dict_kv_ctx ctx = {.buf = buf,
+            json__write_dict_kv_ctx ctx = {.w = w,
                                            .first = true,
                                            .indent = indent,
                                            .depth = depth + 1};
@@ -155,7 +159,7 @@ static bool json__write_object(c11_sbuf* buf, py_TValue* obj, int indent, int de
                 return true;
             }
             if(indent > 0) c11_sbuf__write_char(buf, '\n');
-            json__write_dict_kv_ctx ctx = {.buf = buf,
+            json__write_dict_kv_ctx ctx = {.w = w,
                                            .first = true,
                                            .indent = indent,
                                            .depth = depth + 1};
@@ -173,19 +177,744 @@ static bool json__write_object(c11_sbuf* buf, py_TValue* obj, int indent, int de
 }
 
 bool py_json_dumps(py_Ref val, int indent) {
-    c11_sbuf buf;
-    c11_sbuf__ctor(&buf);
-    bool ok = json__write_object(&buf, val, indent, 0);
+    json_Writer w = {.write = NULL};
+    c11_sbuf__ctor(&w.buf);
+    bool ok = json__write_object(&w, val, indent, 0);
     if(!ok) {
-        c11_sbuf__dtor(&buf);
+        c11_sbuf__dtor(&w.buf);
         return false;
     }
-    c11_sbuf__py_submit(&buf, py_retval());
+    c11_sbuf__py_submit(&w.buf, py_retval());
     return true;
 }
 
-bool py_json_loads(const char* source) {
-    py_GlobalRef mod = py_getmodule("json");
-    return py_exec(source, "<json>", EVAL_MODE, mod);
+static bool Json__dump(py_Ref val, py_Ref file, int indent) {
+    if(!py_getattr(file, py_name("write"))) return false;
+    py_StackRef write = py_pushtmp();
+    py_assign(write, py_retval());
+    json_Writer w = {.write = write};
+    c11_sbuf__ctor(&w.buf);
+    bool ok = json__write_object(&w, val, indent, 0) && json__flush(&w);
+    c11_sbuf__dtor(&w.buf);
+    py_pop();
+    return ok;
+}
+
+/* loads */
+
+/* Parsing is a resumable state machine, so `json.loads` and the push parser share it. Open
+ * containers are kept in a list after the result, together with a dict key waiting for its value,
+ * so nesting does not recurse in C. Runs of whitespace and plain string characters are skipped 16
+ * bytes at a time.
+ *
+ * Token parsers return 1 on success, 0 on error and -1 when the input stops inside the token.
+ */
+
+#define Json__MAX_DEPTH 1000
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define Json__SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define Json__NEON
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+typedef enum {
+    Json__VALUE,           // after ':' and ',' in a list
+    Json__VALUE_OR_CLOSE,  // after '['
+    Json__KEY,             // after ',' in a dict
+    Json__KEY_OR_CLOSE,    // after '{'
+    Json__COLON,
+    Json__COMMA_OR_CLOSE,
+    Json__DONE,
+} json_State;
+
+typedef struct {
+    const char* begin;  // start of the text being scanned
+    const char* p;
+    const char* end;
+    bool final;  // whether `end` is also the end of the document
+    bool closed;
+    json_State state;
+    c11_vector kinds;    // '[' or '{' for each open container
+    c11_vector buf;      // scratch for strings with escapes
+    c11_vector pending;  // input the push parser could not consume yet
+    // position of `begin` in the document
+    int offset;
+    int line;
+    int column;
+} json_Parser;
+
+PK_INLINE static int Json__ctz(uint64_t mask) {
+#if(defined(__clang__) || defined(__GNUC__))
+    return __builtin_ctzll(mask);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (int)index;
+#else
+    int index = 0;
+    while((mask & 1) == 0) {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+PK_INLINE static bool Json__isspace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+PK_INLINE static bool Json__isplain(char c) {
+    return c != '"' && c != '\\' && (unsigned char)c >= 0x20;
+}
+
+/// Number of leading whitespace bytes in `p[0:16]`.
+PK_INLINE static int Json__space_run16(const char* p) {
+#if defined(Json__SSE2)
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                           _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                              _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                                           _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+    uint64_t mask = (uint16_t)~_mm_movemask_epi8(ws);
+    return mask ? Json__ctz(mask) : 16;
+#elif defined(Json__NEON)
+    uint8x16_t v = vld1q_u8((const uint8_t*)p);
+    uint8x16_t ws = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\n'))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8('\r')), vceqq_u8(v, vdupq_n_u8('\t'))));
+    // NEON has no movemask, a byte is reported as a 4-bit lane
+    uint8x8_t res = vshrn_n_u16(vreinterpretq_u16_u8(vmvnq_u8(ws)), 4);
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(res), 0);
+    return mask ? Json__ctz(mask) >> 2 : 16;
+#else
+    for(int i = 0; i < 16; i++) {
+        if(!Json__isspace(p[i])) return i;
+    }
+    return 16;
+#endif
+}
+
+/// Number of leading bytes in `p[0:16]` that need no special handling inside a string.
+PK_INLINE static int Json__plain_run16(const char* p) {
+#if defined(Json__SSE2)
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i ctl = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+    __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                                _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                                   ctl);
+    uint64_t mask = (uint16_t)_mm_movemask_epi8(special);
+    return mask ? Json__ctz(mask) : 16;
+#elif defined(Json__NEON)
+    uint8x16_t v = vld1q_u8((const uint8_t*)p);
+    uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                                           vceqq_u8(v, vdupq_n_u8('\\'))),
+                                  vcleq_u8(v, vdupq_n_u8(0x1F)));
+    uint8x8_t res = vshrn_n_u16(vreinterpretq_u16_u8(special), 4);
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(res), 0);
+    return mask ? Json__ctz(mask) >> 2 : 16;
+#else
+    for(int i = 0; i < 16; i++) {
+        if(!Json__isplain(p[i])) return i;
+    }
+    return 16;
+#endif
+}
+
+static void Json__skip_space(json_Parser* self) {
+    // most runs are a single space or none at all
+    if(self->p == self->end || !Json__isspace(*self->p)) return;
+    self->p++;
+    while(self->end - self->p >= 16) {
+        int n = Json__space_run16(self->p);
+        self->p += n;
+        if(n < 16) return;
+    }
+    while(self->p < self->end && Json__isspace(*self->p)) {
+        self->p++;
+    }
+}
+
+static void Json__ctor(json_Parser* self) {
+    memset(self, 0, sizeof(json_Parser));
+    self->state = Json__VALUE;
+    self->line = 1;
+    c11_vector__ctor(&self->kinds, sizeof(char));
+    c11_vector__ctor(&self->buf, sizeof(char));
+    c11_vector__ctor(&self->pending, sizeof(char));
+}
+
+static void Json__dtor(json_Parser* self) {
+    c11_vector__dtor(&self->kinds);
+    c11_vector__dtor(&self->buf);
+    c11_vector__dtor(&self->pending);
+}
+
+static bool Json__error(json_Parser* self, const char* msg) {
+    int line = self->line;
+    int column = self->column + (int)(self->p - self->begin);
+    for(const char* q = self->begin; q < self->p; q++) {
+        if(*q == '\n') {
+            line++;
+            column = (int)(self->p - q) - 1;
+        }
+    }
+    return ValueError("%s: line %d column %d (char %d)",
+                      msg,
+                      line,
+                      column + 1,
+                      self->offset + (int)(self->p - self->begin));
+}
+
+/// Move `begin` up to `p`, keeping track of the position.
+static void Json__advance(json_Parser* self) {
+    for(const char* q = self->begin; q < self->p; q++) {
+        if(*q == '\n') {
+            self->line++;
+            self->column = 0;
+        } else {
+            self->column++;
+        }
+    }
+    self->offset += (int)(self->p - self->begin);
+    self->begin = self->p;
+}
+
+static int Json__hex4(const char* p) {
+    int res = 0;
+    for(int i = 0; i < 4; i++) {
+        char c = p[i];
+        int digit;
+        if(c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if(c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if(c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        res = res * 16 + digit;
+    }
+    return res;
+}
+
+static int Json__parse_string(json_Parser* self, py_OutRef out) {
+    const char* quote = self->p++;
+    const char* start = self->p;
+    while(true) {
+        while(self->end - self->p >= 16) {
+            int n = Json__plain_run16(self->p);
+            self->p += n;
+            if(n < 16) break;
+        }
+        while(self->p < self->end && Json__isplain(*self->p)) {
+            self->p++;
+        }
+        if(self->p == self->end) goto __UNTERMINATED;
+        char c = *self->p;
+        if(c == '"') break;
+        if(c != '\\') return Json__error(self, "Invalid control character at");
+        // flush the plain run and decode the escape
+        if(self->p > start) {
+            c11_vector__extend(char, &self->buf, start, (int)(self->p - start));
+        }
+        if(self->end - self->p < 2) goto __UNTERMINATED;
+        char esc = self->p[1];
+        self->p += 2;
+        switch(esc) {
+            case '"': c11_vector__push(char, &self->buf, '"'); break;
+            case '\\': c11_vector__push(char, &self->buf, '\\'); break;
+            case '/': c11_vector__push(char, &self->buf, '/'); break;
+            case 'b': c11_vector__push(char, &self->buf, '\b'); break;
+            case 'f': c11_vector__push(char, &self->buf, '\f'); break;
+            case 'n': c11_vector__push(char, &self->buf, '\n'); break;
+            case 'r': c11_vector__push(char, &self->buf, '\r'); break;
+            case 't': c11_vector__push(char, &self->buf, '\t'); break;
+            case 'u': {
+                if(self->end - self->p < 4) goto __UNTERMINATED;
+                int code = Json__hex4(self->p);
+                if(code == -1) {
+                    self->p -= 2;
+                    return Json__error(self, "Invalid \\uXXXX escape");
+                }
+                self->p += 4;
+                // combine a surrogate pair
+                if(code >= 0xD800 && code <= 0xDBFF) {
+                    if(self->end - self->p < 6 && !self->final) goto __UNTERMINATED;
+                    if(self->end - self->p >= 6 && self->p[0] == '\\' && self->p[1] == 'u') {
+                        int low = Json__hex4(self->p + 2);
+                        if(low >= 0xDC00 && low <= 0xDFFF) {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                            self->p += 6;
+                        }
+                    }
+                }
+                char utf8[4];
+                int n = c11__u32_to_u8(code, utf8);
+                c11_vector__extend(char, &self->buf, utf8, n);
+                break;
+            }
+            default: self->p -= 2; return Json__error(self, "Invalid \\escape");
+        }
+        start = self->p;
+    }
+    if(self->buf.length == 0) {
+        py_newstrv(out, (c11_sv){start, (int)(self->p - start)});
+    } else {
+        c11_vector__extend(char, &self->buf, start, (int)(self->p - start));
+        py_newstrv(out, (c11_sv){self->buf.data, self->buf.length});
+        c11_vector__clear(&self->buf);
+    }
+    self->p++;
+    return 1;
+
+__UNTERMINATED:
+    c11_vector__clear(&self->buf);
+    self->p = quote;
+    if(!self->final) return -1;
+    return Json__error(self, "Unterminated string starting at");
+}
+
+PK_INLINE static bool Json__isdigit(json_Parser* self) {
+    return self->p < self->end && *self->p >= '0' && *self->p <= '9';
+}
+
+PK_INLINE static bool Json__isnumber(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static int Json__parse_number(json_Parser* self, py_OutRef out) {
+    const char* start = self->p;
+    if(!self->final) {
+        // more digits may follow in the next chunk
+        const char* q = self->p;
+        while(q < self->end && Json__isnumber(*q)) {
+            q++;
+        }
+        if(q == self->end) return -1;
+    }
+    if(*self->p == '-') self->p++;
+    if(!Json__isdigit(self)) {
+        self->p = start;
+        return Json__error(self, "Expecting value");
+    }
+    // an int of up to 18 digits can not overflow, longer ones are parsed below
+    py_i64 value = 0;
+    int ndigits = 0;
+    if(*self->p == '0') {
+        self->p++;
+        ndigits = 1;
+    } else {
+        while(Json__isdigit(self)) {
+            if(ndigits < 18) value = value * 10 + (*self->p - '0');
+            self->p++;
+            ndigits++;
+        }
+    }
+    bool is_float = false;
+    if(self->p < self->end && *self->p == '.') {
+        self->p++;
+        if(!Json__isdigit(self)) return Json__error(self, "Expecting digits after '.'");
+        while(Json__isdigit(self)) {
+            self->p++;
+        }
+        is_float = true;
+    }
+    if(self->p < self->end && (*self->p == 'e' || *self->p == 'E')) {
+        self->p++;
+        if(self->p < self->end && (*self->p == '+' || *self->p == '-')) self->p++;
+        if(!Json__isdigit(self)) return Json__error(self, "Expecting digits in exponent");
+        while(Json__isdigit(self)) {
+            self->p++;
+        }
+        is_float = true;
+    }
+    if(!is_float && ndigits <= 18) {
+        py_newint(out, *start == '-' ? -value : value);
+        return 1;
+    }
+    // `strtod` needs a terminated copy
+    int size = (int)(self->p - start);
+    char small[64];
+    char* text = size < (int)sizeof(small) ? small : PK_MALLOC(size + 1);
+    memcpy(text, start, size);
+    text[size] = '\0';
+    py_f64 f = strtod(text, NULL);
+    if(!is_float && ndigits == 19) {
+        // still fits when it is in range
+        char* endp;
+        errno = 0;
+        long long v = strtoll(text, &endp, 10);
+        if(errno == 0) {
+            py_newint(out, v);
+            if(text != small) PK_FREE(text);
+            return 1;
+        }
+    }
+    if(text != small) PK_FREE(text);
+    py_newfloat(out, f);
+    return 1;
+}
+
+static int Json__match(json_Parser* self, const char* word, int size) {
+    int n = (int)(self->end - self->p);
+    if(n >= size) {
+        if(memcmp(self->p, word, size) != 0) return 0;
+        self->p += size;
+        return 1;
+    }
+    return !self->final && memcmp(self->p, word, n) == 0 ? -1 : 0;
+}
+
+static int Json__parse_scalar(json_Parser* self, py_OutRef out) {
+    int res = 0;
+    switch(*self->p) {
+        case '"': return Json__parse_string(self, out);
+        case 't':
+            res = Json__match(self, "true", 4);
+            if(res == 1) py_newbool(out, true);
+            break;
+        case 'f':
+            res = Json__match(self, "false", 5);
+            if(res == 1) py_newbool(out, false);
+            break;
+        case 'n':
+            res = Json__match(self, "null", 4);
+            if(res == 1) py_newnone(out);
+            break;
+        case 'N':
+            res = Json__match(self, "NaN", 3);
+            if(res == 1) py_newfloat(out, NAN);
+            break;
+        case 'I':
+            res = Json__match(self, "Infinity", 8);
+            if(res == 1) py_newfloat(out, INFINITY);
+            break;
+        case '-':
+            res = Json__match(self, "-Infinity", 9);
+            if(res == 0) return Json__parse_number(self, out);
+            if(res == 1) py_newfloat(out, -INFINITY);
+            break;
+        default:
+            if(*self->p >= '0' && *self->p <= '9') return Json__parse_number(self, out);
+            break;
+    }
+    if(res == 0) return Json__error(self, "Expecting value");
+    return res;
+}
+
+/// Store a finished value into the innermost open container, or as the result.
+static bool Json__emit(json_Parser* self, py_Ref stack, py_Ref value) {
+    if(self->kinds.length == 0) {
+        py_list_append(stack, value);
+        self->state = Json__DONE;
+        return true;
+    }
+    self->state = Json__COMMA_OR_CLOSE;
+    int n = py_list_len(stack);
+    py_ItemRef top = py_list_getitem(stack, n - 1);
+    if(c11_vector__back(char, &self->kinds) == '[') {
+        py_list_append(top, value);
+        return true;
+    }
+    // `top` is the key
+    bool ok = py_dict_setitem(py_list_getitem(stack, n - 2), top, value);
+    py_list_delitem(stack, n - 1);
+    return ok;
+}
+
+static void Json__close(json_Parser* self, py_Ref stack) {
+    self->p++;
+    c11_vector__pop(&self->kinds);
+    py_list_delitem(stack, py_list_len(stack) - 1);
+    self->state = self->kinds.length == 0 ? Json__DONE : Json__COMMA_OR_CLOSE;
+}
+
+/// Consume as much of the input as possible. `value` is scratch space.
+static bool Json__run(json_Parser* self, py_Ref stack, py_Ref value) {
+    while(true) {
+        Json__skip_space(self);
+        if(self->p == self->end) return true;
+        char c = *self->p;
+        int res;
+        switch(self->state) {
+            case Json__VALUE_OR_CLOSE:
+                if(c == ']') {
+                    Json__close(self, stack);
+                    break;
+                }
+                // fallthrough
+            case Json__VALUE:
+                if(c == '[' || c == '{') {
+                    if(self->kinds.length == Json__MAX_DEPTH) {
+                        return Json__error(self, "Nesting too deep");
+                    }
+                    self->p++;
+                    if(c == '[') {
+                        py_newlist(value);
+                    } else {
+                        py_newdict(value);
+                    }
+                    if(!Json__emit(self, stack, value)) return false;
+                    py_list_append(stack, value);
+                    c11_vector__push(char, &self->kinds, c);
+                    self->state = c == '[' ? Json__VALUE_OR_CLOSE : Json__KEY_OR_CLOSE;
+                    break;
+                }
+                res = Json__parse_scalar(self, value);
+                if(res != 1) return res == -1;
+                if(!Json__emit(self, stack, value)) return false;
+                break;
+            case Json__KEY_OR_CLOSE:
+                if(c == '}') {
+                    Json__close(self, stack);
+                    break;
+                }
+                // fallthrough
+            case Json__KEY:
+                if(c != '"') {
+                    return Json__error(self, "Expecting property name enclosed in double quotes");
+                }
+                res = Json__parse_string(self, value);
+                if(res != 1) return res == -1;
+                py_list_append(stack, value);
+                self->state = Json__COLON;
+                break;
+            case Json__COLON:
+                if(c != ':') return Json__error(self, "Expecting ':' delimiter");
+                self->p++;
+                self->state = Json__VALUE;
+                break;
+            case Json__COMMA_OR_CLOSE: {
+                char kind = c11_vector__back(char, &self->kinds);
+                if(c == ',') {
+                    self->p++;
+                    self->state = kind == '[' ? Json__VALUE : Json__KEY;
+                } else if(c == (kind == '[' ? ']' : '}')) {
+                    Json__close(self, stack);
+                } else {
+                    return Json__error(self, "Expecting ',' delimiter");
+                }
+                break;
+            }
+            case Json__DONE: return Json__error(self, "Extra data");
+        }
+    }
+}
+
+static bool Json__feed(json_Parser* self, py_Ref stack) {
+    py_StackRef value = py_pushtmp();
+    bool ok = Json__run(self, stack, value);
+    py_pop();
+    return ok;
+}
+
+/// Check that the document is complete once the input has ended.
+static bool Json__finish(json_Parser* self) {
+    switch(self->state) {
+        case Json__DONE: return true;
+        case Json__KEY:
+        case Json__KEY_OR_CLOSE:
+            return Json__error(self, "Expecting property name enclosed in double quotes");
+        case Json__COLON: return Json__error(self, "Expecting ':' delimiter");
+        case Json__COMMA_OR_CLOSE: return Json__error(self, "Expecting ',' delimiter");
+        default: return Json__error(self, "Expecting value");
+    }
+}
+
+static bool Json__loads(c11_sv source) {
+    json_Parser self;
+    Json__ctor(&self);
+    self.begin = self.p = source.data;
+    self.end = source.data + source.size;
+    self.final = true;
+    py_StackRef stack = py_pushtmp();
+    py_newlist(stack);
+    bool ok = Json__feed(&self, stack) && Json__finish(&self);
+    if(ok) py_assign(py_retval(), py_list_getitem(stack, 0));
+    py_pop();
+    Json__dtor(&self);
+    return ok;
+}
+
+bool py_json_loads(const char* source) { return Json__loads((c11_sv){source, strlen(source)}); }
+
+/* push parser */
+
+void py_json_parser_new(py_OutRef out) {
+    py_Type type = py_totype(py_getdict(py_getmodule("json"), py_name("Parser")));
+    json_Parser* self = py_newobject(out, type, 1, sizeof(json_Parser));
+    Json__ctor(self);
+    py_newlist(py_getslot(out, 0));
+}
+
+bool py_json_parser_feed(py_Ref parser, const char* data, int size) {
+    json_Parser* self = py_touserdata(parser);
+    if(self->closed) return ValueError("parser is closed");
+    py_Ref stack = py_getslot(parser, 0);
+    bool ok;
+    if(self->pending.length == 0) {
+        // scan the chunk in place and keep only an unfinished token
+        self->begin = self->p = data;
+        self->end = data + size;
+        ok = Json__feed(self, stack);
+        if(ok) {
+            Json__advance(self);
+            if(self->end > self->p) {
+                c11_vector__extend(char, &self->pending, self->p, (int)(self->end - self->p));
+            }
+        }
+    } else {
+        if(size > 0) c11_vector__extend(char, &self->pending, data, size);
+        self->begin = self->p = self->pending.data;
+        self->end = self->p + self->pending.length;
+        ok = Json__feed(self, stack);
+        if(ok) {
+            Json__advance(self);
+            int rest = (int)(self->end - self->p);
+            memmove(self->pending.data, self->p, rest);
+            self->pending.length = rest;
+        }
+    }
+    if(!ok) self->closed = true;
+    return ok;
+}
+
+bool py_json_parser_close(py_Ref parser) {
+    json_Parser* self = py_touserdata(parser);
+    if(self->closed) return ValueError("parser is closed");
+    self->closed = true;
+    py_Ref stack = py_getslot(parser, 0);
+    self->begin = self->p = self->pending.data;
+    self->end = self->p + self->pending.length;
+    self->final = true;
+    bool ok = Json__feed(self, stack) && Json__finish(self);
+    if(ok) py_assign(py_retval(), py_list_getitem(stack, 0));
+    py_list_clear(stack);
+    c11_vector__clear(&self->pending);
+    return ok;
+}
+
+/* module */
+
+static bool json_loads(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    if(py_isstr(argv)) return Json__loads(py_tosv(argv));
+    py_Buffer view;
+    if(!py_getbuffer(argv, &view, false)) return false;
+    bool ok = Json__loads((c11_sv){view.data, view.size});
+    py_releasebuffer(&view);
+    return ok;
+}
+
+static bool json_dumps(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    int indent = py_toint(&argv[1]);
+    return py_json_dumps(argv, indent);
+}
+
+static bool json_dump(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    PY_CHECK_ARG_TYPE(2, tp_int);
+    if(!Json__dump(py_arg(0), py_arg(1), py_toint(py_arg(2)))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool Parser__feed(py_Ref self, py_Ref data) {
+    if(py_isstr(data)) {
+        c11_sv sv = py_tosv(data);
+        return py_json_parser_feed(self, sv.data, sv.size);
+    }
+    py_Buffer view;
+    if(!py_getbuffer(data, &view, false)) return false;
+    bool ok = py_json_parser_feed(self, view.data, view.size);
+    py_releasebuffer(&view);
+    return ok;
+}
+
+static bool json_load(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_StackRef parser = py_pushtmp();
+    py_json_parser_new(parser);
+    if(!py_getattr(argv, py_name("read"))) return false;
+    py_StackRef read = py_pushtmp();
+    py_assign(read, py_retval());
+    py_StackRef size = py_pushtmp();
+    py_newint(size, Json__CHUNK_SIZE);
+    py_StackRef chunk = py_pushtmp();
+    while(true) {
+        if(!py_call(read, 1, size)) return false;
+        py_assign(chunk, py_retval());
+        int length = py_isstr(chunk) ? py_tosv(chunk).size : -1;
+        if(length == -1) {
+            py_Buffer view;
+            if(!py_getbuffer(chunk, &view, false)) return false;
+            length = view.size;
+            py_releasebuffer(&view);
+        }
+        if(length == 0) break;
+        if(!Parser__feed(parser, chunk)) return false;
+    }
+    bool ok = py_json_parser_close(parser);
+    py_shrink(4);
+    return ok;
+}
+
+static void json_Parser__dtor(void* ud) { Json__dtor(ud); }
+
+static bool json_Parser__new__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_json_parser_new(py_retval());
+    return true;
+}
+
+static bool json_Parser_feed(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Parser__feed(py_arg(0), py_arg(1))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool json_Parser_close(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    return py_json_parser_close(py_arg(0));
+}
+
+void pk__add_module_json() {
+    py_Ref mod = py_newmodule("json");
+
+    py_setdict(mod, py_name("null"), py_None());
+    py_setdict(mod, py_name("true"), py_True());
+    py_setdict(mod, py_name("false"), py_False());
+    py_TValue tmp;
+    py_newfloat(&tmp, NAN);
+    py_setdict(mod, py_name("NaN"), &tmp);
+    py_newfloat(&tmp, INFINITY);
+    py_setdict(mod, py_name("Infinity"), &tmp);
+
+    py_bindfunc(mod, "loads", json_loads);
+    py_bind(mod, "dumps(obj, indent=0)", json_dumps);
+    py_bindfunc(mod, "load", json_load);
+    py_bind(mod, "dump(obj, fp, indent=0)", json_dump);
+
+    py_Type type = pk_newtype("Parser", tp_object, mod, json_Parser__dtor, false, true);
+    py_setdict(mod, py_name("Parser"), py_tpobject(type));
+    py_bindmagic(type, __new__, json_Parser__new__);
+    py_bindmethod(type, "feed", json_Parser_feed);
+    py_bindmethod(type, "close", json_Parser_close);
 }
 
+#undef Json__MAX_DEPTH
+#undef Json__CHUNK_SIZE
+#undef Json__SSE2
+#undef Json__NEON
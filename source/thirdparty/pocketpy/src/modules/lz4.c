@@ -3,18 +3,30 @@
 #include <string.h>
 #include <assert.h>
 #include "pocketpy/pocketpy.h"
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/threads.h"
+#include "pocketpy/common/vector.h"
+#include "pocketpy/interpreter/vm.h"
 #include "lz4/lib/lz4.h"
+#include "lz4/lib/lz4frame.h"
+#define XXH_STATIC_LINKING_ONLY
+#include "lz4/lib/xxhash.h"
+
+// how much compressed data is read from the file at a time
+#define LZ4__CHUNK_SIZE (64 * 1024)
+#define LZ4__MAX_THREADS 64
 
 static bool lz4_compress(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    PY_CHECK_ARG_TYPE(0, tp_bytes);
-    int src_size;
-    const void* src = py_tobytes(argv, &src_size);
+    py_Buffer view;
+    if(!py_getbuffer(argv, &view, false)) return false;
+    int src_size = view.size;
     int dst_capacity = LZ4_compressBound(src_size);
     char* p = (char*)py_newbytes(py_retval(), sizeof(int) + dst_capacity);
     memcpy(p, &src_size, sizeof(int));
     char* dst = p + sizeof(int);
-    int dst_size = LZ4_compress_default(src, dst, src_size, dst_capacity);
+    int dst_size = LZ4_compress_default(view.data, dst, src_size, dst_capacity);
+    py_releasebuffer(&view);
     if(dst_size <= 0) return ValueError("LZ4 compression failed");
     py_bytes_resize(py_retval(), sizeof(int) + dst_size);
     return true;
@@ -22,26 +34,413 @@ static bool lz4_compress(int argc, py_Ref argv) {
 
 static bool lz4_decompress(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    PY_CHECK_ARG_TYPE(0, tp_bytes);
-    int total_size;
-    const int* p = (int*)py_tobytes(argv, &total_size);
-    const char* src = (const char*)(p + 1);
-    if(total_size < sizeof(int)) return ValueError("invalid LZ4 data");
-    int uncompressed_size = *p;
-    if(uncompressed_size < 0) return ValueError("invalid LZ4 data");
+    py_Buffer view;
+    if(!py_getbuffer(argv, &view, false)) return false;
+    int total_size = view.size;
+    const char* src = (const char*)view.data + sizeof(int);
+    int uncompressed_size;
+    if(total_size < (int)sizeof(int)) uncompressed_size = -1;
+    else memcpy(&uncompressed_size, view.data, sizeof(int));
+    if(uncompressed_size < 0) {
+        py_releasebuffer(&view);
+        return ValueError("invalid LZ4 data");
+    }
     char* dst = (char*)py_newbytes(py_retval(), uncompressed_size);
     int dst_size = LZ4_decompress_safe(src, dst, total_size - sizeof(int), uncompressed_size);
+    py_releasebuffer(&view);
     if(dst_size < 0) return ValueError("LZ4 decompression failed");
     assert(dst_size == uncompressed_size);
     return true;
 }
 
+/* LZ4File reads and writes the LZ4 frame format, so the files are compatible with the `lz4`
+ * command line tool. Memory use is bounded by the block size: the writer buffers one block per
+ * thread, the reader one chunk of compressed data.
+ *
+ * The writer produces independent blocks, so a batch of them can be compressed in parallel.
+ * slot 0 holds the underlying file object.
+ */
+
+typedef struct {
+    const char* src;
+    int src_size;
+    char* dst;
+    int dst_size;
+} lz4_Block;
+
+typedef struct {
+    lz4_Block* blocks;
+    int start;
+    int step;
+    int length;
+#if PK_ENABLE_THREADS
+    atomic_bool is_done;
+#endif
+} lz4_Batch;
+
+typedef struct {
+    bool writing;
+    bool closed;
+    bool owns_file;
+    // writer
+    int block_size;
+    int n_threads;
+    char* src;  // n_threads blocks of input
+    int src_length;
+    char* dst;  // n_threads compressed blocks
+    XXH32_state_t checksum;
+    // reader
+    LZ4F_dctx* dctx;
+    c11_vector /*T=char*/ chunk;
+    int chunk_pos;
+    bool in_frame;
+    bool eof;
+} lz4_File;
+
+static void lz4_File__dtor(void* ud) {
+    lz4_File* self = ud;
+    PK_FREE(self->src);
+    PK_FREE(self->dst);
+    if(self->dctx) LZ4F_freeDecompressionContext(self->dctx);
+    c11_vector__dtor(&self->chunk);
+}
+
+static void lz4__compress_block(lz4_Block* block) {
+    int bound = LZ4_compressBound(block->src_size);
+    int size = LZ4_compress_default(block->src, block->dst + 4, block->src_size, bound);
+    uint32_t header = size;
+    if(size <= 0 || size >= block->src_size) {
+        // incompressible data is stored as is, flagged by the highest bit
+        memcpy(block->dst + 4, block->src, block->src_size);
+        size = block->src_size;
+        header = size | 0x80000000u;
+    }
+    memcpy(block->dst, &header, 4);
+    block->dst_size = size + 4;
+}
+
+static void lz4__compress_batch(void* arg) {
+    lz4_Batch* batch = arg;
+    for(int i = batch->start; i < batch->length; i += batch->step) {
+        lz4__compress_block(&batch->blocks[i]);
+    }
+#if PK_ENABLE_THREADS
+    // the batch lives on the stack of the flushing thread, do not touch it afterwards
+    atomic_store(&batch->is_done, true);
+#endif
+}
+
+/// Pass `size` bytes to the `write` method of the underlying file.
+static bool lz4__write_file(py_Ref self, const void* data, int size) {
+    if(size == 0) return true;
+    if(!py_getattr(py_getslot(self, 0), py_name("write"))) return false;
+    py_StackRef args = py_pushtmp();
+    py_assign(args, py_retval());
+    void* p = py_newbytes(py_pushtmp(), size);
+    memcpy(p, data, size);
+    bool ok = py_call(args, 1, args + 1);
+    py_shrink(2);
+    return ok;
+}
+
+/// Compress and write out the buffered input.
+static bool lz4_File__flush_blocks(py_Ref self) {
+    lz4_File* ud = py_touserdata(self);
+    if(ud->src_length == 0) return true;
+    int block_bound = LZ4_compressBound(ud->block_size) + 4;
+    lz4_Block blocks[LZ4__MAX_THREADS];
+    int n_blocks = 0;
+    for(int offset = 0; offset < ud->src_length; offset += ud->block_size) {
+        lz4_Block* block = &blocks[n_blocks];
+        block->src = ud->src + offset;
+        block->src_size = c11__min(ud->block_size, ud->src_length - offset);
+        block->dst = ud->dst + n_blocks * block_bound;
+        n_blocks++;
+    }
+    int n_workers = c11__min(ud->n_threads, n_blocks);
+    lz4_Batch batches[LZ4__MAX_THREADS];
+    for(int i = 0; i < n_workers; i++) {
+        lz4_Batch* batch = &batches[i];
+        batch->blocks = blocks;
+        batch->start = i;
+        batch->step = n_workers;
+        batch->length = n_blocks;
+    }
+#if PK_ENABLE_THREADS
+    // the other batches run on the shared pool, the first one here
+    for(int i = 1; i < n_workers; i++) {
+        atomic_init(&batches[i].is_done, false);
+        if(!c11_thrdpool__submit(&pk_compute_thread_pool, lz4__compress_batch, &batches[i])) {
+            lz4__compress_batch(&batches[i]);
+        }
+    }
+    atomic_init(&batches[0].is_done, false);
+    lz4__compress_batch(&batches[0]);
+    for(int i = 1; i < n_workers; i++) {
+        c11_thrdpool__wait(&pk_compute_thread_pool, &batches[i].is_done, -1);
+    }
+#else
+    for(int i = 0; i < n_workers; i++) {
+        lz4__compress_batch(&batches[i]);
+    }
+#endif
+    ud->src_length = 0;
+    // blocks are laid out with gaps, write the used parts in one go
+    int total_size = 0;
+    for(int i = 0; i < n_blocks; i++) {
+        memmove(ud->dst + total_size, blocks[i].dst, blocks[i].dst_size);
+        total_size += blocks[i].dst_size;
+    }
+    return lz4__write_file(self, ud->dst, total_size);
+}
+
+static bool lz4_File__write_header(py_Ref self) {
+    lz4_File* ud = py_touserdata(self);
+    int block_size_id;
+    switch(ud->block_size) {
+        case 64 * 1024: block_size_id = 4; break;
+        case 256 * 1024: block_size_id = 5; break;
+        case 1024 * 1024: block_size_id = 6; break;
+        default: block_size_id = 7; break;
+    }
+    unsigned char header[7];
+    uint32_t magic = 0x184D2204;
+    memcpy(header, &magic, 4);
+    // version 01, independent blocks, content checksum
+    header[4] = 0x40 | 0x20 | 0x04;
+    header[5] = block_size_id << 4;
+    header[6] = (XXH32(header + 4, 2, 0) >> 8) & 0xFF;
+    return lz4__write_file(self, header, sizeof(header));
+}
+
+static bool lz4_File__close(py_Ref self) {
+    lz4_File* ud = py_touserdata(self);
+    if(ud->closed) return true;
+    ud->closed = true;
+    if(ud->writing) {
+        if(!lz4_File__flush_blocks(self)) return false;
+        // end mark and content checksum
+        uint32_t footer[2] = {0, XXH32_digest(&ud->checksum)};
+        if(!lz4__write_file(self, footer, sizeof(footer))) return false;
+    }
+    if(ud->owns_file) {
+        if(!py_getattr(py_getslot(self, 0), py_name("close"))) return false;
+        py_StackRef f = py_pushtmp();
+        py_assign(f, py_retval());
+        bool ok = py_call(f, 0, NULL);
+        py_pop();
+        if(!ok) return false;
+    }
+    return true;
+}
+
+static bool lz4_open(int argc, py_Ref argv) {
+    // open(file, mode='rb', block_size=65536, threads=1)
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    PY_CHECK_ARG_TYPE(2, tp_int);
+    PY_CHECK_ARG_TYPE(3, tp_int);
+    const char* mode = py_tostr(py_arg(1));
+    bool writing;
+    if(strcmp(mode, "rb") == 0 || strcmp(mode, "r") == 0) {
+        writing = false;
+    } else if(strcmp(mode, "wb") == 0 || strcmp(mode, "w") == 0) {
+        writing = true;
+    } else {
+        return ValueError("invalid mode: '%s'", mode);
+    }
+    py_i64 block_size = py_toint(py_arg(2));
+    if(block_size != 64 * 1024 && block_size != 256 * 1024 && block_size != 1024 * 1024 &&
+       block_size != 4 * 1024 * 1024) {
+        return ValueError("block_size must be 64KB, 256KB, 1MB or 4MB");
+    }
+    py_i64 n_threads = py_toint(py_arg(3));
+    if(n_threads < 1 || n_threads > LZ4__MAX_THREADS) {
+        return ValueError("threads must be between 1 and %d", LZ4__MAX_THREADS);
+    }
+
+    py_StackRef file = py_pushtmp();
+    bool owns_file = py_isstr(py_arg(0));
+    if(owns_file) {
+        py_StackRef args = py_pushtmp();
+        py_assign(args, py_arg(0));
+        py_newstr(py_pushtmp(), writing ? "wb" : "rb");
+        if(!py_call(py_getbuiltin(py_name("open")), 2, args)) return false;
+        py_shrink(2);
+        py_assign(file, py_retval());
+    } else {
+        py_assign(file, py_arg(0));
+    }
+
+    py_Type type = py_totype(py_getdict(py_getmodule("lz4"), py_name("LZ4File")));
+    lz4_File* ud = py_newobject(py_retval(), type, 1, sizeof(lz4_File));
+    memset(ud, 0, sizeof(lz4_File));
+    py_setslot(py_retval(), 0, file);
+    py_pop();
+    ud->writing = writing;
+    ud->owns_file = owns_file;
+    c11_vector__ctor(&ud->chunk, sizeof(char));
+    if(writing) {
+        ud->block_size = block_size;
+        ud->n_threads = n_threads;
+        ud->src = PK_MALLOC(block_size * n_threads);
+        ud->dst = PK_MALLOC((LZ4_compressBound(block_size) + 4) * n_threads);
+        XXH32_reset(&ud->checksum, 0);
+        py_StackRef out = py_pushtmp();
+        py_assign(out, py_retval());
+        if(!lz4_File__write_header(out)) return false;
+        py_assign(py_retval(), out);
+        py_pop();
+    } else {
+        LZ4F_errorCode_t code = LZ4F_createDecompressionContext(&ud->dctx, LZ4F_VERSION);
+        if(LZ4F_isError(code)) return ValueError("%s", LZ4F_getErrorName(code));
+    }
+    return true;
+}
+
+static bool lz4_LZ4File__new__(int argc, py_Ref argv) {
+    return TypeError("use lz4.open() to create 'LZ4File' objects");
+}
+
+static bool lz4_LZ4File_write(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    lz4_File* ud = py_touserdata(py_arg(0));
+    if(!ud->writing) return ValueError("file is not open for writing");
+    if(ud->closed) return ValueError("I/O operation on closed file");
+    py_Buffer view;
+    if(py_isstr(py_arg(1))) {
+        c11_sv sv = py_tosv(py_arg(1));
+        view.data = (void*)sv.data;
+        view.size = sv.size;
+        view.obj = NULL;
+    } else {
+        if(!py_getbuffer(py_arg(1), &view, false)) return false;
+    }
+    // keep the source alive even if the write callbacks drop it
+    py_push(py_arg(1));
+    const char* p = view.data;
+    int remaining = view.size;
+    int capacity = ud->block_size * ud->n_threads;
+    bool ok = true;
+    XXH32_update(&ud->checksum, p, remaining);
+    while(remaining > 0) {
+        int n = c11__min(remaining, capacity - ud->src_length);
+        memcpy(ud->src + ud->src_length, p, n);
+        ud->src_length += n;
+        p += n;
+        remaining -= n;
+        if(ud->src_length == capacity) {
+            ok = lz4_File__flush_blocks(py_arg(0));
+            if(!ok) break;
+        }
+    }
+    py_pop();
+    if(view.obj) py_releasebuffer(&view);
+    if(!ok) return false;
+    py_newint(py_retval(), view.size);
+    return true;
+}
+
+static bool lz4_File__fill_chunk(py_Ref self) {
+    lz4_File* ud = py_touserdata(self);
+    if(!py_getattr(py_getslot(self, 0), py_name("read"))) return false;
+    py_StackRef read = py_pushtmp();
+    py_assign(read, py_retval());
+    py_newint(py_pushtmp(), LZ4__CHUNK_SIZE);
+    if(!py_call(read, 1, read + 1)) return false;
+    py_shrink(2);
+    py_Buffer view;
+    if(!py_getbuffer(py_retval(), &view, false)) return false;
+    c11_vector__clear(&ud->chunk);
+    c11_vector__extend(char, &ud->chunk, view.data, view.size);
+    ud->chunk_pos = 0;
+    if(view.size == 0) ud->eof = true;
+    py_releasebuffer(&view);
+    return true;
+}
+
+static bool lz4_LZ4File_read(int argc, py_Ref argv) {
+    // read(size=-1)
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    lz4_File* ud = py_touserdata(py_arg(0));
+    if(ud->writing) return ValueError("file is not open for reading");
+    if(ud->closed) return ValueError("I/O operation on closed file");
+    py_i64 size = py_toint(py_arg(1));
+    c11_vector out;
+    c11_vector__ctor(&out, sizeof(char));
+    while(size < 0 || out.length < size) {
+        if(ud->chunk_pos == ud->chunk.length) {
+            if(!ud->eof && !lz4_File__fill_chunk(py_arg(0))) {
+                c11_vector__dtor(&out);
+                return false;
+            }
+            if(ud->eof) break;
+        }
+        int want = size < 0 ? LZ4__CHUNK_SIZE : (int)(size - out.length);
+        c11_vector__reserve(&out, out.length + want);
+        size_t dst_size = want;
+        size_t src_size = ud->chunk.length - ud->chunk_pos;
+        size_t hint = LZ4F_decompress(ud->dctx,
+                                      (char*)out.data + out.length,
+                                      &dst_size,
+                                      (char*)ud->chunk.data + ud->chunk_pos,
+                                      &src_size,
+                                      NULL);
+        if(LZ4F_isError(hint)) {
+            c11_vector__dtor(&out);
+            return ValueError("invalid LZ4 frame: %s", LZ4F_getErrorName(hint));
+        }
+        ud->chunk_pos += src_size;
+        out.length += dst_size;
+        // a new frame may follow the one that just ended
+        ud->in_frame = hint != 0;
+    }
+    if(ud->eof && ud->in_frame) {
+        c11_vector__dtor(&out);
+        return ValueError("truncated LZ4 frame");
+    }
+    void* p = py_newbytes(py_retval(), out.length);
+    if(out.length) memcpy(p, out.data, out.length);
+    c11_vector__dtor(&out);
+    return true;
+}
+
+static bool lz4_LZ4File_close(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    if(!lz4_File__close(py_arg(0))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool lz4_LZ4File__enter__(int argc, py_Ref argv) {
+    py_assign(py_retval(), py_arg(0));
+    return true;
+}
+
+static bool lz4_LZ4File__exit__(int argc, py_Ref argv) {
+    if(!lz4_File__close(py_arg(0))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
 void pk__add_module_lz4() {
     py_Ref mod = py_newmodule("lz4");
     py_bindfunc(mod, "compress", lz4_compress);
     py_bindfunc(mod, "decompress", lz4_decompress);
+    py_bind(mod, "open(file, mode='rb', block_size=65536, threads=1)", lz4_open);
+
+    py_Type type = pk_newtype("LZ4File", tp_object, mod, lz4_File__dtor, false, true);
+    py_setdict(mod, py_name("LZ4File"), py_tpobject(type));
+    py_bindmagic(type, __new__, lz4_LZ4File__new__);
+    py_bindmagic(type, __enter__, lz4_LZ4File__enter__);
+    py_bindmagic(type, __exit__, lz4_LZ4File__exit__);
+    py_bind(py_tpobject(type), "read(self, size=-1)", lz4_LZ4File_read);
+    py_bindmethod(type, "write", lz4_LZ4File_write);
+    py_bindmethod(type, "close", lz4_LZ4File_close);
 }
 
+#undef LZ4__CHUNK_SIZE
+#undef LZ4__MAX_THREADS
+
 #else
 
 void pk__add_module_lz4() {}
@@ -103,7 +103,7 @@ void pk__add_module_os() {
 
 typedef struct {
     const char* path;
-    const char* mode;
+    bool is_binary;  // the mode string may be stored inline, so keep only what is needed
     FILE* file;
 } io_FileIO;
 
@@ -115,8 +115,9 @@ static bool io_FileIO__new__(int argc, py_Ref argv) {
     py_Type cls = py_totype(argv);
     io_FileIO* ud = py_newobject(py_retval(), cls, 0, sizeof(io_FileIO));
     ud->path = py_tostr(py_arg(1));
-    ud->mode = py_tostr(py_arg(2));
-    ud->file = fopen(ud->path, ud->mode);
+    const char* mode = py_tostr(py_arg(2));
+    ud->is_binary = mode[0] != '\0' && mode[strlen(mode) - 1] == 'b';
+    ud->file = fopen(ud->path, mode);
     if(ud->file == NULL) {
         const char* msg = strerror(errno);
         return OSError("[Errno %d] %s: '%s'", errno, msg, ud->path);
@@ -141,7 +142,7 @@ static bool io_FileIO__exit__(int argc, py_Ref argv) {
 
 static bool io_FileIO_read(int argc, py_Ref argv) {
     io_FileIO* ud = py_touserdata(py_arg(0));
-    bool is_binary = ud->mode[strlen(ud->mode) - 1] == 'b';
+    bool is_binary = ud->is_binary;
     int size;
     if(argc == 1) {
         long current = ftell(ud->file);
@@ -199,11 +200,11 @@ static bool io_FileIO_write(int argc, py_Ref argv) {
     PY_CHECK_ARGC(2);
     io_FileIO* ud = py_touserdata(py_arg(0));
     size_t written_size;
-    if(ud->mode[strlen(ud->mode) - 1] == 'b') {
-        PY_CHECK_ARG_TYPE(1, tp_bytes);
-        int filesize;
-        unsigned char* data = py_tobytes(py_arg(1), &filesize);
-        written_size = fwrite(data, 1, filesize, ud->file);
+    if(ud->is_binary) {
+        py_Buffer view;
+        if(!py_getbuffer(py_arg(1), &view, false)) return false;
+        written_size = fwrite(view.data, 1, view.size, ud->file);
+        py_releasebuffer(&view);
     } else {
         PY_CHECK_ARG_TYPE(1, tp_str);
         c11_sv sv = py_tosv(py_arg(1));
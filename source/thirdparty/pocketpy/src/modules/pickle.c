@@ -7,6 +7,7 @@
 #include "pocketpy/interpreter/vm.h"
 #include "pocketpy/interpreter/array2d.h"
 #include <stdint.h>
+#include <errno.h>
 
 typedef enum {
     // clang-format off
@@ -32,26 +33,129 @@ typedef enum {
     PKL_CALL,
     PKL_OBJECT,
     PKL_EOF,
+    // new ops go below, so that existing data keeps loading
+    PKL_BUFFER,
+    PKL_VARINT,
+    PKL_STRTAB,
+    PKL_APPENDS,
+    PKL_SETITEMS,
+    PKL_TUPLE,
     // clang-format on
 } PickleOp;
 
+/* Format 2 follows the magic with a version byte. Lengths and indices are varints, types are
+ * numbered by their position in the header, and short strings go through a string table: an
+ * entry is written in full on first use and by its index afterwards. Format 1 data has a
+ * text header instead, and can still be loaded.
+ */
+#define PKL_VERSION 2
+
+// `bytes` of at least this size are passed out-of-band when a `buffers` list is given
+#define PKL_OOB_MIN_SIZE 1024
+// longer strings are written inline
+#define PKL_STRTAB_MAX_SIZE 256
+// large containers are built in batches of this size, so that loading uses bounded stack space
+#define PKL_BATCH_SIZE 1024
+
+typedef struct {
+    int offset;
+    int size;
+} pkl_StrEntry;
+
+/// Strings written so far, by content.
+typedef struct {
+    c11_vector /*T=char*/ chars;
+    c11_vector /*T=pkl_StrEntry*/ entries;
+    int* slots;  // open addressing into `entries`, -1 if empty
+    int capacity;
+} pkl_StrTable;
+
+static void pkl_StrTable__ctor(pkl_StrTable* self) {
+    c11_vector__ctor(&self->chars, sizeof(char));
+    c11_vector__ctor(&self->entries, sizeof(pkl_StrEntry));
+    self->capacity = 64;
+    self->slots = PK_MALLOC(sizeof(int) * self->capacity);
+    memset(self->slots, -1, sizeof(int) * self->capacity);
+}
+
+static void pkl_StrTable__dtor(pkl_StrTable* self) {
+    c11_vector__dtor(&self->chars);
+    c11_vector__dtor(&self->entries);
+    PK_FREE(self->slots);
+}
+
+static uint64_t pkl_StrTable__hash(c11_sv sv) {
+    uint64_t hash = c11_sv__hash(sv);
+    return hash ^ (hash >> 29);
+}
+
+static void pkl_StrTable__insert_slot(pkl_StrTable* self, c11_sv sv, int index) {
+    int mask = self->capacity - 1;
+    int i = (int)(pkl_StrTable__hash(sv) & mask);
+    while(self->slots[i] != -1) {
+        i = (i + 1) & mask;
+    }
+    self->slots[i] = index;
+}
+
+/// Find `sv`, or add it and return -1.
+static int pkl_StrTable__get_or_add(pkl_StrTable* self, c11_sv sv) {
+    int mask = self->capacity - 1;
+    int i = (int)(pkl_StrTable__hash(sv) & mask);
+    while(self->slots[i] != -1) {
+        pkl_StrEntry* e = c11__at(pkl_StrEntry, &self->entries, self->slots[i]);
+        const char* data = (const char*)self->chars.data + e->offset;
+        if(e->size == sv.size && memcmp(data, sv.data, sv.size) == 0) return self->slots[i];
+        i = (i + 1) & mask;
+    }
+    pkl_StrEntry entry = {self->chars.length, sv.size};
+    c11_vector__extend(char, &self->chars, sv.data, sv.size);
+    c11_vector__push(pkl_StrEntry, &self->entries, entry);
+    self->slots[i] = self->entries.length - 1;
+    // keep the load factor below 1/2
+    if(self->entries.length * 2 > self->capacity) {
+        PK_FREE(self->slots);
+        self->capacity *= 2;
+        self->slots = PK_MALLOC(sizeof(int) * self->capacity);
+        memset(self->slots, -1, sizeof(int) * self->capacity);
+        for(int j = 0; j < self->entries.length; j++) {
+            pkl_StrEntry* e = c11__at(pkl_StrEntry, &self->entries, j);
+            c11_sv key = {(const char*)self->chars.data + e->offset, e->size};
+            pkl_StrTable__insert_slot(self, key, j);
+        }
+    }
+    return -1;
+}
+
 typedef struct {
-    bool* used_types;
-    int used_types_length;
+    int* type_slots;  // position of each type in the header, or -1
+    int type_slots_length;
+    c11_vector /*T=py_Type*/ types;
+    pkl_StrTable strings;
     c11_smallmap_p2i memo;
     c11_vector /*T=char*/ codes;
+    py_Ref buffer_callback;  // decides which `bytes` go out-of-band, or NULL
+    py_Ref buffers;          // list collecting large `bytes` out-of-band, or NULL
+    int buffers_length;
 } PickleObject;
 
 static void PickleObject__ctor(PickleObject* self) {
-    self->used_types_length = pk_current_vm->types.length;
-    self->used_types = PK_MALLOC(self->used_types_length);
-    memset(self->used_types, 0, self->used_types_length);
+    self->type_slots_length = pk_current_vm->types.length;
+    self->type_slots = PK_MALLOC(sizeof(int) * self->type_slots_length);
+    memset(self->type_slots, -1, sizeof(int) * self->type_slots_length);
+    c11_vector__ctor(&self->types, sizeof(py_Type));
+    pkl_StrTable__ctor(&self->strings);
     c11_smallmap_p2i__ctor(&self->memo);
     c11_vector__ctor(&self->codes, sizeof(char));
+    self->buffer_callback = NULL;
+    self->buffers = NULL;
+    self->buffers_length = 0;
 }
 
 static void PickleObject__dtor(PickleObject* self) {
-    PK_FREE(self->used_types);
+    PK_FREE(self->type_slots);
+    c11_vector__dtor(&self->types);
+    pkl_StrTable__dtor(&self->strings);
     c11_smallmap_p2i__dtor(&self->memo);
     c11_vector__dtor(&self->codes);
 }
@@ -78,28 +182,67 @@ static void pkl__emit_op(PickleObject* buf, PickleOp op) {
     c11_vector__push(char, &buf->codes, op);
 }
 
+static void pkl__write_uint(c11_vector* codes, uint64_t val) {
+    if(val < 0x80) {
+        c11_vector__push(char, codes, (char)val);
+        return;
+    }
+    char tmp[10];
+    int n = 0;
+    while(val >= 0x80) {
+        tmp[n++] = (char)(val | 0x80);
+        val >>= 7;
+    }
+    tmp[n++] = (char)val;
+    c11_vector__extend(char, codes, tmp, n);
+}
+
+static void pkl__emit_uint(PickleObject* buf, uint64_t val) { pkl__write_uint(&buf->codes, val); }
+
+/// Write an integer value. Small ones take a single op.
 static void pkl__emit_int(PickleObject* buf, py_i64 val) {
     if(val >= 0 && val <= 15) {
         pkl__emit_op(buf, PKL_INT_0 + val);
         return;
     }
-    if(INT8_MIN <= val && val <= INT8_MAX) {
-        pkl__emit_op(buf, PKL_INT8);
-        PickleObject__write_bytes(buf, &val, 1);
-    } else if(INT16_MIN <= val && val <= INT16_MAX) {
-        pkl__emit_op(buf, PKL_INT16);
-        PickleObject__write_bytes(buf, &val, 2);
-    } else if(INT32_MIN <= val && val <= INT32_MAX) {
-        pkl__emit_op(buf, PKL_INT32);
-        PickleObject__write_bytes(buf, &val, 4);
-    } else {
-        pkl__emit_op(buf, PKL_INT64);
-        PickleObject__write_bytes(buf, &val, 8);
+    pkl__emit_op(buf, PKL_VARINT);
+    // zigzag, so that small negative numbers stay short
+    pkl__emit_uint(buf, ((uint64_t)val << 1) ^ (uint64_t)(val >> 63));
+}
+
+static void pkl__emit_sint(PickleObject* buf, py_i64 val) {
+    pkl__emit_uint(buf, ((uint64_t)val << 1) ^ (uint64_t)(val >> 63));
+}
+
+/// Write a string through the string table.
+static void pkl__emit_strtab(PickleObject* buf, c11_sv sv) {
+    int index = pkl_StrTable__get_or_add(&buf->strings, sv);
+    if(index != -1) {
+        pkl__emit_uint(buf, index);
+        return;
+    }
+    // the next free index introduces a new entry
+    pkl__emit_uint(buf, buf->strings.entries.length - 1);
+    pkl__emit_uint(buf, sv.size);
+    PickleObject__write_bytes(buf, sv.data, sv.size);
+}
+
+/// Write the header position of a type, adding it to the header on first use.
+static void pkl__emit_type(PickleObject* buf, py_Type type) {
+    int slot = buf->type_slots[type];
+    if(slot == -1) {
+        slot = buf->types.length;
+        buf->type_slots[type] = slot;
+        c11_vector__push(py_Type, &buf->types, type);
     }
+    pkl__emit_uint(buf, slot);
 }
 
-static void pkl__emit_cstr(PickleObject* buf, const char* s) {
-    PickleObject__write_bytes(buf, s, strlen(s) + 1);
+/// Make sure `type` is in the header, for values that store it raw.
+static void pkl__use_type(PickleObject* buf, py_Type type) {
+    if(buf->type_slots[type] != -1) return;
+    buf->type_slots[type] = buf->types.length;
+    c11_vector__push(py_Type, &buf->types, type);
 }
 
 const static char* pkl__read_cstr(const unsigned char** p) {
@@ -108,6 +251,22 @@ const static char* pkl__read_cstr(const unsigned char** p) {
     return s;
 }
 
+static uint64_t pkl__read_uint(const unsigned char** p) {
+    uint64_t val = 0;
+    int shift = 0;
+    while(true) {
+        unsigned char byte = *(*p)++;
+        val |= (uint64_t)(byte & 0x7F) << shift;
+        if(byte < 0x80) return val;
+        shift += 7;
+    }
+}
+
+static py_i64 pkl__read_sint(const unsigned char** p) {
+    uint64_t val = pkl__read_uint(p);
+    return (py_i64)((val >> 1) ^ (~(val & 1) + 1));
+}
+
 #define UNALIGNED_READ(p_val, p_buf)                                                               \
     do {                                                                                           \
         memcpy((p_val), (p_buf), sizeof(*(p_val)));                                                \
@@ -149,41 +308,107 @@ static py_i64 pkl__read_int(const unsigned char** p) {
 }
 
 static bool pickle_loads(int argc, py_Ref argv) {
-    PY_CHECK_ARGC(1);
-    PY_CHECK_ARG_TYPE(0, tp_bytes);
-    int size;
-    const unsigned char* data = py_tobytes(argv, &size);
-    return py_pickle_loads(data, size);
+    // (data, buffers=None)
+    py_Ref buffers = NULL;
+    if(!py_isnone(py_arg(1))) {
+        buffers = py_arg(1);
+        if(!py_islist(buffers) && !py_istuple(buffers)) {
+            if(!py_tpcall(tp_list, 1, buffers)) return false;
+            py_assign(buffers, py_retval());
+        }
+    }
+    py_Buffer view;
+    if(!py_getbuffer(py_arg(0), &view, false)) return false;
+    bool ok = pk_pickle_loads(view.data, view.size, buffers);
+    py_releasebuffer(&view);
+    return ok;
 }
 
 static bool pickle_dumps(int argc, py_Ref argv) {
-    PY_CHECK_ARGC(1);
-    return py_pickle_dumps(argv);
+    // (obj, buffer_callback=None)
+    py_Ref buffer_callback = py_isnone(py_arg(1)) ? NULL : py_arg(1);
+    return pk_pickle_dumps(py_arg(0), buffer_callback, NULL);
+}
+
+static bool pickle_load(int argc, py_Ref argv) {
+    // (file, buffers=None)
+    if(!py_getattr(py_arg(0), py_name("read"))) return false;
+    py_StackRef read = py_pushtmp();
+    py_assign(read, py_retval());
+    if(!py_call(read, 0, NULL)) return false;
+    // (data, buffers)
+    py_assign(read, py_retval());
+    py_push(py_arg(1));
+    bool ok = pickle_loads(2, read);
+    py_shrink(2);
+    return ok;
+}
+
+static bool pickle_dump(int argc, py_Ref argv) {
+    // (obj, file, buffer_callback=None)
+    py_Ref buffer_callback = py_isnone(py_arg(2)) ? NULL : py_arg(2);
+    if(!py_getattr(py_arg(1), py_name("write"))) return false;
+    py_StackRef write = py_pushtmp();
+    py_assign(write, py_retval());
+    if(!pk_pickle_dumps(py_arg(0), buffer_callback, NULL)) return false;
+    py_push(py_retval());
+    bool ok = py_call(write, 1, write + 1);
+    py_shrink(2);
+    if(ok) py_newnone(py_retval());
+    return ok;
 }
 
 void pk__add_module_pickle() {
     py_Ref mod = py_newmodule("pickle");
 
-    py_bindfunc(mod, "loads", pickle_loads);
-    py_bindfunc(mod, "dumps", pickle_dumps);
+    py_bind(mod, "loads(data, buffers=None)", pickle_loads);
+    py_bind(mod, "dumps(obj, buffer_callback=None)", pickle_dumps);
+    py_bind(mod, "load(file, buffers=None)", pickle_load);
+    py_bind(mod, "dump(obj, file, buffer_callback=None)", pickle_dump);
 }
 
 static bool pkl__write_object(PickleObject* buf, py_TValue* obj);
 
 static bool pkl__write_array(PickleObject* buf, PickleOp op, py_TValue* arr, int length) {
+    bool batched = length > PKL_BATCH_SIZE;
     for(int i = 0; i < length; i++) {
         bool ok = pkl__write_object(buf, arr + i);
         if(!ok) return false;
+        int n = (i + 1) % PKL_BATCH_SIZE;
+        if(n != 0 && i + 1 < length) continue;
+        if(n == 0) n = PKL_BATCH_SIZE;
+        if(i < PKL_BATCH_SIZE) {
+            // a large tuple is built as a list first
+            pkl__emit_op(buf, batched ? PKL_BUILD_LIST : op);
+        } else {
+            pkl__emit_op(buf, PKL_APPENDS);
+        }
+        pkl__emit_uint(buf, n);
+    }
+    if(length == 0) {
+        pkl__emit_op(buf, op);
+        pkl__emit_uint(buf, 0);
     }
-    pkl__emit_op(buf, op);
-    pkl__emit_int(buf, length);
+    if(batched && op == PKL_BUILD_TUPLE) pkl__emit_op(buf, PKL_TUPLE);
     return true;
 }
 
+typedef struct {
+    PickleObject* buf;
+    int count;  // items since the last op
+    bool built;
+} pkl_DictWriter;
+
 static bool pkl__write_dict_kv(py_Ref k, py_Ref v, void* ctx) {
-    PickleObject* buf = (PickleObject*)ctx;
-    if(!pkl__write_object(buf, k)) return false;
-    if(!pkl__write_object(buf, v)) return false;
+    pkl_DictWriter* w = (pkl_DictWriter*)ctx;
+    if(!pkl__write_object(w->buf, k)) return false;
+    if(!pkl__write_object(w->buf, v)) return false;
+    if(++w->count == PKL_BATCH_SIZE) {
+        pkl__emit_op(w->buf, w->built ? PKL_SETITEMS : PKL_BUILD_DICT);
+        pkl__emit_uint(w->buf, w->count);
+        w->count = 0;
+        w->built = true;
+    }
     return true;
 }
 
@@ -191,7 +416,7 @@ static bool pkl__try_memo(PickleObject* buf, PyObject* memo_key) {
     int index = c11_smallmap_p2i__get(&buf->memo, memo_key, -1);
     if(index != -1) {
         pkl__emit_op(buf, PKL_MEMO_GET);
-        pkl__emit_int(buf, index);
+        pkl__emit_uint(buf, index);
         return true;
     }
     return false;
@@ -201,7 +426,25 @@ static void pkl__store_memo(PickleObject* buf, PyObject* memo_key) {
     int index = buf->memo.length;
     c11_smallmap_p2i__set(&buf->memo, memo_key, index);
     pkl__emit_op(buf, PKL_MEMO_SET);
-    pkl__emit_int(buf, index);
+    pkl__emit_uint(buf, index);
+}
+
+/// Pass a `bytes` object out-of-band if asked to.
+/// Returns 1 if it was, 0 if it should be written in-band and -1 on error.
+static int pkl__out_of_band(PickleObject* buf, py_Ref obj, int size) {
+    if(buf->buffer_callback) {
+        if(!py_call(buf->buffer_callback, 1, obj)) return -1;
+        // a true value keeps the buffer in-band
+        int res = py_bool(py_retval());
+        if(res != 0) return res == 1 ? 0 : -1;
+    } else if(buf->buffers != NULL && size >= PKL_OOB_MIN_SIZE) {
+        py_list_append(buf->buffers, obj);
+    } else {
+        return 0;
+    }
+    pkl__emit_op(buf, PKL_BUFFER);
+    pkl__emit_uint(buf, buf->buffers_length++);
+    return 1;
 }
 
 static bool _check_function(Function* f) {
@@ -250,21 +493,30 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
             return true;
         }
         case tp_str: {
+            c11_sv sv = py_tosv(obj);
+            if(sv.size <= PKL_STRTAB_MAX_SIZE) {
+                pkl__emit_op(buf, PKL_STRTAB);
+                pkl__emit_strtab(buf, sv);
+                return true;
+            }
             if(obj->is_ptr && pkl__try_memo(buf, obj->_obj)) return true;
             pkl__emit_op(buf, PKL_STRING);
-            c11_sv sv = py_tosv(obj);
-            pkl__emit_int(buf, sv.size);
+            pkl__emit_uint(buf, sv.size);
             PickleObject__write_bytes(buf, sv.data, sv.size);
             if(obj->is_ptr) pkl__store_memo(buf, obj->_obj);
             return true;
         }
         case tp_bytes: {
             if(pkl__try_memo(buf, obj->_obj)) return true;
-            pkl__emit_op(buf, PKL_BYTES);
             int size;
             unsigned char* data = py_tobytes(obj, &size);
-            pkl__emit_int(buf, size);
-            PickleObject__write_bytes(buf, data, size);
+            int res = pkl__out_of_band(buf, obj, size);
+            if(res == -1) return false;
+            if(res == 0) {
+                pkl__emit_op(buf, PKL_BYTES);
+                pkl__emit_uint(buf, size);
+                PickleObject__write_bytes(buf, data, size);
+            }
             pkl__store_memo(buf, obj->_obj);
             return true;
         }
@@ -284,10 +536,13 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
         }
         case tp_dict: {
             if(pkl__try_memo(buf, obj->_obj)) return true;
-            bool ok = py_dict_apply(obj, pkl__write_dict_kv, (void*)buf);
+            pkl_DictWriter w = {buf, 0, false};
+            bool ok = py_dict_apply(obj, pkl__write_dict_kv, &w);
             if(!ok) return false;
-            pkl__emit_op(buf, PKL_BUILD_DICT);
-            pkl__emit_int(buf, py_dict_len(obj));
+            if(!w.built || w.count > 0) {
+                pkl__emit_op(buf, w.built ? PKL_SETITEMS : PKL_BUILD_DICT);
+                pkl__emit_uint(buf, w.count);
+            }
             pkl__store_memo(buf, obj->_obj);
             return true;
         }
@@ -306,30 +561,28 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
         case tp_vec2i: {
             c11_vec2i val = py_tovec2i(obj);
             pkl__emit_op(buf, PKL_VEC2I);
-            pkl__emit_int(buf, val.x);
-            pkl__emit_int(buf, val.y);
+            pkl__emit_sint(buf, val.x);
+            pkl__emit_sint(buf, val.y);
             return true;
         }
         case tp_vec3i: {
             c11_vec3i val = py_tovec3i(obj);
             pkl__emit_op(buf, PKL_VEC3I);
-            pkl__emit_int(buf, val.x);
-            pkl__emit_int(buf, val.y);
-            pkl__emit_int(buf, val.z);
+            pkl__emit_sint(buf, val.x);
+            pkl__emit_sint(buf, val.y);
+            pkl__emit_sint(buf, val.z);
             return true;
         }
         case tp_type: {
             pkl__emit_op(buf, PKL_TYPE);
-            py_Type type = py_totype(obj);
-            buf->used_types[type] = true;
-            pkl__emit_int(buf, type);
+            pkl__emit_type(buf, py_totype(obj));
             return true;
         }
         case tp_module: {
             if(pkl__try_memo(buf, obj->_obj)) return true;
             py_ModuleInfo* mi = py_touserdata(obj);
             pkl__emit_op(buf, PKL_IMPORT_PATH);
-            pkl__emit_cstr(buf, mi->path->data);
+            pkl__emit_strtab(buf, c11_string__sv(mi->path));
             pkl__store_memo(buf, obj->_obj);
             return true;
         }
@@ -342,14 +595,12 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
                 // NOTE: copied from logic of `case tp_type:`
                 pkl__emit_op(buf, PKL_TYPE);
                 py_TypeInfo* ti = PyObject__userdata(f->clazz);
-                py_Type type = ti->index;
-                buf->used_types[type] = true;
-                pkl__emit_int(buf, type);
+                pkl__emit_type(buf, ti->index);
             } else {
                 if(!pkl__write_object(buf, f->module)) return false;
             }
             pkl__emit_op(buf, PKL_GETATTR);
-            pkl__emit_cstr(buf, name->data);
+            pkl__emit_strtab(buf, c11_string__sv(name));
             pkl__store_memo(buf, obj->_obj);
             return true;
         }
@@ -369,12 +620,10 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
             c11_string* name = f->decl->code.name;
             // NOTE: copied from logic of `case tp_type:`
             pkl__emit_op(buf, PKL_TYPE);
-            py_Type type = py_totype(self);
-            buf->used_types[type] = true;
-            pkl__emit_int(buf, type);
+            pkl__emit_type(buf, py_totype(self));
 
             pkl__emit_op(buf, PKL_GETATTR);
-            pkl__emit_cstr(buf, name->data);
+            pkl__emit_strtab(buf, c11_string__sv(name));
             return true;
         }
         case tp_array2d: {
@@ -384,11 +633,11 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
                 if(arr->data[i].is_ptr)
                     return TypeError(
                         "'array2d' object is not picklable because it contains heap-allocated objects");
-                buf->used_types[arr->data[i].type] = true;
+                pkl__use_type(buf, arr->data[i].type);
             }
             pkl__emit_op(buf, PKL_ARRAY2D);
-            pkl__emit_int(buf, arr->header.n_cols);
-            pkl__emit_int(buf, arr->header.n_rows);
+            pkl__emit_uint(buf, arr->header.n_cols);
+            pkl__emit_uint(buf, arr->header.n_rows);
             PickleObject__write_bytes(buf, arr->data, arr->header.numel * sizeof(py_TValue));
             pkl__store_memo(buf, obj->_obj);
             return true;
@@ -397,7 +646,7 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
             if(!obj->is_ptr) {
                 pkl__emit_op(buf, PKL_TVALUE);
                 PickleObject__write_bytes(buf, obj, sizeof(py_TValue));
-                buf->used_types[obj->type] = true;
+                pkl__use_type(buf, obj->type);
                 return true;
             }
             // try memo for `is_ptr=true` objects
@@ -408,7 +657,9 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
             if(f_reduce != NULL) {
                 if(!py_call(f_reduce, 1, obj)) return false;
                 // expected: (callable, args)
-                py_Ref reduced = py_retval();
+                // keep it on the stack, writing the parts may call back into python
+                py_Ref reduced = py_pushtmp();
+                py_assign(reduced, py_retval());
                 if(!py_istuple(reduced)) { return TypeError("__reduce__ must return a tuple"); }
                 if(py_tuple_len(reduced) != 2) {
                     return TypeError("__reduce__ must return a tuple of length 2");
@@ -421,7 +672,8 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
                     if(!pkl__write_object(buf, py_tuple_getitem(args_tuple, i))) return false;
                 }
                 pkl__emit_op(buf, PKL_CALL);
-                pkl__emit_int(buf, args_length);
+                pkl__emit_uint(buf, args_length);
+                py_pop();
                 // store memo
                 pkl__store_memo(buf, obj->_obj);
                 return true;
@@ -434,15 +686,12 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
                     if(!pkl__write_object(buf, &kv->value)) return false;
                 }
                 pkl__emit_op(buf, PKL_OBJECT);
-                pkl__emit_int(buf, obj->type);
-                buf->used_types[obj->type] = true;
-                pkl__emit_int(buf, dict->length);
+                pkl__emit_type(buf, obj->type);
+                pkl__emit_uint(buf, dict->length);
                 for(int i = 0; i < dict->capacity; i++) {
                     NameDict_KV* kv = &dict->items[i];
                     if(kv->key == NULL) continue;
-                    c11_sv field = py_name2sv(kv->key);
-                    // include '\0'
-                    PickleObject__write_bytes(buf, field.data, field.size + 1);
+                    pkl__emit_strtab(buf, py_name2sv(kv->key));
                 }
 
                 // store memo
@@ -455,9 +704,15 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
     c11__unreachable();
 }
 
-bool py_pickle_dumps(py_Ref val) {
+bool py_pickle_dumps(py_Ref val) { return pk_pickle_dumps(val, NULL, NULL); }
+
+bool pk_pickle_dumps(py_Ref val, py_Ref buffer_callback, py_Ref buffers) {
     PickleObject buf;
     PickleObject__ctor(&buf);
+    buf.buffer_callback = buffer_callback;
+    buf.buffers = buffers;
+    // indices continue, so one list can serve several streams
+    if(buffers) buf.buffers_length = py_list_len(buffers);
     bool ok = pkl__write_object(&buf, val);
     if(!ok) {
         PickleObject__dtor(&buf);
@@ -496,19 +751,21 @@ static py_i64 pkl__header_read_int(const unsigned char** p, char sep) {
     return out;
 }
 
-bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_d2d* type_mapping);
+typedef struct {
+    int version;
+    c11_smallmap_d2d type_mapping;   // old type index -> new type index
+    c11_vector /*T=py_Type*/ types;  // header position -> new type index (version 2)
+    py_Ref buffers;
+} pkl_Loader;
 
-bool py_pickle_loads(const unsigned char* data, int size) {
-    const unsigned char* p = data;
+bool py_pickle_loads_body(const unsigned char* p, int memo_length, pkl_Loader* loader);
 
-    // \xf0\x9f\xa5\x95
-    if(size < 4 || p[0] != 240 || p[1] != 159 || p[2] != 165 || p[3] != 149)
-        return ValueError("invalid pickle data");
-    p += 4;
-
-    c11_smallmap_d2d type_mapping;
-    c11_smallmap_d2d__ctor(&type_mapping);
+bool py_pickle_loads(const unsigned char* data, int size) {
+    return pk_pickle_loads(data, size, NULL);
+}
 
+static bool pkl__read_header_v1(const unsigned char** p_ptr, pkl_Loader* loader) {
+    const unsigned char* p = *p_ptr;
     while(true) {
         if(*p == '\n') {
             p++;
@@ -517,16 +774,61 @@ bool py_pickle_loads(const unsigned char* data, int size) {
         py_Type type = pkl__header_read_int(&p, '(');
         c11_sv path = pkl__header_read_sv(&p, ')');
         py_Type new_type = pkl__header_find_type(path);
-        if(new_type == 0) {
-            c11_smallmap_d2d__dtor(&type_mapping);
-            return ImportError("cannot find type '%v'", path);
-        }
-        if(type != new_type) c11_smallmap_d2d__set(&type_mapping, type, new_type);
+        if(new_type == 0) return ImportError("cannot find type '%v'", path);
+        if(type != new_type) c11_smallmap_d2d__set(&loader->type_mapping, type, new_type);
+    }
+    *p_ptr = p;
+    return true;
+}
+
+static bool pkl__read_header_v2(const unsigned char** p_ptr, pkl_Loader* loader) {
+    const unsigned char* p = *p_ptr;
+    int n_types = pkl__read_uint(&p);
+    for(int i = 0; i < n_types; i++) {
+        py_Type type = pkl__read_uint(&p);
+        c11_sv path;
+        path.size = pkl__read_uint(&p);
+        path.data = (const char*)p;
+        p += path.size;
+        py_Type new_type = pkl__header_find_type(path);
+        if(new_type == 0) return ImportError("cannot find type '%v'", path);
+        if(type != new_type) c11_smallmap_d2d__set(&loader->type_mapping, type, new_type);
+        c11_vector__push(py_Type, &loader->types, new_type);
+    }
+    *p_ptr = p;
+    return true;
+}
+
+bool pk_pickle_loads(const unsigned char* data, int size, py_Ref buffers) {
+    const unsigned char* p = data;
+
+    // \xf0\x9f\xa5\x95
+    if(size < 5 || p[0] != 240 || p[1] != 159 || p[2] != 165 || p[3] != 149)
+        return ValueError("invalid pickle data");
+    p += 4;
+
+    pkl_Loader loader;
+    // version 1 starts with a text header, whose first byte is a digit or '\n'
+    loader.version = *p < ' ' && *p != '\n' ? *p++ : 1;
+    if(loader.version > PKL_VERSION) {
+        return ValueError("unsupported pickle protocol: %d", loader.version);
     }
+    c11_smallmap_d2d__ctor(&loader.type_mapping);
+    c11_vector__ctor(&loader.types, sizeof(py_Type));
+    loader.buffers = buffers;
 
-    int memo_length = pkl__header_read_int(&p, '\n');
-    bool ok = py_pickle_loads_body(p, memo_length, &type_mapping);
-    c11_smallmap_d2d__dtor(&type_mapping);
+    bool ok;
+    int memo_length;
+    if(loader.version == 1) {
+        ok = pkl__read_header_v1(&p, &loader);
+        if(ok) memo_length = pkl__header_read_int(&p, '\n');
+    } else {
+        ok = pkl__read_header_v2(&p, &loader);
+        if(ok) memo_length = pkl__read_uint(&p);
+    }
+    if(ok) ok = py_pickle_loads_body(p, memo_length, &loader);
+    c11_smallmap_d2d__dtor(&loader.type_mapping);
+    c11_vector__dtor(&loader.types);
     return ok;
 }
 
@@ -536,7 +838,55 @@ static py_Type pkl__fix_type(py_Type type, c11_smallmap_d2d* type_mapping) {
     return type;
 }
 
-bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_d2d* type_mapping) {
+/// Read a length or an index field.
+static int pkl__read_size(const unsigned char** p, pkl_Loader* loader) {
+    if(loader->version == 1) return pkl__read_int(p);
+    return pkl__read_uint(p);
+}
+
+static py_Type pkl__read_type(const unsigned char** p, pkl_Loader* loader) {
+    if(loader->version == 1) return pkl__fix_type(pkl__read_int(p), &loader->type_mapping);
+    return c11__getitem(py_Type, &loader->types, pkl__read_uint(p));
+}
+
+/// Read a string table reference, and the entry itself if it is new.
+static py_ItemRef pkl__read_strtab(const unsigned char** p, py_Ref table) {
+    int index = pkl__read_uint(p);
+    if(index == py_list_len(table)) {
+        c11_sv sv;
+        sv.size = pkl__read_uint(p);
+        sv.data = (const char*)*p;
+        (*p) += sv.size;
+        py_newstrv(py_retval(), sv);
+        py_list_append(table, py_retval());
+    }
+    return py_list_getitem(table, index);
+}
+
+/// Read a name, either inline (version 1) or from the string table.
+static c11_sv pkl__read_name(const unsigned char** p, pkl_Loader* loader, py_Ref table) {
+    if(loader->version == 1) {
+        const char* s = pkl__read_cstr(p);
+        return (c11_sv){s, strlen(s)};
+    }
+    return py_tosv(pkl__read_strtab(p, table));
+}
+
+/// Whether instances of `type` are only a `__dict__`, as `PKL_OBJECT` rebuilds them.
+static bool pkl__is_pure(py_Type type) {
+    for(py_TypeInfo* ti = pk_typeinfo(type); ti->index != tp_object; ti = ti->base_ti) {
+        if(!ti->is_python) return false;
+    }
+    return true;
+}
+
+static bool pkl__set_add(py_Ref key, py_Ref val, void* ctx) { return py_set_add(ctx, key); }
+
+bool py_pickle_loads_body(const unsigned char* p, int memo_length, pkl_Loader* loader) {
+    c11_smallmap_d2d* type_mapping = &loader->type_mapping;
+    py_Ref buffers = loader->buffers;
+    py_Ref p_strtab = py_pushtmp();
+    py_newlist(p_strtab);
     py_StackRef p0 = py_peek(0);
     py_Ref p_memo = py_newtuple(py_pushtmp(), memo_length);
     while(true) {
@@ -544,14 +894,14 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
         p++;
         switch(op) {
             case PKL_MEMO_GET: {
-                int index = pkl__read_int(&p);
+                int index = pkl__read_size(&p, loader);
                 py_Ref val = &p_memo[index];
                 assert(!py_isnil(val));
                 py_push(val);
                 break;
             }
             case PKL_MEMO_SET: {
-                int index = pkl__read_int(&p);
+                int index = pkl__read_size(&p, loader);
                 p_memo[index] = *py_peek(-1);
                 break;
             }
@@ -600,6 +950,10 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
                 py_newint(py_pushtmp(), val);
                 break;
             }
+            case PKL_VARINT: {
+                py_newint(py_pushtmp(), pkl__read_sint(&p));
+                break;
+            }
             case PKL_FLOAT32: {
                 float val;
                 UNALIGNED_READ(&val, p);
@@ -621,21 +975,25 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
                 break;
             }
             case PKL_STRING: {
-                int size = pkl__read_int(&p);
+                int size = pkl__read_size(&p, loader);
                 char* dst = py_newstrn(py_pushtmp(), size);
                 memcpy(dst, p, size);
                 p += size;
                 break;
             }
+            case PKL_STRTAB: {
+                py_push(pkl__read_strtab(&p, p_strtab));
+                break;
+            }
             case PKL_BYTES: {
-                int size = pkl__read_int(&p);
+                int size = pkl__read_size(&p, loader);
                 unsigned char* dst = py_newbytes(py_pushtmp(), size);
                 memcpy(dst, p, size);
                 p += size;
                 break;
             }
             case PKL_BUILD_LIST: {
-                int length = pkl__read_int(&p);
+                int length = pkl__read_size(&p, loader);
                 py_Ref val = py_retval();
                 py_newlistn(val, length);
                 for(int i = length - 1; i >= 0; i--) {
@@ -647,7 +1005,7 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
                 break;
             }
             case PKL_BUILD_TUPLE: {
-                int length = pkl__read_int(&p);
+                int length = pkl__read_size(&p, loader);
                 py_Ref val = py_retval();
                 py_Ref p = py_newtuple(val, length);
                 for(int i = length - 1; i >= 0; i--) {
@@ -658,7 +1016,7 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
                 break;
             }
             case PKL_BUILD_DICT: {
-                int length = pkl__read_int(&p);
+                int length = pkl__read_size(&p, loader);
                 py_Ref val = py_pushtmp();
                 py_newdict(val);
                 py_StackRef begin = py_peek(-1) - 2 * length;
@@ -674,6 +1032,32 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
                 py_push(py_retval());
                 break;
             }
+            case PKL_APPENDS: {
+                int length = pkl__read_size(&p, loader);
+                py_Ref val = py_peek(-length - 1);
+                for(int i = 0; i < length; i++) {
+                    py_list_append(val, py_peek(-length + i));
+                }
+                py_shrink(length);
+                break;
+            }
+            case PKL_SETITEMS: {
+                int length = pkl__read_size(&p, loader);
+                py_Ref val = py_peek(-2 * length - 1);
+                for(py_StackRef i = val + 1; i < py_peek(0); i += 2) {
+                    if(!py_dict_setitem(val, i, i + 1)) return false;
+                }
+                py_shrink(2 * length);
+                break;
+            }
+            case PKL_TUPLE: {
+                py_Ref val = py_peek(-1);
+                int length = py_list_len(val);
+                py_Ref p = py_newtuple(py_retval(), length);
+                memcpy(p, py_list_data(val), sizeof(py_TValue) * length);
+                py_assign(val, py_retval());
+                break;
+            }
             case PKL_VEC2: {
                 c11_vec2 val;
                 UNALIGNED_READ(&val, p);
@@ -688,28 +1072,29 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
             }
             case PKL_VEC2I: {
                 c11_vec2i val;
-                val.x = pkl__read_int(&p);
-                val.y = pkl__read_int(&p);
+                bool v1 = loader->version == 1;
+                val.x = v1 ? pkl__read_int(&p) : pkl__read_sint(&p);
+                val.y = v1 ? pkl__read_int(&p) : pkl__read_sint(&p);
                 py_newvec2i(py_pushtmp(), val);
                 break;
             }
             case PKL_VEC3I: {
                 c11_vec3i val;
-                val.x = pkl__read_int(&p);
-                val.y = pkl__read_int(&p);
-                val.z = pkl__read_int(&p);
+                bool v1 = loader->version == 1;
+                val.x = v1 ? pkl__read_int(&p) : pkl__read_sint(&p);
+                val.y = v1 ? pkl__read_int(&p) : pkl__read_sint(&p);
+                val.z = v1 ? pkl__read_int(&p) : pkl__read_sint(&p);
                 py_newvec3i(py_pushtmp(), val);
                 break;
             }
             case PKL_TYPE: {
-                py_Type type = (py_Type)pkl__read_int(&p);
-                type = pkl__fix_type(type, type_mapping);
+                py_Type type = pkl__read_type(&p, loader);
                 py_push(py_tpobject(type));
                 break;
             }
             case PKL_ARRAY2D: {
-                int n_cols = pkl__read_int(&p);
-                int n_rows = pkl__read_int(&p);
+                int n_cols = pkl__read_size(&p, loader);
+                int n_rows = pkl__read_size(&p, loader);
                 c11_array2d* arr = c11_newarray2d(py_pushtmp(), n_cols, n_rows);
                 int total_size = arr->header.numel * sizeof(py_TValue);
                 memcpy(arr->data, p, total_size);
@@ -720,7 +1105,7 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
                 break;
             }
             case PKL_IMPORT_PATH: {
-                const char* path = pkl__read_cstr(&p);
+                const char* path = pkl__read_name(&p, loader, p_strtab).data;
                 int res = py_import(path);
                 if(res == -1) return false;
                 if(res == 0) return ImportError("No module named '%s'", path);
@@ -728,9 +1113,9 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
                 break;
             }
             case PKL_GETATTR: {
-                const char* name = pkl__read_cstr(&p);
+                c11_sv name = pkl__read_name(&p, loader, p_strtab);
                 py_Ref obj = py_peek(-1);
-                if(!py_getattr(obj, py_name(name))) return false;
+                if(!py_getattr(obj, py_namev(name))) return false;
                 py_pop();
                 py_push(py_retval());
                 break;
@@ -743,32 +1128,57 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
                 break;
             }
             case PKL_CALL: {
-                int argc = pkl__read_int(&p);
+                int argc = pkl__read_size(&p, loader);
                 if(!py_vectorcall(argc, 0)) return false;
                 py_push(py_retval());
                 break;
             }
             case PKL_OBJECT: {
-                py_Type type = (py_Type)pkl__read_int(&p);
-                type = pkl__fix_type(type, type_mapping);
-                py_newobject(py_retval(), type, -1, 0);
-                NameDict* dict = PyObject__dict(py_retval()->_obj);
-                int dict_length = pkl__read_int(&p);
-                for(int i = 0; i < dict_length; i++) {
-                    py_StackRef value = py_peek(-1);
-                    c11_sv field = {(const char*)p, strlen((const char*)p)};
-                    NameDict__set(dict, py_namev(field), value);
+                py_Type type = pkl__read_type(&p, loader);
+                int dict_length = pkl__read_size(&p, loader);
+                py_Ref val = py_pushtmp();
+                if(type == tp_set && dict_length == 1) {
+                    // version 1 wrote sets as a python class keeping the elements in `_a`
+                    c11_sv field = pkl__read_name(&p, loader, p_strtab);
+                    py_Ref elems = val - 1;
+                    if(!c11__sveq2(field, "_a") || !py_isdict(elems)) {
+                        return ValueError("invalid pickle data");
+                    }
+                    py_newset(val);
+                    if(!py_dict_apply(elems, pkl__set_add, val)) return false;
+                    py_assign(elems, val);
                     py_pop();
-                    p += field.size + 1;
+                    break;
                 }
+                if(!pkl__is_pure(type)) return TypeError("cannot unpickle '%t' object", type);
+                py_newobject(val, type, -1, 0);
+                NameDict* dict = PyObject__dict(val->_obj);
+                // fields were written in reverse, the first one is on top
+                for(int i = 0; i < dict_length; i++) {
+                    c11_sv field = pkl__read_name(&p, loader, p_strtab);
+                    NameDict__set(dict, py_namev(field), val - 1 - i);
+                }
+                py_assign(py_retval(), val);
+                py_shrink(dict_length + 1);
                 py_push(py_retval());
                 break;
             }
+            case PKL_BUFFER: {
+                int index = pkl__read_size(&p, loader);
+                py_TValue* items;
+                int length = buffers ? pk_arrayview(buffers, &items) : 0;
+                if(index < 0 || index >= length) {
+                    return ValueError("missing out-of-band buffer %d", index);
+                }
+                // the object is used as is, without copying
+                py_push(&items[index]);
+                break;
+            }
             case PKL_EOF: {
-                // [memo, obj]
+                // [strtab, memo, obj]
                 if(py_peek(0) - p0 != 2) return ValueError("invalid pickle data");
                 py_assign(py_retval(), py_peek(-1));
-                py_shrink(2);
+                py_shrink(3);
                 return true;
             }
             default: c11__unreachable();
@@ -778,31 +1188,155 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
 }
 
 static bool PickleObject__py_submit(PickleObject* self, py_OutRef out) {
-    c11_sbuf cleartext;
-    c11_sbuf__ctor(&cleartext);
-    c11_sbuf__write_cstr(&cleartext, "\xf0\x9f\xa5\x95");
-    // line 1: type mapping
-    for(py_Type type = 0; type < self->used_types_length; type++) {
-        if(self->used_types[type]) {
-            c11_sbuf__write_int(&cleartext, type);
-            c11_sbuf__write_char(&cleartext, '(');
-            c11_sbuf__write_type_path(&cleartext, type);
-            c11_sbuf__write_char(&cleartext, ')');
-        }
-    }
-    c11_sbuf__write_char(&cleartext, '\n');
-    // line 2: memo length
-    c11_sbuf__write_int(&cleartext, self->memo.length);
-    c11_sbuf__write_char(&cleartext, '\n');
+    c11_vector header;
+    c11_vector__ctor(&header, sizeof(char));
+    c11_vector__extend(char, &header, "\xf0\x9f\xa5\x95", 4);
+    c11_vector__push(char, &header, PKL_VERSION);
+    // types, in the order they are referenced
+    pkl__write_uint(&header, self->types.length);
+    c11__foreach(py_Type, &self->types, type) {
+        c11_sbuf path_buf;
+        c11_sbuf__ctor(&path_buf);
+        c11_sbuf__write_type_path(&path_buf, *type);
+        c11_string* path = c11_sbuf__submit(&path_buf);
+        pkl__write_uint(&header, *type);
+        pkl__write_uint(&header, path->size);
+        c11_vector__extend(char, &header, path->data, path->size);
+        c11_string__delete(path);
+    }
+    pkl__write_uint(&header, self->memo.length);
     // -------------------------------------------------- //
-    c11_string* header = c11_sbuf__submit(&cleartext);
-    int total_size = header->size + self->codes.length;
+    int total_size = header.length + self->codes.length;
     unsigned char* p = py_newbytes(py_retval(), total_size);
-    memcpy(p, header->data, header->size);
-    memcpy(p + header->size, self->codes.data, self->codes.length);
-    c11_string__delete(header);
+    memcpy(p, header.data, header.length);
+    memcpy(p + header.length, self->codes.data, self->codes.length);
+    c11_vector__dtor(&header);
     PickleObject__dtor(self);
     return true;
 }
 
+/************* snapshot *************/
+
+static void pkl__collect_modules(BinTree* node, c11_vector* out) {
+    if(node == NULL) return;
+    pkl__collect_modules(node->left, out);
+    // the root node is a placeholder
+    if(!py_isnil(&node->value)) {
+        py_ModuleInfo* mi = py_touserdata(&node->value);
+        if(mi->is_source || mi->self == pk_current_vm->main) {
+            c11_vector__push(py_Ref, out, &node->value);
+        }
+    }
+    pkl__collect_modules(node->right, out);
+}
+
+static bool pkl__snapshot_global(py_Name name, py_Ref val, void* ctx) {
+    c11_sv sv = py_name2sv(name);
+    if(sv.size >= 2 && sv.data[0] == '_' && sv.data[1] == '_') return true;
+    switch(val->type) {
+        // code is defined again by the program, only data is kept
+        case tp_module:
+        case tp_function:
+        case tp_nativefunc:
+        case tp_boundmethod:
+        case tp_type:
+        case tp_property:
+        case tp_staticmethod:
+        case tp_classmethod: return true;
+        default: break;
+    }
+    py_newstrv(py_pushtmp(), sv);
+    bool ok = py_dict_setitem(ctx, py_peek(-1), val);
+    py_pop();
+    return ok;
+}
+
+static bool pkl__restore_global(py_Ref key, py_Ref val, void* ctx) {
+    if(!py_isstr(key)) return ValueError("invalid snapshot");
+    py_setdict(ctx, py_namev(py_tosv(key)), val);
+    return true;
+}
+
+bool py_snapshot_save(const char* path) {
+#if PK_ENABLE_OS
+    c11_vector modules;
+    c11_vector__ctor(&modules, sizeof(py_Ref));
+    pkl__collect_modules(&pk_current_vm->modules, &modules);
+    // [(path, {name: value}), ...]
+    py_StackRef state = py_pushtmp();
+    py_newlist(state);
+    bool ok = true;
+    c11__foreach(py_Ref, &modules, mod) {
+        py_ModuleInfo* mi = py_touserdata(*mod);
+        py_StackRef item = py_pushtmp();
+        py_Ref p = py_newtuple(item, 2);
+        py_newstrv(&p[0], c11_string__sv(mi->path));
+        py_newdict(&p[1]);
+        py_list_append(state, item);
+        py_pop();
+        ok = py_applydict(*mod, pkl__snapshot_global, &p[1]);
+        if(!ok) break;
+    }
+    c11_vector__dtor(&modules);
+    if(ok) ok = py_pickle_dumps(state);
+    py_pop();
+    if(!ok) return false;
+
+    int size;
+    unsigned char* data = py_tobytes(py_retval(), &size);
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) return OSError("[Errno %d] %s: '%s'", errno, strerror(errno), path);
+    size_t written_size = fwrite(data, 1, size, f);
+    fclose(f);
+    if(written_size != (size_t)size) return OSError("failed to write snapshot: '%s'", path);
+    return true;
+#else
+    return OSError("snapshots require PK_ENABLE_OS");
+#endif
+}
+
+bool py_snapshot_load(const char* path) {
+#if PK_ENABLE_OS
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) return OSError("[Errno %d] %s: '%s'", errno, strerror(errno), path);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* data = PK_MALLOC(size);
+    size = fread(data, 1, size, f);
+    fclose(f);
+    bool ok = py_pickle_loads(data, size);
+    PK_FREE(data);
+    if(!ok) return false;
+
+    py_StackRef state = py_pushtmp();
+    py_assign(state, py_retval());
+    if(!py_islist(state)) return ValueError("invalid snapshot: '%s'", path);
+    for(int i = 0; i < py_list_len(state); i++) {
+        py_Ref item = py_list_getitem(state, i);
+        if(!py_istuple(item) || py_tuple_len(item) != 2 ||
+           !py_isstr(py_tuple_getitem(item, 0)) || !py_isdict(py_tuple_getitem(item, 1))) {
+            return ValueError("invalid snapshot: '%s'", path);
+        }
+        const char* mod_path = py_tostr(py_tuple_getitem(item, 0));
+        py_GlobalRef mod = py_getmodule(mod_path);
+        if(mod == NULL) {
+            int res = py_import(mod_path);
+            if(res == -1) return false;
+            if(res == 0) return ImportError("No module named '%s'", mod_path);
+            mod = py_getmodule(mod_path);
+        }
+        if(!py_dict_apply(py_tuple_getitem(item, 1), pkl__restore_global, mod)) return false;
+    }
+    py_pop();
+    return true;
+#else
+    return OSError("snapshots require PK_ENABLE_OS");
+#endif
+}
+
 #undef UNALIGNED_READ
+#undef PKL_VERSION
+#undef PKL_OOB_MIN_SIZE
+#undef PKL_STRTAB_MAX_SIZE
+#undef PKL_BATCH_SIZE
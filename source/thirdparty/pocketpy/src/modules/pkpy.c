@@ -106,6 +106,22 @@ static bool pkpy_watchdog_end(int argc, py_Ref argv) {
 }
 #endif
 
+static bool pkpy_snapshot_save(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_str);
+    if(!py_snapshot_save(py_tostr(argv))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool pkpy_snapshot_load(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_str);
+    if(!py_snapshot_load(py_tostr(argv))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
 #if PK_ENABLE_THREADS
 
 typedef struct c11_ComputeThread c11_ComputeThread;
@@ -117,6 +133,8 @@ typedef struct {
     int args_size;
     unsigned char* kwargs_data;
     int kwargs_size;
+    // out-of-band `bytes` of the arguments, kept alive by the thread object
+    c11_vector /*T=c11_sv*/ buffers;
 } ComputeThreadJobCall;
 
 typedef struct {
@@ -130,6 +148,7 @@ static void ComputeThreadJobCall__dtor(void* arg) {
     PK_FREE(self->eval_src);
     PK_FREE(self->args_data);
     PK_FREE(self->kwargs_data);
+    c11_vector__dtor(&self->buffers);
 }
 
 static void ComputeThreadJobExec__dtor(void* arg) {
@@ -139,12 +158,13 @@ static void ComputeThreadJobExec__dtor(void* arg) {
 
 typedef struct c11_ComputeThread {
     int vm_index;
+    bool owns_vm;  // created by `py_newvm()`, deleted with this object
     atomic_bool is_done;
     unsigned char* last_retval_data;
     int last_retval_size;
+    c11_vector /*T=c11_sv*/ last_retval_buffers;  // owned copies
     char* last_error;
 
-    c11_thrd_t thread;
     void* job;
     void (*job_dtor)(void*);
 } c11_ComputeThread;
@@ -159,25 +179,86 @@ static void
     self->job_dtor = job_dtor;
 }
 
-static bool _pk_compute_thread_flags[16];
+static c11_vector /*T=bool*/ _pk_compute_thread_flags;  // guarded by `pk_all_vm_mutex`
+
+static bool _pk_compute_thread_flags__get(int index) {
+    c11_mutex__lock(&pk_all_vm_mutex);
+    c11_vector* flags = &_pk_compute_thread_flags;
+    bool value = index < flags->length && c11__getitem(bool, flags, index);
+    c11_mutex__unlock(&pk_all_vm_mutex);
+    return value;
+}
+
+/// Set the flag of `index` and return its old value.
+static bool _pk_compute_thread_flags__set(int index, bool value) {
+    c11_mutex__lock(&pk_all_vm_mutex);
+    c11_vector* flags = &_pk_compute_thread_flags;
+    if(flags->elem_size == 0) c11_vector__ctor(flags, sizeof(bool));
+    while(flags->length <= index) {
+        c11_vector__push(bool, flags, false);
+    }
+    bool old_value = c11__getitem(bool, flags, index);
+    c11__setitem(bool, flags, index, value);
+    c11_mutex__unlock(&pk_all_vm_mutex);
+    return old_value;
+}
+
+static void c11_ComputeThread__clear_retval(c11_ComputeThread* self) {
+    if(self->last_retval_data) {
+        PK_FREE(self->last_retval_data);
+        self->last_retval_data = NULL;
+        self->last_retval_size = 0;
+    }
+    c11__foreach(c11_sv, &self->last_retval_buffers, it) PK_FREE((void*)it->data);
+    c11_vector__clear(&self->last_retval_buffers);
+}
+
+/// Pickle the result of a job. Large `bytes` are passed out-of-band, so they are copied only once
+/// on the way to the other VM.
+static bool c11_ComputeThread__set_retval(c11_ComputeThread* self, py_Ref val) {
+    py_StackRef obj = py_pushtmp();
+    py_assign(obj, val);
+    py_StackRef buffers = py_pushtmp();
+    py_newlist(buffers);
+    if(!pk_pickle_dumps(obj, NULL, buffers)) return false;
+    int size;
+    unsigned char* data = py_tobytes(py_retval(), &size);
+    self->last_retval_data = c11_memdup(data, size);
+    self->last_retval_size = size;
+    for(int i = 0; i < py_list_len(buffers); i++) {
+        data = py_tobytes(py_list_getitem(buffers, i), &size);
+        c11_sv copy = {(const char*)c11_memdup(data, size), size};
+        c11_vector__push(c11_sv, &self->last_retval_buffers, copy);
+    }
+    py_shrink(2);
+    return true;
+}
+
+/// Create a tuple of `bytes` in the current VM from out-of-band buffers of another VM.
+static void ComputeThread__newbuffers(py_OutRef out, c11_vector* buffers) {
+    py_TValue* items = py_newtuple(out, buffers->length);
+    for(int i = 0; i < buffers->length; i++) {
+        c11_sv sv = c11__getitem(c11_sv, buffers, i);
+        memcpy(py_newbytes(&items[i], sv.size), sv.data, sv.size);
+    }
+}
 
 static void c11_ComputeThread__dtor(c11_ComputeThread* self) {
     if(!atomic_load(&self->is_done)) {
         c11__abort("ComputeThread(%d) is not done yet!! But the object was deleted.",
                    self->vm_index);
     }
-    if(self->last_retval_data) PK_FREE(self->last_retval_data);
+    c11_ComputeThread__clear_retval(self);
+    c11_vector__dtor(&self->last_retval_buffers);
     if(self->last_error) PK_FREE(self->last_error);
     c11_ComputeThread__reset_job(self, NULL, NULL);
-    _pk_compute_thread_flags[self->vm_index] = false;
+    if(self->vm_index == 0) return;  // `__init__` was not called
+    _pk_compute_thread_flags__set(self->vm_index, false);
+    if(self->owns_vm) py_delvm(self->vm_index);
 }
 
 static void c11_ComputeThread__on_job_begin(c11_ComputeThread* self) {
-    if(self->last_retval_data) {
-        PK_FREE(self->last_retval_data);
-        self->last_retval_data = NULL;
-        self->last_retval_size = 0;
-    }
+    c11_ComputeThread__clear_retval(self);
     if(self->last_error) {
         PK_FREE(self->last_error);
         self->last_error = NULL;
@@ -186,12 +267,18 @@ static void c11_ComputeThread__on_job_begin(c11_ComputeThread* self) {
 }
 
 static bool ComputeThread__new__(int argc, py_Ref argv) {
+    // slot 0: out-of-band arguments of the current job
+    // slot 1: `Future` of the current job
     c11_ComputeThread* self =
-        py_newobject(py_retval(), py_totype(argv), 0, sizeof(c11_ComputeThread));
+        py_newobject(py_retval(), py_totype(argv), 2, sizeof(c11_ComputeThread));
+    py_newnone(py_getslot(py_retval(), 0));
+    py_newnone(py_getslot(py_retval(), 1));
     self->vm_index = 0;
+    self->owns_vm = false;
     atomic_store(&self->is_done, true);
     self->last_retval_data = NULL;
     self->last_retval_size = 0;
+    c11_vector__ctor(&self->last_retval_buffers, sizeof(c11_sv));
     self->last_error = NULL;
     self->job = NULL;
     self->job_dtor = NULL;
@@ -199,19 +286,24 @@ static bool ComputeThread__new__(int argc, py_Ref argv) {
 }
 
 static bool ComputeThread__init__(int argc, py_Ref argv) {
-    PY_CHECK_ARGC(2);
-    PY_CHECK_ARG_TYPE(1, tp_int);
     c11_ComputeThread* self = py_touserdata(py_arg(0));
-    int index = py_toint(py_arg(1));
-    if(index >= 1 && index < 16) {
-        if(_pk_compute_thread_flags[index]) {
-            return ValueError("vm_index %d is already in use", index);
-        }
-        _pk_compute_thread_flags[index] = true;
-        self->vm_index = index;
+    int index;
+    if(py_isnone(py_arg(1))) {
+        index = py_newvm();
+        self->owns_vm = true;
     } else {
-        return ValueError("vm_index %d is out of range", index);
+        PY_CHECK_ARG_TYPE(1, tp_int);
+        index = py_toint(py_arg(1));
+        if(index < 1) return ValueError("vm_index %d is out of range", index);
+        // create it now so that `py_newvm()` does not pick the same index
+        int old_vm_index = py_currentvm();
+        py_switchvm(index);
+        py_switchvm(old_vm_index);
     }
+    if(_pk_compute_thread_flags__set(index, true)) {
+        return ValueError("vm_index %d is already in use", index);
+    }
+    self->vm_index = index;
     py_newnone(py_retval());
     return true;
 }
@@ -225,12 +317,14 @@ static bool ComputeThread_is_done(int argc, py_Ref argv) {
 }
 
 static bool ComputeThread_wait_for_done(int argc, py_Ref argv) {
-    PY_CHECK_ARGC(1);
     c11_ComputeThread* self = py_touserdata(argv);
-    while(!atomic_load(&self->is_done)) {
-        c11_thrd_yield();
+    double timeout = -1;
+    if(!py_isnone(py_arg(1))) {
+        if(!py_castfloat(py_arg(1), &timeout)) return false;
+        if(timeout < 0) return ValueError("timeout must be non-negative");
     }
-    py_newnone(py_retval());
+    bool value = c11_thrdpool__wait(&pk_compute_thread_pool, &self->is_done, timeout);
+    py_newbool(py_retval(), value);
     return true;
 }
 
@@ -251,63 +345,203 @@ static bool ComputeThread_last_retval(int argc, py_Ref argv) {
     c11_ComputeThread* self = py_touserdata(argv);
     if(!atomic_load(&self->is_done)) return OSError("thread is not done yet");
     if(self->last_retval_data == NULL) return ValueError("no retval available");
-    return py_pickle_loads(self->last_retval_data, self->last_retval_size);
+    py_StackRef buffers = py_pushtmp();
+    ComputeThread__newbuffers(buffers, &self->last_retval_buffers);
+    bool ok = pk_pickle_loads(self->last_retval_data, self->last_retval_size, buffers);
+    py_pop();
+    return ok;
 }
 
-static c11_thrd_retval_t ComputeThreadJob_call(void* arg) {
+static void ComputeThreadJob_call(void* arg) {
     ComputeThreadJobCall* job = arg;
     c11_ComputeThread* self = job->self;
     c11_ComputeThread__on_job_begin(self);
 
     py_StackRef p0 = py_peek(0);
 
+    // copy the out-of-band arguments straight into this VM
+    py_StackRef buffers = py_pushtmp();
+    ComputeThread__newbuffers(buffers, &job->buffers);
     if(!py_pusheval(job->eval_src, NULL)) goto __ERROR;
-    // [callable]
-    if(!py_pickle_loads(job->args_data, job->args_size)) goto __ERROR;
+    // [buffers, callable]
+    if(!pk_pickle_loads(job->args_data, job->args_size, buffers)) goto __ERROR;
     py_push(py_retval());
-    // [callable, args]
-    if(!py_pickle_loads(job->kwargs_data, job->kwargs_size)) goto __ERROR;
+    // [buffers, callable, args]
+    if(!pk_pickle_loads(job->kwargs_data, job->kwargs_size, buffers)) goto __ERROR;
     py_push(py_retval());
-    // [callable, args, kwargs]
+    // [buffers, callable, args, kwargs]
     if(!py_smarteval("_0(*_1, **_2)", NULL, py_peek(-3), py_peek(-2), py_peek(-1))) goto __ERROR;
 
-    py_shrink(3);
-    if(!py_pickle_dumps(py_retval())) goto __ERROR;
-    int retval_size;
-    unsigned char* retval_data = py_tobytes(py_retval(), &retval_size);
-    self->last_retval_data = c11_memdup(retval_data, retval_size);
-    self->last_retval_size = retval_size;
+    py_shrink(4);
+    if(!c11_ComputeThread__set_retval(self, py_retval())) goto __ERROR;
     atomic_store(&self->is_done, true);
-    return (c11_thrd_retval_t)0;
+    return;
 
 __ERROR:
     self->last_error = py_formatexc();
-    atomic_store(&self->is_done, true);
     py_clearexc(p0);
     py_newnone(py_retval());
-    return (c11_thrd_retval_t)0;
+    // the VM can run the next job from here
+    atomic_store(&self->is_done, true);
 }
 
-static c11_thrd_retval_t ComputeThreadJob_exec(void* arg) {
+static void ComputeThreadJob_exec(void* arg) {
     ComputeThreadJobExec* job = arg;
     c11_ComputeThread* self = job->self;
     c11_ComputeThread__on_job_begin(self);
 
     py_StackRef p0 = py_peek(0);
     if(!py_exec(job->source, "<job>", job->mode, NULL)) goto __ERROR;
-    if(!py_pickle_dumps(py_retval())) goto __ERROR;
-    int retval_size;
-    unsigned char* retval_data = py_tobytes(py_retval(), &retval_size);
-    self->last_retval_data = c11_memdup(retval_data, retval_size);
-    self->last_retval_size = retval_size;
+    if(!c11_ComputeThread__set_retval(self, py_retval())) goto __ERROR;
     atomic_store(&self->is_done, true);
-    return (c11_thrd_retval_t)0;
+    return;
 
 __ERROR:
     self->last_error = py_formatexc();
-    atomic_store(&self->is_done, true);
     py_clearexc(p0);
-    return (c11_thrd_retval_t)0;
+    atomic_store(&self->is_done, true);
+}
+
+/*************** Future ***************/
+
+typedef struct {
+    bool is_settled;  // the result was taken from the thread
+    bool is_pending;  // has callbacks waiting for `py_poll_completions()`
+    char* error;        // owned, NULL if the job succeeded
+} pk_Future;
+
+static void pk_Future__dtor(pk_Future* self) {
+    if(self->error) PK_FREE(self->error);
+}
+
+static py_Type pk_Future__type() {
+    return py_totype(py_getdict(py_getmodule("pkpy"), py_name("Future")));
+}
+
+/// Futures with callbacks to run when their jobs finish, a list in the `pkpy` module.
+static py_Ref pk_Future__pending() {
+    py_GlobalRef mod = py_getmodule("pkpy");
+    return py_getdict(mod, py_name("_pending_futures"));
+}
+
+/// Take the result of a finished job from its thread. Return false if it is still running.
+static bool pk_Future__settle(py_Ref self) {
+    pk_Future* ud = py_touserdata(self);
+    if(ud->is_settled) return true;
+    py_Ref thread = py_getslot(self, 0);
+    c11_ComputeThread* ct = py_touserdata(thread);
+    if(!atomic_load(&ct->is_done)) return false;
+    ud->is_settled = true;
+    if(ct->last_error) {
+        ud->error = c11_strdup(ct->last_error);
+        return true;
+    }
+    py_StackRef p0 = py_peek(0);
+    py_StackRef buffers = py_pushtmp();
+    ComputeThread__newbuffers(buffers, &ct->last_retval_buffers);
+    if(pk_pickle_loads(ct->last_retval_data, ct->last_retval_size, buffers)) {
+        py_setslot(self, 1, py_retval());
+    } else {
+        ud->error = py_formatexc();
+        py_clearexc(p0);
+    }
+    py_pop();
+    return true;
+}
+
+static bool Future_done(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_newbool(py_retval(), pk_Future__settle(argv));
+    return true;
+}
+
+static bool Future_result(int argc, py_Ref argv) {
+    py_Ref self = py_arg(0);
+    if(!pk_Future__settle(self)) {
+        double timeout = -1;
+        if(!py_isnone(py_arg(1))) {
+            if(!py_castfloat(py_arg(1), &timeout)) return false;
+            if(timeout < 0) return ValueError("timeout must be non-negative");
+        }
+        c11_ComputeThread* ct = py_touserdata(py_getslot(self, 0));
+        if(!c11_thrdpool__wait(&pk_compute_thread_pool, &ct->is_done, timeout)) {
+            return TimeoutError("the job is not done after %f seconds", timeout);
+        }
+        pk_Future__settle(self);
+    }
+    pk_Future* ud = py_touserdata(self);
+    if(ud->error) return RuntimeError("the job failed:\n%s", ud->error);
+    py_assign(py_retval(), py_getslot(self, 1));
+    return true;
+}
+
+static bool Future_add_done_callback(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    pk_Future* ud = py_touserdata(argv);
+    if(pk_Future__settle(argv) && !ud->is_pending) return py_call(py_arg(1), 1, argv);
+    py_list_append(py_getslot(argv, 2), py_arg(1));
+    if(!ud->is_pending) {
+        ud->is_pending = true;
+        py_list_append(pk_Future__pending(), argv);
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+bool py_poll_completions() {
+    py_Ref pending = pk_Future__pending();
+    int i = 0;
+    while(i < py_list_len(pending)) {
+        if(!pk_Future__settle(py_list_getitem(pending, i))) {
+            i++;
+            continue;
+        }
+        // callbacks can submit more jobs, which are appended to `pending`
+        py_StackRef future = py_pushtmp();
+        py_assign(future, py_list_getitem(pending, i));
+        py_list_delitem(pending, i);
+        ((pk_Future*)py_touserdata(future))->is_pending = false;
+        py_StackRef callbacks = py_pushtmp();
+        py_assign(callbacks, py_getslot(future, 2));
+        py_newlist(py_getslot(future, 2));
+        for(int j = 0; j < py_list_len(callbacks); j++) {
+            if(!py_call(py_list_getitem(callbacks, j), 1, future)) {
+                py_shrink(2);
+                return false;
+            }
+        }
+        py_shrink(2);
+    }
+    return true;
+}
+
+static bool pkpy_poll_completions(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(0);
+    if(!py_poll_completions()) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool c11_ComputeThread__submit(py_Ref thread, void (*func)(void*), void* job) {
+    c11_ComputeThread* self = py_touserdata(thread);
+    // the result of the previous job is overwritten by this one
+    py_Ref prev = py_getslot(thread, 1);
+    if(!py_isnone(prev)) pk_Future__settle(prev);
+    atomic_store(&self->is_done, false);
+    if(!c11_thrdpool__submit(&pk_compute_thread_pool, func, job)) {
+        atomic_store(&self->is_done, true);
+        return OSError("thrd_create() failed");
+    }
+    // slot 0: thread, slot 1: result, slot 2: callbacks
+    pk_Future* ud = py_newobject(py_retval(), pk_Future__type(), 3, sizeof(pk_Future));
+    ud->is_settled = false;
+    ud->is_pending = false;
+    ud->error = NULL;
+    py_setslot(py_retval(), 0, thread);
+    py_newnone(py_getslot(py_retval(), 1));
+    py_newlist(py_getslot(py_retval(), 2));
+    py_setslot(thread, 1, py_retval());
+    return true;
 }
 
 static bool ComputeThread_submit_exec(int argc, py_Ref argv) {
@@ -323,14 +557,7 @@ static bool ComputeThread_submit_exec(int argc, py_Ref argv) {
     job->mode = EXEC_MODE;
     c11_ComputeThread__reset_job(self, job, ComputeThreadJobExec__dtor);
     /**************************/
-    atomic_store(&self->is_done, false);
-    bool ok = c11_thrd_create(&self->thread, ComputeThreadJob_exec, job);
-    if(!ok) {
-        atomic_store(&self->is_done, true);
-        return OSError("thrd_create() failed");
-    }
-    py_newnone(py_retval());
-    return true;
+    return c11_ComputeThread__submit(py_arg(0), ComputeThreadJob_exec, job);
 }
 
 static bool ComputeThread_submit_eval(int argc, py_Ref argv) {
@@ -346,14 +573,7 @@ static bool ComputeThread_submit_eval(int argc, py_Ref argv) {
     job->mode = EVAL_MODE;
     c11_ComputeThread__reset_job(self, job, ComputeThreadJobExec__dtor);
     /**************************/
-    atomic_store(&self->is_done, false);
-    bool ok = c11_thrd_create(&self->thread, ComputeThreadJob_exec, job);
-    if(!ok) {
-        atomic_store(&self->is_done, true);
-        return OSError("thrd_create() failed");
-    }
-    py_newnone(py_retval());
-    return true;
+    return c11_ComputeThread__submit(py_arg(0), ComputeThreadJob_exec, job);
 }
 
 static bool ComputeThread_submit_call(int argc, py_Ref argv) {
@@ -365,32 +585,38 @@ static bool ComputeThread_submit_call(int argc, py_Ref argv) {
     PY_CHECK_ARG_TYPE(3, tp_dict);
     // eval_src
     const char* eval_src = py_tostr(py_arg(1));
+    // large `bytes` are read by the worker in place, until the next job is submitted
+    py_Ref buffers = py_getslot(py_arg(0), 0);
+    py_newlist(buffers);
     // *args
-    if(!py_pickle_dumps(py_arg(2))) return false;
+    if(!pk_pickle_dumps(py_arg(2), NULL, buffers)) return false;
     int args_size;
     unsigned char* args_data = py_tobytes(py_retval(), &args_size);
+    args_data = c11_memdup(args_data, args_size);
     // *kwargs
-    if(!py_pickle_dumps(py_arg(3))) return false;
+    if(!pk_pickle_dumps(py_arg(3), NULL, buffers)) {
+        PK_FREE(args_data);
+        return false;
+    }
     int kwargs_size;
     unsigned char* kwargs_data = py_tobytes(py_retval(), &kwargs_size);
     /**************************/
     ComputeThreadJobCall* job = PK_MALLOC(sizeof(ComputeThreadJobCall));
     job->self = self;
     job->eval_src = c11_strdup(eval_src);
-    job->args_data = c11_memdup(args_data, args_size);
+    job->args_data = args_data;
     job->args_size = args_size;
     job->kwargs_data = c11_memdup(kwargs_data, kwargs_size);
     job->kwargs_size = kwargs_size;
+    c11_vector__ctor(&job->buffers, sizeof(c11_sv));
+    for(int i = 0; i < py_list_len(buffers); i++) {
+        int size;
+        unsigned char* data = py_tobytes(py_list_getitem(buffers, i), &size);
+        c11_vector__push(c11_sv, &job->buffers, ((c11_sv){(const char*)data, size}));
+    }
     c11_ComputeThread__reset_job(self, job, ComputeThreadJobCall__dtor);
     /**************************/
-    atomic_store(&self->is_done, false);
-    bool ok = c11_thrd_create(&self->thread, ComputeThreadJob_call, job);
-    if(!ok) {
-        atomic_store(&self->is_done, true);
-        return OSError("thrd_create() failed");
-    }
-    py_newnone(py_retval());
-    return true;
+    return c11_ComputeThread__submit(py_arg(0), ComputeThreadJob_call, job);
 }
 
 static bool c11_ComputeThread__exec_blocked(c11_ComputeThread* self,
@@ -439,12 +665,19 @@ static bool ComputeThread_eval(int argc, py_Ref argv) {
 }
 
 static void pk_ComputeThread__register(py_Ref mod) {
+    py_Type future = py_newtype("Future", tp_object, mod, (py_Dtor)pk_Future__dtor);
+    py_bindmethod(future, "done", Future_done);
+    py_bind(py_tpobject(future), "result(self, timeout=None)", Future_result);
+    py_bindmethod(future, "add_done_callback", Future_add_done_callback);
+    py_newlist(py_emplacedict(mod, py_name("_pending_futures")));
+    py_bindfunc(mod, "poll_completions", pkpy_poll_completions);
+
     py_Type type = py_newtype("ComputeThread", tp_object, mod, (py_Dtor)c11_ComputeThread__dtor);
 
     py_bindmagic(type, __new__, ComputeThread__new__);
-    py_bindmagic(type, __init__, ComputeThread__init__);
+    py_bind(py_tpobject(type), "__init__(self, vm_index=None)", ComputeThread__init__);
     py_bindproperty(type, "is_done", ComputeThread_is_done, NULL);
-    py_bindmethod(type, "wait_for_done", ComputeThread_wait_for_done);
+    py_bind(py_tpobject(type), "wait_for_done(self, timeout=None)", ComputeThread_wait_for_done);
     py_bindmethod(type, "last_error", ComputeThread_last_error);
     py_bindmethod(type, "last_retval", ComputeThread_last_retval);
 
@@ -458,8 +691,373 @@ static void pk_ComputeThread__register(py_Ref mod) {
     py_bindmethod(type, "eval", ComputeThread_eval);
 }
 
+/*************** Channel ***************/
+
+// A bounded lock-free queue (Vyukov). Each slot has a sequence number telling whether it is
+// free for the writer at `head` or filled for the reader at `tail`, so any number of producers
+// and consumers only contend on one CAS. Blocking is the slow path, with a mutex and condvars.
+
+typedef struct {
+    atomic_size_t seq;
+    unsigned char* data;  // owned
+    int size;
+    bool is_pickled;
+} pk_ChannelSlot;
+
+struct py_Channel {
+    int rc;  // guarded by `pk_all_vm_mutex`
+    char* name;
+    int capacity;  // power of two
+    pk_ChannelSlot* slots;
+    atomic_size_t head;
+    atomic_size_t tail;
+
+    c11_mutex_t mutex;
+    c11_cond_t not_empty;
+    c11_cond_t not_full;
+    atomic_int n_waiting_recv;
+    atomic_int n_waiting_send;
+};
+
+static c11_vector /*T=py_Channel* */ _pk_channels;  // guarded by `pk_all_vm_mutex`
+
+static bool py_Channel__try_push(py_Channel* self, pk_ChannelSlot* msg) {
+    size_t pos = atomic_load_explicit(&self->head, memory_order_relaxed);
+    pk_ChannelSlot* slot;
+    while(true) {
+        slot = &self->slots[pos & (self->capacity - 1)];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if(diff == 0) {
+            if(atomic_compare_exchange_weak_explicit(&self->head,
+                                                     &pos,
+                                                     pos + 1,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed)) {
+                break;
+            }
+        } else if(diff < 0) {
+            return false;  // full
+        } else {
+            pos = atomic_load_explicit(&self->head, memory_order_relaxed);
+        }
+    }
+    slot->data = msg->data;
+    slot->size = msg->size;
+    slot->is_pickled = msg->is_pickled;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool py_Channel__try_pop(py_Channel* self, pk_ChannelSlot* msg) {
+    size_t pos = atomic_load_explicit(&self->tail, memory_order_relaxed);
+    pk_ChannelSlot* slot;
+    while(true) {
+        slot = &self->slots[pos & (self->capacity - 1)];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if(diff == 0) {
+            if(atomic_compare_exchange_weak_explicit(&self->tail,
+                                                     &pos,
+                                                     pos + 1,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed)) {
+                break;
+            }
+        } else if(diff < 0) {
+            return false;  // empty
+        } else {
+            pos = atomic_load_explicit(&self->tail, memory_order_relaxed);
+        }
+    }
+    msg->data = slot->data;
+    msg->size = slot->size;
+    msg->is_pickled = slot->is_pickled;
+    atomic_store_explicit(&slot->seq, pos + self->capacity, memory_order_release);
+    return true;
+}
+
+/// Wake the threads blocked on `cond`, if any.
+static void py_Channel__notify(py_Channel* self, atomic_int* n_waiting, c11_cond_t* cond) {
+    // pairs with the fence in `py_Channel__transfer()`, a waiter either sees the change or is
+    // counted here
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load(n_waiting) == 0) return;
+    c11_mutex__lock(&self->mutex);
+    c11_cond__broadcast(cond);
+    c11_mutex__unlock(&self->mutex);
+}
+
+/// Push or pop `msg`, blocking at most `timeout` seconds if it is not negative.
+static bool py_Channel__transfer(py_Channel* self, pk_ChannelSlot* msg, bool is_push, double timeout) {
+    bool (*op)(py_Channel*, pk_ChannelSlot*) = is_push ? py_Channel__try_push : py_Channel__try_pop;
+    atomic_int* n_waiting = is_push ? &self->n_waiting_send : &self->n_waiting_recv;
+    c11_cond_t* cond = is_push ? &self->not_full : &self->not_empty;
+    bool ok = op(self, msg);
+    if(!ok && timeout != 0) {
+        struct timespec deadline;
+        if(timeout > 0) c11_deadline(&deadline, timeout);
+        c11_mutex__lock(&self->mutex);
+        atomic_fetch_add(n_waiting, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        while(!(ok = op(self, msg))) {
+            if(timeout < 0) {
+                c11_cond__wait(cond, &self->mutex);
+            } else if(!c11_cond__timedwait(cond, &self->mutex, &deadline)) {
+                ok = op(self, msg);
+                break;
+            }
+        }
+        atomic_fetch_sub(n_waiting, 1);
+        c11_mutex__unlock(&self->mutex);
+    }
+    if(!ok) return false;
+    if(is_push) {
+        py_Channel__notify(self, &self->n_waiting_recv, &self->not_empty);
+    } else {
+        py_Channel__notify(self, &self->n_waiting_send, &self->not_full);
+    }
+    return true;
+}
+
+/// Round `capacity` up to a power of two. A ring of one slot could not tell full from empty.
+static int py_Channel__roundup(int capacity) {
+    int res = 2;
+    while(res < capacity) {
+        res *= 2;
+    }
+    return res;
+}
+
+py_Channel* py_channel_open(const char* name, int capacity) {
+    c11_mutex__lock(&pk_all_vm_mutex);
+    if(_pk_channels.elem_size == 0) c11_vector__ctor(&_pk_channels, sizeof(py_Channel*));
+    c11__foreach(py_Channel*, &_pk_channels, it) {
+        if(strcmp((*it)->name, name) == 0) {
+            (*it)->rc++;
+            c11_mutex__unlock(&pk_all_vm_mutex);
+            return *it;
+        }
+    }
+    py_Channel* self = PK_MALLOC(sizeof(py_Channel));
+    self->rc = 1;
+    self->name = c11_strdup(name);
+    self->capacity = py_Channel__roundup(capacity);
+    self->slots = PK_MALLOC(sizeof(pk_ChannelSlot) * self->capacity);
+    for(int i = 0; i < self->capacity; i++) {
+        atomic_init(&self->slots[i].seq, i);
+    }
+    atomic_init(&self->head, 0);
+    atomic_init(&self->tail, 0);
+    c11_mutex__ctor(&self->mutex);
+    c11_cond__ctor(&self->not_empty);
+    c11_cond__ctor(&self->not_full);
+    atomic_init(&self->n_waiting_recv, 0);
+    atomic_init(&self->n_waiting_send, 0);
+    c11_vector__push(py_Channel*, &_pk_channels, self);
+    c11_mutex__unlock(&pk_all_vm_mutex);
+    return self;
+}
+
+void py_channel_close(py_Channel* self) {
+    c11_mutex__lock(&pk_all_vm_mutex);
+    bool is_last = --self->rc == 0;
+    if(is_last) {
+        for(int i = 0; i < _pk_channels.length; i++) {
+            if(c11__getitem(py_Channel*, &_pk_channels, i) == self) {
+                c11_vector__erase(py_Channel*, &_pk_channels, i);
+                break;
+            }
+        }
+    }
+    c11_mutex__unlock(&pk_all_vm_mutex);
+    if(!is_last) return;
+    pk_ChannelSlot msg;
+    while(py_Channel__try_pop(self, &msg)) {
+        PK_FREE(msg.data);
+    }
+    c11_cond__dtor(&self->not_full);
+    c11_cond__dtor(&self->not_empty);
+    c11_mutex__dtor(&self->mutex);
+    PK_FREE(self->slots);
+    PK_FREE(self->name);
+    PK_FREE(self);
+}
+
+bool py_channel_send(py_Channel* self, const void* data, int size, double timeout) {
+    pk_ChannelSlot msg = {.data = c11_memdup(data, size), .size = size, .is_pickled = false};
+    if(py_Channel__transfer(self, &msg, true, timeout)) return true;
+    PK_FREE(msg.data);
+    return false;
+}
+
+bool py_channel_recv(py_Channel* self, void** data, int* size, bool* is_pickled, double timeout) {
+    pk_ChannelSlot msg;
+    if(!py_Channel__transfer(self, &msg, false, timeout)) return false;
+    *data = msg.data;
+    *size = msg.size;
+    *is_pickled = msg.is_pickled;
+    return true;
+}
+
+static bool Channel__new__(int argc, py_Ref argv) {
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    py_i64 capacity = 64;
+    if(!py_isnone(py_arg(2))) {
+        PY_CHECK_ARG_TYPE(2, tp_int);
+        capacity = py_toint(py_arg(2));
+        if(capacity < 1 || capacity > (1 << 20)) return ValueError("capacity out of range");
+    }
+    py_Channel* ch = py_channel_open(py_tostr(py_arg(1)), (int)capacity);
+    if(!py_isnone(py_arg(2)) && ch->capacity != py_Channel__roundup((int)capacity)) {
+        int existing = ch->capacity;
+        py_channel_close(ch);
+        return ValueError("channel '%s' already exists with capacity %d",
+                          py_tostr(py_arg(1)),
+                          existing);
+    }
+    py_Channel** ud = py_newobject(py_retval(), py_totype(argv), 0, sizeof(py_Channel*));
+    *ud = ch;
+    return true;
+}
+
+static void Channel__dtor(py_Channel** self) { py_channel_close(*self); }
+
+static bool Channel__timeout(py_Ref arg, double* out) {
+    *out = -1;
+    if(py_isnone(arg)) return true;
+    if(!py_castfloat(arg, out)) return false;
+    if(*out < 0) return ValueError("timeout must be non-negative");
+    return true;
+}
+
+static bool Channel_send(int argc, py_Ref argv) {
+    py_Channel* self = *(py_Channel**)py_touserdata(argv);
+    double timeout;
+    if(!Channel__timeout(py_arg(2), &timeout)) return false;
+    if(!py_pickle_dumps(py_arg(1))) return false;
+    int size;
+    unsigned char* data = py_tobytes(py_retval(), &size);
+    pk_ChannelSlot msg = {.data = c11_memdup(data, size), .size = size, .is_pickled = true};
+    if(!py_Channel__transfer(self, &msg, true, timeout)) {
+        PK_FREE(msg.data);
+        return TimeoutError("channel '%s' is full", self->name);
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool Channel_send_bytes(int argc, py_Ref argv) {
+    py_Channel* self = *(py_Channel**)py_touserdata(argv);
+    double timeout;
+    if(!Channel__timeout(py_arg(2), &timeout)) return false;
+    py_Buffer buf;
+    if(!py_getbuffer(py_arg(1), &buf, false)) return false;
+    bool ok = py_channel_send(self, buf.data, buf.size, timeout);
+    py_releasebuffer(&buf);
+    if(!ok) return TimeoutError("channel '%s' is full", self->name);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool Channel_recv(int argc, py_Ref argv) {
+    py_Channel* self = *(py_Channel**)py_touserdata(argv);
+    double timeout;
+    if(!Channel__timeout(py_arg(1), &timeout)) return false;
+    pk_ChannelSlot msg;
+    if(!py_Channel__transfer(self, &msg, false, timeout)) {
+        return TimeoutError("channel '%s' is empty", self->name);
+    }
+    bool ok = true;
+    if(msg.is_pickled) {
+        ok = py_pickle_loads(msg.data, msg.size);
+    } else {
+        memcpy(py_newbytes(py_retval(), msg.size), msg.data, msg.size);
+    }
+    PK_FREE(msg.data);
+    return ok;
+}
+
+static bool Channel__len__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Channel* self = *(py_Channel**)py_touserdata(argv);
+    size_t head = atomic_load(&self->head);
+    size_t tail = atomic_load(&self->tail);
+    // both move while other threads use the channel
+    py_newint(py_retval(), head > tail ? (py_i64)(head - tail) : 0);
+    return true;
+}
+
+static bool Channel_name(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Channel* self = *(py_Channel**)py_touserdata(argv);
+    py_newstr(py_retval(), self->name);
+    return true;
+}
+
+static bool Channel_capacity(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Channel* self = *(py_Channel**)py_touserdata(argv);
+    py_newint(py_retval(), self->capacity);
+    return true;
+}
+
+static bool Channel__reduce__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Channel* self = *(py_Channel**)py_touserdata(argv);
+    // channels are found by name, in any VM
+    py_Ref p = py_newtuple(py_pushtmp(), 2);
+    p[0] = *py_tpobject(argv->type);
+    py_Ref args = py_newtuple(&p[1], 2);
+    py_newstr(&args[0], self->name);
+    py_newint(&args[1], self->capacity);
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+static void pk_Channel__register(py_Ref mod) {
+    py_Type type = py_newtype("Channel", tp_object, mod, (py_Dtor)Channel__dtor);
+    py_bind(py_tpobject(type), "__new__(cls, name, capacity=None)", Channel__new__);
+    py_bindmagic(type, __len__, Channel__len__);
+    py_bindmagic(type, __reduce__, Channel__reduce__);
+    py_bindproperty(type, "name", Channel_name, NULL);
+    py_bindproperty(type, "capacity", Channel_capacity, NULL);
+    py_bind(py_tpobject(type), "send(self, obj, timeout=None)", Channel_send);
+    py_bind(py_tpobject(type), "send_bytes(self, data, timeout=None)", Channel_send_bytes);
+    py_bind(py_tpobject(type), "recv(self, timeout=None)", Channel_recv);
+}
+
+#else
+
+bool py_poll_completions() { return true; }
+
 #endif  // PK_ENABLE_THREADS
 
+static bool pkpy_clonevm(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_int);
+    int index = py_toint(argv);
+    int old_vm_index = py_currentvm();
+    if(index < 1 || index == old_vm_index) return ValueError("vm_index %d is out of range", index);
+#if PK_ENABLE_THREADS
+    if(_pk_compute_thread_flags__get(index)) {
+        return ValueError("vm_index %d is already in use", index);
+    }
+#endif
+    bool ok = py_clonevm(old_vm_index, index);
+    char* err = ok ? NULL : py_formatexc();
+    if(!ok) py_clearexc(NULL);
+    py_switchvm(old_vm_index);
+    if(!ok) {
+        RuntimeError("clonevm() failed:\n%s", err);
+        PK_FREE(err);
+        return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
 static void pkpy_configmacros_add(py_Ref dict, const char* key, int val) {
     assert(dict->type == tp_dict);
     py_TValue tmp;
@@ -542,6 +1140,9 @@ void pk__add_module_pkpy() {
     py_bindfunc(mod, "enable_full_buffering_mode", pkpy_enable_full_buffering_mode);
 
     py_bindfunc(mod, "currentvm", pkpy_currentvm);
+    py_bindfunc(mod, "snapshot_save", pkpy_snapshot_save);
+    py_bindfunc(mod, "snapshot_load", pkpy_snapshot_load);
+    py_bindfunc(mod, "clonevm", pkpy_clonevm);
 
 #if PK_ENABLE_WATCHDOG
     py_bindfunc(mod, "watchdog_begin", pkpy_watchdog_begin);
@@ -550,6 +1151,7 @@ void pk__add_module_pkpy() {
 
 #if PK_ENABLE_THREADS
     pk_ComputeThread__register(mod);
+    pk_Channel__register(mod);
 #endif
 
     py_bindfunc(mod, "profiler_begin", pkpy_profiler_begin);
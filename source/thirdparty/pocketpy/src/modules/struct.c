@@ -0,0 +1,600 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/sstream.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* A format is compiled once into a list of `struct_Item`s with precomputed offsets. Module-level
+ * functions look the compiled `Struct` up in a small cache keyed by the format string. Values are
+ * packed and unpacked byte by byte in the requested order, so no host byte swapping is needed.
+ * Ints are 64-bit signed, so unpacking a 'Q' or 'N' value of 2**63 or more raises `struct.error`.
+ */
+
+typedef struct {
+    char code;
+    int count;   // repeat count, or the length of 's' and 'p'
+    int offset;  // of the first item
+    int size;    // of a single item
+} struct_Item;
+
+typedef struct {
+    c11_vector items;  // struct_Item
+    int size;
+    int nvalues;
+    bool little;
+} c11_struct;
+
+typedef struct {
+    int offset;
+} c11_struct_unpack_iterator;
+
+#define Struct__CACHE_SIZE 100
+
+#define StructError(...) py_exception(Struct__error(), __VA_ARGS__)
+
+static py_Type Struct__error() {
+    return py_totype(py_getdict(py_getmodule("struct"), py_name("error")));
+}
+
+PK_INLINE static bool Struct__host_little() {
+    const uint16_t x = 1;
+    return *(const uint8_t*)&x == 1;
+}
+
+/// Return the size of `code` or 0 if it is invalid. `align` is only meaningful in native mode.
+static int Struct__itemsize(char code, bool native, int* align) {
+#define CASE(c, T, std)                                                                            \
+    case c:                                                                                        \
+        *align = native ? (int)_Alignof(T) : 1;                                                    \
+        return native ? (int)sizeof(T) : std;
+
+    switch(code) {
+        CASE('x', char, 1)
+        CASE('c', char, 1)
+        CASE('b', signed char, 1)
+        CASE('B', unsigned char, 1)
+        CASE('?', bool, 1)
+        CASE('s', char, 1)
+        CASE('p', char, 1)
+        CASE('h', short, 2)
+        CASE('H', unsigned short, 2)
+        CASE('i', int, 4)
+        CASE('I', unsigned int, 4)
+        CASE('l', long, 4)
+        CASE('L', unsigned long, 4)
+        CASE('q', long long, 8)
+        CASE('Q', unsigned long long, 8)
+        CASE('f', float, 4)
+        CASE('d', double, 8)
+        case 'n':
+        case 'N':
+            if(!native) return 0;
+            *align = (int)_Alignof(size_t);
+            return (int)sizeof(size_t);
+        default: return 0;
+    }
+#undef CASE
+}
+
+static void c11_struct__dtor(void* ud) {
+    c11_struct* self = ud;
+    c11_vector__dtor(&self->items);
+}
+
+static bool c11_struct__ctor(c11_struct* self, c11_sv format) {
+    c11_vector__ctor(&self->items, sizeof(struct_Item));
+    self->size = 0;
+    self->nvalues = 0;
+    self->little = Struct__host_little();
+    bool native = true;
+    int i = 0;
+    if(format.size > 0) {
+        switch(format.data[0]) {
+            case '@': i++; break;
+            case '=': i++, native = false; break;
+            case '<': i++, native = false, self->little = true; break;
+            case '>':
+            case '!': i++, native = false, self->little = false; break;
+        }
+    }
+    int64_t offset = 0;
+    while(i < format.size) {
+        char c = format.data[i];
+        if(c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            i++;
+            continue;
+        }
+        int64_t count = 1;
+        if(c >= '0' && c <= '9') {
+            count = 0;
+            while(i < format.size && format.data[i] >= '0' && format.data[i] <= '9') {
+                count = count * 10 + (format.data[i++] - '0');
+                if(count > INT32_MAX) return StructError("total struct size too long");
+            }
+            if(i == format.size) {
+                return StructError("repeat count given without format specifier");
+            }
+            c = format.data[i];
+        }
+        i++;
+        int align;
+        int size = Struct__itemsize(c, native, &align);
+        if(size == 0) return StructError("bad char in struct format");
+        if(native) offset = (offset + align - 1) / align * align;
+        struct_Item item = {c, (int)count, (int)offset, size};
+        if(c == 's' || c == 'p') {
+            item.size = (int)count;
+            offset += count;
+            self->nvalues++;
+            c11_vector__push(struct_Item, &self->items, item);
+        } else {
+            offset += count * size;
+            if(c != 'x' && count > 0) {
+                self->nvalues += (int)count;
+                c11_vector__push(struct_Item, &self->items, item);
+            }
+        }
+        if(offset > INT32_MAX) return StructError("total struct size too long");
+    }
+    self->size = (int)offset;
+    return true;
+}
+
+PK_INLINE static void Struct__write_uint(char* p, uint64_t v, int size, bool little) {
+    for(int i = 0; i < size; i++) {
+        p[little ? i : size - 1 - i] = (char)(v & 0xff);
+        v >>= 8;
+    }
+}
+
+PK_INLINE static uint64_t Struct__read_uint(const char* p, int size, bool little) {
+    uint64_t v = 0;
+    for(int i = 0; i < size; i++) {
+        v = (v << 8) | (uint8_t)p[little ? size - 1 - i : i];
+    }
+    return v;
+}
+
+static bool Struct__pack_value(char code, int size, bool little, char* p, py_Ref val) {
+    switch(code) {
+        case 'c': {
+            int n = 0;
+            const unsigned char* data = py_istype(val, tp_bytes) ? py_tobytes(val, &n) : NULL;
+            if(n != 1) return StructError("char format requires a bytes object of length 1");
+            *p = (char)data[0];
+            return true;
+        }
+        case '?': {
+            int res = py_bool(val);
+            if(res == -1) return false;
+            *p = (char)res;
+            return true;
+        }
+        case 'f': {
+            py_f64 f;
+            if(!py_isint(val) && !py_isfloat(val)) {
+                return StructError("required argument is not a float");
+            }
+            py_castfloat(val, &f);
+            float x = (float)f;
+            uint32_t bits;
+            memcpy(&bits, &x, 4);
+            Struct__write_uint(p, bits, 4, little);
+            return true;
+        }
+        case 'd': {
+            py_f64 f;
+            if(!py_isint(val) && !py_isfloat(val)) {
+                return StructError("required argument is not a float");
+            }
+            py_castfloat(val, &f);
+            uint64_t bits;
+            memcpy(&bits, &f, 8);
+            Struct__write_uint(p, bits, 8, little);
+            return true;
+        }
+    }
+    if(!py_isint(val)) return StructError("required argument is not an integer");
+    py_i64 v = py_toint(val);
+    bool is_signed = code == 'b' || code == 'h' || code == 'i' || code == 'l' || code == 'q' ||
+                     code == 'n';
+    if(size < 8) {
+        int bits = size * 8;
+        py_i64 lo = is_signed ? -((py_i64)1 << (bits - 1)) : 0;
+        py_i64 hi = is_signed ? ((py_i64)1 << (bits - 1)) - 1 : ((py_i64)1 << bits) - 1;
+        if(v < lo || v > hi) {
+            return StructError("'%c' format requires %i <= number <= %i", code, lo, hi);
+        }
+    } else if(!is_signed && v < 0) {
+        return StructError("'%c' format requires 0 <= number", code);
+    }
+    Struct__write_uint(p, (uint64_t)v, size, little);
+    return true;
+}
+
+static bool Struct__unpack_value(char code, int size, bool little, const char* p, py_OutRef out) {
+    switch(code) {
+        case 'c': py_newbytes(out, 1)[0] = (unsigned char)*p; return true;
+        case '?': py_newbool(out, *p != 0); return true;
+        case 'f': {
+            uint32_t bits = (uint32_t)Struct__read_uint(p, 4, little);
+            float x;
+            memcpy(&x, &bits, 4);
+            py_newfloat(out, x);
+            return true;
+        }
+        case 'd': {
+            uint64_t bits = Struct__read_uint(p, 8, little);
+            py_f64 x;
+            memcpy(&x, &bits, 8);
+            py_newfloat(out, x);
+            return true;
+        }
+        case 'b':
+        case 'h':
+        case 'i':
+        case 'l':
+        case 'q':
+        case 'n': {
+            uint64_t v = Struct__read_uint(p, size, little);
+            int shift = 64 - size * 8;
+            // sign-extend from `size` bytes
+            py_newint(out, (py_i64)(v << shift) >> shift);
+            return true;
+        }
+        default: {
+            uint64_t v = Struct__read_uint(p, size, little);
+            // ints are 64-bit signed, so the top half of 'Q' and 'N' cannot be represented
+            if(v > INT64_MAX) {
+                return StructError("'%c' value does not fit in a signed 64-bit int", code);
+            }
+            py_newint(out, (py_i64)v);
+            return true;
+        }
+    }
+}
+
+/// Pack `argc` values from `argv` into `dst`, which holds at least `self->size` bytes.
+static bool c11_struct__pack(c11_struct* self, char* dst, int argc, py_Ref argv) {
+    if(argc != self->nvalues) {
+        return StructError("pack expected %d items for packing (got %d)", self->nvalues, argc);
+    }
+    memset(dst, 0, self->size);
+    py_Ref val = argv;
+    c11__foreach(struct_Item, &self->items, item) {
+        char* p = dst + item->offset;
+        if(item->code == 's' || item->code == 'p') {
+            if(!py_istype(val, tp_bytes)) {
+                return StructError("argument for '%c' must be a bytes object", item->code);
+            }
+            int n;
+            const unsigned char* data = py_tobytes(val, &n);
+            if(item->code == 's') {
+                memcpy(p, data, c11__min(n, item->count));
+            } else if(item->count > 0) {
+                n = c11__min(c11__min(n, item->count - 1), 255);
+                *p = (char)n;
+                memcpy(p + 1, data, n);
+            }
+            val++;
+            continue;
+        }
+        for(int i = 0; i < item->count; i++) {
+            if(!Struct__pack_value(item->code, item->size, self->little, p, val)) return false;
+            p += item->size;
+            val++;
+        }
+    }
+    return true;
+}
+
+/// Unpack `self->size` bytes from `src` into a tuple.
+static bool c11_struct__unpack(c11_struct* self, const char* src, py_OutRef out) {
+    py_TValue* p = py_newtuple(out, self->nvalues);
+    for(int i = 0; i < self->nvalues; i++)
+        py_newnone(&p[i]);
+    c11__foreach(struct_Item, &self->items, item) {
+        const char* q = src + item->offset;
+        if(item->code == 's') {
+            memcpy(py_newbytes(p++, item->count), q, item->count);
+        } else if(item->code == 'p') {
+            int n = item->count > 0 ? c11__min((uint8_t)*q, item->count - 1) : 0;
+            memcpy(py_newbytes(p++, n), q + 1, n);
+        } else {
+            for(int i = 0; i < item->count; i++) {
+                if(!Struct__unpack_value(item->code, item->size, self->little, q, p++)) {
+                    return false;
+                }
+                q += item->size;
+            }
+        }
+    }
+    return true;
+}
+
+/* Struct */
+
+static bool Struct__new__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    py_Ref out = py_pushtmp();
+    c11_struct* self = py_newobject(out, py_totype(argv), 1, sizeof(c11_struct));
+    py_setslot(out, 0, py_arg(1));
+    if(!c11_struct__ctor(self, py_tosv(py_arg(1)))) return false;
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool Struct__pack(c11_struct* self, int argc, py_Ref argv) {
+    py_Ref out = py_pushtmp();
+    char* dst = (char*)py_newbytes(out, self->size);
+    if(!c11_struct__pack(self, dst, argc, argv)) return false;
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool Struct__pack_into(c11_struct* self, py_Ref buffer, py_Ref offset, int argc,
+                              py_Ref argv) {
+    if(!py_checkint(offset)) return false;
+    // pack into scratch memory first: converting the values may run python code
+    char small[64];
+    char* tmp = self->size <= (int)sizeof(small) ? small : PK_MALLOC(self->size);
+    bool ok = c11_struct__pack(self, tmp, argc, argv);
+    py_Buffer view;
+    if(ok) ok = py_getbuffer(buffer, &view, true);
+    if(ok) {
+        py_i64 index = py_toint(offset);
+        if(index < 0) {
+            if(index + view.size < 0) {
+                ok = StructError("offset %i out of range for %d-byte buffer", index, view.size);
+            }
+            index += view.size;
+        }
+        if(ok && view.size - index < self->size) {
+            ok = StructError("pack_into requires a buffer of at least %i bytes for packing %d "
+                             "bytes at offset %i (actual buffer size is %d)",
+                             (py_i64)self->size + index,
+                             self->size,
+                             index,
+                             view.size);
+        }
+        if(ok) memcpy((char*)view.data + index, tmp, self->size);
+        py_releasebuffer(&view);
+    }
+    if(tmp != small) PK_FREE(tmp);
+    if(!ok) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool Struct__unpack(c11_struct* self, py_Ref buffer) {
+    py_Buffer view;
+    if(!py_getbuffer(buffer, &view, false)) return false;
+    if(view.size != self->size) {
+        py_releasebuffer(&view);
+        return StructError("unpack requires a buffer of %d bytes", self->size);
+    }
+    bool ok = c11_struct__unpack(self, view.data, py_retval());
+    py_releasebuffer(&view);
+    return ok;
+}
+
+static bool Struct__unpack_from(c11_struct* self, py_Ref buffer, py_Ref offset) {
+    if(!py_checkint(offset)) return false;
+    py_Buffer view;
+    if(!py_getbuffer(buffer, &view, false)) return false;
+    py_i64 index = py_toint(offset);
+    if(index < 0) {
+        if(index + view.size < 0) {
+            py_releasebuffer(&view);
+            return StructError("offset %i out of range for %d-byte buffer", index, view.size);
+        }
+        index += view.size;
+    }
+    if(view.size - index < self->size) {
+        py_releasebuffer(&view);
+        return StructError("unpack_from requires a buffer of at least %i bytes for unpacking %d "
+                           "bytes at offset %i (actual buffer size is %d)",
+                           (py_i64)self->size + index,
+                           self->size,
+                           index,
+                           view.size);
+    }
+    bool ok = c11_struct__unpack(self, (const char*)view.data + index, py_retval());
+    py_releasebuffer(&view);
+    return ok;
+}
+
+static bool Struct__iter_unpack(py_Ref self, py_Ref buffer) {
+    c11_struct* ud = py_touserdata(self);
+    if(ud->size == 0) return StructError("cannot iteratively unpack with a struct of length 0");
+    py_Buffer view;
+    if(!py_getbuffer(buffer, &view, false)) return false;
+    int size = view.size;
+    py_releasebuffer(&view);
+    if(size % ud->size != 0) {
+        return StructError("iterative unpacking requires a buffer of a multiple of %d bytes",
+                           ud->size);
+    }
+    py_Type type = py_totype(py_getdict(py_getmodule("struct"), py_name("unpack_iterator")));
+    c11_struct_unpack_iterator* it =
+        py_newobject(py_retval(), type, 2, sizeof(c11_struct_unpack_iterator));
+    it->offset = 0;
+    py_setslot(py_retval(), 0, self);
+    py_setslot(py_retval(), 1, buffer);
+    return true;
+}
+
+static bool Struct_pack(int argc, py_Ref argv) {
+    return Struct__pack(py_touserdata(argv), argc - 1, argv + 1);
+}
+
+static bool Struct_pack_into(int argc, py_Ref argv) {
+    if(argc < 3) return TypeError("pack_into expected buffer and offset arguments");
+    return Struct__pack_into(py_touserdata(argv), &argv[1], &argv[2], argc - 3, argv + 3);
+}
+
+static bool Struct_unpack(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    return Struct__unpack(py_touserdata(argv), py_arg(1));
+}
+
+static bool Struct_unpack_from(int argc, py_Ref argv) {
+    // unpack_from(self, buffer, offset=0)
+    return Struct__unpack_from(py_touserdata(argv), py_arg(1), py_arg(2));
+}
+
+static bool Struct_iter_unpack(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    return Struct__iter_unpack(argv, py_arg(1));
+}
+
+static bool Struct_format(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_assign(py_retval(), py_getslot(argv, 0));
+    return true;
+}
+
+static bool Struct_size(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_struct* self = py_touserdata(argv);
+    py_newint(py_retval(), self->size);
+    return true;
+}
+
+static bool Struct__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    pk_sprintf(&buf, "Struct(%q)", py_tosv(py_getslot(argv, 0)));
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+static bool unpack_iterator__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_struct_unpack_iterator* it = py_touserdata(argv);
+    c11_struct* self = py_touserdata(py_getslot(argv, 0));
+    py_Buffer view;
+    if(!py_getbuffer(py_getslot(argv, 1), &view, false)) return false;
+    if(view.size - it->offset < self->size) {
+        py_releasebuffer(&view);
+        return StopIteration();
+    }
+    bool ok = c11_struct__unpack(self, (const char*)view.data + it->offset, py_retval());
+    py_releasebuffer(&view);
+    if(!ok) return false;
+    it->offset += self->size;
+    return true;
+}
+
+/* module functions */
+
+/// Compile the format `fmt` or fetch it from the cache, storing the `Struct` in `out`.
+static bool Struct__get(py_Ref fmt, py_OutRef out) {
+    if(!py_checktype(fmt, tp_str)) return false;
+    py_GlobalRef mod = py_getmodule("struct");
+    py_Ref cache = py_getdict(mod, py_name("_cache"));
+    int res = py_dict_getitem(cache, fmt);
+    if(res == -1) return false;
+    if(res == 1) {
+        py_assign(out, py_retval());
+        return true;
+    }
+    if(!py_call(py_getdict(mod, py_name("Struct")), 1, fmt)) return false;
+    py_assign(out, py_retval());
+    if(py_dict_len(cache) >= Struct__CACHE_SIZE) py_newdict(cache);
+    return py_dict_setitem(cache, fmt, out);
+}
+
+static bool struct_pack(int argc, py_Ref argv) {
+    if(argc < 1) return TypeError("pack expected at least 1 argument, got 0");
+    py_Ref s = py_pushtmp();
+    if(!Struct__get(argv, s)) return false;
+    if(!Struct__pack(py_touserdata(s), argc - 1, argv + 1)) return false;
+    py_pop();
+    return true;
+}
+
+static bool struct_pack_into(int argc, py_Ref argv) {
+    if(argc < 3) return TypeError("pack_into expected format, buffer and offset arguments");
+    py_Ref s = py_pushtmp();
+    if(!Struct__get(argv, s)) return false;
+    if(!Struct__pack_into(py_touserdata(s), &argv[1], &argv[2], argc - 3, argv + 3)) {
+        return false;
+    }
+    py_pop();
+    return true;
+}
+
+static bool struct_unpack(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    py_Ref s = py_pushtmp();
+    if(!Struct__get(argv, s)) return false;
+    if(!Struct__unpack(py_touserdata(s), py_arg(1))) return false;
+    py_pop();
+    return true;
+}
+
+static bool struct_unpack_from(int argc, py_Ref argv) {
+    // unpack_from(format, buffer, offset=0)
+    py_Ref s = py_pushtmp();
+    if(!Struct__get(argv, s)) return false;
+    if(!Struct__unpack_from(py_touserdata(s), py_arg(1), py_arg(2))) return false;
+    py_pop();
+    return true;
+}
+
+static bool struct_iter_unpack(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    py_Ref s = py_pushtmp();
+    if(!Struct__get(argv, s)) return false;
+    if(!Struct__iter_unpack(s, py_arg(1))) return false;
+    py_pop();
+    return true;
+}
+
+static bool struct_calcsize(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Ref s = py_pushtmp();
+    if(!Struct__get(argv, s)) return false;
+    c11_struct* self = py_touserdata(s);
+    py_newint(py_retval(), self->size);
+    py_pop();
+    return true;
+}
+
+void pk__add_module_struct() {
+    py_GlobalRef mod = py_newmodule("struct");
+    py_newdict(py_emplacedict(mod, py_name("_cache")));
+    py_newtype("error", tp_Exception, mod, NULL);
+
+    py_Type type = py_newtype("Struct", tp_object, mod, c11_struct__dtor);
+    py_tpsetfinal(type);
+    py_bindmagic(type, __new__, Struct__new__);
+    py_bindmagic(type, __repr__, Struct__repr__);
+    py_bindmethod(type, "pack", Struct_pack);
+    py_bindmethod(type, "pack_into", Struct_pack_into);
+    py_bindmethod(type, "unpack", Struct_unpack);
+    py_bind(py_tpobject(type), "unpack_from(self, buffer, offset=0)", Struct_unpack_from);
+    py_bindmethod(type, "iter_unpack", Struct_iter_unpack);
+    py_bindproperty(type, "format", Struct_format, NULL);
+    py_bindproperty(type, "size", Struct_size, NULL);
+
+    type = py_newtype("unpack_iterator", tp_object, mod, NULL);
+    py_tpsetfinal(type);
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, unpack_iterator__next__);
+
+    py_bindfunc(mod, "pack", struct_pack);
+    py_bindfunc(mod, "pack_into", struct_pack_into);
+    py_bindfunc(mod, "unpack", struct_unpack);
+    py_bind(mod, "unpack_from(format, buffer, offset=0)", struct_unpack_from);
+    py_bindfunc(mod, "iter_unpack", struct_iter_unpack);
+    py_bindfunc(mod, "calcsize", struct_calcsize);
+}
+
+#undef Struct__CACHE_SIZE
+#undef StructError
@@ -13,12 +13,24 @@ PK_INLINE py_Ref py_getdict(py_Ref self, py_Name name) {
 
 PK_INLINE void py_setdict(py_Ref self, py_Name name, py_Ref val) {
     assert(self && self->is_ptr);
-    NameDict__set(PyObject__dict(self->_obj), name, val);
+    NameDict* dict = PyObject__dict(self->_obj);
+    if(self->type == tp_type) {
+        // frozen dicts point to the values, so updating an existing name keeps them valid
+        // `__hash__` is special, whether it is `None` is resolved when freezing
+        if(name == __hash__ || !NameDict__contains(dict, name)) {
+            py_TypeInfo__invalidate(py_touserdata(self));
+        }
+    }
+    NameDict__set(dict, name, val);
 }
 
 bool py_deldict(py_Ref self, py_Name name) {
     assert(self && self->is_ptr);
-    return NameDict__del(PyObject__dict(self->_obj), name);
+    NameDict* dict = PyObject__dict(self->_obj);
+    if(self->type == tp_type && NameDict__contains(dict, name)) {
+        py_TypeInfo__invalidate(py_touserdata(self));
+    }
+    return NameDict__del(dict, name);
 }
 
 py_ItemRef py_emplacedict(py_Ref self, py_Name name) {
@@ -40,6 +52,7 @@ bool py_applydict(py_Ref self, bool (*f)(py_Name, py_Ref, void*), void* ctx) {
 
 void py_cleardict(py_Ref self) {
     assert(self && self->is_ptr);
+    if(self->type == tp_type) py_TypeInfo__invalidate(py_touserdata(self));
     NameDict* dict = PyObject__dict(self->_obj);
     NameDict__clear(dict);
 }
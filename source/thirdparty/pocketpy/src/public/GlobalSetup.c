@@ -11,9 +11,51 @@ static bool pk_initialized;
 static bool pk_finalized;
 
 static VM pk_default_vm;
-static VM* pk_all_vm[16];
+static c11_vector /*T=VM* */ pk_all_vm;  // NULL for deleted VMs
 static py_TValue _True, _False, _None, _NIL;
 
+#if PK_ENABLE_THREADS
+c11_mutex_t pk_all_vm_mutex;
+c11_thrdpool pk_compute_thread_pool;
+#endif
+
+static void pk_all_vm__lock() {
+#if PK_ENABLE_THREADS
+    c11_mutex__lock(&pk_all_vm_mutex);
+#endif
+}
+
+static void pk_all_vm__unlock() {
+#if PK_ENABLE_THREADS
+    c11_mutex__unlock(&pk_all_vm_mutex);
+#endif
+}
+
+static VM* pk_all_vm__get(int index) {
+    pk_all_vm__lock();
+    VM* vm = index < pk_all_vm.length ? c11__getitem(VM*, &pk_all_vm, index) : NULL;
+    pk_all_vm__unlock();
+    return vm;
+}
+
+static void pk_all_vm__new(VM* vm) {
+    VM* prev = pk_current_vm;
+    pk_current_vm = vm;
+    memset(vm, 0, sizeof(VM));
+    VM__ctor(vm);
+    pk_current_vm = prev;
+}
+
+static void pk_all_vm__delete(VM* vm) {
+    // temp fix https://github.com/pocketpy/pocketpy/issues/315
+    // TODO: refactor VM__ctor and VM__dtor
+    VM* prev = pk_current_vm;
+    pk_current_vm = vm;
+    VM__dtor(vm);
+    pk_current_vm = prev;
+    PK_FREE(vm);
+}
+
 void py_initialize() {
     c11__rtassert(!pk_finalized);
 
@@ -32,7 +74,13 @@ void py_initialize() {
     _Static_assert(sizeof(py_TValue) == 24, "sizeof(py_TValue) != 24");
     _Static_assert(offsetof(py_TValue, extra) == 4, "offsetof(py_TValue, extra) != 4");
 
-    pk_current_vm = pk_all_vm[0] = &pk_default_vm;
+#if PK_ENABLE_THREADS
+    c11_mutex__ctor(&pk_all_vm_mutex);
+    c11_thrdpool__ctor(&pk_compute_thread_pool, 256);
+#endif
+    c11_vector__ctor(&pk_all_vm, sizeof(VM*));
+    c11_vector__push(VM*, &pk_all_vm, &pk_default_vm);
+    pk_current_vm = &pk_default_vm;
 
     // initialize some convenient references
     py_newbool(&_True, true);
@@ -48,39 +96,95 @@ void py_finalize() {
     if(pk_finalized) c11__abort("py_finalize() can only be called once!");
     pk_finalized = true;
 
-    for(int i = 1; i < 16; i++) {
-        VM* vm = pk_all_vm[i];
+#if PK_ENABLE_THREADS
+    // jobs must not run while their VMs are deleted
+    c11_thrdpool__dtor(&pk_compute_thread_pool);
+#endif
+    for(int i = 1; i < pk_all_vm.length; i++) {
+        VM* vm = c11__getitem(VM*, &pk_all_vm, i);
         if(vm) {
-            // temp fix https://github.com/pocketpy/pocketpy/issues/315
-            // TODO: refactor VM__ctor and VM__dtor
-            pk_current_vm = vm;
-            VM__dtor(vm);
-            PK_FREE(vm);
+            c11__setitem(VM*, &pk_all_vm, i, NULL);
+            pk_all_vm__delete(vm);
         }
     }
     pk_current_vm = &pk_default_vm;
     VM__dtor(&pk_default_vm);
     pk_current_vm = NULL;
+    c11_vector__dtor(&pk_all_vm);
+#if PK_ENABLE_THREADS
+    c11_mutex__dtor(&pk_all_vm_mutex);
+#endif
 
     pk_names_finalize();
 }
 
 int py_currentvm() {
-    for(int i = 0; i < 16; i++) {
-        if(pk_all_vm[i] == pk_current_vm) return i;
+    int index = -1;
+    pk_all_vm__lock();
+    for(int i = 0; i < pk_all_vm.length; i++) {
+        if(c11__getitem(VM*, &pk_all_vm, i) == pk_current_vm) {
+            index = i;
+            break;
+        }
     }
-    return -1;
+    pk_all_vm__unlock();
+    return index;
 }
 
 void py_switchvm(int index) {
-    if(index < 0 || index >= 16) c11__abort("invalid vm index");
-    if(!pk_all_vm[index]) {
-        pk_current_vm = pk_all_vm[index] = PK_MALLOC(sizeof(VM));
-        memset(pk_current_vm, 0, sizeof(VM));
-        VM__ctor(pk_all_vm[index]);
+    if(index < 0) c11__abort("invalid vm index");
+    VM* vm = NULL;
+    pk_all_vm__lock();
+    while(pk_all_vm.length <= index) {
+        c11_vector__push(VM*, &pk_all_vm, NULL);
+    }
+    vm = c11__getitem(VM*, &pk_all_vm, index);
+    bool is_new = vm == NULL;
+    if(is_new) {
+        vm = PK_MALLOC(sizeof(VM));
+        c11__setitem(VM*, &pk_all_vm, index, vm);
+    }
+    pk_all_vm__unlock();
+    if(is_new) pk_all_vm__new(vm);
+    pk_current_vm = vm;
+}
+
+int py_newvm() {
+    VM* vm = PK_MALLOC(sizeof(VM));
+    pk_all_vm__lock();
+    int index = 1;
+    while(index < pk_all_vm.length && c11__getitem(VM*, &pk_all_vm, index) != NULL) {
+        index++;
+    }
+    if(index == pk_all_vm.length) {
+        c11_vector__push(VM*, &pk_all_vm, vm);
     } else {
-        pk_current_vm = pk_all_vm[index];
+        c11__setitem(VM*, &pk_all_vm, index, vm);
     }
+    pk_all_vm__unlock();
+    pk_all_vm__new(vm);
+    return index;
+}
+
+void py_delvm(int index) {
+    if(index == 0) c11__abort("cannot delete the default vm");
+    if(index < 0) c11__abort("invalid vm index");
+    VM* vm = NULL;
+    pk_all_vm__lock();
+    if(index < pk_all_vm.length) {
+        vm = c11__getitem(VM*, &pk_all_vm, index);
+        if(vm == pk_current_vm) {
+            pk_all_vm__unlock();
+            c11__abort("cannot delete the current vm");
+        }
+        c11__setitem(VM*, &pk_all_vm, index, NULL);
+        // trailing slots are not needed anymore
+        while(c11_vector__back(VM*, &pk_all_vm) == NULL) {
+            c11_vector__pop(&pk_all_vm);
+        }
+    }
+    pk_all_vm__unlock();
+    if(vm) pk_all_vm__delete(vm);
 }
 
 void py_resetvm() {
@@ -90,8 +194,21 @@ void py_resetvm() {
     VM__ctor(vm);
 }
 
+bool py_clonevm(int src_index, int dst_index) {
+    if(src_index < 0 || dst_index < 0) c11__abort("invalid vm index");
+    if(src_index == dst_index) c11__abort("cannot clone a vm into itself");
+    VM* src = pk_all_vm__get(src_index);
+    if(!src) c11__abort("vm %d does not exist", src_index);
+    bool exists = pk_all_vm__get(dst_index) != NULL;
+    py_switchvm(dst_index);
+    if(exists) py_resetvm();
+    return VM__clone(pk_current_vm, src);
+}
+
 void py_resetallvm() {
-    for(int i = 0; i < 16; i++) {
+    int length = pk_all_vm.length;
+    for(int i = 0; i < length; i++) {
+        if(!pk_all_vm__get(i)) continue;
         py_switchvm(i);
         py_resetvm();
     }
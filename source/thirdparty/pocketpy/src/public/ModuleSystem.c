@@ -31,6 +31,7 @@ py_Ref py_newmodule(const char* path) {
     }
 
     mi->path = c11_string__new(path);
+    mi->is_source = false;
     path = mi->path->data;
 
     // we do not allow override in order to avoid memory leak
@@ -157,6 +158,7 @@ __SUCCESS:
     do {
     } while(0);
     py_GlobalRef mod = py_newmodule(path_cstr);
+    ((py_ModuleInfo*)py_touserdata(mod))->is_source = true;
     bool ok = py_exec((const char*)data, filename->data, EXEC_MODE, mod);
     py_assign(py_retval(), mod);
 
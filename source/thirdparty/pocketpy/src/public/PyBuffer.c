@@ -0,0 +1,422 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/sstream.h"
+#include "pocketpy/interpreter/typeinfo.h"
+#include "pocketpy/interpreter/vm.h"
+
+bool py_checkbuffer(py_Ref self) { return pk_typeinfo(self->type)->getbuffer != NULL; }
+
+bool py_getbuffer(py_Ref self, py_Buffer* out, bool writable) {
+    py_GetBufferFunc getbuffer = pk_typeinfo(self->type)->getbuffer;
+    if(!getbuffer) return TypeError("a bytes-like object is required, not '%t'", self->type);
+    out->obj = self;
+    out->internal = NULL;
+    out->release = NULL;
+    return getbuffer(self, out, writable);
+}
+
+void py_releasebuffer(py_Buffer* self) {
+    if(self->release) self->release(self);
+    self->release = NULL;
+}
+
+int pk__format_itemsize(char format) {
+    switch(format) {
+        case 'B': return 1;
+        case 'b': return 1;
+        case 'h': return 2;
+        case 'i': return 4;
+        case 'q': return 8;
+        case 'f': return 4;
+        case 'd': return 8;
+        default: return 0;
+    }
+}
+
+void pk__unpack_item(char format, const void* p, py_OutRef out) {
+    switch(format) {
+        case 'B': py_newint(out, *(uint8_t*)p); break;
+        case 'b': py_newint(out, *(int8_t*)p); break;
+        case 'h': py_newint(out, *(int16_t*)p); break;
+        case 'i': py_newint(out, *(int32_t*)p); break;
+        case 'q': py_newint(out, *(int64_t*)p); break;
+        case 'f': py_newfloat(out, *(float*)p); break;
+        case 'd': py_newfloat(out, *(double*)p); break;
+        default: c11__unreachable();
+    }
+}
+
+bool pk__pack_item(char format, void* p, py_Ref val) {
+    if(format == 'f' || format == 'd') {
+        py_f64 f;
+        if(!py_castfloat(val, &f)) return false;
+        if(format == 'f') {
+            *(float*)p = (float)f;
+        } else {
+            *(double*)p = f;
+        }
+        return true;
+    }
+    if(!py_checkint(val)) return false;
+    py_i64 v = py_toint(val);
+    switch(format) {
+        case 'B':
+            if(v < 0 || v > UINT8_MAX) return ValueError("unsigned char is out of range");
+            *(uint8_t*)p = (uint8_t)v;
+            break;
+        case 'b':
+            if(v < INT8_MIN || v > INT8_MAX) return ValueError("signed char is out of range");
+            *(int8_t*)p = (int8_t)v;
+            break;
+        case 'h':
+            if(v < INT16_MIN || v > INT16_MAX) return ValueError("signed short is out of range");
+            *(int16_t*)p = (int16_t)v;
+            break;
+        case 'i':
+            if(v < INT32_MIN || v > INT32_MAX) return ValueError("signed int is out of range");
+            *(int32_t*)p = (int32_t)v;
+            break;
+        case 'q': *(int64_t*)p = v; break;
+        default: c11__unreachable();
+    }
+    return true;
+}
+
+/* memoryview */
+
+/* A `memoryview` records a window into the buffer of the object in its slot 0 and acquires that
+ * buffer again on every access. Resizing the object therefore never leaves a dangling pointer:
+ * the window is validated against the current size instead.
+ */
+
+typedef struct {
+    int offset;  // in bytes
+    int size;    // in bytes
+    int itemsize;
+    char format;
+    bool readonly;
+    bool released;
+} c11_memoryview;
+
+static bool memoryview__getbuffer(py_Ref self, py_Buffer* out, bool writable) {
+    c11_memoryview* mv = py_touserdata(self);
+    if(mv->released) return ValueError("operation forbidden on released memoryview object");
+    if(writable && mv->readonly) return TypeError("cannot modify read-only memory");
+    if(!py_getbuffer(py_getslot(self, 0), out, writable)) return false;
+    if(mv->offset + mv->size > out->size) {
+        py_releasebuffer(out);
+        return ValueError("memoryview: the underlying buffer has shrunk");
+    }
+    out->data = (char*)out->data + mv->offset;
+    out->size = mv->size;
+    out->itemsize = mv->itemsize;
+    out->format = mv->format;
+    out->readonly = mv->readonly;
+    return true;
+}
+
+static c11_memoryview* c11_memoryview__new(py_OutRef out, py_Ref obj) {
+    c11_memoryview* mv = py_newobject(out, py_typeof(obj), 1, sizeof(c11_memoryview));
+    *mv = *(c11_memoryview*)py_touserdata(obj);
+    py_setslot(out, 0, py_getslot(obj, 0));
+    return mv;
+}
+
+static bool memoryview__new__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    py_Type cls = py_totype(argv);
+    py_Ref obj = py_arg(1);
+    if(py_typeof(obj) == cls) {
+        // share the exporter instead of stacking views
+        py_Buffer view;
+        if(!py_getbuffer(obj, &view, false)) return false;
+        py_releasebuffer(&view);
+        c11_memoryview__new(py_retval(), obj);
+        return true;
+    }
+    py_Buffer view;
+    if(!py_getbuffer(obj, &view, false)) return false;
+    c11_memoryview* mv = py_newobject(py_retval(), cls, 1, sizeof(c11_memoryview));
+    mv->offset = 0;
+    mv->size = view.size;
+    mv->itemsize = view.itemsize;
+    mv->format = view.format;
+    mv->readonly = view.readonly;
+    mv->released = false;
+    py_setslot(py_retval(), 0, obj);
+    py_releasebuffer(&view);
+    return true;
+}
+
+static bool memoryview__len__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_memoryview* mv = py_touserdata(argv);
+    if(mv->released) return ValueError("operation forbidden on released memoryview object");
+    py_newint(py_retval(), mv->size / mv->itemsize);
+    return true;
+}
+
+static bool memoryview__getitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_memoryview* mv = py_touserdata(argv);
+    py_Ref key = py_arg(1);
+    int length = mv->size / mv->itemsize;
+    if(py_isint(key)) {
+        int index = py_toint(key);
+        if(!pk__normalize_index(&index, length)) return false;
+        py_Buffer view;
+        if(!memoryview__getbuffer(argv, &view, false)) return false;
+        pk__unpack_item(view.format, (char*)view.data + index * view.itemsize, py_retval());
+        py_releasebuffer(&view);
+        return true;
+    }
+    if(!py_istype(key, tp_slice)) return TypeError("memoryview: invalid slice key");
+    if(mv->released) return ValueError("operation forbidden on released memoryview object");
+    int start, stop, step;
+    if(!pk__parse_int_slice(key, length, &start, &stop, &step)) return false;
+    if(step != 1) return ValueError("memoryview: only contiguous slices are supported");
+    c11_memoryview* res = c11_memoryview__new(py_retval(), argv);
+    res->offset += start * mv->itemsize;
+    res->size = c11__max(stop - start, 0) * mv->itemsize;
+    return true;
+}
+
+static bool memoryview__setitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    c11_memoryview* mv = py_touserdata(argv);
+    py_Ref key = py_arg(1);
+    int length = mv->size / mv->itemsize;
+    py_Buffer view;
+    if(py_isint(key)) {
+        int index = py_toint(key);
+        if(!pk__normalize_index(&index, length)) return false;
+        if(!memoryview__getbuffer(argv, &view, true)) return false;
+        bool ok = pk__pack_item(view.format, (char*)view.data + index * view.itemsize, py_arg(2));
+        py_releasebuffer(&view);
+        if(!ok) return false;
+        py_newnone(py_retval());
+        return true;
+    }
+    if(!py_istype(key, tp_slice)) return TypeError("memoryview: invalid slice key");
+    int start, stop, step;
+    if(!pk__parse_int_slice(key, length, &start, &stop, &step)) return false;
+    if(step != 1) return ValueError("memoryview: only contiguous slices are supported");
+    py_Buffer src;
+    if(!py_getbuffer(py_arg(2), &src, false)) return false;
+    int size = c11__max(stop - start, 0) * mv->itemsize;
+    if(src.format != mv->format || src.size != size) {
+        py_releasebuffer(&src);
+        return ValueError("memoryview assignment: lvalue and rvalue have different structures");
+    }
+    if(!memoryview__getbuffer(argv, &view, true)) {
+        py_releasebuffer(&src);
+        return false;
+    }
+    memmove((char*)view.data + start * view.itemsize, src.data, size);
+    py_releasebuffer(&view);
+    py_releasebuffer(&src);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool memoryview_tobytes(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Buffer view;
+    if(!memoryview__getbuffer(argv, &view, false)) return false;
+    memcpy(py_newbytes(py_retval(), view.size), view.data, view.size);
+    py_releasebuffer(&view);
+    return true;
+}
+
+static bool memoryview_tolist(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Buffer view;
+    if(!memoryview__getbuffer(argv, &view, false)) return false;
+    int length = view.size / view.itemsize;
+    py_newlistn(py_retval(), length);
+    py_TValue* p = py_list_data(py_retval());
+    for(int i = 0; i < length; i++) {
+        pk__unpack_item(view.format, (char*)view.data + i * view.itemsize, &p[i]);
+    }
+    py_releasebuffer(&view);
+    return true;
+}
+
+static bool memoryview__iter__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    if(!memoryview_tolist(1, argv)) return false;
+    py_Ref list = py_pushtmp();
+    py_assign(list, py_retval());
+    bool ok = py_iter(list);
+    py_pop();
+    return ok;
+}
+
+static bool memoryview_cast(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    c11_memoryview* mv = py_touserdata(argv);
+    if(mv->released) return ValueError("operation forbidden on released memoryview object");
+    c11_sv format = py_tosv(py_arg(1));
+    int itemsize = format.size == 1 ? pk__format_itemsize(format.data[0]) : 0;
+    if(itemsize == 0) {
+        return ValueError("memoryview: format must be one of 'B', 'b', 'h', 'i', 'q', 'f', 'd'");
+    }
+    if(mv->size % itemsize != 0) {
+        return TypeError("memoryview: length is not a multiple of itemsize");
+    }
+    c11_memoryview* res = c11_memoryview__new(py_retval(), argv);
+    res->itemsize = itemsize;
+    res->format = format.data[0];
+    return true;
+}
+
+static bool memoryview_release(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_memoryview* mv = py_touserdata(argv);
+    mv->released = true;
+    py_setslot(argv, 0, py_None());
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool memoryview__enter__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_assign(py_retval(), argv);
+    return true;
+}
+
+static bool memoryview__exit__(int argc, py_Ref argv) { return memoryview_release(1, argv); }
+
+/// -1: error, 0: false, 1: true
+static int Memoryview__equal(py_Ref lhs, py_Ref rhs) {
+    py_Buffer a, b;
+    if(!memoryview__getbuffer(lhs, &a, false)) return -1;
+    if(!py_getbuffer(rhs, &b, false)) {
+        py_releasebuffer(&a);
+        return -1;
+    }
+    int length = a.size / a.itemsize;
+    int res = length == b.size / b.itemsize;
+    if(res && a.format == b.format && a.format != 'f' && a.format != 'd') {
+        res = memcmp(a.data, b.data, a.size) == 0;
+    } else if(res) {
+        for(int i = 0; i < length && res; i++) {
+            py_TValue x, y;
+            pk__unpack_item(a.format, (char*)a.data + i * a.itemsize, &x);
+            pk__unpack_item(b.format, (char*)b.data + i * b.itemsize, &y);
+            if(py_isint(&x) && py_isint(&y)) {
+                res = py_toint(&x) == py_toint(&y);
+            } else {
+                py_f64 fx = py_isint(&x) ? (py_f64)py_toint(&x) : py_tofloat(&x);
+                py_f64 fy = py_isint(&y) ? (py_f64)py_toint(&y) : py_tofloat(&y);
+                res = fx == fy;
+            }
+        }
+    }
+    py_releasebuffer(&a);
+    py_releasebuffer(&b);
+    return res;
+}
+
+static bool memoryview__eq__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    c11_memoryview* mv = py_touserdata(argv);
+    if(py_isidentical(py_arg(0), py_arg(1))) {
+        py_newbool(py_retval(), true);
+        return true;
+    }
+    if(mv->released || !py_checkbuffer(py_arg(1))) {
+        py_newnotimplemented(py_retval());
+        return true;
+    }
+    int res = Memoryview__equal(py_arg(0), py_arg(1));
+    if(res == -1) return false;
+    py_newbool(py_retval(), res);
+    return true;
+}
+
+static bool memoryview__ne__(int argc, py_Ref argv) {
+    if(!memoryview__eq__(argc, argv)) return false;
+    if(py_isbool(py_retval())) py_newbool(py_retval(), !py_tobool(py_retval()));
+    return true;
+}
+
+static bool memoryview__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_memoryview* mv = py_touserdata(argv);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstr(&buf, mv->released ? "<released memory at " : "<memory at ");
+    c11_sbuf__write_ptr(&buf, argv->_obj);
+    c11_sbuf__write_char(&buf, '>');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+static bool memoryview_obj(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_memoryview* mv = py_touserdata(argv);
+    if(mv->released) return ValueError("operation forbidden on released memoryview object");
+    py_assign(py_retval(), py_getslot(argv, 0));
+    return true;
+}
+
+static bool memoryview_nbytes(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_memoryview* mv = py_touserdata(argv);
+    py_newint(py_retval(), mv->size);
+    return true;
+}
+
+static bool memoryview_readonly(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_memoryview* mv = py_touserdata(argv);
+    py_newbool(py_retval(), mv->readonly);
+    return true;
+}
+
+static bool memoryview_itemsize(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_memoryview* mv = py_touserdata(argv);
+    py_newint(py_retval(), mv->itemsize);
+    return true;
+}
+
+static bool memoryview_format(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    c11_memoryview* mv = py_touserdata(argv);
+    char format[2] = {mv->format, '\0'};
+    py_newstr(py_retval(), format);
+    return true;
+}
+
+py_Type pk_memoryview__register() {
+    py_Type type = pk_newtype("memoryview", tp_object, NULL, NULL, false, true);
+    py_tpsetbuffer(type, memoryview__getbuffer);
+    py_setdict(py_tpobject(type), __hash__, py_None());
+
+    py_bindmagic(type, __new__, memoryview__new__);
+    py_bindmagic(type, __len__, memoryview__len__);
+    py_bindmagic(type, __getitem__, memoryview__getitem__);
+    py_bindmagic(type, __setitem__, memoryview__setitem__);
+    py_bindmagic(type, __iter__, memoryview__iter__);
+    py_bindmagic(type, __enter__, memoryview__enter__);
+    py_bindmagic(type, __exit__, memoryview__exit__);
+    py_bindmagic(type, __eq__, memoryview__eq__);
+    py_bindmagic(type, __ne__, memoryview__ne__);
+    py_bindmagic(type, __repr__, memoryview__repr__);
+
+    py_bindmethod(type, "tobytes", memoryview_tobytes);
+    py_bindmethod(type, "tolist", memoryview_tolist);
+    py_bindmethod(type, "cast", memoryview_cast);
+    py_bindmethod(type, "release", memoryview_release);
+
+    py_bindproperty(type, "obj", memoryview_obj, NULL);
+    py_bindproperty(type, "nbytes", memoryview_nbytes, NULL);
+    py_bindproperty(type, "readonly", memoryview_readonly, NULL);
+    py_bindproperty(type, "itemsize", memoryview_itemsize, NULL);
+    py_bindproperty(type, "format", memoryview_format, NULL);
+    return type;
+}
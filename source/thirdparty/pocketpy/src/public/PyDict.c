@@ -13,52 +13,98 @@ typedef struct {
     int mode;  // 0: keys, 1: values, 2: items
 } DictIterator;
 
-#define Dict__step(x) ((x) < mask ? (x) + 1 : 0)
-
-static uint32_t Dict__next_cap(uint32_t cap) {
-    switch(cap) {
-        case 7: return 17;
-        case 17: return 37;
-        case 37: return 79;
-        case 79: return 163;
-        case 163: return 331;
-        case 331: return 673;
-        case 673: return 1361;
-        case 1361: return 2053;
-        case 2053: return 3083;
-        case 3083: return 4637;
-        case 4637: return 6959;
-        case 6959: return 10453;
-        case 10453: return 15683;
-        case 15683: return 23531;
-        case 23531: return 35311;
-        case 35311: return 52967;
-        case 52967: return 79451;
-        case 79451: return 119179;
-        case 119179: return 178781;
-        case 178781: return 268189;
-        case 268189: return 402299;
-        case 402299: return 603457;
-        case 603457: return 905189;
-        case 905189: return 1357787;
-        case 1357787: return 2036687;
-        case 2036687: return 3055043;
-        case 3055043: return 4582577;
-        case 4582577: return 6873871;
-        case 6873871: return 10310819;
-        case 10310819: return 15466229;
-        case 15466229: return 23199347;
-        case 23199347: return 34799021;
-        case 34799021: return 52198537;
-        case 52198537: return 78297827;
-        case 78297827: return 117446801;
-        case 117446801: return 176170229;
-        case 176170229: return 264255353;
-        case 264255353: return 396383041;
-        case 396383041: return 594574583;
-        case 594574583: return 891861923;
-        default: c11__unreachable();
+/* Dict is a swiss table: a power-of-two array of 1-byte control words split
+ * into groups of `Dict__GROUP_WIDTH`, plus a parallel array of indices into
+ * `entries`. `entries` keeps the insertion order required by Python.
+ *
+ * A control byte is either EMPTY, DELETED, or the low 7 bits of the hash (h2)
+ * of the entry it points to. A lookup starts at the group selected by the
+ * remaining hash bits (h1), matches h2 against the whole group at once and
+ * stops at the first group containing an EMPTY byte. Groups are visited with
+ * triangular probing, which covers every group when the group count is a
+ * power of two.
+ */
+#define Dict__CTRL_EMPTY ((uint8_t)0x80)
+#define Dict__CTRL_DELETED ((uint8_t)0xFE)
+#define Dict__GROUP_WIDTH 16
+// 16-bit indices are used while `entries` can not outgrow UINT16_MAX
+#define Dict__MAX_SHORT_CAPACITY 16384
+
+#define Dict__h1(hash) ((hash) >> 7)
+#define Dict__h2(hash) ((uint8_t)((hash) & 0x7F))
+#define Dict__max_load(cap) ((cap) - (cap) / 8)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define Dict__MASK_SHIFT 0
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+// NEON has no movemask, a match is reported as the high bit of a 4-bit lane
+#define Dict__MASK_SHIFT 2
+#else
+#define Dict__MASK_SHIFT 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+typedef uint64_t Dict__Mask;
+
+PK_INLINE static int Dict__mask_lowest(Dict__Mask mask) {
+#if(defined(__clang__) || defined(__GNUC__))
+    return __builtin_ctzll(mask) >> Dict__MASK_SHIFT;
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (int)index >> Dict__MASK_SHIFT;
+#else
+    int index = 0;
+    while((mask & 1) == 0) {
+        mask >>= 1;
+        index++;
     }
+    return index >> Dict__MASK_SHIFT;
+#endif
+}
+
+/// Bitmask of bytes in the group equal to `h2`.
+PK_INLINE static Dict__Mask Dict__match(const uint8_t* group, uint8_t h2) {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    uint8x16_t eq = vceqq_u8(vld1q_u8(group), vdupq_n_u8(h2));
+    uint8x8_t res = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(res), 0) & 0x8888888888888888ull;
+#else
+    Dict__Mask mask = 0;
+    for(int i = 0; i < Dict__GROUP_WIDTH; i++) {
+        if(group[i] == h2) mask |= (Dict__Mask)1 << i;
+    }
+    return mask;
+#endif
+}
+
+/// Bitmask of EMPTY or DELETED bytes in the group (both have the high bit set).
+PK_INLINE static Dict__Mask Dict__match_free(const uint8_t* group) {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return (uint16_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    uint8x16_t neg = vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(group)), vdupq_n_s8(0));
+    uint8x8_t res = vshrn_n_u16(vreinterpretq_u16_u8(neg), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(res), 0) & 0x8888888888888888ull;
+#else
+    Dict__Mask mask = 0;
+    for(int i = 0; i < Dict__GROUP_WIDTH; i++) {
+        if(group[i] & 0x80) mask |= (Dict__Mask)1 << i;
+    }
+    return mask;
+#endif
+}
+
+PK_INLINE static Dict__Mask Dict__match_empty(const uint8_t* group) {
+    return Dict__match(group, Dict__CTRL_EMPTY);
 }
 
 static uint64_t Dict__hash_2nd(uint64_t key) {
@@ -73,66 +119,78 @@ static uint64_t Dict__hash_2nd(uint64_t key) {
     return key;
 }
 
-static void Dict__ctor(Dict* self, uint32_t capacity, int entries_capacity) {
+void Dict__ctor(Dict* self, uint32_t capacity, int entries_capacity) {
+    assert(capacity >= PK_DICT_MIN_CAPACITY && (capacity & (capacity - 1)) == 0);
     self->length = 0;
     self->capacity = capacity;
+    self->growth_left = Dict__max_load(capacity);
+    self->index_is_short = capacity <= Dict__MAX_SHORT_CAPACITY;
+    self->str_keys_only = true;
 
-    size_t indices_size;
-    if(self->capacity < UINT16_MAX) {
-        self->index_is_short = true;
-        indices_size = self->capacity * sizeof(uint16_t);
-        self->null_index_value = UINT16_MAX;
-    } else {
-        self->index_is_short = false;
-        indices_size = self->capacity * sizeof(uint32_t);
-        self->null_index_value = UINT32_MAX;
-    }
-
-    self->indices = PK_MALLOC(indices_size);
-    memset(self->indices, -1, indices_size);
+    size_t index_size = self->index_is_short ? sizeof(uint16_t) : sizeof(uint32_t);
+    // control bytes and indices share one allocation
+    self->ctrl = PK_MALLOC(capacity * (1 + index_size));
+    self->indices = self->ctrl + capacity;
+    memset(self->ctrl, Dict__CTRL_EMPTY, capacity);
 
     c11_vector__ctor(&self->entries, sizeof(DictEntry));
     c11_vector__reserve(&self->entries, entries_capacity);
 }
 
-static void Dict__dtor(Dict* self) {
+void Dict__dtor(Dict* self) {
     self->length = 0;
     self->capacity = 0;
-    PK_FREE(self->indices);
+    PK_FREE(self->ctrl);
     c11_vector__dtor(&self->entries);
 }
 
-static uint32_t Dict__get_index(Dict* self, uint32_t index) {
+static uint32_t Dict__get_index(Dict* self, uint32_t slot) {
     if(self->index_is_short) {
         uint16_t* indices = self->indices;
-        return indices[index];
+        return indices[slot];
     } else {
         uint32_t* indices = self->indices;
-        return indices[index];
+        return indices[slot];
     }
 }
 
-static void Dict__swap_null_index(Dict* self, uint32_t pre_z, uint32_t z) {
+static void Dict__set_index(Dict* self, uint32_t slot, uint32_t value) {
     if(self->index_is_short) {
         uint16_t* indices = self->indices;
-        assert(indices[pre_z] == UINT16_MAX);
-        indices[pre_z] = indices[z];
-        indices[z] = UINT16_MAX;
+        indices[slot] = (uint16_t)value;
     } else {
         uint32_t* indices = self->indices;
-        assert(indices[pre_z] == UINT32_MAX);
-        indices[pre_z] = indices[z];
-        indices[z] = UINT32_MAX;
+        indices[slot] = value;
     }
 }
 
-static void Dict__set_index(Dict* self, uint32_t index, uint32_t value) {
-    if(self->index_is_short) {
-        uint16_t* indices = self->indices;
-        indices[index] = (uint16_t)value;
-    } else {
-        uint32_t* indices = self->indices;
-        indices[index] = value;
+PK_INLINE static uint64_t Dict__hash_str(c11_sv sv) { return Dict__hash_2nd(c11_sv__hash(sv)); }
+
+/// Probe for a string key without touching `py_hash` or `py_equal`.
+/// In `str_keys_only` mode every entry is known to be a string, so no type check is needed.
+static DictEntry* Dict__probe_str(Dict* self, c11_sv key, uint64_t hash, uint32_t* p_slot) {
+    uint8_t h2 = Dict__h2(hash);
+    uint32_t group_mask = self->capacity / Dict__GROUP_WIDTH - 1;
+    uint32_t group = (uint32_t)Dict__h1(hash) & group_mask;
+    for(uint32_t step = 1;; step++) {
+        const uint8_t* ctrl = self->ctrl + group * Dict__GROUP_WIDTH;
+        Dict__Mask mask = Dict__match(ctrl, h2);
+        while(mask) {
+            uint32_t slot = group * Dict__GROUP_WIDTH + Dict__mask_lowest(mask);
+            DictEntry* entry = c11__at(DictEntry, &self->entries, Dict__get_index(self, slot));
+            if(entry->hash == hash && (self->str_keys_only || py_isstr(&entry->key))) {
+                c11_sv lhs = py_tosv(&entry->key);
+                // same string object, or same bytes
+                if(lhs.data == key.data ||
+                   (lhs.size == key.size && memcmp(lhs.data, key.data, key.size) == 0)) {
+                    *p_slot = slot;
+                    return entry;
+                }
+            }
+            mask &= mask - 1;
+        }
+        if(Dict__match_empty(ctrl)) return NULL;
+        group = (group + step) & group_mask;
     }
 }
 
@@ -140,192 +198,181 @@ static void Dict__set_index(Dict* self, uint32_t index, uint32_t value) {
 static bool Dict__probe(Dict* self,
                         py_TValue* key,
                         uint64_t* p_hash,
-                        uint32_t* p_idx,
+                        uint32_t* p_slot,
                         DictEntry** p_entry) {
     if(py_isstr(key)) {
-        *p_hash = c11_sv__hash(py_tosv(key));
-    } else {
-        py_i64 h_user;
-        if(!py_hash(key, &h_user)) return false;
-        *p_hash = Dict__hash_2nd((uint64_t)h_user);
+        c11_sv sv = py_tosv(key);
+        *p_hash = Dict__hash_str(sv);
+        *p_entry = Dict__probe_str(self, sv, *p_hash, p_slot);
+        return true;
     }
-    uint32_t mask = self->capacity - 1;
-    uint32_t idx = (*p_hash) % self->capacity;
-    while(true) {
-        uint32_t idx2 = Dict__get_index(self, idx);
-        if(idx2 == self->null_index_value) break;
-        DictEntry* entry = c11__at(DictEntry, &self->entries, idx2);
-        if(entry->hash == (*p_hash)) {
-            if(py_isstr(&entry->key) && py_isstr(key)) {
-                c11_sv lhs = py_tosv(&entry->key);
-                c11_sv rhs = py_tosv(key);
-                if(c11__sveq(lhs, rhs)) {
-                    *p_idx = idx;
-                    *p_entry = entry;
-                    return true;
-                }
-            } else {
+    py_i64 h_user;
+    if(!py_hash(key, &h_user)) return false;
+    uint64_t hash = Dict__hash_2nd((uint64_t)h_user);
+    *p_hash = hash;
+    uint8_t h2 = Dict__h2(hash);
+    uint32_t group_mask = self->capacity / Dict__GROUP_WIDTH - 1;
+    uint32_t group = (uint32_t)Dict__h1(hash) & group_mask;
+    for(uint32_t step = 1;; step++) {
+        const uint8_t* ctrl = self->ctrl + group * Dict__GROUP_WIDTH;
+        Dict__Mask mask = Dict__match(ctrl, h2);
+        while(mask) {
+            uint32_t slot = group * Dict__GROUP_WIDTH + Dict__mask_lowest(mask);
+            DictEntry* entry = c11__at(DictEntry, &self->entries, Dict__get_index(self, slot));
+            if(entry->hash == hash) {
                 int res = py_equal(&entry->key, key);
                 if(res == 1) {
-                    *p_idx = idx;
+                    *p_slot = slot;
                     *p_entry = entry;
                     return true;
                 }
                 if(res == -1) return false;  // error
             }
+            mask &= mask - 1;
         }
-        // try next index
-        idx = Dict__step(idx);
+        // a group with an EMPTY byte terminates every probe sequence passing through it
+        if(Dict__match_empty(ctrl)) break;
+        // try next group
+        group = (group + step) & group_mask;
     }
     // not found
-    *p_idx = idx;
     *p_entry = NULL;
     return true;
 }
 
-static bool Dict__try_get(Dict* self, py_TValue* key, DictEntry** out) {
+bool Dict__try_get(Dict* self, py_TValue* key, DictEntry** out) {
     uint64_t hash;
-    uint32_t idx;
-    return Dict__probe(self, key, &hash, &idx, out);
+    uint32_t slot;
+    return Dict__probe(self, key, &hash, &slot, out);
+}
+
+/// Find the first EMPTY or DELETED slot on the probe sequence of `hash`.
+static uint32_t Dict__find_free_slot(Dict* self, uint64_t hash) {
+    uint32_t group_mask = self->capacity / Dict__GROUP_WIDTH - 1;
+    uint32_t group = (uint32_t)Dict__h1(hash) & group_mask;
+    for(uint32_t step = 1;; step++) {
+        Dict__Mask mask = Dict__match_free(self->ctrl + group * Dict__GROUP_WIDTH);
+        if(mask) return group * Dict__GROUP_WIDTH + Dict__mask_lowest(mask);
+        group = (group + step) & group_mask;
+    }
 }
 
-static void Dict__clear(Dict* self) {
-    size_t indices_size = self->index_is_short ? self->capacity * sizeof(uint16_t)
-                                               : self->capacity * sizeof(uint32_t);
-    memset(self->indices, -1, indices_size);
+void Dict__clear(Dict* self) {
+    memset(self->ctrl, Dict__CTRL_EMPTY, self->capacity);
+    self->growth_left = Dict__max_load(self->capacity);
     c11_vector__clear(&self->entries);
     self->length = 0;
+    self->str_keys_only = true;
 }
 
-static void Dict__rehash_2x(Dict* self) {
+/// Rebuild the table with `new_capacity` slots, dropping deleted entries and tombstones.
+static void Dict__rehash(Dict* self, uint32_t new_capacity) {
     Dict old_dict = *self;
-    uint32_t new_capacity = Dict__next_cap(old_dict.capacity);
-    uint32_t mask = new_capacity - 1;
     // create a new dict with new capacity
     Dict__ctor(self, new_capacity, old_dict.entries.capacity);
+    self->str_keys_only = old_dict.str_keys_only;
     // move entries from old dict to new dict
     for(int i = 0; i < old_dict.entries.length; i++) {
         DictEntry* old_entry = c11__at(DictEntry, &old_dict.entries, i);
         if(py_isnil(&old_entry->key)) continue;  // skip deleted
-        uint32_t idx = old_entry->hash % new_capacity;
-        while(true) {
-            uint32_t idx2 = Dict__get_index(self, idx);
-            if(idx2 == self->null_index_value) {
-                c11_vector__push(DictEntry, &self->entries, *old_entry);
-                Dict__set_index(self, idx, self->entries.length - 1);
-                self->length++;
-                break;
-            }
-            // try next index
-            idx = Dict__step(idx);
-        }
+        uint32_t slot = Dict__find_free_slot(self, old_entry->hash);
+        self->ctrl[slot] = Dict__h2(old_entry->hash);
+        c11_vector__push(DictEntry, &self->entries, *old_entry);
+        Dict__set_index(self, slot, self->entries.length - 1);
+        self->length++;
     }
+    self->growth_left -= self->length;
     Dict__dtor(&old_dict);
 }
 
-static void Dict__compact_entries(Dict* self) {
-    uint32_t* mappings = PK_MALLOC(self->entries.length * sizeof(uint32_t));
-
-    int n = 0;
-    for(int i = 0; i < self->entries.length; i++) {
-        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
-        if(py_isnil(&entry->key)) continue;
-        mappings[i] = n;
-        if(i != n) {
-            DictEntry* new_entry = c11__at(DictEntry, &self->entries, n);
-            *new_entry = *entry;
-        }
-        n++;
-    }
-    self->entries.length = n;
-    // update indices
-    for(uint32_t idx = 0; idx < self->capacity; idx++) {
-        uint32_t idx2 = Dict__get_index(self, idx);
-        if(idx2 == self->null_index_value) continue;
-        Dict__set_index(self, idx, mappings[idx2]);
+/// Insert a key known to be absent from the dict.
+static void Dict__insert(Dict* self, uint64_t hash, py_TValue* key, py_TValue* val) {
+    uint32_t slot = Dict__find_free_slot(self, hash);
+    if(self->growth_left == 0 && self->ctrl[slot] == Dict__CTRL_EMPTY) {
+        // out of EMPTY slots: grow, or just drop tombstones if the table is sparse
+        uint32_t live_limit = Dict__max_load(self->capacity) / 2;
+        bool is_sparse = (uint32_t)self->length < live_limit;
+        Dict__rehash(self, is_sparse ? self->capacity : self->capacity * 2);
+        slot = Dict__find_free_slot(self, hash);
     }
-    PK_FREE(mappings);
+    if(self->ctrl[slot] == Dict__CTRL_EMPTY) self->growth_left--;
+    self->ctrl[slot] = Dict__h2(hash);
+    // the first non-str key switches the dict to generic mode for good
+    if(!py_isstr(key)) self->str_keys_only = false;
+    DictEntry* new_entry = c11_vector__emplace(&self->entries);
+    new_entry->hash = hash;
+    new_entry->key = *key;
+    new_entry->val = *val;
+    Dict__set_index(self, slot, self->entries.length - 1);
+    self->length++;
 }
 
-static bool Dict__set(Dict* self, py_TValue* key, py_TValue* val) {
+bool Dict__set(Dict* self, py_TValue* key, py_TValue* val) {
     uint64_t hash;
-    uint32_t idx;
+    uint32_t slot;
     DictEntry* entry;
-    if(!Dict__probe(self, key, &hash, &idx, &entry)) return false;
+    if(!Dict__probe(self, key, &hash, &slot, &entry)) return false;
     if(entry) {
         // update existing entry
         entry->val = *val;
         return true;
     }
-    // insert new entry
-    DictEntry* new_entry = c11_vector__emplace(&self->entries);
-    new_entry->hash = hash;
-    new_entry->key = *key;
-    new_entry->val = *val;
-    Dict__set_index(self, idx, self->entries.length - 1);
-    self->length++;
-    // check if we need to rehash
-    float load_factor = (float)self->length / self->capacity;
-    if(load_factor > (self->index_is_short ? 0.3f : 0.4f)) Dict__rehash_2x(self);
+    Dict__insert(self, hash, key, val);
     return true;
 }
 
-/// Delete an entry from the dict.
-/// -1: error, 0: not found, 1: found and deleted
-static int Dict__pop(Dict* self, py_Ref key) {
-    // Dict__log_index(self, "before pop");
-    uint64_t hash;
-    uint32_t idx;
-    DictEntry* entry;
-    if(!Dict__probe(self, key, &hash, &idx, &entry)) return -1;
-    if(!entry) return 0;  // not found
-
-    // found the entry, delete and return it
+/// Delete a found entry and return its value via `py_retval()`.
+static void Dict__erase(Dict* self, uint32_t slot, DictEntry* entry) {
     py_assign(py_retval(), &entry->val);
-    Dict__set_index(self, idx, self->null_index_value);
     py_newnil(&entry->key);
     py_newnil(&entry->val);
     self->length--;
 
-    /* tidy */
-    // https://github.com/OpenHFT/Chronicle-Map/blob/820573a68471509ffc1b0584454f4a67c0be1b84/src/main/java/net/openhft/chronicle/hash/impl/CompactOffHeapLinearHashTable.java#L156
-    uint32_t mask = self->capacity - 1;
-    uint32_t posToRemove = idx;
-    uint32_t posToShift = posToRemove;
-    // int probe_count = 0;
-    // int swap_count = 0;
-    while(true) {
-        posToShift = Dict__step(posToShift);
-        uint32_t idx_z = Dict__get_index(self, posToShift);
-        if(idx_z == self->null_index_value) break;
-        uint64_t hash_z = c11__at(DictEntry, &self->entries, idx_z)->hash;
-        uint32_t insertPos = (uint64_t)hash_z % self->capacity;
-        // the following condition essentially means circular permutations
-        // of three (r = posToRemove, s = posToShift, i = insertPos)
-        // positions are accepted:
-        // [...i..r...s.] or
-        // [...r..s...i.] or
-        // [...s..i...r.]
-        bool cond1 = insertPos <= posToRemove;
-        bool cond2 = posToRemove <= posToShift;
-        if((cond1 && cond2) ||
-           // chain wrapped around capacity
-           (posToShift < insertPos && (cond1 || cond2))) {
-            Dict__swap_null_index(self, posToRemove, posToShift);
-            posToRemove = posToShift;
-            // swap_count++;
-        }
-        // probe_count++;
+    // If the group still has an EMPTY byte, no probe sequence has ever passed through it,
+    // so the slot can become EMPTY again. Otherwise leave a tombstone.
+    const uint8_t* group = self->ctrl + (slot & ~(uint32_t)(Dict__GROUP_WIDTH - 1));
+    if(Dict__match_empty(group)) {
+        self->ctrl[slot] = Dict__CTRL_EMPTY;
+        self->growth_left++;
+    } else {
+        self->ctrl[slot] = Dict__CTRL_DELETED;
     }
-    // printf("Dict__pop: probe_count=%d, swap_count=%d\n", probe_count, swap_count);
+
     // compact entries if necessary
     if(self->entries.length > 16 && (self->length < self->entries.length >> 1)) {
-        Dict__compact_entries(self);  // compact entries
+        Dict__rehash(self, self->capacity);
     }
-    // Dict__log_index(self, "after pop");
+}
+
+/// Delete an entry from the dict.
+/// -1: error, 0: not found, 1: found and deleted
+int Dict__pop(Dict* self, py_Ref key) {
+    uint64_t hash;
+    uint32_t slot;
+    DictEntry* entry;
+    if(!Dict__probe(self, key, &hash, &slot, &entry)) return -1;
+    if(!entry) return 0;  // not found
+    Dict__erase(self, slot, entry);
     return 1;
 }
 
+/// Initialize `self` as a copy of `src`.
+void Dict__copy(Dict* self, Dict* src) {
+    self->length = src->length;
+    self->capacity = src->capacity;
+    self->growth_left = src->growth_left;
+    self->index_is_short = src->index_is_short;
+    self->str_keys_only = src->str_keys_only;
+    // copy entries
+    self->entries = c11_vector__copy(&src->entries);
+    // copy control bytes and indices
+    size_t index_size = src->index_is_short ? sizeof(uint16_t) : sizeof(uint32_t);
+    size_t table_size = src->capacity * (1 + index_size);
+    self->ctrl = PK_MALLOC(table_size);
+    self->indices = self->ctrl + src->capacity;
+    memcpy(self->ctrl, src->ctrl, table_size);
+}
+
 static void DictIterator__ctor(DictIterator* self, Dict* dict, int mode) {
     assert(mode >= 0 && mode <= 2);
     self->dict = dict;
@@ -353,13 +400,13 @@ static bool dict__new__(int argc, py_Ref argv) {
     py_Type cls = py_totype(argv);
     int slots = cls == tp_dict ? 0 : -1;
     Dict* ud = py_newobject(py_retval(), cls, slots, sizeof(Dict));
-    Dict__ctor(ud, 17, 4);
+    Dict__ctor(ud, PK_DICT_MIN_CAPACITY, 4);
     return true;
 }
 
 void py_newdict(py_OutRef out) {
     Dict* ud = py_newobject(out, tp_dict, 0, sizeof(Dict));
-    Dict__ctor(ud, 17, 4);
+    Dict__ctor(ud, PK_DICT_MIN_CAPACITY, 4);
 }
 
 static bool dict__init__(int argc, py_Ref argv) {
@@ -521,17 +568,7 @@ static bool dict_copy(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     Dict* self = py_touserdata(argv);
     Dict* new_dict = py_newobject(py_retval(), tp_dict, 0, sizeof(Dict));
-    new_dict->length = self->length;
-    new_dict->capacity = self->capacity;
-    new_dict->null_index_value = self->null_index_value;
-    new_dict->index_is_short = self->index_is_short;
-    // copy entries
-    new_dict->entries = c11_vector__copy(&self->entries);
-    // copy indices
-    size_t indices_size = self->index_is_short ? self->capacity * sizeof(uint16_t)
-                                               : self->capacity * sizeof(uint32_t);
-    new_dict->indices = PK_MALLOC(indices_size);
-    memcpy(new_dict->indices, self->indices, indices_size);
+    Dict__copy(new_dict, self);
     return true;
 }
 
@@ -569,30 +606,28 @@ static bool dict_pop(int argc, py_Ref argv) {
     return true;
 }
 
+void pk_newdictiterator(py_OutRef out, py_Ref owner, int mode) {
+    Dict* self = py_touserdata(owner);
+    DictIterator* ud = py_newobject(out, tp_dict_iterator, 1, sizeof(DictIterator));
+    DictIterator__ctor(ud, self, mode);
+    py_setslot(out, 0, owner);  // keep a reference to the dict
+}
+
 static bool dict_keys(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    Dict* self = py_touserdata(argv);
-    DictIterator* ud = py_newobject(py_retval(), tp_dict_iterator, 1, sizeof(DictIterator));
-    DictIterator__ctor(ud, self, 0);
-    py_setslot(py_retval(), 0, argv);  // keep a reference to the dict
+    pk_newdictiterator(py_retval(), argv, 0);
     return true;
 }
 
 static bool dict_values(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    Dict* self = py_touserdata(argv);
-    DictIterator* ud = py_newobject(py_retval(), tp_dict_iterator, 1, sizeof(DictIterator));
-    DictIterator__ctor(ud, self, 1);
-    py_setslot(py_retval(), 0, argv);  // keep a reference to the dict
+    pk_newdictiterator(py_retval(), argv, 1);
     return true;
 }
 
 static bool dict_items(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    Dict* self = py_touserdata(argv);
-    DictIterator* ud = py_newobject(py_retval(), tp_dict_iterator, 1, sizeof(DictIterator));
-    DictIterator__ctor(ud, self, 2);
-    py_setslot(py_retval(), 0, argv);  // keep a reference to the dict
+    pk_newdictiterator(py_retval(), argv, 2);
     return true;
 }
 
@@ -693,27 +728,45 @@ int py_dict_delitem(py_Ref self, py_Ref key) {
 }
 
 int py_dict_getitem_by_str(py_Ref self, const char* key) {
-    py_Ref tmp = py_pushtmp();
-    py_newstr(tmp, key);
-    int res = py_dict_getitem(self, tmp);
-    py_pop();
-    return res;
+    assert(py_isdict(self));
+    Dict* ud = py_touserdata(self);
+    c11_sv sv = {key, strlen(key)};
+    uint32_t slot;
+    DictEntry* entry = Dict__probe_str(ud, sv, Dict__hash_str(sv), &slot);
+    if(entry) {
+        py_assign(py_retval(), &entry->val);
+        return 1;
+    }
+    return 0;
 }
 
 bool py_dict_setitem_by_str(py_Ref self, const char* key, py_Ref val) {
+    assert(py_isdict(self));
+    Dict* ud = py_touserdata(self);
+    c11_sv sv = {key, strlen(key)};
+    uint64_t hash = Dict__hash_str(sv);
+    uint32_t slot;
+    DictEntry* entry = Dict__probe_str(ud, sv, hash, &slot);
+    if(entry) {
+        entry->val = *val;
+        return true;
+    }
     py_Ref tmp = py_pushtmp();
-    py_newstr(tmp, key);
-    bool res = py_dict_setitem(self, tmp, val);
+    py_newstrv(tmp, sv);
+    Dict__insert(ud, hash, tmp, val);
     py_pop();
-    return res;
+    return true;
 }
 
 int py_dict_delitem_by_str(py_Ref self, const char* key) {
-    py_Ref tmp = py_pushtmp();
-    py_newstr(tmp, key);
-    int res = py_dict_delitem(self, tmp);
-    py_pop();
-    return res;
+    assert(py_isdict(self));
+    Dict* ud = py_touserdata(self);
+    c11_sv sv = {key, strlen(key)};
+    uint32_t slot;
+    DictEntry* entry = Dict__probe_str(ud, sv, Dict__hash_str(sv), &slot);
+    if(!entry) return 0;
+    Dict__erase(ud, slot, entry);
+    return 1;
 }
 
 int py_dict_getitem_by_int(py_Ref self, py_i64 key) {
@@ -750,4 +803,12 @@ bool py_dict_apply(py_Ref self, bool (*f)(py_Ref, py_Ref, void*), void* ctx) {
     return true;
 }
 
-#undef Dict__step
\ No newline at end of file
+
+#undef Dict__CTRL_EMPTY
+#undef Dict__CTRL_DELETED
+#undef Dict__GROUP_WIDTH
+#undef Dict__MAX_SHORT_CAPACITY
+#undef Dict__h1
+#undef Dict__h2
+#undef Dict__max_load
+#undef Dict__MASK_SHIFT
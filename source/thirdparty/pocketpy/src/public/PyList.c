@@ -350,26 +350,557 @@ static bool list_insert(int argc, py_Ref argv) {
     return true;
 }
 
-static int lt_with_key(py_TValue* a, py_TValue* b, py_TValue* key) {
-    if(!key) return py_less(a, b);
-    VM* vm = pk_current_vm;
-    // project a
-    py_push(key);
-    py_pushnil();
-    py_push(a);
-    if(!py_vectorcall(1, 0)) return -1;
-    py_push(py_retval());
-    // project b
-    py_push(key);
-    py_pushnil();
-    py_push(b);
-    if(!py_vectorcall(1, 0)) return -1;
-    py_push(py_retval());
-    // binary op
-    bool ok = pk_stack_binaryop(vm, __lt__, __gt__);
-    if(!ok) return -1;
-    py_shrink(2);
-    return py_bool(py_retval());
+/* list.sort() is a Timsort over a `SortSlice`: the keys being compared, plus an optional
+ * parallel array of values that is moved along with them when a `key` function is given.
+ * Keys are computed once per element before sorting. If every key is an int, a float or a
+ * str, the comparisons are done in C without going through `__lt__`.
+ *
+ * All buffers are owned by list objects on the stack, so the garbage collector can see every
+ * element while a comparison runs arbitrary Python code.
+ */
+#define ListSort__MIN_GALLOP 7
+#define ListSort__MAX_PENDING 85
+
+typedef struct {
+    py_TValue* keys;
+    py_TValue* values;  // NULL if there is no `key` function
+} SortSlice;
+
+typedef struct {
+    int base;
+    int length;
+} SortRun;
+
+typedef struct {
+    int (*lt)(py_TValue* a, py_TValue* b);  // -1: error, 0: false, 1: true
+    int min_gallop;
+    SortSlice tmp;  // scratch space for merges
+    int tmp_capacity;
+    py_Ref tmp_owner;  // list object owning `tmp`
+    int n_pending;
+    SortRun pending[ListSort__MAX_PENDING];
+} ListSort;
+
+static int ListSort__lt_int(py_TValue* a, py_TValue* b) { return a->_i64 < b->_i64; }
+
+static int ListSort__lt_float(py_TValue* a, py_TValue* b) { return a->_f64 < b->_f64; }
+
+static int ListSort__lt_str(py_TValue* a, py_TValue* b) {
+    return c11_sv__cmp(py_tosv(a), py_tosv(b)) < 0;
+}
+
+static int ListSort__lt_generic(py_TValue* a, py_TValue* b) { return py_less(a, b); }
+
+PK_INLINE static void SortSlice__advance(SortSlice* self, int n) {
+    self->keys += n;
+    if(self->values) self->values += n;
+}
+
+PK_INLINE static void SortSlice__copy(SortSlice* dst, int i, SortSlice* src, int j) {
+    dst->keys[i] = src->keys[j];
+    if(dst->values) dst->values[i] = src->values[j];
+}
+
+PK_INLINE static void SortSlice__memcpy(SortSlice* dst, int i, SortSlice* src, int j, int n) {
+    memcpy(dst->keys + i, src->keys + j, n * sizeof(py_TValue));
+    if(dst->values) memcpy(dst->values + i, src->values + j, n * sizeof(py_TValue));
+}
+
+PK_INLINE static void SortSlice__memmove(SortSlice* dst, int i, SortSlice* src, int j, int n) {
+    memmove(dst->keys + i, src->keys + j, n * sizeof(py_TValue));
+    if(dst->values) memmove(dst->values + i, src->values + j, n * sizeof(py_TValue));
+}
+
+static void SortSlice__reverse(SortSlice* self, int n) {
+    for(int i = 0, j = n - 1; i < j; i++, j--) {
+        py_TValue tmp = self->keys[i];
+        self->keys[i] = self->keys[j];
+        self->keys[j] = tmp;
+        if(self->values) {
+            tmp = self->values[i];
+            self->values[i] = self->values[j];
+            self->values[j] = tmp;
+        }
+    }
+}
+
+static void ListSort__ensure_tmp(ListSort* self, int need, bool has_values) {
+    if(need <= self->tmp_capacity) return;
+    int length = has_values ? need * 2 : need;
+    py_newlistn(self->tmp_owner, length);
+    py_TValue* data = py_list_data(self->tmp_owner);
+    memset(data, 0, length * sizeof(py_TValue));
+    self->tmp.keys = data;
+    self->tmp.values = has_values ? data + need : NULL;
+    self->tmp_capacity = need;
+}
+
+/// Sort `lo[0:n]` by binary insertion, given that `lo[0:start]` is already sorted.
+static bool ListSort__binary_insertion(ListSort* self, SortSlice lo, int n, int start) {
+    for(; start < n; start++) {
+        py_TValue* pivot = &lo.keys[start];
+        int l = 0, r = start;
+        while(l < r) {
+            int p = l + ((r - l) >> 1);
+            int res = self->lt(pivot, &lo.keys[p]);
+            if(res == -1) return false;
+            if(res) {
+                r = p;
+            } else {
+                l = p + 1;
+            }
+        }
+        // pivot belongs at `l`, shift `lo[l:start]` right by one
+        py_TValue key = lo.keys[start];
+        memmove(lo.keys + l + 1, lo.keys + l, (start - l) * sizeof(py_TValue));
+        lo.keys[l] = key;
+        if(lo.values) {
+            py_TValue val = lo.values[start];
+            memmove(lo.values + l + 1, lo.values + l, (start - l) * sizeof(py_TValue));
+            lo.values[l] = val;
+        }
+    }
+    return true;
+}
+
+/// Length of the run at the beginning of `lo[0:n]`, or -1 on error.
+/// A strictly descending run is reversed in place, which keeps the sort stable.
+static int ListSort__count_run(ListSort* self, SortSlice lo, int n) {
+    if(n == 1) return 1;
+    int res = self->lt(&lo.keys[1], &lo.keys[0]);
+    if(res == -1) return -1;
+    int i = 2;
+    if(res) {
+        for(; i < n; i++) {
+            res = self->lt(&lo.keys[i], &lo.keys[i - 1]);
+            if(res == -1) return -1;
+            if(!res) break;
+        }
+        SortSlice__reverse(&lo, i);
+    } else {
+        for(; i < n; i++) {
+            res = self->lt(&lo.keys[i], &lo.keys[i - 1]);
+            if(res == -1) return -1;
+            if(res) break;
+        }
+    }
+    return i;
+}
+
+/// Locate the leftmost position in sorted `a[0:n]` to insert `key`, starting near `hint`.
+/// Returns -1 on error.
+static int ListSort__gallop_left(ListSort* self, py_TValue* key, py_TValue* a, int n, int hint) {
+    int ofs = 1, lastofs = 0, res;
+    a += hint;
+    res = self->lt(a, key);
+    if(res == -1) return -1;
+    if(res) {
+        // a[hint] < key: gallop right until a[hint+lastofs] < key <= a[hint+ofs]
+        int maxofs = n - hint;
+        while(ofs < maxofs) {
+            res = self->lt(a + ofs, key);
+            if(res == -1) return -1;
+            if(!res) break;
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+            if(ofs <= 0) ofs = maxofs;  // overflow
+        }
+        if(ofs > maxofs) ofs = maxofs;
+        lastofs += hint;
+        ofs += hint;
+    } else {
+        // key <= a[hint]: gallop left until a[hint-ofs] < key <= a[hint-lastofs]
+        int maxofs = hint + 1;
+        while(ofs < maxofs) {
+            res = self->lt(a - ofs, key);
+            if(res == -1) return -1;
+            if(res) break;
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+            if(ofs <= 0) ofs = maxofs;
+        }
+        if(ofs > maxofs) ofs = maxofs;
+        int k = lastofs;
+        lastofs = hint - ofs;
+        ofs = hint - k;
+    }
+    a -= hint;
+    // a[lastofs] < key <= a[ofs], binary search in between
+    lastofs++;
+    while(lastofs < ofs) {
+        int m = lastofs + ((ofs - lastofs) >> 1);
+        res = self->lt(a + m, key);
+        if(res == -1) return -1;
+        if(res) {
+            lastofs = m + 1;
+        } else {
+            ofs = m;
+        }
+    }
+    return ofs;
+}
+
+/// Like `ListSort__gallop_left`, but returns the rightmost position.
+static int ListSort__gallop_right(ListSort* self, py_TValue* key, py_TValue* a, int n, int hint) {
+    int ofs = 1, lastofs = 0, res;
+    a += hint;
+    res = self->lt(key, a);
+    if(res == -1) return -1;
+    if(res) {
+        // key < a[hint]: gallop left until a[hint-ofs] <= key < a[hint-lastofs]
+        int maxofs = hint + 1;
+        while(ofs < maxofs) {
+            res = self->lt(key, a - ofs);
+            if(res == -1) return -1;
+            if(!res) break;
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+            if(ofs <= 0) ofs = maxofs;
+        }
+        if(ofs > maxofs) ofs = maxofs;
+        int k = lastofs;
+        lastofs = hint - ofs;
+        ofs = hint - k;
+    } else {
+        // a[hint] <= key: gallop right until a[hint+lastofs] <= key < a[hint+ofs]
+        int maxofs = n - hint;
+        while(ofs < maxofs) {
+            res = self->lt(key, a + ofs);
+            if(res == -1) return -1;
+            if(res) break;
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+            if(ofs <= 0) ofs = maxofs;
+        }
+        if(ofs > maxofs) ofs = maxofs;
+        lastofs += hint;
+        ofs += hint;
+    }
+    a -= hint;
+    // a[lastofs] <= key < a[ofs], binary search in between
+    lastofs++;
+    while(lastofs < ofs) {
+        int m = lastofs + ((ofs - lastofs) >> 1);
+        res = self->lt(key, a + m);
+        if(res == -1) return -1;
+        if(res) {
+            ofs = m;
+        } else {
+            lastofs = m + 1;
+        }
+    }
+    return ofs;
+}
+
+/// Merge the adjacent runs `a[0:na]` and `b[0:nb]` in place, with `na <= nb`.
+/// `a[0]` belongs at the front and `a[na-1]` belongs after `b[0]`.
+static bool ListSort__merge_lo(ListSort* self, SortSlice a, int na, SortSlice b, int nb) {
+    ListSort__ensure_tmp(self, na, a.values != NULL);
+    SortSlice dest = a;
+    SortSlice tmp = self->tmp;
+    SortSlice__memcpy(&tmp, 0, &a, 0, na);
+    a = tmp;
+
+    SortSlice__copy(&dest, 0, &b, 0);
+    SortSlice__advance(&dest, 1);
+    SortSlice__advance(&b, 1);
+    nb--;
+    if(nb == 0) goto __SUCCEED;
+    if(na == 1) goto __COPY_B;
+
+    int min_gallop = self->min_gallop;
+    while(true) {
+        int acount = 0, bcount = 0;  // number of times a or b won in a row
+        // straightforward merge until one run appears to win consistently
+        while(true) {
+            int res = self->lt(b.keys, a.keys);
+            if(res == -1) goto __FAIL;
+            if(res) {
+                SortSlice__copy(&dest, 0, &b, 0);
+                SortSlice__advance(&dest, 1);
+                SortSlice__advance(&b, 1);
+                bcount++;
+                acount = 0;
+                if(--nb == 0) goto __SUCCEED;
+                if(bcount >= min_gallop) break;
+            } else {
+                SortSlice__copy(&dest, 0, &a, 0);
+                SortSlice__advance(&dest, 1);
+                SortSlice__advance(&a, 1);
+                acount++;
+                bcount = 0;
+                if(--na == 1) goto __COPY_B;
+                if(acount >= min_gallop) break;
+            }
+        }
+        // galloping, until neither run wins often
+        min_gallop++;
+        do {
+            min_gallop -= min_gallop > 1;
+            self->min_gallop = min_gallop;
+            int k = ListSort__gallop_right(self, b.keys, a.keys, na, 0);
+            acount = k;
+            if(k) {
+                if(k < 0) goto __FAIL;
+                SortSlice__memcpy(&dest, 0, &a, 0, k);
+                SortSlice__advance(&dest, k);
+                SortSlice__advance(&a, k);
+                na -= k;
+                if(na == 1) goto __COPY_B;
+                // na == 0 is impossible as a[na-1] belongs after b[0]
+                if(na == 0) goto __SUCCEED;
+            }
+            SortSlice__copy(&dest, 0, &b, 0);
+            SortSlice__advance(&dest, 1);
+            SortSlice__advance(&b, 1);
+            if(--nb == 0) goto __SUCCEED;
+
+            k = ListSort__gallop_left(self, a.keys, b.keys, nb, 0);
+            bcount = k;
+            if(k) {
+                if(k < 0) goto __FAIL;
+                SortSlice__memmove(&dest, 0, &b, 0, k);
+                SortSlice__advance(&dest, k);
+                SortSlice__advance(&b, k);
+                nb -= k;
+                if(nb == 0) goto __SUCCEED;
+            }
+            SortSlice__copy(&dest, 0, &a, 0);
+            SortSlice__advance(&dest, 1);
+            SortSlice__advance(&a, 1);
+            if(--na == 1) goto __COPY_B;
+        } while(acount >= ListSort__MIN_GALLOP || bcount >= ListSort__MIN_GALLOP);
+        min_gallop++;  // penalize leaving galloping mode
+        self->min_gallop = min_gallop;
+    }
+__SUCCEED:
+    if(na) SortSlice__memcpy(&dest, 0, &a, 0, na);
+    return true;
+__FAIL:
+    // put the rest of `a` back, so that the list still holds every element
+    if(na) SortSlice__memcpy(&dest, 0, &a, 0, na);
+    return false;
+__COPY_B:
+    // the last element of a belongs at the end of the merge
+    SortSlice__memmove(&dest, 0, &b, 0, nb);
+    SortSlice__copy(&dest, nb, &a, 0);
+    return true;
+}
+
+/// Merge the adjacent runs `a[0:na]` and `b[0:nb]` in place, with `na >= nb`.
+/// `a[0]` belongs at the front and `a[na-1]` belongs after `b[0]`.
+static bool ListSort__merge_hi(ListSort* self, SortSlice a, int na, SortSlice b, int nb) {
+    ListSort__ensure_tmp(self, nb, a.values != NULL);
+    SortSlice dest = b;
+    SortSlice__advance(&dest, nb - 1);
+    SortSlice tmp = self->tmp;
+    SortSlice__memcpy(&tmp, 0, &b, 0, nb);
+    SortSlice basea = a;
+    SortSlice baseb = tmp;
+    b = tmp;
+    SortSlice__advance(&b, nb - 1);
+    SortSlice__advance(&a, na - 1);
+
+    SortSlice__copy(&dest, 0, &a, 0);
+    SortSlice__advance(&dest, -1);
+    SortSlice__advance(&a, -1);
+    na--;
+    if(na == 0) goto __SUCCEED;
+    if(nb == 1) goto __COPY_A;
+
+    int min_gallop = self->min_gallop;
+    while(true) {
+        int acount = 0, bcount = 0;
+        while(true) {
+            int res = self->lt(b.keys, a.keys);
+            if(res == -1) goto __FAIL;
+            if(res) {
+                SortSlice__copy(&dest, 0, &a, 0);
+                SortSlice__advance(&dest, -1);
+                SortSlice__advance(&a, -1);
+                acount++;
+                bcount = 0;
+                if(--na == 0) goto __SUCCEED;
+                if(acount >= min_gallop) break;
+            } else {
+                SortSlice__copy(&dest, 0, &b, 0);
+                SortSlice__advance(&dest, -1);
+                SortSlice__advance(&b, -1);
+                bcount++;
+                acount = 0;
+                if(--nb == 1) goto __COPY_A;
+                if(bcount >= min_gallop) break;
+            }
+        }
+        min_gallop++;
+        do {
+            min_gallop -= min_gallop > 1;
+            self->min_gallop = min_gallop;
+            int k = ListSort__gallop_right(self, b.keys, basea.keys, na, na - 1);
+            if(k < 0) goto __FAIL;
+            k = na - k;
+            acount = k;
+            if(k) {
+                SortSlice__advance(&dest, -k);
+                SortSlice__advance(&a, -k);
+                SortSlice__memmove(&dest, 1, &a, 1, k);
+                na -= k;
+                if(na == 0) goto __SUCCEED;
+            }
+            SortSlice__copy(&dest, 0, &b, 0);
+            SortSlice__advance(&dest, -1);
+            SortSlice__advance(&b, -1);
+            if(--nb == 1) goto __COPY_A;
+
+            k = ListSort__gallop_left(self, a.keys, baseb.keys, nb, nb - 1);
+            if(k < 0) goto __FAIL;
+            k = nb - k;
+            bcount = k;
+            if(k) {
+                SortSlice__advance(&dest, -k);
+                SortSlice__advance(&b, -k);
+                SortSlice__memcpy(&dest, 1, &b, 1, k);
+                nb -= k;
+                if(nb == 1) goto __COPY_A;
+                // nb == 0 is impossible as b[0] belongs before a[na-1]
+                if(nb == 0) goto __SUCCEED;
+            }
+            SortSlice__copy(&dest, 0, &a, 0);
+            SortSlice__advance(&dest, -1);
+            SortSlice__advance(&a, -1);
+            if(--na == 0) goto __SUCCEED;
+        } while(acount >= ListSort__MIN_GALLOP || bcount >= ListSort__MIN_GALLOP);
+        min_gallop++;
+        self->min_gallop = min_gallop;
+    }
+__SUCCEED:
+    if(nb) SortSlice__memcpy(&dest, -(nb - 1), &baseb, 0, nb);
+    return true;
+__FAIL:
+    if(nb) SortSlice__memcpy(&dest, -(nb - 1), &baseb, 0, nb);
+    return false;
+__COPY_A:
+    // the first element of b belongs at the front of the merge
+    SortSlice__advance(&dest, -na);
+    SortSlice__advance(&a, -na);
+    SortSlice__memmove(&dest, 1, &a, 1, na);
+    SortSlice__copy(&dest, 0, &b, 0);
+    return true;
+}
+
+/// Merge the pending runs at `i` and `i + 1`.
+static bool ListSort__merge_at(ListSort* self, SortSlice base, int i) {
+    SortSlice a = base, b = base;
+    int na = self->pending[i].length;
+    int nb = self->pending[i + 1].length;
+    SortSlice__advance(&a, self->pending[i].base);
+    SortSlice__advance(&b, self->pending[i + 1].base);
+
+    self->pending[i].length = na + nb;
+    if(i == self->n_pending - 3) self->pending[i + 1] = self->pending[i + 2];
+    self->n_pending--;
+
+    // elements of a already in place
+    int k = ListSort__gallop_right(self, b.keys, a.keys, na, 0);
+    if(k < 0) return false;
+    SortSlice__advance(&a, k);
+    na -= k;
+    if(na == 0) return true;
+    // elements of b already in place
+    nb = ListSort__gallop_left(self, &a.keys[na - 1], b.keys, nb, nb - 1);
+    if(nb <= 0) return nb == 0;
+    if(na <= nb) return ListSort__merge_lo(self, a, na, b, nb);
+    return ListSort__merge_hi(self, a, na, b, nb);
+}
+
+/// Restore the run length invariants on the pending stack:
+/// len[-3] > len[-2] + len[-1] and len[-2] > len[-1].
+static bool ListSort__merge_collapse(ListSort* self, SortSlice base) {
+    SortRun* p = self->pending;
+    while(self->n_pending > 1) {
+        int n = self->n_pending - 2;
+        if((n > 0 && p[n - 1].length <= p[n].length + p[n + 1].length) ||
+           (n > 1 && p[n - 2].length <= p[n - 1].length + p[n].length)) {
+            if(p[n - 1].length < p[n + 1].length) n--;
+        } else if(p[n].length > p[n + 1].length) {
+            break;
+        }
+        if(!ListSort__merge_at(self, base, n)) return false;
+    }
+    return true;
+}
+
+static bool ListSort__merge_force_collapse(ListSort* self, SortSlice base) {
+    SortRun* p = self->pending;
+    while(self->n_pending > 1) {
+        int n = self->n_pending - 2;
+        if(n > 0 && p[n - 1].length < p[n + 1].length) n--;
+        if(!ListSort__merge_at(self, base, n)) return false;
+    }
+    return true;
+}
+
+/// Minimum run length: n/2^k rounded up, within [32, 64], so that the runs merge evenly.
+static int ListSort__min_run(int n) {
+    int r = 0;
+    while(n >= 64) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/// Pick the fastest comparison valid for all `keys`.
+static int (*ListSort__select_lt(py_TValue* keys, int n))(py_TValue*, py_TValue*) {
+    py_Type type = keys[0].type;
+    if(type != tp_int && type != tp_float && type != tp_str) return ListSort__lt_generic;
+    for(int i = 1; i < n; i++) {
+        if(keys[i].type != type) return ListSort__lt_generic;
+    }
+    switch(type) {
+        case tp_int: return ListSort__lt_int;
+        case tp_float: return ListSort__lt_float;
+        case tp_str: return ListSort__lt_str;
+        default: c11__unreachable();
+    }
+}
+
+/// Stable sort of `keys[0:n]`, moving `values` (if not NULL) along with them.
+/// `tmp_owner` is a stack slot used to keep the scratch buffer alive.
+static bool ListSort__sort(py_TValue* keys, py_TValue* values, int n, py_Ref tmp_owner) {
+    if(n < 2) return true;
+    ListSort self;
+    self.lt = ListSort__select_lt(keys, n);
+    self.min_gallop = ListSort__MIN_GALLOP;
+    self.tmp.keys = self.tmp.values = NULL;
+    self.tmp_capacity = 0;
+    self.tmp_owner = tmp_owner;
+    self.n_pending = 0;
+
+    SortSlice base = {keys, values};
+    SortSlice lo = base;
+    int remaining = n;
+    int min_run = ListSort__min_run(n);
+    do {
+        int run = ListSort__count_run(&self, lo, remaining);
+        if(run < 0) return false;
+        // extend short runs to min(min_run, remaining)
+        if(run < min_run) {
+            int force = remaining <= min_run ? remaining : min_run;
+            if(!ListSort__binary_insertion(&self, lo, force, run)) return false;
+            run = force;
+        }
+        assert(self.n_pending < ListSort__MAX_PENDING);
+        self.pending[self.n_pending].base = (int)(lo.keys - keys);
+        self.pending[self.n_pending].length = run;
+        self.n_pending++;
+        if(!ListSort__merge_collapse(&self, base)) return false;
+        SortSlice__advance(&lo, run);
+        remaining -= run;
+    } while(remaining);
+    if(!ListSort__merge_force_collapse(&self, base)) return false;
+    assert(self.n_pending == 1 && self.pending[0].length == n);
+    return true;
 }
 
 // sort(self, key=None, reverse=False)
@@ -378,17 +909,52 @@ static bool list_sort(int argc, py_Ref argv) {
 
     py_Ref key = py_arg(1);
     if(py_isnone(key)) key = NULL;
-
-    bool ok = c11__stable_sort(self->data,
-                               self->length,
-                               sizeof(py_TValue),
-                               (int (*)(const void*, const void*, void*))lt_with_key,
-                               key);
-    if(!ok) return false;
-
     PY_CHECK_ARG_TYPE(2, tp_bool);
     bool reverse = py_tobool(py_arg(2));
-    if(reverse) c11__reverse(py_TValue, self);
+
+    // Sort a detached copy, so that comparisons can not resize the list under us.
+    // [items, keys, tmp]
+    py_Ref items_owner = py_pushtmp();
+    py_newlist(items_owner);
+    List* items = py_touserdata(items_owner);
+    List detached = *items;
+    *items = *self;
+    *self = detached;
+
+    // reverse before and after sorting, so that equal elements keep their order
+    if(reverse) c11__reverse(py_TValue, items);
+
+    int n = items->length;
+    bool ok = true;
+    py_TValue* keys = items->data;
+    py_TValue* values = NULL;
+    if(key && n > 0) {
+        py_Ref keys_owner = py_pushtmp();
+        py_newlistn(keys_owner, n);
+        keys = py_list_data(keys_owner);
+        memset(keys, 0, n * sizeof(py_TValue));
+        values = items->data;
+        for(int i = 0; i < n; i++) {
+            ok = py_call(key, 1, &values[i]);
+            if(!ok) break;
+            keys[i] = *py_retval();
+        }
+    } else {
+        py_pushnone();
+    }
+    py_Ref tmp = py_pushtmp();
+    if(ok) ok = ListSort__sort(keys, values, n, tmp);
+
+    if(reverse) c11__reverse(py_TValue, items);
+
+    // put the elements back
+    bool modified = self->length != 0;
+    detached = *self;
+    *self = *items;
+    *items = detached;
+    py_shrink(3);
+    if(!ok) return false;
+    if(modified) return ValueError("list modified during sort");
     py_newnone(py_retval());
     return true;
 }
@@ -442,3 +1008,6 @@ py_Type pk_list__register() {
     py_setdict(py_tpobject(type), __hash__, py_None());
     return type;
 }
+
+#undef ListSort__MIN_GALLOP
+#undef ListSort__MAX_PENDING
@@ -0,0 +1,618 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/sstream.h"
+#include "pocketpy/interpreter/types.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* `set` and `frozenset` store their elements as the keys of a `Dict`, whose values are all
+ * `None`. Both types share the dict's hash table, so hashing and probing rules are identical.
+ */
+
+static bool Set__is_setlike(py_Ref self) {
+    return py_isinstance(self, tp_set) || py_isinstance(self, tp_frozenset);
+}
+
+/// The builtin type of the result of a set operation on `self`.
+static py_Type Set__result_type(py_Ref self) {
+    return py_isinstance(self, tp_frozenset) ? tp_frozenset : tp_set;
+}
+
+static Dict* Set__new(py_OutRef out, py_Type type) {
+    int slots = (type == tp_set || type == tp_frozenset) ? 0 : -1;
+    Dict* ud = py_newobject(out, type, slots, sizeof(Dict));
+    Dict__ctor(ud, PK_DICT_MIN_CAPACITY, 4);
+    return ud;
+}
+
+PK_INLINE static bool Set__add(Dict* self, py_Ref key) { return Dict__set(self, key, py_None()); }
+
+/// -1: error, 0: not found, 1: found
+static int Set__contains(Dict* self, py_Ref key) {
+    DictEntry* entry;
+    if(!Dict__try_get(self, key, &entry)) return -1;
+    return entry != NULL;
+}
+
+/// Add every element of `iterable` to `self`. `self` must be reachable from the stack.
+static bool Set__update(Dict* self, py_Ref iterable) {
+    if(Set__is_setlike(iterable) || py_isinstance(iterable, tp_dict)) {
+        Dict* other = py_touserdata(iterable);
+        for(int i = 0; i < other->entries.length; i++) {
+            DictEntry* entry = c11__at(DictEntry, &other->entries, i);
+            if(py_isnil(&entry->key)) continue;
+            if(!Set__add(self, &entry->key)) return false;
+        }
+        return true;
+    }
+    py_TValue* p;
+    int length = pk_arrayview(iterable, &p);
+    if(length != -1) {
+        for(int i = 0; i < length; i++) {
+            if(!Set__add(self, p + i)) return false;
+        }
+        return true;
+    }
+    if(!py_iter(iterable)) return false;
+    py_push(py_retval());
+    py_Ref item = py_pushtmp();
+    while(true) {
+        int res = py_next(py_peek(-2));
+        if(res == -1) return false;
+        if(res == 0) break;
+        // `py_hash` may clobber `py_retval()`
+        py_assign(item, py_retval());
+        if(!Set__add(self, item)) return false;
+    }
+    py_shrink(2);
+    return true;
+}
+
+/// Create a new set of `type` from `iterable` into `py_retval()`.
+static bool Set__from_iterable(py_Type type, py_Ref iterable) {
+    py_Ref tmp = py_pushtmp();
+    Dict* ud = Set__new(tmp, type);
+    if(!Set__update(ud, iterable)) return false;
+    py_assign(py_retval(), tmp);
+    py_pop();
+    return true;
+}
+
+/// Push `other` as a set-like object onto the stack, converting it if necessary.
+static bool Set__push_setlike(py_Ref other) {
+    if(Set__is_setlike(other)) {
+        py_push(other);
+        return true;
+    }
+    if(!Set__from_iterable(tp_frozenset, other)) return false;
+    py_push(py_retval());
+    return true;
+}
+
+/// -1: error, 0: false, 1: true
+static int Set__issubset(Dict* self, Dict* other) {
+    if(self->length > other->length) return 0;
+    for(int i = 0; i < self->entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        int res = Set__contains(other, &entry->key);
+        if(res != 1) return res;
+    }
+    return 1;
+}
+
+/// Add the elements of `self` which are (or are not) in `other` to `out`.
+static bool Set__filter(Dict* out, Dict* self, Dict* other, bool keep_common) {
+    for(int i = 0; i < self->entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        int res = Set__contains(other, &entry->key);
+        if(res == -1) return false;
+        if(res == keep_common) {
+            if(!Set__add(out, &entry->key)) return false;
+        }
+    }
+    return true;
+}
+
+typedef enum {
+    SetOp_UNION,
+    SetOp_INTERSECTION,
+    SetOp_DIFFERENCE,
+    SetOp_SYMMETRIC_DIFFERENCE,
+} SetOp;
+
+/// Compute `lhs <op> rhs` into `py_retval()`. Both operands must be set-like.
+static bool Set__binaryop(py_Ref lhs, py_Ref rhs, SetOp op) {
+    Dict* a = py_touserdata(lhs);
+    Dict* b = py_touserdata(rhs);
+    py_Ref tmp = py_pushtmp();
+    Dict* out;
+    bool ok;
+    switch(op) {
+        case SetOp_UNION:
+            out = py_newobject(tmp, Set__result_type(lhs), 0, sizeof(Dict));
+            Dict__copy(out, a);
+            ok = Set__update(out, rhs);
+            break;
+        case SetOp_INTERSECTION:
+            out = Set__new(tmp, Set__result_type(lhs));
+            // probe the larger set with the elements of the smaller one
+            ok = a->length <= b->length ? Set__filter(out, a, b, true)
+                                        : Set__filter(out, b, a, true);
+            break;
+        case SetOp_DIFFERENCE:
+            out = Set__new(tmp, Set__result_type(lhs));
+            ok = Set__filter(out, a, b, false);
+            break;
+        case SetOp_SYMMETRIC_DIFFERENCE:
+            out = Set__new(tmp, Set__result_type(lhs));
+            ok = Set__filter(out, a, b, false) && Set__filter(out, b, a, false);
+            break;
+        default: c11__unreachable();
+    }
+    if(!ok) return false;
+    py_assign(py_retval(), tmp);
+    py_pop();
+    return true;
+}
+
+/// Apply `op` to `self` and each of `argv[0:argc]`, which can be any iterables.
+static bool Set__binaryop_many(py_Ref self, int argc, py_Ref argv, SetOp op) {
+    py_push(self);
+    for(int i = 0; i < argc; i++) {
+        if(op == SetOp_UNION) {
+            // no need to build a temporary set for union
+            Dict* tmp = py_newobject(py_retval(), Set__result_type(self), 0, sizeof(Dict));
+            Dict__copy(tmp, py_touserdata(py_peek(-1)));
+            py_assign(py_peek(-1), py_retval());
+            if(!Set__update(tmp, &argv[i])) return false;
+            continue;
+        }
+        if(!Set__push_setlike(&argv[i])) return false;
+        if(!Set__binaryop(py_peek(-2), py_peek(-1), op)) return false;
+        py_pop();
+        py_assign(py_peek(-1), py_retval());
+    }
+    if(argc == 0) {
+        // always return a new object, like `copy()`
+        Dict* tmp = py_newobject(py_retval(), Set__result_type(self), 0, sizeof(Dict));
+        Dict__copy(tmp, py_touserdata(self));
+        py_pop();
+        return true;
+    }
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+/* magic methods shared by set and frozenset */
+
+static bool set__len__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    py_newint(py_retval(), self->length);
+    return true;
+}
+
+static bool set__contains__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Set__contains(py_touserdata(argv), py_arg(1));
+    if(res == -1) return false;
+    py_newbool(py_retval(), res);
+    return true;
+}
+
+static bool set__iter__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    pk_newdictiterator(py_retval(), argv, 0);
+    return true;
+}
+
+static bool set__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    bool is_plain = argv->type == tp_set;
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    if(!is_plain) {
+        c11_sbuf__write_sv(&buf, py_name2sv(pk_typeinfo(argv->type)->name));
+        c11_sbuf__write_char(&buf, '(');
+    }
+    if(self->length == 0) {
+        if(is_plain) c11_sbuf__write_cstr(&buf, "set(");
+        c11_sbuf__write_char(&buf, ')');
+        c11_sbuf__py_submit(&buf, py_retval());
+        return true;
+    }
+    c11_sbuf__write_char(&buf, '{');
+    bool is_first = true;
+    for(int i = 0; i < self->entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        if(!is_first) c11_sbuf__write_cstr(&buf, ", ");
+        if(!py_repr(&entry->key)) {
+            c11_sbuf__dtor(&buf);
+            return false;
+        }
+        c11_sbuf__write_sv(&buf, py_tosv(py_retval()));
+        is_first = false;
+    }
+    c11_sbuf__write_char(&buf, '}');
+    if(!is_plain) c11_sbuf__write_char(&buf, ')');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+#define DEF_SET_COMPARE(name, expr)                                                                \
+    static bool set__##name##__(int argc, py_Ref argv) {                                           \
+        PY_CHECK_ARGC(2);                                                                          \
+        if(!Set__is_setlike(py_arg(1))) {                                                              \
+            py_newnotimplemented(py_retval());                                                     \
+            return true;                                                                           \
+        }                                                                                          \
+        Dict* a = py_touserdata(py_arg(0));                                                        \
+        Dict* b = py_touserdata(py_arg(1));                                                        \
+        int res = expr;                                                                            \
+        if(res == -1) return false;                                                                \
+        py_newbool(py_retval(), res);                                                              \
+        return true;                                                                               \
+    }
+
+DEF_SET_COMPARE(eq, a->length != b->length ? 0 : Set__issubset(a, b))
+DEF_SET_COMPARE(le, Set__issubset(a, b))
+DEF_SET_COMPARE(lt, a->length >= b->length ? 0 : Set__issubset(a, b))
+DEF_SET_COMPARE(ge, Set__issubset(b, a))
+DEF_SET_COMPARE(gt, a->length <= b->length ? 0 : Set__issubset(b, a))
+
+static bool set__ne__(int argc, py_Ref argv) {
+    if(!set__eq__(argc, argv)) return false;
+    if(py_isbool(py_retval())) {
+        bool res = py_tobool(py_retval());
+        py_newbool(py_retval(), !res);
+    }
+    return true;
+}
+
+#define DEF_SET_BINARY_OP(name, op)                                                                \
+    static bool set__##name##__(int argc, py_Ref argv) {                                           \
+        PY_CHECK_ARGC(2);                                                                          \
+        if(!Set__is_setlike(py_arg(1))) {                                                              \
+            py_newnotimplemented(py_retval());                                                     \
+            return true;                                                                           \
+        }                                                                                          \
+        return Set__binaryop(py_arg(0), py_arg(1), op);                                            \
+    }
+
+DEF_SET_BINARY_OP(or, SetOp_UNION)
+DEF_SET_BINARY_OP(and, SetOp_INTERSECTION)
+DEF_SET_BINARY_OP(sub, SetOp_DIFFERENCE)
+DEF_SET_BINARY_OP(xor, SetOp_SYMMETRIC_DIFFERENCE)
+
+static bool set__reduce__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    py_Ref p = py_newtuple(py_pushtmp(), 2);
+    py_assign(&p[0], py_tpobject(argv->type));
+    py_Ref elems = py_newtuple(&p[1], 1);
+    py_newlistn(&elems[0], self->length);
+    int j = 0;
+    for(int i = 0; i < self->entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        py_list_setitem(&elems[0], j++, &entry->key);
+    }
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+/* methods shared by set and frozenset */
+
+static bool set_copy(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    Dict* ud = py_newobject(py_retval(), Set__result_type(argv), 0, sizeof(Dict));
+    Dict__copy(ud, self);
+    return true;
+}
+
+static bool set_union(int argc, py_Ref argv) {
+    return Set__binaryop_many(argv, argc - 1, argv + 1, SetOp_UNION);
+}
+
+static bool set_intersection(int argc, py_Ref argv) {
+    return Set__binaryop_many(argv, argc - 1, argv + 1, SetOp_INTERSECTION);
+}
+
+static bool set_difference(int argc, py_Ref argv) {
+    return Set__binaryop_many(argv, argc - 1, argv + 1, SetOp_DIFFERENCE);
+}
+
+static bool set_symmetric_difference(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    return Set__binaryop_many(argv, 1, argv + 1, SetOp_SYMMETRIC_DIFFERENCE);
+}
+
+static bool set_isdisjoint(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    Dict* self = py_touserdata(argv);
+    py_TValue* p;
+    int length = pk_arrayview(py_arg(1), &p);
+    if(length == -1) {
+        if(!Set__push_setlike(py_arg(1))) return false;
+        Dict* other = py_touserdata(py_peek(-1));
+        // probe the larger set with the elements of the smaller one
+        Dict* small = self->length <= other->length ? self : other;
+        Dict* large = small == self ? other : self;
+        for(int i = 0; i < small->entries.length; i++) {
+            DictEntry* entry = c11__at(DictEntry, &small->entries, i);
+            if(py_isnil(&entry->key)) continue;
+            int res = Set__contains(large, &entry->key);
+            if(res == -1) return false;
+            if(res == 1) {
+                py_pop();
+                py_newbool(py_retval(), false);
+                return true;
+            }
+        }
+        py_pop();
+        py_newbool(py_retval(), true);
+        return true;
+    }
+    for(int i = 0; i < length; i++) {
+        int res = Set__contains(self, p + i);
+        if(res == -1) return false;
+        if(res == 1) {
+            py_newbool(py_retval(), false);
+            return true;
+        }
+    }
+    py_newbool(py_retval(), true);
+    return true;
+}
+
+static bool set_issubset(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Set__push_setlike(py_arg(1))) return false;
+    int res = Set__issubset(py_touserdata(argv), py_touserdata(py_peek(-1)));
+    if(res == -1) return false;
+    py_pop();
+    py_newbool(py_retval(), res);
+    return true;
+}
+
+static bool set_issuperset(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Set__push_setlike(py_arg(1))) return false;
+    int res = Set__issubset(py_touserdata(py_peek(-1)), py_touserdata(argv));
+    if(res == -1) return false;
+    py_pop();
+    py_newbool(py_retval(), res);
+    return true;
+}
+
+/* set only */
+
+static bool set__new__(int argc, py_Ref argv) {
+    Set__new(py_retval(), py_totype(argv));
+    return true;
+}
+
+static bool set__init__(int argc, py_Ref argv) {
+    if(argc > 2) return TypeError("set() takes at most 1 argument (%d given)", argc - 1);
+    Dict* self = py_touserdata(argv);
+    Dict__clear(self);
+    if(argc == 2 && !Set__update(self, py_arg(1))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_add(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Set__add(py_touserdata(argv), py_arg(1))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_discard(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(Dict__pop(py_touserdata(argv), py_arg(1)) == -1) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_remove(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Dict__pop(py_touserdata(argv), py_arg(1));
+    if(res == -1) return false;
+    if(res == 0) return KeyError(py_arg(1));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_pop(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    // the last live entry is the cheapest one to remove
+    for(int i = self->entries.length - 1; i >= 0; i--) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        py_Ref key = py_pushtmp();
+        py_assign(key, &entry->key);
+        int res = Dict__pop(self, key);
+        if(res == -1) return false;
+        assert(res == 1);
+        py_assign(py_retval(), key);
+        py_pop();
+        return true;
+    }
+    py_Ref msg = py_pushtmp();
+    py_newstr(msg, "pop from an empty set");
+    return KeyError(msg);
+}
+
+static bool set_clear(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict__clear(py_touserdata(argv));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_update(int argc, py_Ref argv) {
+    Dict* self = py_touserdata(argv);
+    for(int i = 1; i < argc; i++) {
+        if(!Set__update(self, py_arg(i))) return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+/// Replace the content of `self` with the result of a set operation in `py_retval()`.
+static void Set__assign(py_Ref self, py_Ref result) {
+    Dict* ud = py_touserdata(self);
+    Dict__dtor(ud);
+    Dict__copy(ud, py_touserdata(result));
+}
+
+static bool set_intersection_update(int argc, py_Ref argv) {
+    if(!Set__binaryop_many(argv, argc - 1, argv + 1, SetOp_INTERSECTION)) return false;
+    Set__assign(argv, py_retval());
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_difference_update(int argc, py_Ref argv) {
+    if(!Set__binaryop_many(argv, argc - 1, argv + 1, SetOp_DIFFERENCE)) return false;
+    Set__assign(argv, py_retval());
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_symmetric_difference_update(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Set__binaryop_many(argv, 1, argv + 1, SetOp_SYMMETRIC_DIFFERENCE)) return false;
+    Set__assign(argv, py_retval());
+    py_newnone(py_retval());
+    return true;
+}
+
+/* frozenset only */
+
+static bool frozenset__new__(int argc, py_Ref argv) {
+    if(argc > 2) return TypeError("frozenset() takes at most 1 argument (%d given)", argc - 1);
+    py_Type cls = py_totype(argv);
+    if(argc == 1) {
+        Set__new(py_retval(), cls);
+        return true;
+    }
+    // frozenset is immutable, so an exact frozenset can be shared
+    if(cls == tp_frozenset && py_istype(py_arg(1), tp_frozenset)) {
+        py_assign(py_retval(), py_arg(1));
+        return true;
+    }
+    return Set__from_iterable(cls, py_arg(1));
+}
+
+static bool frozenset__hash__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    // order independent, the per-element shuffle keeps `{a, b}` and `{c, d}` apart
+    // even when `a ^ b == c ^ d`
+    uint64_t x = 0;
+    for(int i = 0; i < self->entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        uint64_t h = entry->hash;
+        x ^= ((h ^ 89869747ULL) ^ (h << 16)) * 3644798167ULL;
+    }
+    x ^= ((uint64_t)self->length + 1) * 1927868237ULL;
+    py_newint(py_retval(), (py_i64)x);
+    return true;
+}
+
+static void Set__bind_common(py_Type type) {
+    py_bindmagic(type, __len__, set__len__);
+    py_bindmagic(type, __contains__, set__contains__);
+    py_bindmagic(type, __iter__, set__iter__);
+    py_bindmagic(type, __repr__, set__repr__);
+    py_bindmagic(type, __eq__, set__eq__);
+    py_bindmagic(type, __ne__, set__ne__);
+    py_bindmagic(type, __le__, set__le__);
+    py_bindmagic(type, __lt__, set__lt__);
+    py_bindmagic(type, __ge__, set__ge__);
+    py_bindmagic(type, __gt__, set__gt__);
+    py_bindmagic(type, __or__, set__or__);
+    py_bindmagic(type, __and__, set__and__);
+    py_bindmagic(type, __sub__, set__sub__);
+    py_bindmagic(type, __xor__, set__xor__);
+    py_bindmagic(type, __reduce__, set__reduce__);
+
+    py_bindmethod(type, "copy", set_copy);
+    py_bindmethod(type, "union", set_union);
+    py_bindmethod(type, "intersection", set_intersection);
+    py_bindmethod(type, "difference", set_difference);
+    py_bindmethod(type, "symmetric_difference", set_symmetric_difference);
+    py_bindmethod(type, "isdisjoint", set_isdisjoint);
+    py_bindmethod(type, "issubset", set_issubset);
+    py_bindmethod(type, "issuperset", set_issuperset);
+}
+
+py_Type pk_set__register() {
+    py_Type type = pk_newtype("set", tp_object, NULL, (void (*)(void*))Dict__dtor, false, false);
+    Set__bind_common(type);
+
+    py_bindmagic(type, __new__, set__new__);
+    py_bindmagic(type, __init__, set__init__);
+
+    py_bindmethod(type, "add", set_add);
+    py_bindmethod(type, "discard", set_discard);
+    py_bindmethod(type, "remove", set_remove);
+    py_bindmethod(type, "pop", set_pop);
+    py_bindmethod(type, "clear", set_clear);
+    py_bindmethod(type, "update", set_update);
+    py_bindmethod(type, "intersection_update", set_intersection_update);
+    py_bindmethod(type, "difference_update", set_difference_update);
+    py_bindmethod(type, "symmetric_difference_update", set_symmetric_difference_update);
+
+    py_setdict(py_tpobject(type), __hash__, py_None());
+    return type;
+}
+
+py_Type pk_frozenset__register() {
+    py_Type type =
+        pk_newtype("frozenset", tp_object, NULL, (void (*)(void*))Dict__dtor, false, false);
+    Set__bind_common(type);
+
+    py_bindmagic(type, __new__, frozenset__new__);
+    py_bindmagic(type, __hash__, frozenset__hash__);
+    return type;
+}
+
+//////////////////////////
+
+void py_newset(py_OutRef out) { Set__new(out, tp_set); }
+
+bool py_set_add(py_Ref self, py_Ref val) {
+    assert(py_istype(self, tp_set));
+    return Set__add(py_touserdata(self), val);
+}
+
+int py_set_contains(py_Ref self, py_Ref val) {
+    assert(Set__is_setlike(self));
+    return Set__contains(py_touserdata(self), val);
+}
+
+int py_set_discard(py_Ref self, py_Ref val) {
+    assert(py_istype(self, tp_set));
+    return Dict__pop(py_touserdata(self), val);
+}
+
+int py_set_len(py_Ref self) {
+    assert(Set__is_setlike(self));
+    Dict* ud = py_touserdata(self);
+    return ud->length;
+}
+
+#undef DEF_SET_COMPARE
+#undef DEF_SET_BINARY_OP
@@ -4,47 +4,69 @@
 #include "pocketpy/objects/base.h"
 #include "pocketpy/pocketpy.h"
 
-bool py_binaryadd(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __add__, __radd__); }
+bool py_binaryadd(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__add__, PK_SLOT__radd__);
+}
 
-bool py_binarysub(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __sub__, __rsub__); }
+bool py_binarysub(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__sub__, PK_SLOT__rsub__);
+}
 
-bool py_binarymul(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __mul__, __rmul__); }
+bool py_binarymul(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__mul__, PK_SLOT__rmul__);
+}
 
 bool py_binarytruediv(py_Ref lhs, py_Ref rhs) {
-    return py_binaryop(lhs, rhs, __truediv__, __rtruediv__);
+    return pk_binaryop(lhs, rhs, PK_SLOT__truediv__, PK_SLOT__rtruediv__);
 }
 
 bool py_binaryfloordiv(py_Ref lhs, py_Ref rhs) {
-    return py_binaryop(lhs, rhs, __floordiv__, __rfloordiv__);
+    return pk_binaryop(lhs, rhs, PK_SLOT__floordiv__, PK_SLOT__rfloordiv__);
 }
 
-bool py_binarymod(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __mod__, __rmod__); }
+bool py_binarymod(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__mod__, PK_SLOT__rmod__);
+}
 
-bool py_binarypow(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __pow__, __rpow__); }
+bool py_binarypow(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__pow__, PK_SLOT__rpow__);
+}
 
-bool py_binarylshift(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __lshift__, 0); }
+bool py_binarylshift(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__lshift__, PK_SLOT_NONE);
+}
 
-bool py_binaryrshift(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __rshift__, 0); }
+bool py_binaryrshift(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__rshift__, PK_SLOT_NONE);
+}
 
-bool py_binaryand(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __and__, 0); }
+bool py_binaryand(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__and__, PK_SLOT_NONE);
+}
 
-bool py_binaryor(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __or__, 0); }
+bool py_binaryor(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__or__, PK_SLOT_NONE);
+}
 
-bool py_binaryxor(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __xor__, 0); }
+bool py_binaryxor(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__xor__, PK_SLOT_NONE);
+}
 
-bool py_binarymatmul(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __matmul__, 0); }
+bool py_binarymatmul(py_Ref lhs, py_Ref rhs) {
+    return pk_binaryop(lhs, rhs, PK_SLOT__matmul__, PK_SLOT_NONE);
+}
 
-bool py_eq(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __eq__, __eq__); }
+bool py_eq(py_Ref lhs, py_Ref rhs) { return pk_binaryop(lhs, rhs, PK_SLOT__eq__, PK_SLOT__eq__); }
 
-bool py_ne(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __ne__, __ne__); }
+bool py_ne(py_Ref lhs, py_Ref rhs) { return pk_binaryop(lhs, rhs, PK_SLOT__ne__, PK_SLOT__ne__); }
 
-bool py_lt(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __lt__, __gt__); }
+bool py_lt(py_Ref lhs, py_Ref rhs) { return pk_binaryop(lhs, rhs, PK_SLOT__lt__, PK_SLOT__gt__); }
 
-bool py_le(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __le__, __ge__); }
+bool py_le(py_Ref lhs, py_Ref rhs) { return pk_binaryop(lhs, rhs, PK_SLOT__le__, PK_SLOT__ge__); }
 
-bool py_gt(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __gt__, __lt__); }
+bool py_gt(py_Ref lhs, py_Ref rhs) { return pk_binaryop(lhs, rhs, PK_SLOT__gt__, PK_SLOT__lt__); }
 
-bool py_ge(py_Ref lhs, py_Ref rhs) { return py_binaryop(lhs, rhs, __ge__, __le__); }
+bool py_ge(py_Ref lhs, py_Ref rhs) { return pk_binaryop(lhs, rhs, PK_SLOT__ge__, PK_SLOT__le__); }
 
 bool py_isidentical(py_Ref lhs, py_Ref rhs) {
     if(lhs->type != rhs->type) return false;
@@ -75,13 +97,13 @@ int py_bool(py_Ref val) {
         case tp_float: return val->_f64 != 0;
         case tp_NoneType: return 0;
         default: {
-            py_Ref tmp = py_tpfindmagic(val->type, __bool__);
+            py_Ref tmp = pk_tpfindslot(val->type, PK_SLOT__bool__);
             if(tmp) {
                 if(!py_call(tmp, 1, val)) return -1;
                 if(!py_checkbool(py_retval())) return -1;
                 return py_tobool(py_retval());
             } else {
-                tmp = py_tpfindmagic(val->type, __len__);
+                tmp = pk_tpfindslot(val->type, PK_SLOT__len__);
                 if(tmp) {
                     if(!py_call(tmp, 1, val)) return -1;
                     if(!py_checkint(py_retval())) return -1;
@@ -101,6 +123,15 @@ int py_equal(py_Ref lhs, py_Ref rhs) {
 }
 
 int py_less(py_Ref lhs, py_Ref rhs) {
+    // homogeneous builtin operands compare without dispatching `__lt__`
+    if(lhs->type == rhs->type) {
+        switch(lhs->type) {
+            case tp_int: return lhs->_i64 < rhs->_i64;
+            case tp_float: return lhs->_f64 < rhs->_f64;
+            case tp_str: return c11_sv__cmp(py_tosv(lhs), py_tosv(rhs)) < 0;
+            default: break;
+        }
+    }
     if(!py_lt(lhs, rhs)) return -1;
     return py_bool(py_retval());
 }
@@ -113,30 +144,22 @@ bool py_callable(py_Ref val) {
         case tp_boundmethod: return true;
         case tp_staticmethod: return true;
         case tp_classmethod: return true;
-        default: return py_tpfindmagic(val->type, __call__);
+        default: return pk_tpfindslot(val->type, PK_SLOT__call__);
     }
 }
 
 bool py_hash(py_Ref val, int64_t* out) {
-    py_TypeInfo* ti = pk_typeinfo(val->type);
-    do {
-        py_Ref slot_hash = py_getdict(&ti->self, __hash__);
-        if(slot_hash && py_isnone(slot_hash)) break;
-        py_Ref slot_eq = py_getdict(&ti->self, __eq__);
-        if(slot_eq) {
-            if(!slot_hash) break;
-            if(!py_call(slot_hash, 1, val)) return false;
-            if(!py_checkint(py_retval())) return false;
-            *out = py_toint(py_retval());
-            return true;
-        }
-        ti = ti->base_ti;
-    } while(ti);
-    return TypeError("unhashable type: '%t'", val->type);
+    // resolved by the nearest type defining `__eq__`, see `py_TypeInfo__resolve_hash`
+    py_Ref slot_hash = pk_tpfindslot(val->type, PK_SLOT__hash__);
+    if(!slot_hash) return TypeError("unhashable type: '%t'", val->type);
+    if(!py_call(slot_hash, 1, val)) return false;
+    if(!py_checkint(py_retval())) return false;
+    *out = py_toint(py_retval());
+    return true;
 }
 
 bool py_iter(py_Ref val) {
-    py_Ref tmp = py_tpfindmagic(val->type, __iter__);
+    py_Ref tmp = pk_tpfindslot(val->type, PK_SLOT__iter__);
     if(!tmp) return TypeError("'%t' object is not iterable", val->type);
     return py_call(tmp, 1, val);
 }
@@ -167,7 +190,7 @@ int py_next(py_Ref val) {
             if(str_iterator__next__(1, val)) return 1;
             break;
         default: {
-            py_Ref tmp = py_tpfindmagic(val->type, __next__);
+            py_Ref tmp = pk_tpfindslot(val->type, PK_SLOT__next__);
             if(!tmp) {
                 TypeError("'%t' object is not an iterator", val->type);
                 return -1;
@@ -189,14 +212,14 @@ bool py_str(py_Ref val) {
         py_assign(py_retval(), val);
         return true;
     }
-    py_Ref tmp = py_tpfindmagic(val->type, __str__);
+    py_Ref tmp = pk_tpfindslot(val->type, PK_SLOT__str__);
     if(!tmp) return py_repr(val);
     return py_call(tmp, 1, val);
 }
 
-bool py_repr(py_Ref val) { return pk_callmagic(__repr__, 1, val); }
+bool py_repr(py_Ref val) { return pk_callmagicslot(PK_SLOT__repr__, 1, val); }
 
-bool py_len(py_Ref val) { return pk_callmagic(__len__, 1, val); }
+bool py_len(py_Ref val) { return pk_callmagicslot(PK_SLOT__len__, 1, val); }
 
 bool py_getattr(py_Ref self, py_Name name) {
     // https://docs.python.org/3/howto/descriptor.html#invocation-from-an-instance
@@ -250,6 +273,11 @@ bool py_getattr(py_Ref self, py_Name name) {
                 py_newboundmethod(py_retval(), self, cls_var);
                 return true;
             }
+            case tp_lru_cache_wrapper: {
+                // a cached method is bound like the function it wraps
+                py_newboundmethod(py_retval(), self, cls_var);
+                return true;
+            }
             case tp_staticmethod: {
                 py_assign(py_retval(), py_getslot(cls_var, 0));
                 return true;
@@ -335,7 +363,7 @@ bool py_delattr(py_Ref self, py_Name name) {
 bool py_getitem(py_Ref self, py_Ref key) {
     py_push(self);
     py_push(key);
-    bool ok = pk_callmagic(__getitem__, 2, py_peek(-2));
+    bool ok = pk_callmagicslot(PK_SLOT__getitem__, 2, py_peek(-2));
     py_shrink(2);
     return ok;
 }
@@ -344,7 +372,7 @@ bool py_setitem(py_Ref self, py_Ref key, py_Ref val) {
     py_push(self);
     py_push(key);
     py_push(val);
-    bool ok = pk_callmagic(__setitem__, 3, py_peek(-3));
+    bool ok = pk_callmagicslot(PK_SLOT__setitem__, 3, py_peek(-3));
     py_shrink(3);
     return ok;
 }
@@ -352,7 +380,7 @@ bool py_setitem(py_Ref self, py_Ref key, py_Ref val) {
 bool py_delitem(py_Ref self, py_Ref key) {
     py_push(self);
     py_push(key);
-    bool ok = pk_callmagic(__delitem__, 2, py_peek(-2));
+    bool ok = pk_callmagicslot(PK_SLOT__delitem__, 2, py_peek(-2));
     py_shrink(2);
     return ok;
 }
@@ -105,7 +105,43 @@ bool py_tpcall(py_Type type, int argc, py_Ref argv) {
     return py_call(py_tpobject(type), argc, argv);
 }
 
+/// The path of `py_binaryop()` for names without a magic slot.
+static bool py_binaryop__byname(py_Ref lhs, py_Ref rhs, py_Name op, py_Name rop) {
+    py_Ref magic = py_tpfindmagic(lhs->type, op);
+    if(magic) {
+        py_push(lhs);
+        py_push(rhs);
+        bool ok = py_call(magic, 2, py_peek(-2));
+        py_shrink(2);
+        if(!ok) return false;
+        if(!py_istype(py_retval(), tp_NotImplementedType)) return true;
+    }
+    // try reverse operation
+    magic = rop ? py_tpfindmagic(rhs->type, rop) : NULL;
+    if(magic) {
+        py_push(rhs);
+        py_push(lhs);
+        bool ok = py_call(magic, 2, py_peek(-2));
+        py_shrink(2);
+        if(!ok) return false;
+        if(!py_istype(py_retval(), tp_NotImplementedType)) return true;
+    }
+    return TypeError("unsupported operand type(s) for '%s': '%t' and '%t'",
+                     pk_op2str(op),
+                     lhs->type,
+                     rhs->type);
+}
+
 bool py_binaryop(py_Ref lhs, py_Ref rhs, py_Name op, py_Name rop) {
+    py_MagicSlot op_slot = pk_magicslot(op);
+    py_MagicSlot rop_slot = rop ? pk_magicslot(rop) : PK_SLOT_NONE;
+    if(op_slot == PK_SLOT_NONE || (rop && rop_slot == PK_SLOT_NONE)) {
+        return py_binaryop__byname(lhs, rhs, op, rop);
+    }
+    return pk_binaryop(lhs, rhs, op_slot, rop_slot);
+}
+
+bool pk_binaryop(py_Ref lhs, py_Ref rhs, py_MagicSlot op, py_MagicSlot rop) {
     py_push(lhs);
     py_push(rhs);
     bool ok = pk_stack_binaryop(pk_current_vm, op, rop);
@@ -168,7 +204,8 @@ bool pk_loadmethod(py_StackRef self, py_Name name) {
     if(cls_var != NULL) {
         switch(cls_var->type) {
             case tp_function:
-            case tp_nativefunc: {
+            case tp_nativefunc:
+            case tp_lru_cache_wrapper: {
                 self[0] = *cls_var;
                 self[1] = self_bak;
                 break;
@@ -195,3 +232,10 @@ bool pk_callmagic(py_Name name, int argc, py_Ref argv) {
     if(!tmp) return AttributeError(argv, name);
     return py_call(tmp, argc, argv);
 }
+
+bool pk_callmagicslot(py_MagicSlot slot, int argc, py_Ref argv) {
+    assert(argc >= 1);
+    py_Ref tmp = pk_tpfindslot(argv->type, slot);
+    if(!tmp) return AttributeError(argv, pk_magicslot_name(slot));
+    return py_call(tmp, argc, argv);
+}
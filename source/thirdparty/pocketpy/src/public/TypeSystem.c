@@ -90,6 +90,12 @@ void py_tpsetfinal(py_Type type) {
     ti->is_final = true;
 }
 
+void py_tpsetbuffer(py_Type type, py_GetBufferFunc getbuffer) {
+    assert(type);
+    py_TypeInfo* ti = pk_typeinfo(type);
+    ti->getbuffer = getbuffer;
+}
+
 void py_tphookattributes(py_Type type,
                          bool (*getattribute)(py_Ref self, py_Name name),
                          bool (*setattribute)(py_Ref self, py_Name name, py_Ref val),
@@ -111,11 +111,16 @@ py_Name py_newfunction(py_OutRef out,
                        py_CFunction f,
                        const char* docstring,
                        int slots) {
-    char buffer[256];
-    snprintf(buffer, sizeof(buffer), "def %s: pass", sig);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstr(&buf, "def ");
+    c11_sbuf__write_cstr(&buf, sig);
+    c11_sbuf__write_cstr(&buf, ": pass");
+    c11_string* src = c11_sbuf__submit(&buf);
     // fn(a, b, *c, d=1) -> None
     CodeObject code;
-    SourceData_ source = SourceData__rcnew(buffer, "<bind>", EXEC_MODE, false);
+    SourceData_ source = SourceData__rcnew(src->data, "<bind>", EXEC_MODE, false);
+    c11_string__delete(src);
     Error* err = pk_compile(source, &code);
     if(err || code.func_decls.length != 1) {
         c11__abort("py_newfunction(): invalid signature '%s'", sig);
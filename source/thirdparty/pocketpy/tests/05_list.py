@@ -122,6 +122,41 @@ a = [1, 3, 2, 2]
 a.sort(key=key, reverse=True)
 assert a == [1, 2, 2, 3]
 
+# stability with runs, galloping and reverse
+a = [(i % 7, i) for i in range(300)] + [(3, 300 + i) for i in range(100)]
+def group_by_key(order):
+    res = []
+    for k in order:
+        res.extend([p for p in a if p[0] == k])
+    return res
+
+b = a[:]
+b.sort(key=lambda p: p[0])
+assert b == group_by_key(range(7))
+b.sort(key=lambda p: p[0], reverse=True)
+assert b == group_by_key(range(6, -1, -1))
+a = list(range(500)) + list(range(1000, 500, -1))
+a.sort()
+assert a == list(range(500)) + list(range(501, 1001))
+a = [str(i) for i in range(100)]
+a.sort()
+assert a[:3] == ['0', '1', '10']
+a = [i / 2 for i in range(100, 0, -1)]
+a.sort()
+assert a[0] == 0.5 and a[-1] == 50.0
+
+# the list can not be modified during sort
+a = [3, 1, 2]
+def key(x):
+    a.append(x)
+    return x
+try:
+    a.sort(key=key)
+    exit(1)
+except ValueError:
+    pass
+assert a == [1, 2, 3]
+
 # test sorted
 a = [8, 2, 4, 2, 9]
 assert sorted(a) == [2, 2, 4, 8, 9]
@@ -178,4 +178,29 @@ d = {
 
 del d['a']
 assert 'a' not in d
-assert d['gc'] == 1
\ No newline at end of file
+assert d['gc'] == 1
+# tombstone reuse keeps insertion order
+a = {}
+for i in range(5000):
+    a[i] = i
+    if i % 4 == 3:
+        del a[i - 1]
+keys = list(a.keys())
+assert keys == sorted(keys)
+assert len(keys) == 3750
+for k in keys:
+    assert a[k] == k
+a.clear()
+assert len(a) == 0
+a['x'] = 1
+assert list(a.items()) == [('x', 1)]
+
+# str-only dicts switch to generic keys on demand
+a = {'a': 1, 'bbbbbbbbbbbbbbbbbbbb': 2}
+assert a['bbbbbbbbbbbbbbbb' + 'bbbb'] == 2
+a[1] = 'one'
+a[(1, 2)] = 'tuple'
+assert a['a'] == 1 and a[1] == 'one' and a[(1, 2)] == 'tuple'
+assert 'bbbbbbbbbbbbbbbbbbbb' in a
+del a['a']
+assert list(a.keys()) == ['bbbbbbbbbbbbbbbbbbbb', 1, (1, 2)]
@@ -167,4 +167,66 @@ class DerivedClass(BaseClass):
         return super().f()
 
     
-assert DerivedClass.f() == 'BaseClass'
\ No newline at end of file
+assert DerivedClass.f() == 'BaseClass'
+
+# inherited lookups see later changes to any base
+class Base:
+    def f(self): return 1
+class Mid(Base): pass
+class Leaf(Mid): pass
+leaf = Leaf()
+assert leaf.f() == 1
+Base.f = lambda self: 2
+assert leaf.f() == 2
+Mid.f = lambda self: 3
+assert leaf.f() == 3
+del Mid.f
+assert leaf.f() == 2
+Base.g = lambda self: 'g'
+assert leaf.g() == 'g'
+del Base.f
+assert not hasattr(leaf, 'f')
+
+# magic methods assigned after class creation
+class Vec:
+    def __init__(self, x): self.x = x
+    def __add__(self, o): return Vec(self.x + o.x)
+class Vec2(Vec): pass
+assert (Vec2(1) + Vec2(2)).x == 3
+Vec.__add__ = lambda self, o: Vec(self.x * o.x)
+assert (Vec2(2) + Vec2(3)).x == 6
+Vec.__len__ = lambda self: 7
+assert len(Vec2(0)) == 7
+class Unhashable(Vec):
+    def __eq__(self, o): return False
+    def __ne__(self, o): return True
+try:
+    hash(Unhashable(1))
+    exit(1)
+except TypeError:
+    pass
+
+# updating an existing name is seen without rebuilding the lookup tables
+Base.count = 0
+for i in range(10):
+    Base.count += 1
+    assert Leaf.count == leaf.count == i + 1
+Leaf.__hash__ = None
+try:
+    hash(leaf)
+    exit(1)
+except TypeError:
+    pass
+
+class Hashed:
+    def __hash__(self): return 1
+    def __eq__(self, other): return self is other
+    def __ne__(self, other): return self is not other
+h = Hashed()
+assert hash(h) == 1
+Hashed.__hash__ = None
+try:
+    hash(h)
+    exit(1)
+except TypeError:
+    pass
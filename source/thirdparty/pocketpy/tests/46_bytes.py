@@ -40,4 +40,7 @@ assert a[5:2:-2] == b",l"
 
 assert bytes() == b''
 assert bytes((65,)) == b'A'
-assert bytes([0, 1, 2, 3]) == b'\x00\x01\x02\x03'
\ No newline at end of file
+assert bytes([0, 1, 2, 3]) == b'\x00\x01\x02\x03'
+# literals that differ only after a NUL byte are distinct constants
+assert b'\x00\x01' != b'\x00\x02'
+assert b'\x00\x02'[1] == 2
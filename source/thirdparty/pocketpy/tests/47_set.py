@@ -87,4 +87,49 @@ assert not {1,2,3}.isdisjoint({2,3,4})
 
 # a = set()
 # b = {*a, 1, 2, 3, *a, *a}
-# assert b == {1, 2, 3}
\ No newline at end of file
+# assert b == {1, 2, 3}
+
+# frozenset
+f = frozenset([1, 2, 3])
+assert f == {1, 2, 3} and {1, 2, 3} == f
+assert hash(f) == hash(frozenset([3, 2, 1]))
+assert {f: 1}[frozenset({1, 2, 3})] == 1
+assert repr(frozenset()) == 'frozenset()'
+assert repr(frozenset([1])) == 'frozenset({1})'
+assert type(f | {4}) is frozenset
+assert type({4} | f) is set
+
+try:
+    hash({1})
+    exit(1)
+except TypeError:
+    pass
+
+# comparisons and multi-argument methods
+assert {1, 2} < {1, 2, 3} and not {1, 2} < {1, 2}
+assert {1, 2} <= {1, 2} and {1, 2, 3} > {1} and {1} >= {1}
+assert {1, 2, 3}.intersection([2, 3], (3, 4)) == {3}
+assert {1, 2}.union([3], range(4, 6)) == {1, 2, 3, 4, 5}
+assert set('abca') == {'a', 'b', 'c'}
+
+a = {1, 2, 3}
+a.difference_update([1])
+assert a == {2, 3}
+a.intersection_update({3, 4})
+assert a == {3}
+a.symmetric_difference_update([3, 5])
+assert a == {5}
+assert a.pop() == 5
+assert len(a) == 0
+
+# subclasses keep their elements alive
+import gc
+class S(set):
+    pass
+
+s = S([str(i) * 3 for i in range(100)])
+gc.collect()
+_ = [[i] for i in range(1000)]
+gc.collect()
+assert s == {str(i) * 3 for i in range(100)}
+assert repr(S()) == 'S()'
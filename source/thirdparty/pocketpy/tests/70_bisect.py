@@ -41,4 +41,27 @@ insort_right(a, 5)
 assert a == [0, 0, 1, 1, 1, 2, 5, 5, 6, 7, 8, 16, 22, 23, 23]
 
 insort_right(a, 1)
-assert a == [0, 0, 1, 1, 1, 1, 2, 5, 5, 6, 7, 8, 16, 22, 23, 23]
\ No newline at end of file
+assert a == [0, 0, 1, 1, 1, 1, 2, 5, 5, 6, 7, 8, 16, 22, 23, 23]
+from bisect import bisect, insort
+
+# key= applies to the items, and to x for insort
+records = [(1, 'a'), (3, 'b'), (5, 'c')]
+assert bisect_left(records, 3, key=lambda r: r[0]) == 1
+assert bisect_right(records, 3, key=lambda r: r[0]) == 2
+insort(records, (4, 'd'), key=lambda r: r[0])
+assert records == [(1, 'a'), (3, 'b'), (4, 'd'), (5, 'c')]
+
+# lo and hi bound the search
+a = [1, 2, 3, 4, 5]
+assert bisect_left(a, 5, 0, 2) == 2
+assert bisect_right(a, 0, 3) == 3
+assert bisect(a, 3) == 3
+try:
+    bisect_left(a, 1, -1)
+    exit(1)
+except ValueError:
+    pass
+
+# tuples and other sequences
+assert bisect_left((1.0, 2.0, 3.0), 2.5) == 2
+assert bisect_left(['a', 'c', 'e'], 'd') == 2
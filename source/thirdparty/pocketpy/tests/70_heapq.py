@@ -6,4 +6,56 @@ b = sorted(a)
 
 heapify(a)
 for x in b:
-    assert heappop(a) == x
\ No newline at end of file
+    assert heappop(a) == x
+
+from heapq import heapreplace, heappushpop
+
+# event queue of (time, seq, payload) tuples
+events = []
+for i in range(500):
+    heappush(events, (randint(0, 50), i, 'e' + str(i)))
+popped = [heappop(events) for _ in range(500)]
+assert popped == sorted(popped)
+assert events == []
+
+a = [5, 1, 8, 3]
+heapify(a)
+assert heapreplace(a, 10) == 1
+assert heappop(a) == 3
+assert heappushpop(a, 0) == 0
+assert heappushpop(a, 7) == 5
+assert sorted(a) == [7, 8, 10]
+
+a = [2.5, 0.5, 1.5]
+heapify(a)
+assert [heappop(a) for _ in range(3)] == [0.5, 1.5, 2.5]
+a = ['pear', 'apple', 'fig']
+heapify(a)
+assert [heappop(a) for _ in range(3)] == ['apple', 'fig', 'pear']
+
+try:
+    heappop([])
+    exit(1)
+except IndexError:
+    pass
+
+try:
+    heappush((), 1)
+    exit(1)
+except TypeError:
+    pass
+
+class Evil:
+    def __init__(self, heap):
+        self.heap = heap
+    def __lt__(self, other):
+        self.heap.clear()
+        return False
+
+h = []
+heappush(h, 1)
+try:
+    heappush(h, Evil(h))
+    exit(1)
+except RuntimeError:
+    pass
@@ -490,12 +490,12 @@ assertEqual(list(d), list(e))
 
 ########## test pickle #############
 
-# d = deque(range(200))
-# for _ in range(5 + 1):
-#     s = pickle.dumps(d)
-#     e = pickle.loads(s)
-#     assertNotEqual(id(e), id(d))
-#     assertEqual(list(e), list(d))
+d = deque(range(200))
+for _ in range(5 + 1):
+    s = pickle.dumps(d)
+    e = pickle.loads(s)
+    assertNotEqual(id(e), id(d))
+    assertEqual(list(e), list(d))
 
 ### test copy ########
 
@@ -524,23 +524,127 @@ q.append(1)
 q.append(2)
 q.append(3)
 assertEqual(list(q), [1, 2, 3])
-assertEqual(q._data, [1, 2, 3, None])
 q.append(4)
 assertEqual(list(q), [2, 3, 4])
-assertEqual(q._data, [None, 2, 3, 4])
 q.appendleft(1)
 assertEqual(list(q), [1, 2, 3])
-assertEqual(q._data, [1, 2, 3, None])
 q.appendleft(0)
 assertEqual(list(q), [0, 1, 2])
-assertEqual(q._data, [1, 2, None, 0])
 q.pop()
 assertEqual(list(q), [0, 1])
-assertEqual(q._data, [1, None, None, 0])
 assertEqual(len(q), 2)
-assertEqual(q._capacity, 4)
 q.popleft()
 assertEqual(list(q), [1])
-assertEqual(q._data, [1, None, None, None])
+assertEqual(repr(q), 'deque([1], maxlen=3)')
+q.extend(range(10))
+assertEqual(list(q), [7, 8, 9])
+q.extendleft(range(10))
+assertEqual(list(q), [9, 8, 7])
+assertEqual(deque(maxlen=3).maxlen, 3)
+assertEqual(deque().maxlen, None)
+q = deque([1, 2], maxlen=0)
+assertEqual(list(q), [])
+q.append(1)
+q.appendleft(1)
+assertEqual(len(q), 0)
+try:
+    deque(maxlen=-1)
+    exit(1)
+except ValueError:
+    pass
+
+# fixed-length history buffer
+history = deque(maxlen=16)
+for i in range(1000):
+    history.append(i)
+    assertEqual(len(history), min(i + 1, 16))
+    assertEqual(history[0], max(0, i - 15))
+    assertEqual(history[-1], i)
+assertEqual(list(history), list(range(984, 1000)))
+assertEqual(history.copy().maxlen, 16)
+
+# rotate a wrapped ring
+d = deque(range(10))
+for i in range(5):
+    d.append(d.popleft())
+for n in range(-25, 25):
+    e = d.copy()
+    e.rotate(n)
+    k = n % 10
+    assertEqual(list(e), list(d)[10-k:] + list(d)[:10-k])
+
+# indexing, remove and reverse
+d = deque(range(10))
+d.rotate(3)
+assertEqual(d[0], 7)
+assertEqual(d[-1], 6)
+d[1] = 'x'
+assertEqual(d[1], 'x')
+try:
+    d[10]
+    exit(1)
+except IndexError:
+    pass
+d.remove('x')
+assertEqual(list(d), [7, 9, 0, 1, 2, 3, 4, 5, 6])
+d.remove(5)
+assertEqual(list(d), [7, 9, 0, 1, 2, 3, 4, 6])
+try:
+    d.remove(100)
+    exit(1)
+except ValueError:
+    pass
+d.reverse()
+assertEqual(list(d), [6, 4, 3, 2, 1, 0, 9, 7])
+
+# mutation during iteration
+d = deque([1, 2, 3])
+try:
+    for x in d:
+        d.append(x)
+    exit(1)
+except RuntimeError:
+    pass
+
+class MutatingCompare:
+    def __eq__(self, other):
+        d.pop()
+        return True
+    def __ne__(self, other):
+        return not self.__eq__(other)
 
+d = deque([1, 2, 3, MutatingCompare(), 4, 5])
+try:
+    d.count(3)
+    exit(1)
+except RuntimeError:
+    pass
+
+# extend with itself
+d = deque([1, 2, 3])
+d.extend(d)
+assertEqual(list(d), [1, 2, 3, 1, 2, 3])
+d.extendleft(d)
+assertEqual(list(d), [3, 2, 1, 3, 2, 1, 1, 2, 3, 1, 2, 3])
+
+# pickle
+d = deque(range(200), maxlen=300)
+e = pickle.loads(pickle.dumps(d))
+assertEqual(list(e), list(d))
+assertEqual(e.maxlen, 300)
+
+# subclass and gc
+class MyDeque(deque):
+    pass
 
+d = MyDeque([[i] for i in range(100)])
+d.tag = 'tagged'
+gc.collect()
+assertEqual(type(d.copy()), MyDeque)
+assertEqual(d.tag, 'tagged')
+assertEqual([x[0] for x in d], list(range(100)))
+d = deque([[i] for i in range(100)])
+it = iter(d)
+d = None
+gc.collect()
+assertEqual([x[0] for x in it], list(range(100)))
@@ -15,6 +15,47 @@ def test(data: bytes):
 test(b'')
 test(b'hello world')
 
+# test the frame format through a file
+import os, json, pickle
+
+data = {'rows': [{'name': 'n' + str(i), 'value': i * 0.5} for i in range(3000)]}
+for threads in [1, 3]:
+    with lz4.open('123.lz4', 'wb', threads=threads) as f:
+        pickle.dump(data, f)
+    with lz4.open('123.lz4', 'rb') as f:
+        assert pickle.load(f) == data
+
+    with lz4.open('123.lz4', 'wb', block_size=256*1024, threads=threads) as f:
+        json.dump(data, f)
+    with lz4.open('123.lz4') as f:
+        assert json.load(f) == data
+
+# read in small pieces, from an open file
+with open('123.lz4', 'rb') as raw:
+    f = lz4.open(raw)
+    parser = json.Parser()
+    while True:
+        chunk = f.read(1000)
+        if not chunk:
+            break
+        assert len(chunk) == 1000 or len(f.read(1)) == 0
+        parser.feed(chunk)
+    f.close()
+assert parser.close() == data
+
+# a truncated frame is an error
+with open('123.lz4', 'rb') as raw:
+    head = raw.read(100)
+with open('123.lz4', 'wb') as raw:
+    raw.write(head)
+try:
+    with lz4.open('123.lz4') as f:
+        f.read()
+    exit(1)
+except ValueError:
+    pass
+os.remove('123.lz4')
+
 import random
 
 def gen_data():
@@ -54,3 +54,93 @@ assert test_f(3) == 3 and miss_keys == [1, 2, 3, 4, 3, 5]
 # [2, 5, 3]
 assert test_f(1) == 1 and miss_keys == [1, 2, 3, 4, 3, 5, 1]
 # [5, 3, 1]
+
+info = test_f.cache_info()
+assert (info.hits, info.misses, info.maxsize, info.currsize) == (4, 7, 3, 3)
+test_f.cache_clear()
+assert test_f.cache_info().currsize == 0
+
+# keyword arguments and typed keys
+from functools import cache
+
+calls = []
+
+@cache
+def pitch(note, octave=4):
+    calls.append((note, octave))
+    return note + octave * 12
+
+assert pitch(0) == 48
+assert pitch(0) == 48
+assert pitch(0, octave=5) == 60
+assert pitch(0, 5) == 60
+assert pitch(0, octave=5) == 60
+assert calls == [(0, 4), (0, 5), (0, 5)]
+assert pitch.cache_info().hits == 2
+assert pitch.cache_info().maxsize is None
+assert pitch.__wrapped__(1) == 49
+
+@lru_cache(maxsize=None, typed=True)
+def kind(x):
+    return type(x)
+
+assert kind(1) is int
+assert kind(1.0) is float
+
+@lru_cache
+def fib(n):
+    return n if n < 2 else fib(n - 1) + fib(n - 2)
+
+assert fib(90) == 2880067194370816120
+assert fib.cache_info().misses == 91
+
+# cached methods
+class Scale:
+    def __init__(self, root):
+        self.root = root
+
+    @lru_cache(maxsize=16)
+    def degree(self, i):
+        return self.root + [0, 2, 4, 5, 7, 9, 11][i % 7] + 12 * (i // 7)
+
+major = Scale(60)
+assert major.degree(2) == 64
+assert major.degree(8) == 74
+f = major.degree
+assert f(2) == 64
+assert Scale.degree.cache_info().hits == 1
+
+# unhashable arguments
+try:
+    test_f([1])
+    exit(1)
+except TypeError:
+    pass
+
+# partial
+def f(a, b, *args, c=0, **kwargs):
+    return (a, b, c, args, kwargs)
+
+p = partial(f, 1, c=3)
+assert p(2) == (1, 2, 3, (), {})
+assert p(2, c=4) == (1, 2, 4, (), {})
+assert p(2, 5, 6, x=7) == (1, 2, 3, (5, 6), {'x': 7})
+assert p.func is f
+assert p.args == (1,)
+assert p.keywords == {'c': 3}
+
+q = partial(p, 2, x=1)
+assert q.func is f
+assert q.args == (1, 2)
+assert q.keywords == {'c': 3, 'x': 1}
+assert q() == (1, 2, 3, (), {'x': 1})
+assert q(x=2) == (1, 2, 3, (), {'x': 2})
+assert q.__call__(9) == (1, 2, 3, (9,), {'x': 1})
+assert list(map(partial(f, 0), [1, 2]))[1] == (0, 2, 0, (), {})
+assert repr(partial(sub, 1, b=2)).startswith('functools.partial(<function sub')
+
+try:
+    partial(1)
+    exit(1)
+except TypeError:
+    pass
@@ -0,0 +1,89 @@
+import json
+
+# scalars
+assert json.loads('0') == 0
+assert json.loads('-0') == 0
+assert json.loads('123') == 123
+assert json.loads('-123') == -123
+assert json.loads('9223372036854775807') == 9223372036854775807
+assert json.loads('-9223372036854775808') == -9223372036854775808
+assert type(json.loads('12345678901234567890')) is float
+assert json.loads('1.5') == 1.5
+assert json.loads('-2.5e3') == -2500.0
+assert json.loads('1E-2') == 0.01
+assert type(json.loads('1e2')) is float
+assert json.loads(' true ') == True
+assert json.loads('false') == False
+assert json.loads('null') is None
+assert json.loads('Infinity') == float('inf')
+assert json.loads('-Infinity') == float('-inf')
+nan = json.loads('NaN')
+assert nan != nan
+
+# strings
+assert json.loads('""') == ''
+assert json.loads('"abc"') == 'abc'
+assert json.loads('"a\\"b\\\\c\\/d"') == 'a"b\\c/d'
+assert json.loads('"\\b\\f\\n\\r\\t"') == '\b\f\n\r\t'
+assert json.loads('"\\u0041\\u00e9"') == 'Aé'
+assert json.loads('"\\ud83d\\ude00"') == '😀'
+assert json.loads('"你好"') == '你好'
+long_str = 'abcdefghijklmnopqrstuvwxyz' * 10
+assert json.loads('"' + long_str + '"') == long_str
+assert json.loads('"' + long_str + '\\n' + long_str + '"') == long_str + '\n' + long_str
+
+# containers
+assert json.loads('[]') == []
+assert json.loads('{}') == {}
+assert json.loads(' [ 1 , [ 2 , { } ] , "3" ] ') == [1, [2, {}], '3']
+assert json.loads('{"a": 1, "b": [true, null], "c": {"d": "e"}}') == {
+    'a': 1, 'b': [True, None], 'c': {'d': 'e'}
+}
+assert json.loads('{"a": 1, "a": 2}') == {'a': 2}
+assert json.loads('\n\t\r [\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n1]') == [1]
+
+deep = json.loads('[' * 900 + ']' * 900)
+for _ in range(899):
+    deep = deep[0]
+assert deep == []
+
+# bytes-like input
+assert json.loads(b'[1, 2]') == [1, 2]
+assert json.loads(bytearray(b'{"x": "y"}')) == {'x': 'y'}
+
+# round trip
+obj = {'a': [1, 2.5, 'x\ny', None, True], 'b': {'c': -1}}
+assert json.loads(json.dumps(obj)) == obj
+assert json.loads(json.dumps(obj, indent=2)) == obj
+
+# errors
+def check_error(source, msg):
+    try:
+        json.loads(source)
+        exit(1)
+    except ValueError as e:
+        assert str(e) == msg, str(e)
+
+check_error('', 'Expecting value: line 1 column 1 (char 0)')
+check_error('[1,', 'Expecting value: line 1 column 4 (char 3)')
+check_error('[1 2]', "Expecting ',' delimiter: line 1 column 4 (char 3)")
+check_error('{"a" 1}', "Expecting ':' delimiter: line 1 column 6 (char 5)")
+check_error('{1: 2}', 'Expecting property name enclosed in double quotes: line 1 column 2 (char 1)')
+check_error('"abc', 'Unterminated string starting at: line 1 column 1 (char 0)')
+check_error('"a\nb"', 'Invalid control character at: line 1 column 3 (char 2)')
+check_error('1 2', 'Extra data: line 1 column 3 (char 2)')
+check_error('[\n  tru]', 'Expecting value: line 2 column 3 (char 4)')
+check_error('[01]', "Expecting ',' delimiter: line 1 column 3 (char 2)")
+check_error('"\\x"', 'Invalid \\escape: line 1 column 2 (char 1)')
+
+try:
+    json.loads('[' * 2000 + ']' * 2000)
+    exit(1)
+except ValueError:
+    pass
+
+try:
+    json.loads(1)
+    exit(1)
+except TypeError:
+    pass
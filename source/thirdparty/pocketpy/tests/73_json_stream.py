@@ -0,0 +1,119 @@
+import json
+
+doc = '{"a": [1, 2.5, -3e2, true, false, null, -Infinity], "b": "x\\u00e9\\ud83d\\ude00\\n", '
+doc += '"c": {"d": [[], {}]}, "e": 12345678901234, "f": "café"}'
+expected = json.loads(doc)
+
+# feeding in chunks of any size gives the same result
+for step in [1, 2, 3, 5, 7, 16, 64, 1000]:
+    p = json.Parser()
+    i = 0
+    while i < len(doc):
+        p.feed(doc[i:i+step])
+        i += step
+    assert str(p.close()) == str(expected), step
+
+data = doc.encode()
+p = json.Parser()
+for i in range(len(data)):
+    p.feed(data[i:i+1])
+assert str(p.close()) == str(expected)
+
+# a token cut at the end of a chunk
+p = json.Parser()
+p.feed('12')
+p.feed('3')
+assert p.close() == 123
+
+p = json.Parser()
+p.feed('[tr')
+p.feed('ue, "ab')
+p.feed('c", -')
+p.feed('Infinity]')
+assert p.close() == [True, 'abc', float('-inf')]
+
+p = json.Parser()
+p.feed('  ')
+p.feed('{}  ')
+assert p.close() == {}
+
+# errors report positions in the whole document
+p = json.Parser()
+p.feed('[1,\n 2')
+try:
+    p.feed(']]')
+    exit(1)
+except ValueError as e:
+    assert str(e) == 'Extra data: line 2 column 4 (char 7)'
+
+try:
+    p.feed('1')
+    exit(1)
+except ValueError:
+    pass
+
+p = json.Parser()
+p.feed('[1, {"a"')
+try:
+    p.close()
+    exit(1)
+except ValueError as e:
+    assert str(e) == "Expecting ':' delimiter: line 1 column 9 (char 8)"
+
+p = json.Parser()
+try:
+    p.close()
+    exit(1)
+except ValueError as e:
+    assert str(e) == 'Expecting value: line 1 column 1 (char 0)'
+
+# any object with write() or read()
+big = {'items': [{'id': i, 'name': 'item' + str(i), 'tags': ['a', 'b']} for i in range(5000)]}
+
+class Writer:
+    def __init__(self):
+        self.parts = []
+    def write(self, s):
+        self.parts.append(s)
+
+w = Writer()
+json.dump(big, w)
+assert len(w.parts) > 1
+assert ''.join(w.parts) == json.dumps(big)
+
+class Reader:
+    def __init__(self, s):
+        self.s = s
+    def read(self, n):
+        res = self.s[:n]
+        self.s = self.s[n:]
+        return res
+
+assert json.load(Reader(doc)) == json.loads(doc)
+
+try:
+    json.dump(object(), Writer())
+    exit(1)
+except TypeError:
+    pass
+
+try:
+    import os
+except ImportError:
+    print('os is not enabled, skipping test...')
+    exit(0)
+
+# dump and load through a file
+with open('123.json', 'wt') as f:
+    json.dump(big, f)
+with open('123.json', 'rt') as f:
+    assert f.read() == json.dumps(big)
+with open('123.json', 'rt') as f:
+    assert json.load(f) == big
+
+with open('123.json', 'wt') as f:
+    json.dump(big, f, indent=2)
+with open('123.json', 'rb') as f:
+    assert json.load(f) == big
+
+os.remove('123.json')
@@ -0,0 +1,243 @@
+from array import array, typecodes
+
+assert typecodes == 'bhiqfd'
+
+# test construction
+a = array('i')
+assert len(a) == 0
+assert a.typecode == 'i'
+assert a.itemsize == 4
+assert repr(a) == "array('i')"
+a = array('d', [1, 2.5, 3])
+assert repr(a) == "array('d', [1.0, 2.5, 3.0])"
+assert a.tolist() == [1.0, 2.5, 3.0]
+assert array('b', range(3)).tolist() == [0, 1, 2]
+assert array('h', map(lambda x: x * x, range(4))).tolist() == [0, 1, 4, 9]
+assert array('q', array('q', [1, 2])).tolist() == [1, 2]
+assert array('d', array('i', [1, 2])).tolist() == [1.0, 2.0]
+assert [array(c).itemsize for c in typecodes] == [1, 2, 4, 8, 4, 8]
+
+for bad in ['x', 'ii', '']:
+    try:
+        array(bad)
+        exit(1)
+    except ValueError:
+        pass
+
+try:
+    array('i', [1.5])
+    exit(1)
+except TypeError:
+    pass
+
+try:
+    array('b', [128])
+    exit(1)
+except ValueError:
+    pass
+
+try:
+    array('h', 'abc')
+    exit(1)
+except TypeError:
+    pass
+
+# test append, extend, insert, pop, remove
+a = array('i')
+for i in range(100):
+    a.append(i)
+assert len(a) == 100
+assert a[99] == 99
+assert a[-1] == 99
+a.extend([100, 101])
+a.extend(array('i', [102]))
+a.extend(range(103, 105))
+assert a.tolist() == list(range(105))
+a = array('i', [1, 2, 3])
+a.extend(a)
+assert a.tolist() == [1, 2, 3, 1, 2, 3]
+try:
+    a.extend(array('d', [1.0]))
+    exit(1)
+except TypeError:
+    pass
+a.insert(0, 9)
+a.insert(-1, 8)
+a.insert(100, 7)
+assert a.tolist() == [9, 1, 2, 3, 1, 2, 8, 3, 7]
+assert a.pop() == 7
+assert a.pop(0) == 9
+assert a.pop(-2) == 8
+assert a.tolist() == [1, 2, 3, 1, 2, 3]
+a.remove(2)
+assert a.tolist() == [1, 3, 1, 2, 3]
+assert a.index(3) == 1
+assert a.count(3) == 2
+assert 2 in a
+assert 5 not in a
+try:
+    a.index(5)
+    exit(1)
+except ValueError:
+    pass
+try:
+    array('d').pop()
+    exit(1)
+except IndexError:
+    pass
+a.reverse()
+assert a.tolist() == [3, 2, 1, 3, 1]
+a = array('f', [0.5])
+a.fromlist([1.5, 2])
+assert a.tolist() == [0.5, 1.5, 2.0]
+try:
+    a.fromlist([3.0, 'x'])
+    exit(1)
+except TypeError:
+    pass
+assert len(a) == 3
+
+# test indexing and slicing
+a = array('i', range(10))
+assert a[2:5].tolist() == [2, 3, 4]
+assert a[::3].tolist() == [0, 3, 6, 9]
+assert a[::-1].tolist() == list(range(9, -1, -1))
+assert a[5:2].tolist() == []
+assert type(a[1:3]) is array
+try:
+    a[10]
+    exit(1)
+except IndexError:
+    pass
+a[0] = 100
+assert a[0] == 100
+a[1:3] = array('i', [7, 7, 7, 7])
+assert a.tolist() == [100, 7, 7, 7, 7, 3, 4, 5, 6, 7, 8, 9]
+a[1:5] = array('i')
+assert a.tolist() == [100, 3, 4, 5, 6, 7, 8, 9]
+a[::2] = array('i', [0, 0, 0, 0])
+assert a.tolist() == [0, 3, 0, 5, 0, 7, 0, 9]
+a[:] = a[::-1]
+assert a.tolist() == [9, 0, 7, 0, 5, 0, 3, 0]
+try:
+    a[::2] = array('i', [1])
+    exit(1)
+except ValueError:
+    pass
+try:
+    a[0:1] = [1]
+    exit(1)
+except TypeError:
+    pass
+del a[0]
+assert a.tolist() == [0, 7, 0, 5, 0, 3, 0]
+del a[::2]
+assert a.tolist() == [7, 5, 3]
+del a[::-2]
+assert a.tolist() == [5]
+del a[:]
+assert len(a) == 0
+
+# test iteration and comparison
+a = array('h', [1, 2, 3])
+assert list(a) == [1, 2, 3]
+assert sum(a) == 6
+assert a == array('h', [1, 2, 3])
+assert a != array('h', [1, 2])
+assert a == array('d', [1.0, 2.0, 3.0])
+assert a != [1, 2, 3]
+assert array('d', [float('nan')]) != array('d', [float('nan')])
+assert array('h', [1, 2]) < a < array('h', [1, 3])
+assert a <= array('d', [1.0, 2.0, 3.0]) and a >= array('i', [1, 2, 3])
+assert a > array('h') and not a < array('h')
+assert not array('d', [float('nan')]) <= array('d', [float('nan')])
+assert array('i') <= array('i') and not array('i') < array('i')
+
+# test tobytes and frombytes
+a = array('h', [1, -2, 300])
+b = a.tobytes()
+assert len(b) == 6
+assert b[0] == 1 and b[1] == 0
+assert array('h', b) == a
+c = array('h')
+c.frombytes(b)
+c.frombytes(b)
+assert c.tolist() == [1, -2, 300, 1, -2, 300]
+try:
+    c.frombytes(bytes([1, 2, 3]))
+    exit(1)
+except ValueError:
+    pass
+assert array('d', array('d', [0.1, 1e300]).tobytes()).tolist() == [0.1, 1e300]
+
+# test empty arrays
+a = array('i')
+assert a[0:0].tolist() == [] and a.tobytes() == b''
+a[0:0] = array('i')
+a.frombytes(b'')
+a.extend(array('i'))
+assert len(array('i', a) + 1) == 0
+
+# test element-wise arithmetic
+a = array('i', [1, 2, 3])
+b = array('i', [10, 20, 30])
+assert (a + b).tolist() == [11, 22, 33]
+assert (b - a).tolist() == [9, 18, 27]
+assert (a * b).tolist() == [10, 40, 90]
+assert (a + 1).tolist() == [2, 3, 4]
+assert (1 + a).tolist() == [2, 3, 4]
+assert (10 - a).tolist() == [9, 8, 7]
+assert (a * 2).typecode == 'i'
+assert (a * 0.5).tolist() == [0.5, 1.0, 1.5]
+assert (a * 0.5).typecode == 'd'
+assert (b / a).tolist() == [10.0, 10.0, 10.0]
+assert (6 / a).tolist() == [6.0, 3.0, 2.0]
+assert (-a).tolist() == [-1, -2, -3]
+assert (array('b', [100]) + 100).tolist() == [-56]
+assert (array('b', [-128]) * -1).tolist() == [-128]
+f = array('f', [0.5, 1.5])
+assert (f * f).tolist() == [0.25, 2.25]
+assert (f - 0.5).typecode == 'f'
+assert (f / 2).tolist() == [0.25, 0.75]
+d = array('d', [1.0, -2.0])
+assert (d / 0).tolist() == [float('inf'), float('-inf')]
+assert str((-array('d', [0.0]))[0]) == '-0.0'
+try:
+    a + array('i', [1])
+    exit(1)
+except ValueError:
+    pass
+try:
+    a + array('q', [1, 2, 3])
+    exit(1)
+except TypeError:
+    pass
+try:
+    a + 'x'
+    exit(1)
+except TypeError:
+    pass
+x = array('d', [1.0, 2.0])
+x += 1
+assert x.tolist() == [2.0, 3.0]
+
+# test pickle
+import pickle
+a = array('q', [1, -2, 2**40])
+assert pickle.loads(pickle.dumps(a)) == a
+assert pickle.loads(pickle.dumps(array('f'))) == array('f')
+
+# test subclassing is not allowed
+try:
+    class MyArray(array):
+        pass
+    exit(1)
+except TypeError:
+    pass
+
+# test hash
+try:
+    hash(array('i'))
+    exit(1)
+except TypeError:
+    pass
@@ -0,0 +1,218 @@
+# test construction
+assert bytearray() == b''
+assert bytearray(3) == b'\x00\x00\x00'
+assert bytearray(b'abc') == b'abc'
+assert bytearray([1, 2, 255]) == b'\x01\x02\xff'
+assert bytearray(range(3)) == b'\x00\x01\x02'
+assert bytearray(memoryview(b'xyz')[1:]) == b'yz'
+assert bytearray(bytearray(b'q')) == b'q'
+assert bytearray('ab'.encode()) == b'ab'
+try:
+    bytearray('abc')
+    exit(1)
+except TypeError:
+    pass
+try:
+    bytearray([256])
+    exit(1)
+except ValueError:
+    pass
+try:
+    bytearray(-1)
+    exit(1)
+except ValueError:
+    pass
+
+# test indexing
+a = bytearray(b'hello')
+assert len(a) == 5
+assert a[0] == 104 and a[-1] == 111
+a[0] = 72
+assert a == b'Hello'
+assert a[1:3] == b'el'
+assert isinstance(a[1:3], bytearray)
+assert a[::-1] == b'olleH'
+assert a[::2] == b'Hlo'
+try:
+    a[0] = 256
+    exit(1)
+except ValueError:
+    pass
+try:
+    a[5]
+    exit(1)
+except IndexError:
+    pass
+
+# test slice assignment
+a = bytearray(b'hello')
+a[1:3] = b'EEE'
+assert a == b'hEEElo'
+a[1:4] = b''
+assert a == b'hlo'
+a[1:1] = [101, 108]
+assert a == b'hello'
+a[len(a):] = bytearray(b'!')
+assert a == b'hello!'
+a[::2] = b'HLO'
+assert a == b'HeLlO!'
+a[:] = a
+assert a == b'HeLlO!'
+a[1:] = a[:3]
+assert a == b'HHeL'
+try:
+    a[::2] = b'x'
+    exit(1)
+except ValueError:
+    pass
+try:
+    a[0:1] = 1
+    exit(1)
+except TypeError:
+    pass
+
+# test deletion
+a = bytearray(b'0123456789')
+del a[0]
+assert a == b'123456789'
+del a[-1]
+assert a == b'12345678'
+del a[2:4]
+assert a == b'125678'
+del a[::2]
+assert a == b'268'
+a = bytearray(b'0123456789')
+del a[::-3]
+assert a == b'124578'
+del a[:]
+assert a == b''
+
+# test methods
+a = bytearray()
+a.append(1)
+a.extend(b'\x02\x03')
+a.extend([4, 5])
+a.extend(iter([6]))
+a.insert(0, 0)
+a.insert(-1, 9)
+assert a == b'\x00\x01\x02\x03\x04\x05\x09\x06'
+assert a.pop() == 6
+assert a.pop(0) == 0
+assert a.pop(-2) == 5
+assert a == b'\x01\x02\x03\x04\x09'
+b = a.copy()
+b.clear()
+assert b == b'' and len(a) == 5
+assert bytearray(b'abc').decode() == 'abc'
+try:
+    bytearray().pop()
+    exit(1)
+except IndexError:
+    pass
+try:
+    a.extend('x')
+    exit(1)
+except TypeError:
+    pass
+
+# test find
+a = bytearray(b'abcabc')
+assert a.find(b'bc') == 1
+assert a.find(b'bc', 2) == 4
+assert a.find(b'bc', 2, 5) == -1
+assert a.find(99) == 2
+assert a.find(b'') == 0
+assert a.find(b'x') == -1
+assert a.find(b'c', -2) == 5
+assert b'ca' in a and 97 in a and b'cc' not in a
+
+# test operators
+a = bytearray(b'ab')
+b = a
+a += b'cd'
+assert a is b and b == b'abcd'
+a += memoryview(b'e')
+assert b == b'abcde'
+assert a + b'f' == b'abcdef'
+assert isinstance(a + b'f', bytearray)
+assert b'x' + bytearray(b'y') == b'xy'
+assert isinstance(b'x' + bytearray(b'y'), bytes)
+assert bytearray(b'a') != b'b'
+assert b'a' == bytearray(b'a')
+try:
+    a += [1]
+    exit(1)
+except TypeError:
+    pass
+try:
+    hash(a)
+    exit(1)
+except TypeError:
+    pass
+assert repr(bytearray(b'a\x00')) == "bytearray(b'a\\x00')"
+assert list(bytearray(b'\x01\x02')) == [1, 2]
+
+# test += on other types keeps its meaning
+x = 1
+x += 2
+assert x == 3
+s = 'a'
+s += 'b'
+assert s == 'ab'
+l = [1]
+l2 = l
+l += [2]
+assert l == [1, 2] and l2 == [1]
+
+class Acc:
+    def __init__(self):
+        self.items = []
+    def __iadd__(self, other):
+        self.items.append(other)
+        return self
+
+acc = Acc()
+alias = acc
+acc += 1
+acc += 2
+assert alias is acc and acc.items == [1, 2]
+
+d = {'k': bytearray()}
+d['k'] += b'xy'
+assert d['k'] == b'xy'
+
+# test empty bytearrays
+a = bytearray()
+assert a == b'' and a != b'x' and a == bytearray()
+a.extend(b'')
+a[0:0] = b''
+assert a.find(b'') == 0 and len(a) == 0
+
+# test growth
+a = bytearray()
+for i in range(10000):
+    a += b'ab'
+assert len(a) == 20000 and a[-2:] == b'ab'
+
+# test buffer consumers
+import base64
+assert base64.b64encode(bytearray(b'hi')) == b'aGk='
+assert bytes(bytearray(b'xy')) == b'xy'
+m = memoryview(bytearray(b'abc'))
+m[0] = 65
+assert m.obj == b'Abc'
+
+import pickle
+a = bytearray(b'\x00pickle\xff')
+assert pickle.loads(pickle.dumps(a)) == a
+assert isinstance(pickle.loads(pickle.dumps(a)), bytearray)
+
+try:
+    import lz4
+except ImportError:
+    lz4 = None
+if lz4 is not None:
+    data = bytearray()
+    for i in range(100):
+        data += b'lz4'
+    assert lz4.decompress(lz4.compress(data)) == data
@@ -0,0 +1,163 @@
+from itertools import chain, islice, count, cycle, repeat, zip_longest
+from itertools import product, permutations, combinations, accumulate, groupby, batched
+
+# test chain
+assert list(chain()) == []
+assert list(chain([1, 2], (), 'ab', range(2))) == [1, 2, 'a', 'b', 0, 1]
+assert list(chain.from_iterable([[1], [], [2, 3]])) == [1, 2, 3]
+assert list(chain.from_iterable(iter([[1, 2], 'x']))) == [1, 2, 'x']
+
+# test islice
+assert list(islice(range(10), 3)) == [0, 1, 2]
+assert list(islice(range(10), 2, 5)) == [2, 3, 4]
+assert list(islice(range(10), 1, None, 3)) == [1, 4, 7]
+assert list(islice(range(10), 0, 9, 4)) == [0, 4, 8]
+assert list(islice(range(3), 5)) == [0, 1, 2]
+assert list(islice(range(3), None)) == [0, 1, 2]
+assert list(islice(count(), 4, 7)) == [4, 5, 6]
+it = iter(range(10))
+assert list(islice(it, 2, 4)) == [2, 3]
+assert next(it) == 4
+try:
+    islice(range(3), -1)
+    exit(1)
+except ValueError:
+    pass
+try:
+    islice(range(3), 0, 3, 0)
+    exit(1)
+except ValueError:
+    pass
+
+# test count
+assert list(islice(count(), 3)) == [0, 1, 2]
+assert list(islice(count(5, -2), 3)) == [5, 3, 1]
+assert list(islice(count(0.5, 0.25), 3)) == [0.5, 0.75, 1.0]
+assert repr(count(3)) == 'count(3)'
+assert repr(count(3, 2)) == 'count(3, 2)'
+
+# test cycle
+assert list(islice(cycle('abc'), 7)) == ['a', 'b', 'c', 'a', 'b', 'c', 'a']
+assert list(cycle([])) == []
+
+# test repeat
+assert list(repeat(1, 3)) == [1, 1, 1]
+assert list(repeat('x', 0)) == []
+assert list(repeat(1, -5)) == []
+assert list(islice(repeat(None), 2)) == [None, None]
+assert list(zip(range(3), repeat(2))) == [(0, 2), (1, 2), (2, 2)]
+
+# test zip_longest
+assert list(zip_longest('abc', [1])) == [('a', 1), ('b', None), ('c', None)]
+assert list(zip_longest([1], 'xy', fillvalue=0)) == [(1, 'x'), (0, 'y')]
+assert list(zip_longest()) == []
+assert list(zip_longest([], [])) == []
+
+# test product
+assert list(product('ab', range(2))) == [('a', 0), ('a', 1), ('b', 0), ('b', 1)]
+assert list(product(range(2), repeat=2)) == [(0, 0), (0, 1), (1, 0), (1, 1)]
+assert list(product()) == [()]
+assert list(product([1, 2], [])) == []
+assert list(product([], repeat=0)) == [()]
+assert len(list(product('abc', 'de', repeat=2))) == 36
+
+# test permutations
+assert list(permutations(range(3))) == [
+    (0, 1, 2), (0, 2, 1), (1, 0, 2), (1, 2, 0), (2, 0, 1), (2, 1, 0)
+]
+assert list(permutations('abc', 2)) == [
+    ('a', 'b'), ('a', 'c'), ('b', 'a'), ('b', 'c'), ('c', 'a'), ('c', 'b')
+]
+assert list(permutations([1, 2], 3)) == []
+assert list(permutations([], 0)) == [()]
+assert list(permutations([1], 0)) == [()]
+assert len(list(permutations(range(5)))) == 120
+
+# test combinations
+assert list(combinations('abcd', 2)) == [
+    ('a', 'b'), ('a', 'c'), ('a', 'd'), ('b', 'c'), ('b', 'd'), ('c', 'd')
+]
+assert list(combinations(range(4), 3)) == [(0, 1, 2), (0, 1, 3), (0, 2, 3), (1, 2, 3)]
+assert list(combinations([1, 2], 3)) == []
+assert list(combinations([1, 2], 0)) == [()]
+assert len(list(combinations(range(10), 4))) == 210
+try:
+    combinations([1], -1)
+    exit(1)
+except ValueError:
+    pass
+
+# test accumulate
+assert list(accumulate([1, 2, 3, 4])) == [1, 3, 6, 10]
+assert list(accumulate([1, 2, 3], initial=10)) == [10, 11, 13, 16]
+assert list(accumulate([], initial=5)) == [5]
+assert list(accumulate([])) == []
+assert list(accumulate([3, 1, 4, 1, 5], max)) == [3, 3, 4, 4, 5]
+assert list(accumulate(['a', 'b', 'c'])) == ['a', 'ab', 'abc']
+assert list(accumulate([[1], [2]], initial=[])) == [[], [1], [1, 2]]
+
+# test groupby
+assert [(k, list(g)) for k, g in groupby('aaabbc')] == [
+    ('a', ['a', 'a', 'a']), ('b', ['b', 'b']), ('c', ['c'])
+]
+assert [k for k, g in groupby([1, 1, 2, 2, 1])] == [1, 2, 1]
+assert [(k, len(list(g))) for k, g in groupby(range(10), key=lambda x: x // 4)] == [
+    (0, 4), (1, 4), (2, 2)
+]
+groups = list(groupby('aabb'))
+assert [list(g) for k, g in groups] == [[], []]
+assert list(groupby([])) == []
+
+# test batched
+assert list(batched(range(7), 3)) == [(0, 1, 2), (3, 4, 5), (6,)]
+assert list(batched('ab', 5)) == [('a', 'b')]
+assert list(batched([], 2)) == []
+try:
+    batched([1], 0)
+    exit(1)
+except ValueError:
+    pass
+
+# test iterators from generators and user types
+def gen():
+    yield 1
+    yield 2
+    yield 3
+
+assert list(chain(gen(), gen())) == [1, 2, 3, 1, 2, 3]
+assert list(accumulate(gen(), lambda a, b: a * b)) == [1, 2, 6]
+assert list(combinations(gen(), 2)) == [(1, 2), (1, 3), (2, 3)]
+
+class Countdown:
+    def __init__(self, n):
+        self.n = n
+    def __iter__(self):
+        return self
+    def __next__(self):
+        if self.n == 0:
+            raise StopIteration
+        self.n -= 1
+        return self.n
+
+assert list(islice(Countdown(5), 1, 4)) == [3, 2, 1]
+assert list(zip_longest(Countdown(2), Countdown(3), fillvalue=-1)) == [(1, 2), (0, 1), (-1, 0)]
+
+# test errors propagate
+def bad():
+    yield 1
+    raise KeyError('bad')
+
+try:
+    list(chain(bad()))
+    exit(1)
+except KeyError:
+    pass
+
+# test gc
+import gc
+it = product(range(3), ['x' * 10 for _ in range(3)], repeat=2)
+gc.collect()
+assert len(list(it)) == 81
+it = groupby([str(i // 3) for i in range(30)])
+gc.collect()
+assert [len(list(g)) for k, g in it] == [3] * 10
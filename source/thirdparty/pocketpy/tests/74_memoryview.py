@@ -0,0 +1,130 @@
+from array import array
+
+# test bytes
+m = memoryview(b'hello')
+assert len(m) == 5
+assert m[0] == 104 and m[-1] == 111
+assert m[1:3].tobytes() == b'el'
+assert m[3:1].tobytes() == b''
+assert m.tolist() == [104, 101, 108, 108, 111]
+assert list(m) == m.tolist()
+assert m.readonly and m.format == 'B' and m.itemsize == 1 and m.nbytes == 5
+assert m.obj == b'hello'
+assert bytes(m) == b'hello'
+assert bytes(m[1:]) == b'ello'
+assert m == b'hello' and m != b'hellO'
+try:
+    m[0] = 1
+    exit(1)
+except TypeError:
+    pass
+try:
+    m[::2]
+    exit(1)
+except ValueError:
+    pass
+
+# test array
+a = array('i', [1, 2, 3, 4])
+m = memoryview(a)
+assert not m.readonly and m.format == 'i' and m.itemsize == 4
+assert len(m) == 4 and m.nbytes == 16
+m[0] = 10
+assert a[0] == 10
+m[-1] = -4
+assert a.tolist() == [10, 2, 3, -4]
+m[1:3] = array('i', [20, 30])
+assert a.tolist() == [10, 20, 30, -4]
+try:
+    m[1:3] = array('i', [1])
+    exit(1)
+except ValueError:
+    pass
+try:
+    m[0] = 1 << 40
+    exit(1)
+except ValueError:
+    pass
+assert m == [10, 20, 30, -4] or m == array('i', [10, 20, 30, -4])
+assert m == array('q', [10, 20, 30, -4])
+assert m == array('d', [10, 20, 30, -4])
+
+# test slices share memory
+s = m[2:]
+s[0] = 99
+assert a[2] == 99
+assert memoryview(s).tolist() == [99, -4]
+
+# test cast
+b = m.cast('B')
+assert len(b) == 16 and b.format == 'B'
+assert b.cast('i').tolist() == a.tolist()
+assert memoryview(array('d', [1.5, 2.5])).cast('q').cast('d').tolist() == [1.5, 2.5]
+try:
+    b[1:].cast('i')
+    exit(1)
+except TypeError:
+    pass
+try:
+    m.cast('x')
+    exit(1)
+except ValueError:
+    pass
+
+# test shrinking the exporter
+a = array('h', [1, 2, 3])
+m = memoryview(a)[1:]
+del a[:]
+try:
+    m[0]
+    exit(1)
+except ValueError:
+    pass
+a.extend([4, 5, 6])
+assert m.tolist() == [5, 6]
+
+# test release
+m = memoryview(b'abc')
+m.release()
+try:
+    len(m)
+    exit(1)
+except ValueError:
+    pass
+with memoryview(array('b', [1, 2])) as m:
+    assert m.tolist() == [1, 2]
+try:
+    m.tobytes()
+    exit(1)
+except ValueError:
+    pass
+assert repr(m).startswith('<released memory at ')
+
+# test errors
+try:
+    memoryview('abc')
+    exit(1)
+except TypeError:
+    pass
+try:
+    hash(memoryview(b''))
+    exit(1)
+except TypeError:
+    pass
+
+# test consumers
+import base64
+a = array('b', [104, 105])
+assert bytes(a) == b'hi'
+assert base64.b64encode(a) == b'aGk='
+assert base64.b64encode(memoryview(b'xhiy')[1:3]) == b'aGk='
+assert base64.b64decode(memoryview(b'aGk=')) == b'hi'
+
+try:
+    import lz4
+except ImportError:
+    lz4 = None
+if lz4 is not None:
+    a = array('q', range(100))
+    assert lz4.decompress(lz4.compress(a)) == a.tobytes()
+    assert lz4.decompress(memoryview(lz4.compress(b'xyz'))) == b'xyz'
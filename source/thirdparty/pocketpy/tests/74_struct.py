@@ -0,0 +1,137 @@
+import struct
+from struct import pack, unpack, pack_into, unpack_from, iter_unpack, calcsize, Struct
+from array import array
+
+# test calcsize
+assert calcsize('') == 0
+assert calcsize('<i') == 4
+assert calcsize('>hhq') == 12
+assert calcsize('<3s2x?') == 6
+assert calcsize('@bi') == 8       # native alignment
+assert calcsize('=bi') == 5
+assert calcsize('<10B') == 10
+assert calcsize('!0i') == 0
+
+# test pack
+assert pack('>i', 1) == b'\x00\x00\x00\x01'
+assert pack('<i', 1) == b'\x01\x00\x00\x00'
+assert pack('>h', -2) == b'\xff\xfe'
+assert pack('<H', 65535) == b'\xff\xff'
+assert pack('>q', -1) == b'\xff\xff\xff\xff\xff\xff\xff\xff'
+assert pack('>Q', 1) == b'\x00\x00\x00\x00\x00\x00\x00\x01'
+assert pack('<bB', -1, 255) == b'\xff\xff'
+assert pack('>?c', True, b'x') == b'\x01x'
+assert pack('>f', 1.0) == b'\x3f\x80\x00\x00'
+assert pack('<d', 1.0) == b'\x00\x00\x00\x00\x00\x00\xf0\x3f'
+assert pack('>f', 2) == b'\x40\x00\x00\x00'
+assert pack('>2h', 1, 2) == b'\x00\x01\x00\x02'
+assert pack('<4s', b'ab') == b'ab\x00\x00'
+assert pack('<2s', b'abcd') == b'ab'
+assert pack('<4p', b'ab') == b'\x02ab\x00'
+assert pack('<3p', b'abcdef') == b'\x02ab'
+assert pack('<bxh', 1, 2) == b'\x01\x00\x02\x00'
+assert pack('<i 2x i', 1, 2) == b'\x01\x00\x00\x00\x00\x00\x02\x00\x00\x00'
+
+# test unpack
+assert unpack('>i', b'\x00\x00\x00\x01') == (1,)
+assert unpack('<h', b'\xfe\xff') == (-2,)
+assert unpack('<H', b'\xfe\xff') == (65534,)
+assert unpack('<b', b'\x80') == (-128,)
+assert unpack('>I', b'\xff\xff\xff\xff') == (4294967295,)
+assert unpack('>?c', b'\x02y') == (True, b'y')
+assert unpack('>f', b'\x3f\x80\x00\x00') == (1.0,)
+assert unpack('<4s', b'ab\x00\x00') == (b'ab\x00\x00',)
+assert unpack('<4p', b'\x02abc') == (b'ab',)
+assert unpack('<0s', b'') == (b'',)
+values = (1, -2, 3, 4, -6.25, b'osc', True)
+fmt = '>bhiqd3s?'
+assert unpack(fmt, pack(fmt, *values)) == values
+fmt = '@bhiqd3s?'
+assert unpack(fmt, pack(fmt, *values)) == values
+assert len(pack(fmt, *values)) == calcsize(fmt)
+
+# test errors
+def raises(f, exc=None):
+    if exc is None:
+        exc = struct.error
+    try:
+        f()
+    except exc:
+        return True
+    return False
+
+assert issubclass(struct.error, Exception)
+assert raises(lambda: pack('>b', 128))
+assert raises(lambda: pack('>B', -1))
+assert raises(lambda: pack('>h', 1 << 15))
+assert raises(lambda: pack('>Q', -1))
+assert raises(lambda: pack('>i', 1.5))
+assert raises(lambda: pack('>f', 'x'))
+assert raises(lambda: pack('>c', b'xy'))
+assert raises(lambda: pack('>s', 'x'))
+assert raises(lambda: pack('>ii', 1))
+assert raises(lambda: pack('>i', 1, 2))
+assert raises(lambda: pack('>y', 1))
+assert raises(lambda: pack('<n', 1))
+assert raises(lambda: calcsize('3'))
+assert raises(lambda: unpack('>i', b'\x00'))
+assert raises(lambda: unpack('>i', b'\x00\x00\x00\x00\x00'))
+assert raises(lambda: pack(1, 2), TypeError)
+assert raises(lambda: unpack('>i', 'abcd'), TypeError)
+# unsigned 64-bit values beyond int64 cannot be represented
+assert unpack('<Q', b'\xff\xff\xff\xff\xff\xff\xff\x7f') == (9223372036854775807,)
+assert raises(lambda: unpack('<Q', b'\xff\xff\xff\xff\xff\xff\xff\xff'))
+assert raises(lambda: unpack('>Q', b'\x80\x00\x00\x00\x00\x00\x00\x00'))
+
+# test buffers
+a = array('b', [0] * 8)
+pack_into('>hh', a, 2, 1, -1)
+assert a.tolist() == [0, 0, 0, 1, -1, -1, 0, 0]
+pack_into('<h', a, -2, 2)
+assert a.tolist() == [0, 0, 0, 1, -1, -1, 2, 0]
+assert unpack_from('>h', a, 2) == (1,)
+assert unpack_from('>h', a, offset=4) == (-1,)
+assert unpack_from('<h', a, -2) == (2,)
+assert unpack_from('<b', a) == (0,)
+assert unpack('<q', a) == unpack('<q', a.tobytes())
+assert raises(lambda: pack_into('>i', a, 6, 1))
+assert raises(lambda: pack_into('>i', b'12345678', 0, 1), TypeError)
+assert raises(lambda: unpack_from('>i', a, 5))
+assert raises(lambda: unpack_from('>i', a, -9))
+m = memoryview(b'\x00\x01\x00\x02\x00\x03')
+assert unpack('>h', m[2:4]) == (2,)
+assert unpack_from('>hh', m, 2) == (2, 3)
+m = memoryview(array('i', [7, 8]))
+pack_into('=i', m, 4, 9)
+assert m.tolist() == [7, 9]
+
+# test iter_unpack
+assert list(iter_unpack('>h', b'\x00\x01\x00\x02')) == [(1,), (2,)]
+assert list(iter_unpack('<hb', memoryview(b'\x01\x00\x02\x03\x00\x04'))) == [(1, 2), (3, 4)]
+assert list(iter_unpack('<i', b'')) == []
+assert raises(lambda: iter_unpack('<i', b'123'))
+assert raises(lambda: iter_unpack('', b''))
+
+# test Struct
+s = Struct('>ihb')
+assert s.size == 7 and s.format == '>ihb'
+assert repr(s) == "Struct('>ihb')"
+data = s.pack(1, 2, 3)
+assert data == pack('>ihb', 1, 2, 3)
+assert s.unpack(data) == (1, 2, 3)
+assert s.unpack_from(b'xx' + data, 2) == (1, 2, 3)
+assert s.unpack_from(b'xx' + data, offset=2) == (1, 2, 3)
+buf = array('b', [0] * 14)
+s.pack_into(buf, 7, 4, 5, 6)
+assert s.unpack_from(buf, 7) == (4, 5, 6)
+assert [t for t in s.iter_unpack(data + data)] == [(1, 2, 3), (1, 2, 3)]
+assert raises(lambda: Struct('>z'))
+
+# test an OSC message
+def osc_string(s):
+    b = s.encode()
+    return pack('>' + str((len(b) // 4 + 1) * 4) + 's', b)
+
+msg = osc_string('/freq') + osc_string(',if') + pack('>if', 440, 0.5)
+assert len(msg) == 20
+assert unpack_from('>if', msg, 12) == (440, 0.5)
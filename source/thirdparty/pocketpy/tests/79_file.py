@@ -66,4 +66,14 @@ f_()
 
 assert os.path.exists('123.bin')
 os.remove('123.bin')
-assert not os.path.exists('123.bin')
\ No newline at end of file
+assert not os.path.exists('123.bin')
+# test writing buffers
+from array import array
+with open('123.bin', 'wb') as f:
+    f.write(array('h', [1, 2]))
+    f.write(memoryview(b'xyz')[1:])
+
+with open('123.bin', 'rb') as f:
+    assert f.read() == array('h', [1, 2]).tobytes() + b'yz'
+
+os.remove('123.bin')
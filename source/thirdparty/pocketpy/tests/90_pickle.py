@@ -11,16 +11,19 @@ def test(data): # type: ignore
 
 test(None)                      # PKL_NONE
 test(...)                       # PKL_ELLIPSIS
-test(1)                         # PKL_INT8
-test(277)                       # PKL_INT16
-test(-66666)                    # PKL_INT32
-test(0xffffffffffff)            # PKL_INT64
+test(1)                         # PKL_INT_1
+test(277)                       # PKL_VARINT
+test(-66666)                    # PKL_VARINT
+test(0xffffffffffff)            # PKL_VARINT
 test(1.0)                       # PKL_FLOAT32
 test(1.12312434234)             # PKL_FLOAT64
 test(True)                      # PKL_TRUE
 test(False)                     # PKL_FALSE
-test("hello")                   # PKL_STRING
+test("hello")                   # PKL_STRTAB
+test("hello" * 100)             # PKL_STRING
 test(b"hello")                  # PKL_BYTES
+test({1, "a"})                  # set.__reduce__
+test(frozenset([2, 3]))         # frozenset.__reduce__
 
 from vmath import vec2, vec3, vec2i, vec3i
 
@@ -141,6 +144,84 @@ class Data:
 
 test(Data(1))
 
+# test out-of-band buffers
+big = ('x' * 5000).encode()
+small = b'abc'
+obj = {'a': big, 'b': [small, big], 'c': bytearray(b'123')}
+
+buffers = []
+data = pkl.dumps(obj, buffer_callback=buffers.append)
+assert len(buffers) == 3
+assert len(data) < 100
+res = pkl.loads(data, buffers=buffers)
+assert res == obj
+assert res['a'] is big      # no copy
+assert res['b'][1] is res['a']
+
+try:
+    pkl.loads(data)
+    exit(1)
+except ValueError:
+    pass
+
+# a corrupted buffer index is rejected
+buffers = []
+data = pkl.dumps(bytearray(b'xyz'), buffer_callback=buffers.append)
+i = bytearray(data).find(b'.\x00')
+assert i != -1
+bad = data[:i + 1] + b'\xff\xff\xff\xff\x0f' + data[i + 2:]
+try:
+    pkl.loads(bad, buffers=buffers * 2)
+    exit(1)
+except ValueError:
+    pass
+
+# a true value keeps the buffer in-band
+buffers = []
+def keep_small(b):
+    if len(b) < 100:
+        return True
+    buffers.append(b)
+data = pkl.dumps(obj, buffer_callback=keep_small)
+assert len(buffers) == 1
+assert pkl.loads(data, tuple(buffers)) == obj
+assert pkl.loads(pkl.dumps(obj)) == obj
+assert pkl.loads(memoryview(pkl.dumps([1, 2]))) == [1, 2]
+
+# test the string table
+rows = [{'name': 'a', 'value': i} for i in range(100)]
+data = pkl.dumps(rows)
+assert len(data) < 1500
+assert pkl.loads(data) == rows
+
+# test data written by the previous version
+class Foo:
+    def __init__(self, a, b):
+        self.a = a
+        self.b = b
+
+data = b'\xf0\x9f\xa5\x953(int)102(__main__.Foo)\n5\n\x06\x15\xfb\x16,\x01\x17\x90\xee\xfe\xff\x18\x00\x00\x00\x00\x00\x01\x00\x00\x1d\x08key\x1d\x08key\x1d\x06x\x19\x00\x00\xc0?\x1d\x06y\x03!\x07\x01\x05\x1b\x1e\x07ab\x01\x06 \x07\x01\x07$\x08\x15\xfc\x1d\x06q\x06,\x15f\x07a\x00b\x00\x01\x08&\x08&\x15f\x1f\x12\x01\t-'
+res = pkl.loads(data)
+assert res[:9] == [1, -5, 300, -70000, 2**40, 'key', 'key', {'x': 1.5, 'y': None}, (True, b'ab')]
+assert res[9] == vec2i(3, -4)
+assert type(res[10]) is Foo and res[10].a == 1 and res[10].b == 'q'
+assert res[11] is int and res[12] is Foo
+
+# sets were a python class keeping the elements in `_a`
+data = b'\xf0\x9f\xa5\x9575(builtins.set)\n3\n\x1d\x06s\x06\x03\x07\x03\x08\x03!\x08\x01\x05,\x15K\x06_a\x00\x01\x06!\x06\x01\x07-'
+res = pkl.loads(data)
+assert type(res['s']) is set and res['s'] == {1, 2, 3}
+res['s'].add(4)
+assert res['s'] == {1, 2, 3, 4}
+
+# only python classes are rebuilt from their `__dict__`
+data = b'\xf0\x9f\xa5\x9575(builtins.list)\n2\n\x08\x03\x1d\x06a\x03!\x07\x01\x05,\x15K\x06_a\x00\x01\x06-'
+try:
+    pkl.loads(data)
+    exit(1)
+except TypeError:
+    pass
+
 exit()
 
 from pickle import dumps, loads, _wrap, _unwrap
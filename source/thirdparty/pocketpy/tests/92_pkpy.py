@@ -5,4 +5,37 @@ class A:
 
 assert is_user_defined_type(A)
 assert not is_user_defined_type(int)
-assert not is_user_defined_type(dict)
\ No newline at end of file
+assert not is_user_defined_type(dict)
+# test snapshots
+import os
+import pkpy
+
+class Point:
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+
+points = [Point(i, -i) for i in range(2000)]
+table = {'a': points[0], 'b': (1, 2.5, 'c')}
+pkpy.snapshot_save('123.snap')
+
+points = None
+table = None
+pkpy.snapshot_load('123.snap')
+assert len(points) == 2000
+assert points[1999].x == 1999 and points[1999].y == -1999
+assert table['a'] is points[0]
+assert table['b'] == (1, 2.5, 'c')
+assert Point is type(points[0])
+
+# a snapshot is a list of (module path, globals) pairs
+import pickle
+for state in [[(1, {})], [('__main__', [])], [('__main__', {1: 2})]]:
+    with open('123.snap', 'wb') as f:
+        f.write(pickle.dumps(state))
+    try:
+        pkpy.snapshot_load('123.snap')
+        exit(1)
+    except ValueError:
+        pass
+os.remove('123.snap')
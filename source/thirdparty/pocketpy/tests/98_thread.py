@@ -38,3 +38,183 @@ while not thread_1.is_done or not thread_2.is_done:
 print("Thread 1 last return value:", thread_1.last_retval())
 print("Thread 2 last return value:", thread_2.last_retval())
 
+# large bytes are passed to and from the worker out-of-band
+thread_1.exec('''
+def reverse(data, tag=None):
+    return {'tag': tag, 'data': data[::-1], 'size': len(data)}
+''')
+payload = ('0123456789' * 1000).encode()
+thread_1.submit_call('reverse', payload, tag=b'small')
+thread_1.wait_for_done()
+assert thread_1.last_error() is None
+res = thread_1.last_retval()
+assert res == {'tag': b'small', 'data': payload[::-1], 'size': 10000}
+
+# a cloned vm starts with the modules and data of the current vm
+import os
+from pkpy import clonevm
+from vmath import vec2
+# the clones import `test2` again, so stay in `tests` until they are made
+cwd = os.getcwd()
+os.chdir('tests')
+from test2.a.g import A, get_value
+
+config = {'name': 'clone', 'items': [1, 2, 3], 'a': A(), 'f': get_value, 'pos': vec2(1, 2)}
+config['items'].append(config['items'])
+config['a'].x = 5
+def local_func(): pass
+
+# native objects without pickle support cannot be cloned
+del thread_1
+del thread_2
+del t
+clonevm(3)
+thread_3 = ComputeThread(3)
+assert thread_3.eval("config['name']") == 'clone'
+assert thread_3.eval("config['items'][3] is config['items']") == True
+assert thread_3.eval("config['a'].x") == 5
+assert thread_3.eval("type(config['a']).__module__") == 'test2.a.g'
+assert thread_3.eval("config['f']()") == '123'
+assert thread_3.eval("config['pos'].y") == 2
+assert thread_3.eval("'local_func' in globals()") == False
+thread_3.exec("config['name'] = 'changed'")
+assert config['name'] == 'clone'
+
+try:
+    clonevm(3)
+    exit(1)
+except ValueError:
+    pass
+
+config['g'] = lambda: 1
+try:
+    clonevm(4)
+    exit(1)
+except RuntimeError:
+    pass
+os.chdir(cwd)
+
+# more than 16 vms, each deleted with its thread
+import gc
+threads = [ComputeThread() for i in range(20)]
+indices = [t.eval('__import__("pkpy").currentvm()') for t in threads]
+assert len(set(indices)) == 20
+assert 0 not in indices
+for t in threads:
+    t.submit_eval('1 + 1')
+for t in threads:
+    t.wait_for_done()
+    assert t.last_retval() == 2
+first = indices[0]
+threads = None
+t = None
+gc.collect()
+assert ComputeThread().eval('__import__("pkpy").currentvm()') == first
+
+# waiting blocks until the job is done or the timeout has passed
+slow = ComputeThread()
+slow.submit_exec('import time\ntime.sleep(0.5)')
+assert slow.wait_for_done(0.01) == False
+assert not slow.is_done
+assert slow.wait_for_done() == True
+assert slow.last_error() is None
+
+# submit_* returns a future, its callbacks run in `poll_completions()`
+from pkpy import poll_completions, Future
+worker = ComputeThread()
+worker.exec('import time\ndef square(x, delay=0):\n    time.sleep(delay)\n    return x * x')
+results = []
+fut = worker.submit_call('square', 7, delay=0.2)
+assert isinstance(fut, Future)
+fut.add_done_callback(lambda f: results.append(f.result()))
+assert fut.result() == 49
+assert fut.done()
+assert results == []
+poll_completions()
+assert results == [49]
+# callbacks of a finished job are called at once
+fut.add_done_callback(lambda f: results.append(-f.result()))
+assert results == [49, -49]
+
+fut = worker.submit_call('square', 3, delay=0.05)
+fut.add_done_callback(lambda f: results.append(f.result()))
+while results[-1] != 9:
+    poll_completions()
+
+fut = worker.submit_eval('1 / 0')
+try:
+    fut.result()
+    exit(1)
+except RuntimeError as e:
+    assert 'ZeroDivisionError' in str(e)
+
+fut = worker.submit_call('square', 2, delay=0.5)
+try:
+    fut.result(0.01)
+    exit(1)
+except TimeoutError:
+    pass
+assert fut.result() == 4
+
+# the result of a future is kept when the thread runs the next job
+first = worker.submit_eval('square(4)')
+worker.wait_for_done()
+second = worker.submit_eval('square(5)')
+assert second.result() == 25
+assert first.result() == 16
+
+# channels
+from pkpy import Channel
+
+results = Channel('results', capacity=5)
+assert results.capacity == 8
+assert len(results) == 0
+worker.exec('from pkpy import Channel\nresults = Channel("results")')
+fut = worker.submit_exec('for i in range(100): results.send({"i": i, "sq": i * i})')
+for i in range(100):
+    assert results.recv() == {'i': i, 'sq': i * i}
+fut.result()
+
+try:
+    results.recv(timeout=0)
+    exit(1)
+except TimeoutError:
+    pass
+
+for i in range(8):
+    results.send_bytes(bytes([i, 255]), timeout=0)
+assert len(results) == 8
+try:
+    results.send(8, timeout=0.01)
+    exit(1)
+except TimeoutError:
+    pass
+for i in range(8):
+    assert results.recv() == bytes([i, 255])
+
+# a ring of one slot would not tell full from empty
+one = Channel('one', 1)
+assert one.capacity == 2
+one.send(1)
+one.send(2, timeout=0)
+try:
+    one.send(3, timeout=0)
+    exit(1)
+except TimeoutError:
+    pass
+assert one.recv(timeout=0) == 1 and one.recv(timeout=0) == 2
+
+# an existing channel keeps its capacity
+assert Channel('one').capacity == 2
+try:
+    Channel('one', 64)
+    exit(1)
+except ValueError:
+    pass
+
+# a channel passed as an argument is opened by name
+worker.exec('def echo(ch, n):\n    for i in range(n): ch.send(i)')
+echo = Channel('echo', 2)
+fut = worker.submit_call('echo', echo, 50)
+assert [echo.recv(timeout=5) for _ in range(50)] == list(range(50))
+fut.result()